@@ -0,0 +1,321 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#ifndef ASV_CORE_BOAT_HH_
+#define ASV_CORE_BOAT_HH_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "asv/core/LiftDrag.hh"
+#include "asv/core/Quaternion.hh"
+#include "asv/core/Vector3.hh"
+#include "asv/core/WinchArray.hh"
+
+namespace asv
+{
+namespace core
+{
+/// \brief One element of a lifting surface: the whole foil at its
+/// centre of pressure, or one spanwise strip of a sail.
+struct SurfacePanel
+{
+  /// \brief Centre of pressure (link frame).
+  Vector3d cp;
+
+  /// \brief Panel area.
+  double area = 1.0;
+
+  /// \brief Twist of the panel relative to the link.
+  Quaterniond twist;
+};
+
+/// \brief A sail or foil attached to the hull, as configured for the
+/// SailLiftDrag and FoilLiftDrag systems.
+struct BoatSurface
+{
+  /// \brief Name of the link the surface is attached to.
+  std::string name;
+
+  /// \brief Lift and drag parameters.
+  LiftDragParams params;
+
+  /// \brief True if the surface is a sail in the wind, false if it is a
+  /// foil in the water.
+  bool sail = false;
+
+  /// \brief Panels (link frame).
+  std::vector<SurfacePanel> panels;
+
+  /// \brief Position of the link origin in the body frame at zero trim.
+  Vector3d position;
+
+  /// \brief Orientation of the link in the body frame at zero trim.
+  Quaterniond rotation;
+
+  /// \brief True if the surface turns on a revolute joint. The trim is
+  /// the joint position.
+  bool trimmable = false;
+
+  /// \brief Name of the joint, if trimmable.
+  std::string jointName;
+
+  /// \brief Moment of inertia of the link about the joint axis.
+  double jointInertia = 1.0;
+
+  /// \brief Viscous damping of the joint.
+  double jointDamping = 0.0;
+
+  /// \brief Trim axis (body frame, unit).
+  Vector3d trimAxis{0.0, 0.0, 1.0};
+
+  /// \brief A point on the trim axis (body frame).
+  Vector3d trimOrigin;
+
+  /// \brief Trim limits in radians.
+  double trimMin = -0.5 * M_PI;
+  double trimMax = 0.5 * M_PI;
+
+  /// \brief Power law exponent for the wind speed as a function of
+  /// height, sails only.
+  double windShearExponent = 0.0;
+
+  /// \brief Height at which the wind equals the reference wind.
+  double windReferenceHeight = 10.0;
+
+  /// \brief The pose of the link in the body frame at a trim angle.
+  /// \param[in] _trim The trim angle in radians, ignored if the surface
+  /// is not trimmable.
+  /// \param[out] _position Position of the link origin (body frame).
+  /// \param[out] _rotation Orientation of the link (body frame).
+  void Pose(double _trim, Vector3d &_position, Quaterniond &_rotation) const
+  {
+    if (!this->trimmable || _trim == 0.0)
+    {
+      _position = this->position;
+      _rotation = this->rotation;
+      return;
+    }
+    auto q = Quaterniond::FromAxisAngle(this->trimAxis, _trim);
+    _position = this->trimOrigin +
+        q.RotateVector(this->position - this->trimOrigin);
+    _rotation = q * this->rotation;
+  }
+
+  /// \brief The wind speed factor at a height above the waterline.
+  /// \param[in] _z The height.
+  double WindShearFactor(double _z) const
+  {
+    if (this->windShearExponent == 0.0)
+      return 1.0;
+
+    // Clamp to avoid a singular profile at or below the surface.
+    double z = std::max(_z, 0.01 * this->windReferenceHeight);
+    return std::pow(z / this->windReferenceHeight, this->windShearExponent);
+  }
+
+  /// \brief Add the lift and drag on the surface to a wrench.
+  ///
+  /// This is the computation of the SailLiftDrag and FoilLiftDrag
+  /// systems for a rigid body, without the wind shadow and foil downwash
+  /// which depend on other bodies.
+  /// \param[in] _trim The trim angle in radians.
+  /// \param[in] _bodyPos Position of the body origin (world frame). The
+  /// height is above the waterline.
+  /// \param[in] _bodyRot Orientation of the body (world frame).
+  /// \param[in] _linVel Velocity of the body origin (world frame).
+  /// \param[in] _angVel Angular velocity of the body (world frame).
+  /// \param[in] _fluidVel Fluid velocity (world frame), for a sail the
+  /// wind at the reference height.
+  /// \param[in,out] _force Force (world frame).
+  /// \param[in,out] _torque Torque about the body origin (world frame).
+  void AddWrench(double _trim,
+      const Vector3d &_bodyPos, const Quaterniond &_bodyRot,
+      const Vector3d &_linVel, const Vector3d &_angVel,
+      const Vector3d &_fluidVel, Vector3d &_force, Vector3d &_torque) const
+  {
+    Vector3d linkPos;
+    Quaterniond linkRot;
+    this->Pose(_trim, linkPos, linkRot);
+    linkPos = _bodyRot.RotateVector(linkPos);
+    linkRot = _bodyRot * linkRot;
+
+    LiftDragResult result;
+    for (const auto &panel : this->panels)
+    {
+      // Centre of pressure relative to the body origin (world frame).
+      auto xr = linkPos + linkRot.RotateVector(panel.cp);
+      auto velCp = _linVel + _angVel.Cross(xr);
+      auto velU = this->WindShearFactor(_bodyPos.z + xr.z) * _fluidVel -
+          velCp;
+      auto rot = linkRot * panel.twist;
+      ComputeLiftDrag(this->params, velU,
+          rot.RotateVector(this->params.forward),
+          rot.RotateVector(this->params.upward),
+          panel.area, result);
+      auto f = result.lift + result.drag;
+      if (!f.IsFinite())
+        continue;
+      _force += f;
+      _torque += xr.Cross(f);
+    }
+  }
+};
+
+/// \brief The hull: mass properties and a simple resistance and
+/// stability model for tools that do not run the hydrodynamics.
+struct BoatHull
+{
+  /// \brief Total mass.
+  double mass = 0.0;
+
+  /// \brief Centre of mass (body frame).
+  Vector3d centreOfMass;
+
+  /// \brief Moments of inertia about the centre of mass (body frame):
+  /// ixx, iyy and izz.
+  Vector3d inertia{1.0, 1.0, 1.0};
+
+  /// \brief Products of inertia about the centre of mass (body frame):
+  /// ixy, ixz and iyz.
+  Vector3d inertiaProducts;
+
+  /// \brief Metacentric height. The righting moment is
+  /// mass * gravity * metacentricHeight * sin(heel).
+  double metacentricHeight = 1.0;
+
+  /// \brief Longitudinal metacentric height, as above for pitch.
+  double longitudinalMetacentricHeight = 10.0;
+
+  /// \brief Waterplane area. The body origin floats on the waterline and
+  /// the heave restoring force is -waterDensity * gravity *
+  /// waterplaneArea * z.
+  double waterplaneArea = 1.0;
+
+  /// \brief Water density.
+  double waterDensity = 1025.0;
+
+  /// \brief Linear resistance coefficients along each body axis. The
+  /// resistance is -(linear + quadratic * |v|) * v for each component
+  /// of the velocity of the body origin (body frame).
+  Vector3d linearDrag;
+
+  /// \brief Quadratic resistance coefficients along each body axis.
+  Vector3d quadraticDrag;
+
+  /// \brief Linear and quadratic damping coefficients about each body
+  /// axis, as for the resistance.
+  Vector3d angularLinearDrag;
+  Vector3d angularQuadraticDrag;
+
+  /// \brief The resistance of the hull.
+  /// \param[in] _velBody Velocity of the body origin (body frame).
+  /// \return The force (body frame).
+  Vector3d Resistance(const Vector3d &_velBody) const
+  {
+    return Vector3d(
+        -(this->linearDrag.x + this->quadraticDrag.x * std::abs(_velBody.x))
+            * _velBody.x,
+        -(this->linearDrag.y + this->quadraticDrag.y * std::abs(_velBody.y))
+            * _velBody.y,
+        -(this->linearDrag.z + this->quadraticDrag.z * std::abs(_velBody.z))
+            * _velBody.z);
+  }
+};
+
+/// \brief A mooring chain, as configured for the Mooring system.
+struct BoatMooring
+{
+  /// \brief Attachment point, the origin of the link (body frame).
+  Vector3d attachment;
+
+  /// \brief Anchor position (world frame).
+  Vector3d anchor;
+
+  /// \brief Chain length.
+  double length = 0.0;
+
+  /// \brief Chain weight per unit length.
+  double weightPerMetre = 0.0;
+};
+
+/// \brief A sail controller, as configured for the
+/// SailPositionController system.
+struct BoatSailController
+{
+  /// \brief Index of the controlled surface in Boat::surfaces.
+  size_t surface = 0;
+
+  /// \brief PID gains and limits, see PidArray::Add.
+  double p = 1.0;
+  double i = 0.1;
+  double d = 0.01;
+  double iMax = 1.0;
+  double iMin = -1.0;
+  double cmdMax = 1000.0;
+  double cmdMin = -1000.0;
+  double cmdOffset = 0.0;
+
+  /// \brief Initial command, the largest sail angle.
+  double initialPosition = 0.0;
+
+  /// \brief True if a sheet winch drives the joint instead of the PID.
+  bool winch = false;
+
+  /// \brief The winch parameters.
+  WinchParams winchParams;
+};
+
+/// \brief A boat as a rigid hull with sails and foils, described in the
+/// frame of its model. The model frame origin is taken to be on the
+/// waterline.
+struct Boat
+{
+  /// \brief The sails and foils.
+  std::vector<BoatSurface> surfaces;
+
+  /// \brief The hull.
+  BoatHull hull;
+
+  /// \brief The mooring chains.
+  std::vector<BoatMooring> moorings;
+
+  /// \brief The sail controllers.
+  std::vector<BoatSailController> controllers;
+
+  /// \brief Initial position of the model frame (world frame).
+  Vector3d position;
+
+  /// \brief Initial orientation of the model frame (world frame).
+  Quaterniond rotation;
+
+  /// \brief The number of trimmable sails.
+  size_t TrimCount() const
+  {
+    size_t n = 0;
+    for (const auto &surface : this->surfaces)
+      n += surface.trimmable && surface.sail ? 1 : 0;
+    return n;
+  }
+};
+
+}  // namespace core
+}  // namespace asv
+
+#endif  // ASV_CORE_BOAT_HH_
@@ -0,0 +1,309 @@
+// Copyright (C) 2023 Rhys Mainwaring
+//
+
+// Adapted from the MooringForce system developed for the MBARI wave buoy
+// including https://github.com/osrf/buoy_sim/pull/135
+//
+// Authors: Mabel Zhang <mabel@openrobotics.org>
+//          Michael Anderson <anderson@mbari.org>
+//          Rhys Mainwaring <rhys.mainwaring@me.com>
+
+// Copyright 2022 Open Source Robotics Foundation, Inc.
+//                and Monterey Bay Aquarium Research Institute
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ASV_CORE_CATENARY_HH_
+#define ASV_CORE_CATENARY_HH_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+namespace asv
+{
+namespace core
+{
+/////////////////////////////////////////////////
+struct CatenaryFunction
+{
+  /// \brief Scaling factor for catenary chain
+  /// \param V Vertical distance from buoy to anchor (metres)
+  /// \param B Length of mooring chain lying on seafloor,
+  /// start of catenary (metres).
+  /// \param L Total length of mooring chain (metres).
+  /// \return  Return scaling factor c, ratio of the horizontal component
+  /// of chain tension and weight of cable per unit length
+  public: static double CatenaryScalingFactor(double _V, double _B, double _L)
+  {
+    // Scaling factor c
+    return (std::pow((_L - _B), 2.0) - std::pow(_V, 2.0)) / (2.0 * _V);
+  }
+};
+
+/////////////////////////////////////////////////
+struct CatenaryHSoln
+{
+  /// \brief Vertical distance from buoy to anchor (metres).
+  private: double V{std::nanf("")};
+
+  /// \brief Horizontal distance from buoy to anchor (metres).
+  private: double H{std::nanf("")};
+
+  /// \brief Total length of mooring chain (metres).
+  private: double L{std::nanf("")};
+
+  /// \brief Constructor.
+  public: CatenaryHSoln(double _V, double _H, double _L)
+      : V(_V),
+      H(_H),
+      L(_L)
+  {
+  }
+
+  /// \brief Set the geometry, so one instance serves every step.
+  public: void Set(double _V, double _H, double _L)
+  {
+    this->V = _V;
+    this->H = _H;
+    this->L = _L;
+  }
+
+  /// \brief Upper bound on B, where the chain hangs vertically.
+  public: double UpperBound() const
+  {
+    return this->L - this->V;
+  }
+
+  /// \brief Invert the catenary equation and solve for the horizontal input.
+  ///
+  /// \param B length of chain on floor.
+  public: double InverseCatenaryVSoln(double _B) const
+  {
+    double c = CatenaryFunction::CatenaryScalingFactor(this->V, _B, this->L);
+    return c * std::acosh(this->V / c + 1.0) + _B;
+  }
+
+  /// \brief Evaluate the target function.
+  ///
+  /// Know 0 <= B < L - V. Take in B = L - V - b as initial guess
+  public: double operator()(double _B) const
+  {
+    return this->InverseCatenaryVSoln(_B) - this->H;
+  }
+};
+
+/////////////////////////////////////////////////
+/// \brief Scalar root finder for CatenaryHSoln.
+///
+/// The horizontal span decreases monotonically as the length of chain
+/// on the floor B grows towards L - V, so the root is bracketed from
+/// above and each step is a Newton step on a forward difference,
+/// falling back to bisection when it leaves the bracket. The solver
+/// holds no dynamic storage, unlike the Eigen HybridNonLinearSolver
+/// it replaces, so it may run every step without allocating. The
+/// parameters and status codes follow the Eigen solver.
+struct CatenaryHSolver
+{
+  /// \brief Converged: the relative change in B is below xtol.
+  public: static constexpr int kConverged = 1;
+
+  /// \brief Stopped after maxfev function evaluations.
+  public: static constexpr int kTooManyEvaluations = 2;
+
+  /// \brief Stopped on an invalid geometry or a non-finite residual.
+  public: static constexpr int kNotMakingProgress = 4;
+
+  /// \brief Tolerance for the relative change in B between iterations.
+  public: double xtol{0.001};
+
+  /// \brief Maximum number of function evaluations.
+  public: int maxfev{20};
+
+  /// \brief Number of iterations of the last solve.
+  public: int iter{0};
+
+  /// \brief Number of function evaluations of the last solve.
+  public: int nfev{0};
+
+  /// \brief Absolute residual at the last solution.
+  public: double fnorm{std::nan("")};
+
+  /// \brief Solve for B.
+  /// \param[in] _f The catenary equation.
+  /// \param[in,out] _B The initial estimate, and the solution.
+  /// \return One of the status codes.
+  public: int Solve(const CatenaryHSoln &_f, double &_B)
+  {
+    this->iter = 0;
+    this->nfev = 0;
+    this->fnorm = std::nan("");
+
+    const double upper = _f.UpperBound();
+    if (!(upper > 0.0))
+      return kNotMakingProgress;
+
+    // Bracket on the root: f > 0 below it and f < 0 above it.
+    double lo = -std::numeric_limits<double>::infinity();
+    double hi = upper;
+
+    double x = _B < upper ? _B : 0.5 * upper;
+    double f = _f(x);
+    ++this->nfev;
+    while (true)
+    {
+      this->fnorm = std::fabs(f);
+      if (!std::isfinite(f))
+        return kNotMakingProgress;
+      if (f == 0.0)
+        break;
+      if (f > 0.0)
+        lo = x;
+      else
+        hi = x;
+
+      if (this->nfev + 2 > this->maxfev)
+        return kTooManyEvaluations;
+
+      // Forward difference, stepping away from the vertical chain.
+      double h = std::sqrt(std::numeric_limits<double>::epsilon()) *
+          std::max(std::fabs(x), 1.0);
+      if (x + h >= upper)
+        h = -h;
+      double df = (_f(x + h) - f) / h;
+
+      double xn = x - f / df;
+      if (!(xn > lo && xn < hi))
+      {
+        xn = std::isinf(lo) ?
+            x - std::max(std::fabs(x), 1.0) : 0.5 * (lo + hi);
+      }
+      ++this->iter;
+
+      bool small = std::fabs(xn - x) <= this->xtol * std::fabs(xn);
+      x = xn;
+      f = _f(x);
+      this->nfev += 2;
+      _B = x;
+      if (small)
+      {
+        this->fnorm = std::fabs(f);
+        return std::isfinite(f) ? kConverged : kNotMakingProgress;
+      }
+    }
+    _B = x;
+    return kConverged;
+  }
+};
+
+/////////////////////////////////////////////////
+/// \brief True if the chain can drop vertically (within tolerance), so
+/// it forms no catenary and the tension is its weight.
+/// \param[in] _V Vertical distance from the vessel to the anchor.
+/// \param[in] _H Horizontal distance from the vessel to the anchor.
+/// \param[in] _L Total length of the chain.
+inline bool CatenarySlack(double _V, double _H, double _L)
+{
+  const double toleranceL = 0.1;
+  return _V + _H <= _L + toleranceL;
+}
+
+/////////////////////////////////////////////////
+/// \brief Upper bound on the length of chain on the floor, the initial
+/// estimate for the solver.
+/// \param[in] _V Vertical distance from the vessel to the anchor.
+/// \param[in] _H Horizontal distance from the vessel to the anchor.
+/// \param[in] _L Total length of the chain.
+inline double CatenaryBMax(double _V, double _H, double _L)
+{
+  return (_L * _L - (_V * _V + _H * _H)) / (2 * (_L - _H));
+}
+
+/////////////////////////////////////////////////
+/// \brief The tension of a mooring chain at the vessel. The Mooring
+/// system and asv::core::FastSim both use it.
+/// \param[in] _V Vertical distance from the vessel to the anchor.
+/// \param[in] _H Horizontal distance from the vessel to the anchor.
+/// \param[in] _L Total length of the chain.
+/// \param[in] _w Weight of the chain per unit length.
+/// \param[in,out] _solver The solver.
+/// \param[out] _tr Horizontal tension, negative towards the anchor.
+/// \param[out] _tz Vertical tension, negative downwards.
+/// \param[out] _B If not null, the length of chain on the floor.
+/// \return CatenaryHSolver::kConverged, or the solver status if it
+/// failed, in which case the tension is for its last estimate. The
+/// solver is not run if the chain is slack.
+inline int CatenaryTension(double _V, double _H, double _L, double _w,
+    CatenaryHSolver &_solver, double &_tr, double &_tz,
+    double *_B = nullptr)
+{
+  // Assume all force is vertical.
+  if (CatenarySlack(_V, _H, _L))
+  {
+    _tr = 0.0;
+    _tz = -_w * _V;
+    if (_B)
+      *_B = _L - _V;
+    return CatenaryHSolver::kConverged;
+  }
+
+  CatenaryHSoln f(_V, _H, _L);
+  double B = CatenaryBMax(_V, _H, _L);
+  int status = _solver.Solve(f, B);
+
+  // Horizontal tension and vertical tension at the attachment point.
+  double c = CatenaryFunction::CatenaryScalingFactor(_V, B, _L);
+  _tr = -c * _w;
+  _tz = -_w * (_L - B);
+  if (_B)
+    *_B = B;
+  return status;
+}
+
+/////////////////////////////////////////////////
+/// \brief The tension of a batch of mooring chains held in flat arrays,
+/// for instance NumPy arrays from the Python bindings.
+/// \param[in] _count The number of chains.
+/// \param[in] _V Vertical distance from the vessel to the anchor.
+/// \param[in] _H Horizontal distance from the vessel to the anchor.
+/// \param[in] _L Total length of the chain.
+/// \param[in] _w Weight of the chain per unit length.
+/// \param[in,out] _solver The solver, whose tolerances apply to every
+/// chain.
+/// \param[out] _tr Horizontal tension of each chain, as above.
+/// \param[out] _tz Vertical tension of each chain, as above.
+/// \param[out] _status If not null, the status of each chain.
+/// \return The number of chains that converged.
+inline size_t CatenaryTension(size_t _count, const double *_V,
+    const double *_H, const double *_L, const double *_w,
+    CatenaryHSolver &_solver, double *_tr, double *_tz,
+    int *_status = nullptr)
+{
+  size_t converged = 0;
+  for (size_t i = 0; i < _count; ++i)
+  {
+    int status = CatenaryTension(_V[i], _H[i], _L[i], _w[i], _solver,
+        _tr[i], _tz[i]);
+    if (_status)
+      _status[i] = status;
+    if (status == CatenaryHSolver::kConverged)
+      ++converged;
+  }
+  return converged;
+}
+
+}  // namespace core
+}  // namespace asv
+
+#endif  // ASV_CORE_CATENARY_HH_
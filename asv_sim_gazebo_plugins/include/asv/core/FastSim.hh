@@ -0,0 +1,265 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#ifndef ASV_CORE_FASTSIM_HH_
+#define ASV_CORE_FASTSIM_HH_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "asv/core/Boat.hh"
+#include "asv/core/PidArray.hh"
+#include "asv/core/WinchArray.hh"
+
+namespace asv
+{
+namespace core
+{
+/// \brief Options for the fast-time simulator.
+struct FastSimOptions
+{
+  /// \brief Time step in seconds.
+  double stepSize = 0.005;
+
+  /// \brief Acceleration due to gravity.
+  double gravity = 9.80665;
+
+  /// \brief Number of threads, or 0 for one per core.
+  size_t threads = 0;
+
+  /// \brief Seed of the random wind. Each boat has its own stream
+  /// derived from the seed and its index.
+  uint64_t seed = 0;
+
+  /// \brief Mean wind velocity (world frame) at the reference height of
+  /// the sails, the direction the wind blows towards.
+  Vector3d wind;
+
+  /// \brief Standard deviation of the gusts in the wind speed.
+  double gustIntensity = 0.0;
+
+  /// \brief Standard deviation of the wind direction in radians.
+  double directionDeviation = 0.0;
+
+  /// \brief Time constant of the gusts and wind shifts in seconds.
+  double gustTimeConstant = 10.0;
+};
+
+/// \brief A fast-time simulator of many independent boats, for Monte
+/// Carlo studies such as autopilot tuning.
+///
+/// Each boat is a rigid hull with the forces of the simulation:
+/// - the sails and foils of BoatSurface::AddWrench,
+/// - the hull resistance of BoatHull::Resistance and the angular
+///   damping,
+/// - linear hydrostatics: a heave spring on the waterplane area and
+///   righting moments from the metacentric heights,
+/// - the catenary of the Mooring system for each mooring.
+///
+/// A surface on a joint turns about the joint axis. A sail with a
+/// controller is free on its joint and driven by the PID or winch of
+/// the SailPositionController system, so only tension is applied. The
+/// position of any other surface on a joint is set directly, for
+/// instance a rudder by an autopilot.
+///
+/// The wind is the mean wind with gusts and shifts from first order
+/// Gauss-Markov processes. The random numbers of each boat come from
+/// its own generator, seeded from FastSimOptions::seed and the boat
+/// index, and the boats are stepped independently, so a run is the same
+/// whatever the number of threads.
+///
+/// The state is held as contiguous arrays over the boats, and over the
+/// surfaces or controllers of each boat. The equations of motion are
+/// integrated with the semi-implicit Euler method.
+class FastSim
+{
+  /// \brief A function called before each step of a boat, for instance
+  /// an autopilot that sets the joint positions or sail commands. It is
+  /// called concurrently for different boats and may only access the
+  /// state of its boat.
+  /// \param[in] _sim The simulator.
+  /// \param[in] _boat The boat index.
+  /// \param[in] _time The time in seconds.
+  public: using Callback =
+      std::function<void(FastSim &_sim, size_t _boat, double _time)>;
+
+  /// \brief Constructor. The boats start at rest at the initial pose of
+  /// the boat.
+  /// \param[in] _boat The boat.
+  /// \param[in] _count The number of boats.
+  /// \param[in] _options The options.
+  public: FastSim(const Boat &_boat, size_t _count,
+      const FastSimOptions &_options = FastSimOptions());
+
+  /// \brief The boat.
+  public: const Boat &BoatModel() const;
+
+  /// \brief The options.
+  public: const FastSimOptions &Options() const;
+
+  /// \brief The number of boats.
+  public: size_t Size() const;
+
+  /// \brief The time in seconds.
+  public: double Time() const;
+
+  /// \brief Reset every boat to rest at the initial pose, with the
+  /// controllers and the wind of the options.
+  public: void Reset();
+
+  /// \brief Step every boat.
+  /// \param[in] _steps The number of steps.
+  /// \param[in] _callback Called before each step of each boat, may be
+  /// empty.
+  public: void Step(size_t _steps, const Callback &_callback = Callback());
+
+  /// \brief Set the pose of a boat.
+  /// \param[in] _boat The boat index.
+  /// \param[in] _position Position of the model frame (world frame).
+  /// \param[in] _rotation Orientation of the model frame (world frame).
+  public: void SetPose(size_t _boat, const Vector3d &_position,
+      const Quaterniond &_rotation);
+
+  /// \brief Set the velocity of a boat.
+  /// \param[in] _boat The boat index.
+  /// \param[in] _linear Velocity of the centre of mass (world frame).
+  /// \param[in] _angular Angular velocity (world frame).
+  public: void SetVelocity(size_t _boat, const Vector3d &_linear,
+      const Vector3d &_angular);
+
+  /// \brief Set the mean wind of a boat.
+  /// \param[in] _boat The boat index.
+  /// \param[in] _wind The mean wind velocity (world frame).
+  public: void SetWind(size_t _boat, const Vector3d &_wind);
+
+  /// \brief Set the command of a sail controller, the largest sail
+  /// angle, or the sheet length for a winch.
+  /// \param[in] _boat The boat index.
+  /// \param[in] _controller The controller index in Boat::controllers.
+  /// \param[in] _command The command.
+  public: void SetSailCommand(size_t _boat, size_t _controller,
+      double _command);
+
+  /// \brief Set the position of a surface on a joint. A controlled sail
+  /// moves from this position.
+  /// \param[in] _boat The boat index.
+  /// \param[in] _surface The surface index in Boat::surfaces.
+  /// \param[in] _position The joint position in radians, clamped to the
+  /// joint limits.
+  public: void SetJointPosition(size_t _boat, size_t _surface,
+      double _position);
+
+  /// \brief Position of the model frame of a boat (world frame).
+  /// \param[in] _boat The boat index.
+  public: Vector3d Position(size_t _boat) const;
+
+  /// \brief Orientation of the model frame of a boat (world frame).
+  /// \param[in] _boat The boat index.
+  public: Quaterniond Rotation(size_t _boat) const;
+
+  /// \brief Velocity of the centre of mass of a boat (world frame).
+  /// \param[in] _boat The boat index.
+  public: Vector3d LinearVelocity(size_t _boat) const;
+
+  /// \brief Angular velocity of a boat (world frame).
+  /// \param[in] _boat The boat index.
+  public: Vector3d AngularVelocity(size_t _boat) const;
+
+  /// \brief The wind of a boat at the current time (world frame).
+  /// \param[in] _boat The boat index.
+  public: Vector3d Wind(size_t _boat) const;
+
+  /// \brief The joint position of a surface in radians.
+  /// \param[in] _boat The boat index.
+  /// \param[in] _surface The surface index in Boat::surfaces.
+  public: double JointPosition(size_t _boat, size_t _surface) const;
+
+  /// \brief Step the boats in a range.
+  /// \param[in] _begin The first boat.
+  /// \param[in] _end One past the last boat.
+  /// \param[in] _steps The number of steps.
+  /// \param[in] _callback Called before each step, may be empty.
+  private: void StepRange(size_t _begin, size_t _end, size_t _steps,
+      const Callback &_callback);
+
+  /// \brief Step one boat.
+  /// \param[in] _boat The boat index.
+  private: void StepBoat(size_t _boat);
+
+  /// \brief Update the gusts of one boat.
+  /// \param[in] _boat The boat index.
+  private: void StepWind(size_t _boat);
+
+  /// \brief A normal random number from the generator of a boat.
+  /// \param[in] _boat The boat index.
+  private: double Normal(size_t _boat);
+
+  /// \brief The boat.
+  private: Boat boat;
+
+  /// \brief The options.
+  private: FastSimOptions options;
+
+  /// \brief The number of boats.
+  private: size_t count = 0;
+
+  /// \brief The time in seconds.
+  private: double time = 0.0;
+
+  /// \brief The inertia about the centre of mass and its inverse (body
+  /// frame).
+  private: double inertia[3][3];
+  private: double inertiaInv[3][3];
+
+  /// \brief Centre of mass position and velocity (world frame).
+  private: std::vector<Vector3d> position;
+  private: std::vector<Vector3d> velocity;
+
+  /// \brief Orientation (world frame).
+  private: std::vector<Quaterniond> rotation;
+
+  /// \brief Angular velocity (body frame).
+  private: std::vector<Vector3d> angularVelocity;
+
+  /// \brief Joint position and velocity, boat by surface.
+  private: std::vector<double> jointPosition;
+  private: std::vector<double> jointVelocity;
+
+  /// \brief Sail commands, boat by controller.
+  private: std::vector<double> sailCommand;
+
+  /// \brief Sail controllers and winches, boat by controller.
+  private: PidArray pid;
+  private: WinchArray winch;
+
+  /// \brief Mean wind, and the gust in speed and direction.
+  private: std::vector<Vector3d> wind;
+  private: std::vector<double> gustSpeed;
+  private: std::vector<double> gustDirection;
+
+  /// \brief Random number generator state.
+  private: std::vector<uint64_t> rng;
+
+  /// \brief The surfaces moved by a controller, boat independent.
+  private: std::vector<bool> controlled;
+};
+
+}  // namespace core
+}  // namespace asv
+
+#endif  // ASV_CORE_FASTSIM_HH_
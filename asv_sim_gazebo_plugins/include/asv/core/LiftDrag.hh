@@ -0,0 +1,231 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// This code modified from the gazebo LiftDrag plugin
+/*
+* Copyright (C) 2012 Open Source Robotics Foundation
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*/
+
+#ifndef ASV_CORE_LIFTDRAG_HH_
+#define ASV_CORE_LIFTDRAG_HH_
+
+#include <cmath>
+
+#include "asv/core/Quaternion.hh"
+#include "asv/core/Vector3.hh"
+
+namespace asv
+{
+namespace core
+{
+/// \brief Parameters of the piecewise linear lift and drag model of a
+/// radially symmetric foil.
+struct LiftDragParams
+{
+  /// \brief Fluid density.
+  double fluidDensity = 1.2;
+
+  /// \brief Foil forward direction (body frame, unit), usually parallel
+  /// to the foil chord.
+  Vector3d forward{1.0, 0.0, 0.0};
+
+  /// \brief Foil upward direction (body frame, unit), usually
+  /// perpendicular to the foil chord in the direction of positive lift
+  /// for the foil in its intended configuration.
+  Vector3d upward{0.0, 0.0, 1.0};
+
+  /// \brief Foil area.
+  double area = 1.0;
+
+  /// \brief Angle of attack at zero lift.
+  double alpha0 = 0.0;
+
+  /// \brief Slope of lift coefficient before stall.
+  double cla = 2.0 * M_PI;
+
+  /// \brief Angle of attack at stall.
+  double alphaStall = 1.0 / 2.0 / M_PI;
+
+  /// \brief Slope of lift coefficient after stall.
+  double claStall = -(2 * M_PI) / (M_PI * M_PI - 1.0);
+
+  /// \brief Slope of drag coefficient.
+  double cda = 2.0 / M_PI;
+};
+
+/// \brief The lift and drag on one surface and the quantities they
+/// were computed from.
+struct LiftDragResult
+{
+  /// \brief Lift force (world frame).
+  Vector3d lift;
+
+  /// \brief Drag force (world frame).
+  Vector3d drag;
+
+  /// \brief Angle of attack in [0, pi] (rad).
+  double alpha = 0.0;
+
+  /// \brief Free-stream speed in the lift-drag plane.
+  double u = 0.0;
+
+  /// \brief Lift coefficient, signed.
+  double cl = 0.0;
+
+  /// \brief Drag coefficient.
+  double cd = 0.0;
+
+  /// \brief Span direction, normal to the lift-drag plane.
+  Vector3d spanUnit;
+
+  /// \brief Lift direction.
+  Vector3d liftUnit;
+
+  /// \brief Drag direction.
+  Vector3d dragUnit;
+};
+
+/// \brief Lift is piecewise linear and symmetric about alpha = PI/2.
+/// \param[in] _params The model parameters.
+/// \param[in] _alpha Angle of attack in [0, pi] (rad).
+inline double LiftCoefficient(const LiftDragParams &_params, double _alpha)
+{
+  auto f1 = [&](double _x)
+  {
+    return _params.cla * (_x - _params.alpha0);
+  };
+
+  auto f2 = [&](double _x)
+  {
+    if (_x < _params.alphaStall)
+      return f1(_x);
+    else
+      return _params.claStall * (_x - _params.alphaStall) +
+          f1(_params.alphaStall);
+  };
+
+  if (_alpha < M_PI / 2.0)
+    return f2(_alpha);
+  else
+    return -f2(M_PI - _alpha);
+}
+
+/// \brief Drag is piecewise linear and symmetric about alpha = PI/2.
+/// \param[in] _params The model parameters.
+/// \param[in] _alpha Angle of attack in [0, pi] (rad).
+inline double DragCoefficient(const LiftDragParams &_params, double _alpha)
+{
+  if (_alpha < M_PI / 2.0)
+    return _params.cda * _alpha;
+  else
+    return _params.cda * (M_PI - _alpha);
+}
+
+/// \brief Compute the lift and drag given the foil axes in the world
+/// frame.
+/// \param[in] _params The model parameters.
+/// \param[in] _velU Free-stream velocity (world frame).
+/// \param[in] _forwardI Foil forward direction (world frame).
+/// \param[in] _upwardI Foil upward direction (world frame).
+/// \param[in] _area Foil area.
+/// \param[out] _result The forces and coefficients.
+/// \return False if the free stream is too slow to define the angle of
+/// attack, in which case the forces are zero and the other outputs are
+/// unchanged.
+inline bool ComputeLiftDrag(const LiftDragParams &_params,
+    const Vector3d &_velU, const Vector3d &_forwardI,
+    const Vector3d &_upwardI, double _area, LiftDragResult &_result)
+{
+  // Avoid division by zero issues.
+  if (_velU.Length() <= 0.01)
+  {
+    _result.lift = Vector3d();
+    _result.drag = Vector3d();
+    return false;
+  }
+
+  // The span vector is normal to lift-drag-plane (world frame)
+  Vector3d spanI = _forwardI.Cross(_upwardI).Normalize();
+
+  // Compute the angle of attack, alpha:
+  // This is the angle between the free stream velocity
+  // projected into the lift-drag plane and the forward vector
+  Vector3d velLD = _velU - _velU.Dot(spanI) * spanI;
+
+  // Get direction of drag
+  Vector3d dragUnit = velLD.Normalized();
+
+  // Get direction of lift
+  Vector3d liftUnit = dragUnit.Cross(spanI).Normalize();
+
+  // Compute angle of attack.
+  double sgnAlpha = _forwardI.Dot(liftUnit) < 0 ? -1.0 : 1.0;
+  double cosAlpha = -_forwardI.Dot(dragUnit);
+  // lift-drag coefficients assume alpha > 0 if foil is symmetric
+  double alpha = std::acos(cosAlpha);
+
+  // Compute dynamic pressure.
+  double u = velLD.Length();
+  double q = 0.5 * _params.fluidDensity * u * u;
+
+  // Compute lift and drag.
+  double cl = LiftCoefficient(_params, alpha) * sgnAlpha;
+  double cd = DragCoefficient(_params, alpha);
+  _result.lift = cl * q * _area * liftUnit;
+  _result.drag = cd * q * _area * dragUnit;
+
+  _result.alpha = alpha;
+  _result.u = u;
+  _result.cl = cl;
+  _result.cd = cd;
+  _result.spanUnit = spanI;
+  _result.liftUnit = liftUnit;
+  _result.dragUnit = dragUnit;
+  return true;
+}
+
+/// \brief Compute the lift and drag on a foil with the model's area.
+/// \param[in] _params The model parameters.
+/// \param[in] _velU Free-stream velocity (world frame).
+/// \param[in] _bodyRot Orientation of the foil (world frame).
+/// \param[out] _result The forces and coefficients.
+/// \return False if the free stream is too slow, as above.
+inline bool ComputeLiftDrag(const LiftDragParams &_params,
+    const Vector3d &_velU, const Quaterniond &_bodyRot,
+    LiftDragResult &_result)
+{
+  return ComputeLiftDrag(_params, _velU,
+      _bodyRot.RotateVector(_params.forward),
+      _bodyRot.RotateVector(_params.upward),
+      _params.area, _result);
+}
+
+}  // namespace core
+}  // namespace asv
+
+#endif  // ASV_CORE_LIFTDRAG_HH_
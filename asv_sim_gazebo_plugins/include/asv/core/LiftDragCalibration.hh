@@ -0,0 +1,335 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ASV_CORE_LIFTDRAGCALIBRATION_HH_
+#define ASV_CORE_LIFTDRAGCALIBRATION_HH_
+
+#include <array>
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "asv/core/Boat.hh"
+#include "asv/core/LiftDrag.hh"
+
+namespace asv
+{
+namespace core
+{
+/// \brief One sample of logged data for the calibration of a sail.
+struct CalibrationSample
+{
+  /// \brief Apparent wind speed at the reference height.
+  double aws = 0.0;
+
+  /// \brief Apparent wind angle in radians, from the bow to the direction
+  /// the wind comes from in the horizontal plane, positive with the wind
+  /// on the port side.
+  double awa = 0.0;
+
+  /// \brief Heel in radians, the roll of the boat about its x axis,
+  /// positive to starboard.
+  double heel = 0.0;
+
+  /// \brief Trim (boom angle) of the sail in radians.
+  double trim = 0.0;
+
+  /// \brief Acceleration of the boat along its x and y axes due to the
+  /// sail, that is with the other forces and gravity removed.
+  double ax = 0.0;
+  double ay = 0.0;
+};
+
+/// \brief A stream of samples that can be read more than once.
+class CalibrationSource
+{
+  /// \brief Destructor.
+  public: virtual ~CalibrationSource() = default;
+
+  /// \brief Start again from the first sample.
+  /// \return True if successful.
+  public: virtual bool Rewind() = 0;
+
+  /// \brief Read the next samples.
+  /// \param[out] _samples Space for the samples.
+  /// \param[in] _count The most samples to read.
+  /// \return The number of samples read, 0 at the end.
+  public: virtual size_t Read(CalibrationSample *_samples,
+      size_t _count) = 0;
+};
+
+/// \brief Samples read from a comma separated file.
+///
+/// The first line names the columns. The columns aws, awa, heel, trim,
+/// ax and ay are required, in any order, and other columns are ignored.
+/// Lines that are empty or start with '#' are skipped, as are lines
+/// that do not parse, which are counted.
+///
+/// The file is read in blocks, so the memory depends on the number of
+/// samples read at a time and not on the size of the file. Parsing the
+/// text costs more than evaluating the model, so the lines of each read
+/// are found with one scan of the block and parsed on a thread pool.
+class CsvCalibrationSource : public CalibrationSource
+{
+  /// \brief The names of the columns, in the order of the fields of
+  /// CalibrationSample.
+  public: static constexpr std::array<const char *, 6> kColumnNames{
+      "aws", "awa", "heel", "trim", "ax", "ay"};
+
+  /// \brief Constructor.
+  /// \param[in] _threads The number of threads that parse the lines, or
+  /// 0 for one per core.
+  public: explicit CsvCalibrationSource(size_t _threads = 0);
+
+  /// \brief Open a file and read its header.
+  /// \param[in] _filename The file name.
+  /// \return False if the file cannot be read or a column is missing.
+  public: bool Open(const std::string &_filename);
+
+  // Documentation inherited
+  public: bool Rewind() override;
+
+  // Documentation inherited
+  public: size_t Read(CalibrationSample *_samples, size_t _count) override;
+
+  /// \brief The number of lines that did not parse since the last
+  /// rewind.
+  public: size_t Skipped() const;
+
+  /// \brief Parse one line.
+  /// \param[in] _begin The start of the line.
+  /// \param[in] _end The end of the line.
+  /// \param[out] _sample The sample.
+  /// \return 0 for a blank line or comment, 1 for a sample and 2 for a
+  /// line that does not parse.
+  private: int Parse(const char *_begin, const char *_end,
+      CalibrationSample &_sample) const;
+
+  /// \brief The number of threads.
+  private: size_t threads = 0;
+
+  /// \brief The file.
+  private: std::ifstream file;
+
+  /// \brief The position of the first line after the header.
+  private: std::streampos start;
+
+  /// \brief True at the end of the file.
+  private: bool eof = false;
+
+  /// \brief Text read from the file, of which [pos, size) is unread.
+  private: std::vector<char> text;
+  private: size_t pos = 0;
+  private: size_t size = 0;
+
+  /// \brief The start and end of each line of the current read, and
+  /// whether it is a sample.
+  private: std::vector<std::pair<size_t, size_t>> lines;
+  private: std::vector<int> status;
+
+  /// \brief The field of each column, or -1 if it is ignored.
+  private: std::vector<int> fields;
+
+  /// \brief The number of lines skipped.
+  private: size_t skipped = 0;
+};
+
+/// \brief Options for the calibration.
+struct LiftDragCalibrationOptions
+{
+  /// \brief Whether each parameter is fitted, in the order of
+  /// LiftDragCalibration::kParamNames. The others keep their initial
+  /// values.
+  std::array<bool, 5> fit{true, true, true, true, true};
+
+  /// \brief Most Levenberg-Marquardt iterations.
+  size_t maxIterations = 50;
+
+  /// \brief Relative tolerance of the parameters and the squared error.
+  double tolerance = 1.0e-8;
+
+  /// \brief Initial damping of the Levenberg-Marquardt steps.
+  double lambda = 1.0e-3;
+
+  /// \brief Number of samples read at a time.
+  size_t chunkSize = 65536;
+
+  /// \brief Number of threads, or 0 for one per core.
+  size_t threads = 0;
+};
+
+/// \brief The result of a calibration.
+struct LiftDragCalibrationResult
+{
+  /// \brief The fitted parameters.
+  LiftDragParams params;
+
+  /// \brief Standard error of each parameter, from the covariance of the
+  /// fit, or 0 if it is not fitted.
+  std::array<double, 5> stddev{};
+
+  /// \brief Root mean square error of the x and y forces.
+  double rms = 0.0;
+
+  /// \brief Coefficient of determination of the x and y forces.
+  double r2 = 0.0;
+
+  /// \brief Number of samples.
+  size_t samples = 0;
+
+  /// \brief Number of iterations and of passes over the samples.
+  size_t iterations = 0;
+  size_t passes = 0;
+
+  /// \brief True if the fit converged within the tolerance.
+  bool converged = false;
+};
+
+/// \brief Fit the lift and drag parameters of a sail to logged data with
+/// a Levenberg-Marquardt solver.
+///
+/// The model force is that of BoatSurface::AddWrench on a boat at rest,
+/// heeled and with the sail trimmed as logged, in the apparent wind. The
+/// residual of a sample is the model force along the body x and y axes
+/// less the mass times the logged acceleration.
+///
+/// The samples are streamed from a CalibrationSource in chunks, and each
+/// iteration is one pass over them, so the memory does not depend on
+/// the length of the log. While one chunk is read the previous one is
+/// evaluated on a thread pool in fixed blocks. A block computes the
+/// geometry of each sample and panel into flat arrays, then the forces
+/// and their analytic derivatives, and adds them to its own normal
+/// equations. The blocks are summed in order, so the result does not
+/// depend on the number of threads.
+class LiftDragCalibration
+{
+  /// \brief Names of the fitted parameters, as in the SDF.
+  public: static constexpr std::array<const char *, 5> kParamNames{
+      "a0", "cla", "alpha_stall", "cla_stall", "cda"};
+
+  /// \brief Get a fitted parameter.
+  /// \param[in] _params The parameters.
+  /// \param[in] _index The index in kParamNames.
+  public: static double Param(const LiftDragParams &_params,
+      size_t _index);
+
+  /// \brief Set a fitted parameter.
+  /// \param[in,out] _params The parameters.
+  /// \param[in] _index The index in kParamNames.
+  /// \param[in] _value The value.
+  public: static void SetParam(LiftDragParams &_params, size_t _index,
+      double _value);
+
+  /// \brief Constructor.
+  /// \param[in] _sail The sail. Its parameters other than the fitted ones
+  /// are kept.
+  /// \param[in] _mass The mass of the boat.
+  /// \param[in] _options The options.
+  public: LiftDragCalibration(const BoatSurface &_sail, double _mass,
+      const LiftDragCalibrationOptions &_options =
+          LiftDragCalibrationOptions());
+
+  /// \brief The sail.
+  public: const BoatSurface &Sail() const;
+
+  /// \brief The options.
+  public: const LiftDragCalibrationOptions &Options() const;
+
+  /// \brief The model forces of a batch of samples.
+  /// \param[in] _params The parameters.
+  /// \param[in] _samples The samples.
+  /// \param[in] _count The number of samples.
+  /// \param[out] _force The x and y force of each sample (body frame),
+  /// 2 * _count values.
+  /// \param[out] _jacobian If not null, the derivatives of the x and y
+  /// force of each sample with respect to each parameter in the order of
+  /// kParamNames, 10 * _count values.
+  public: void Evaluate(const LiftDragParams &_params,
+      const CalibrationSample *_samples, size_t _count, double *_force,
+      double *_jacobian = nullptr) const;
+
+  /// \brief Fit the parameters.
+  /// \param[in,out] _source The samples, read from the start once per
+  /// iteration.
+  /// \param[in] _initial The initial parameters.
+  /// \return The result, with the initial parameters and no samples if
+  /// the source cannot be read.
+  public: LiftDragCalibrationResult Calibrate(CalibrationSource &_source,
+      const LiftDragParams &_initial) const;
+
+  /// \brief The normal equations of the samples.
+  private: struct Normal;
+
+  /// \brief Space for the geometry of one block.
+  private: struct Scratch;
+
+  /// \brief Compute the geometry of a block of samples.
+  /// \param[in] _samples The samples.
+  /// \param[in] _count The number of samples.
+  /// \param[out] _scratch The geometry.
+  private: void Geometry(const CalibrationSample *_samples, size_t _count,
+      Scratch &_scratch) const;
+
+  /// \brief The force and its derivatives for one sample.
+  /// \param[in] _params The parameters.
+  /// \param[in] _scratch The geometry.
+  /// \param[in] _sample The sample index in the block.
+  /// \param[out] _force The x and y force.
+  /// \param[out] _jacobian The derivatives of the x and y force.
+  private: void Force(const LiftDragParams &_params,
+      const Scratch &_scratch, size_t _sample, double _force[2],
+      double _jacobian[2][5]) const;
+
+  /// \brief Add a block of samples to the normal equations.
+  private: void Accumulate(const LiftDragParams &_params,
+      const CalibrationSample *_samples, size_t _count, Scratch &_scratch,
+      Normal &_normal) const;
+
+  /// \brief One pass over the samples.
+  /// \param[in,out] _source The samples.
+  /// \param[in] _params The parameters.
+  /// \param[out] _normal The normal equations.
+  /// \return False if the source cannot be read.
+  private: bool Pass(CalibrationSource &_source,
+      const LiftDragParams &_params, Normal &_normal) const;
+
+  /// \brief The sail.
+  private: BoatSurface sail;
+
+  /// \brief The mass of the boat.
+  private: double mass = 0.0;
+
+  /// \brief The options.
+  private: LiftDragCalibrationOptions options;
+
+  /// \brief The panel centres of pressure and axes at zero trim (body
+  /// frame), split about the trim axis as in SailTrim.
+  private: std::vector<Vector3d> cpParallel;
+  private: std::vector<Vector3d> cpPerpendicular;
+  private: std::vector<Vector3d> cpCross;
+  private: std::vector<Vector3d> forwardParallel;
+  private: std::vector<Vector3d> forwardPerpendicular;
+  private: std::vector<Vector3d> forwardCross;
+  private: std::vector<Vector3d> upwardParallel;
+  private: std::vector<Vector3d> upwardPerpendicular;
+  private: std::vector<Vector3d> upwardCross;
+};
+
+}  // namespace core
+}  // namespace asv
+
+#endif  // ASV_CORE_LIFTDRAGCALIBRATION_HH_
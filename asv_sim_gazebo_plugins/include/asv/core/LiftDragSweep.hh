@@ -0,0 +1,196 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#ifndef ASV_CORE_LIFTDRAGSWEEP_HH_
+#define ASV_CORE_LIFTDRAGSWEEP_HH_
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "asv/core/Boat.hh"
+#include "asv/core/LiftDrag.hh"
+
+namespace asv
+{
+namespace core
+{
+/// \brief Values of the swept lift and drag parameters. A sweep covers
+/// every combination; an empty list keeps the value of the base
+/// parameters.
+struct LiftDragRanges
+{
+  /// \brief The parameters, in the order of LiftDragSweep::kParamNames.
+  std::array<std::vector<double>, 5> values;
+
+  /// \brief The number of combinations.
+  size_t Count() const;
+
+  /// \brief One combination.
+  /// \param[in] _base The parameters that are not swept.
+  /// \param[in] _index The index of the combination in [0, Count()),
+  /// with the first parameter varying slowest.
+  /// \return The parameters.
+  LiftDragParams Combination(const LiftDragParams &_base,
+      size_t _index) const;
+};
+
+/// \brief The fit of one set of parameters to the reference forces.
+struct LiftDragFit
+{
+  /// \brief The parameters.
+  LiftDragParams params;
+
+  /// \brief Index of the combination in the sweep.
+  size_t index = 0;
+
+  /// \brief Root mean square error of the drive and side forces.
+  double rms = 0.0;
+
+  /// \brief Coefficient of determination of the drive and side forces.
+  double r2 = 0.0;
+};
+
+/// \brief Evaluate the forces on a sail over a set of apparent winds
+/// for many values of its lift and drag parameters, to tune them.
+///
+/// The forces are those of BoatSurface::AddWrench for an upright boat
+/// with the sail at a fixed trim. The geometry of each wind and panel,
+/// the angle of attack, dynamic pressure and lift and drag directions,
+/// does not depend on the swept parameters: cla, alpha_stall,
+/// cla_stall, cda and area. It is computed once into flat arrays, so an
+/// evaluation is only the piecewise linear coefficients and a multiply
+/// and add per wind and panel.
+///
+/// Sweeps run on a thread pool and keep only the best fits, so the
+/// memory does not grow with the number of combinations.
+class LiftDragSweep
+{
+  /// \brief Names of the swept parameters, as in the SDF.
+  public: static constexpr std::array<const char *, 5> kParamNames{
+      "cla", "alpha_stall", "cla_stall", "cda", "area"};
+
+  /// \brief Get a swept parameter.
+  /// \param[in] _params The parameters.
+  /// \param[in] _index The index in kParamNames.
+  public: static double Param(const LiftDragParams &_params,
+      size_t _index);
+
+  /// \brief Set a swept parameter.
+  /// \param[in,out] _params The parameters.
+  /// \param[in] _index The index in kParamNames.
+  /// \param[in] _value The value.
+  public: static void SetParam(LiftDragParams &_params, size_t _index,
+      double _value);
+
+  /// \brief Constructor.
+  /// \param[in] _sail The sail, whose parameters are the base of the
+  /// sweep. The fluid density, forward and upward directions are kept.
+  /// \param[in] _trim The trim of the sail in radians.
+  /// \param[in] _aws Apparent wind speed of each point.
+  /// \param[in] _awa Apparent wind angle of each point in radians, from
+  /// the bow to the direction the wind comes from, positive with the
+  /// wind on the port side.
+  public: LiftDragSweep(const BoatSurface &_sail, double _trim,
+      const std::vector<double> &_aws, const std::vector<double> &_awa);
+
+  /// \brief The sail.
+  public: const BoatSurface &Sail() const;
+
+  /// \brief The number of points.
+  public: size_t Size() const;
+
+  /// \brief The forces at every point.
+  /// \param[in] _params The parameters.
+  /// \param[out] _drive The force along the body x axis at each point.
+  /// \param[out] _side The force along the body y axis at each point.
+  public: void Evaluate(const LiftDragParams &_params, double *_drive,
+      double *_side) const;
+
+  /// \brief Set the reference forces for the fits. By default they are
+  /// the forces with the parameters of the sail.
+  /// \param[in] _drive The drive at each point.
+  /// \param[in] _side The side force at each point.
+  /// \return False if the sizes do not match the points.
+  public: bool SetReference(const std::vector<double> &_drive,
+      const std::vector<double> &_side);
+
+  /// \brief The fit of one set of parameters to the reference.
+  /// \param[in] _params The parameters.
+  /// \return The fit.
+  public: LiftDragFit Fit(const LiftDragParams &_params) const;
+
+  /// \brief Fit every combination of the ranges on a thread pool.
+  /// \param[in] _ranges The parameter values.
+  /// \param[in] _best The number of fits to return.
+  /// \param[in] _threads The number of threads, or 0 for one per core.
+  /// \return The best fits, least error first.
+  public: std::vector<LiftDragFit> Sweep(const LiftDragRanges &_ranges,
+      size_t _best, size_t _threads = 0) const;
+
+  /// \brief The sensitivity of the force coefficients to each swept
+  /// parameter: the change in the drive and side forces for a relative
+  /// change in the parameter, divided by the dynamic pressure of the
+  /// wind and the sail area, by central differences.
+  /// \param[in] _params The parameters to linearise about.
+  /// \param[out] _drive For each point, the sensitivity of the drive
+  /// coefficient to each parameter.
+  /// \param[out] _side As above for the side force coefficient.
+  public: void Sensitivity(const LiftDragParams &_params,
+      std::vector<std::array<double, 5>> &_drive,
+      std::vector<std::array<double, 5>> &_side) const;
+
+  /// \brief The forces at one point.
+  /// \param[in] _params The parameters.
+  /// \param[in] _point The point index.
+  /// \param[out] _drive The force along the body x axis.
+  /// \param[out] _side The force along the body y axis.
+  private: void PointForce(const LiftDragParams &_params, size_t _point,
+      double &_drive, double &_side) const;
+
+  /// \brief The sail.
+  private: BoatSurface sail;
+
+  /// \brief The number of points and panels.
+  private: size_t points = 0;
+  private: size_t panels = 0;
+
+  /// \brief Dynamic pressure of each point.
+  private: std::vector<double> pressure;
+
+  /// \brief Angle of attack, dynamic pressure times panel area as a
+  /// fraction of the sail area, and the lift direction signed by the
+  /// angle of attack and drag direction (body x and y), of each point
+  /// and panel, point major.
+  private: std::vector<double> alpha;
+  private: std::vector<double> weight;
+  private: std::vector<double> liftX;
+  private: std::vector<double> liftY;
+  private: std::vector<double> dragX;
+  private: std::vector<double> dragY;
+
+  /// \brief Reference forces of each point.
+  private: std::vector<double> referenceDrive;
+  private: std::vector<double> referenceSide;
+
+  /// \brief Sum of squares of the reference forces about their means.
+  private: double referenceSquares = 0.0;
+};
+
+}  // namespace core
+}  // namespace asv
+
+#endif  // ASV_CORE_LIFTDRAGSWEEP_HH_
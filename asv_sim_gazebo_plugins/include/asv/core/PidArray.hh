@@ -0,0 +1,85 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ASV_CORE_PIDARRAY_HH_
+#define ASV_CORE_PIDARRAY_HH_
+
+#include <cstddef>
+#include <vector>
+
+namespace asv
+{
+namespace core
+{
+/// \brief A set of independent PID controllers stored as contiguous
+/// arrays, so a controller for many joints updates in one tight loop.
+///
+/// Each controller follows gz::math::PID: the integral term is clamped
+/// to [iMin, iMax] and the command, offset - p - i - d, is clamped to
+/// [cmdMin, cmdMax]. A limit is ignored if its max is less than its min.
+class PidArray
+{
+  /// \brief Add a controller.
+  /// \param[in] _p The proportional gain.
+  /// \param[in] _i The integral gain.
+  /// \param[in] _d The derivative gain.
+  /// \param[in] _iMax The integral upper limit.
+  /// \param[in] _iMin The integral lower limit.
+  /// \param[in] _cmdMax Output max value.
+  /// \param[in] _cmdMin Output min value.
+  /// \param[in] _cmdOffset Command offset (feed-forward).
+  /// \return The index of the controller.
+  public: size_t Add(double _p, double _i, double _d,
+      double _iMax, double _iMin, double _cmdMax, double _cmdMin,
+      double _cmdOffset = 0.0);
+
+  /// \brief The number of controllers.
+  public: size_t Size() const;
+
+  /// \brief Reset the error state of every controller.
+  public: void Reset();
+
+  /// \brief Update one controller.
+  /// \param[in] _index The controller index.
+  /// \param[in] _error The error, state - target.
+  /// \param[in] _dt The time step in seconds.
+  /// \return The command.
+  public: double Update(size_t _index, double _error, double _dt);
+
+  /// \brief Update every controller.
+  /// \param[in] _error The error of each controller.
+  /// \param[in] _dt The time step in seconds.
+  /// \param[out] _cmd The command of each controller.
+  public: void Update(const double *_error, double _dt, double *_cmd);
+
+  /// \brief Gains and limits.
+  private: std::vector<double> pGain;
+  private: std::vector<double> iGain;
+  private: std::vector<double> dGain;
+  private: std::vector<double> iMax;
+  private: std::vector<double> iMin;
+  private: std::vector<double> cmdMax;
+  private: std::vector<double> cmdMin;
+  private: std::vector<double> cmdOffset;
+
+  /// \brief Integral and previous errors.
+  private: std::vector<double> iErr;
+  private: std::vector<double> pErrLast;
+};
+
+}  // namespace core
+}  // namespace asv
+
+#endif  // ASV_CORE_PIDARRAY_HH_
@@ -0,0 +1,140 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#ifndef ASV_CORE_QUATERNION_HH_
+#define ASV_CORE_QUATERNION_HH_
+
+#include <cmath>
+
+#include "asv/core/Vector3.hh"
+
+namespace asv
+{
+namespace core
+{
+/// \brief A minimal quaternion for the force models, following
+/// gz::math::Quaterniond.
+struct Quaterniond
+{
+  /// \brief w component.
+  double w = 1.0;
+
+  /// \brief x component.
+  double x = 0.0;
+
+  /// \brief y component.
+  double y = 0.0;
+
+  /// \brief z component.
+  double z = 0.0;
+
+  /// \brief Constructor, the identity.
+  constexpr Quaterniond() = default;
+
+  /// \brief Constructor.
+  constexpr Quaterniond(double _w, double _x, double _y, double _z)
+      : w(_w), x(_x), y(_y), z(_z)
+  {
+  }
+
+  /// \brief Construct from Euler angles, in the convention of
+  /// gz::math::Quaterniond.
+  /// \param[in] _roll Rotation about x (rad).
+  /// \param[in] _pitch Rotation about y (rad).
+  /// \param[in] _yaw Rotation about z (rad).
+  static Quaterniond FromEuler(double _roll, double _pitch, double _yaw)
+  {
+    double cr = std::cos(0.5 * _roll);
+    double sr = std::sin(0.5 * _roll);
+    double cp = std::cos(0.5 * _pitch);
+    double sp = std::sin(0.5 * _pitch);
+    double cy = std::cos(0.5 * _yaw);
+    double sy = std::sin(0.5 * _yaw);
+    Quaterniond q(cr * cp * cy + sr * sp * sy,
+                  sr * cp * cy - cr * sp * sy,
+                  cr * sp * cy + sr * cp * sy,
+                  cr * cp * sy - sr * sp * cy);
+    return q.Normalize();
+  }
+
+  /// \brief Construct from an axis and angle.
+  /// \param[in] _axis The axis, need not be normalized.
+  /// \param[in] _angle The angle (rad).
+  static Quaterniond FromAxisAngle(const Vector3d &_axis, double _angle)
+  {
+    double l = _axis.Length();
+    if (l < 1.0E-6)
+      return Quaterniond();
+    double s = std::sin(0.5 * _angle) / l;
+    return Quaterniond(std::cos(0.5 * _angle),
+        _axis.x * s, _axis.y * s, _axis.z * s);
+  }
+
+  /// \brief Normalize in place, the identity if the norm is near zero.
+  /// \return The quaternion.
+  Quaterniond &Normalize()
+  {
+    double s = std::sqrt(w * w + x * x + y * y + z * z);
+    if (s < 1.0E-6)
+    {
+      *this = Quaterniond();
+      return *this;
+    }
+    this->w /= s;
+    this->x /= s;
+    this->y /= s;
+    this->z /= s;
+    return *this;
+  }
+
+  /// \brief The inverse, the identity if the norm is near zero.
+  Quaterniond Inverse() const
+  {
+    double s = w * w + x * x + y * y + z * z;
+    if (s < 1.0E-6)
+      return Quaterniond();
+    return Quaterniond(w / s, -x / s, -y / s, -z / s);
+  }
+
+  /// \brief Hamilton product.
+  constexpr Quaterniond operator*(const Quaterniond &_q) const
+  {
+    return Quaterniond(
+        w * _q.w - x * _q.x - y * _q.y - z * _q.z,
+        w * _q.x + x * _q.w + y * _q.z - z * _q.y,
+        w * _q.y - x * _q.z + y * _q.w + z * _q.x,
+        w * _q.z + x * _q.y - y * _q.x + z * _q.w);
+  }
+
+  /// \brief Rotate a vector.
+  Vector3d RotateVector(const Vector3d &_v) const
+  {
+    Quaterniond p = (*this) * (Quaterniond(0.0, _v.x, _v.y, _v.z) *
+        this->Inverse());
+    return Vector3d(p.x, p.y, p.z);
+  }
+
+  /// \brief Rotate a vector by the inverse rotation.
+  Vector3d RotateVectorReverse(const Vector3d &_v) const
+  {
+    return this->Inverse().RotateVector(_v);
+  }
+};
+
+}  // namespace core
+}  // namespace asv
+
+#endif  // ASV_CORE_QUATERNION_HH_
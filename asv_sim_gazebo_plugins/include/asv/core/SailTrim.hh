@@ -0,0 +1,154 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#ifndef ASV_CORE_SAILTRIM_HH_
+#define ASV_CORE_SAILTRIM_HH_
+
+#include <cstddef>
+#include <vector>
+
+#include "asv/core/Boat.hh"
+
+namespace asv
+{
+namespace core
+{
+/// \brief Options for the sail trim optimizer.
+struct SailTrimOptions
+{
+  /// \brief Number of points in the sweep of the trim range.
+  size_t samples = 25;
+
+  /// \brief Tolerance of the refined trim in radians.
+  double tolerance = 1.0e-4;
+
+  /// \brief Largest heeling moment, or 0 for no limit. Trims with a
+  /// larger moment are rejected, so the sail is eased to depower. For a
+  /// heel limit this is mass * gravity * metacentric height *
+  /// sin(heel).
+  double maxHeelingMoment = 0.0;
+
+  /// \brief Direction of the drive (body frame, unit).
+  Vector3d forward{1.0, 0.0, 0.0};
+};
+
+/// \brief The forces on a sail at a trim.
+struct SailTrimResult
+{
+  /// \brief Trim angle in radians.
+  double trim = 0.0;
+
+  /// \brief Force along SailTrimOptions::forward.
+  double drive = 0.0;
+
+  /// \brief Side force along the body y axis.
+  double side = 0.0;
+
+  /// \brief Heeling moment about the body x axis through the body
+  /// origin.
+  double heelingMoment = 0.0;
+
+  /// \brief True if the heeling moment is within the limit.
+  bool feasible = true;
+};
+
+/// \brief Find the trim of a sail that gives the most drive in an
+/// apparent wind, optionally with a limit on the heeling moment.
+///
+/// The forces are those of BoatSurface::AddWrench for a boat that is
+/// upright and not turning, with the wind shear of the surface, so a
+/// sail loaded with asv::LoadBoat has the parameters of its SailLiftDrag
+/// plugin. The panels are rotated about the trim axis in closed form,
+/// so a sweep evaluates the lift and drag of every panel at every trim
+/// in one loop with no allocation. The optimizer sweeps the trim range
+/// and refines the best feasible trim by a golden section search
+/// bracketed by its neighbours in the sweep, which takes a few
+/// microseconds for a sail with a few panels.
+///
+/// The optimizer is immutable after construction and may be used from
+/// several threads.
+class SailTrim
+{
+  /// \brief Constructor.
+  /// \param[in] _sail The sail. If it is not trimmable the trim is 0.
+  /// \param[in] _options The options.
+  public: explicit SailTrim(const BoatSurface &_sail,
+      const SailTrimOptions &_options = SailTrimOptions());
+
+  /// \brief The sail.
+  public: const BoatSurface &Sail() const;
+
+  /// \brief The options.
+  public: const SailTrimOptions &Options() const;
+
+  /// \brief The best trim for an apparent wind.
+  /// \param[in] _wind The apparent wind velocity at the reference height
+  /// (body frame), the direction the wind blows towards.
+  /// \return The trim and its forces. If no trim is within the heeling
+  /// moment limit, the trim with the least heeling moment, marked not
+  /// feasible.
+  public: SailTrimResult Optimize(const Vector3d &_wind) const;
+
+  /// \brief The best trim for an apparent wind speed and angle.
+  /// \param[in] _aws Apparent wind speed.
+  /// \param[in] _awa Apparent wind angle in radians, from the bow to the
+  /// direction the wind comes from, positive with the wind on the port
+  /// side.
+  /// \return The trim and its forces.
+  public: SailTrimResult Optimize(double _aws, double _awa) const;
+
+  /// \brief The forces at a batch of trims.
+  /// \param[in] _wind The apparent wind velocity (body frame).
+  /// \param[in] _trim The trims in radians.
+  /// \param[in] _count The number of trims.
+  /// \param[out] _drive The drive at each trim.
+  /// \param[out] _heelingMoment The heeling moment at each trim.
+  public: void Evaluate(const Vector3d &_wind, const double *_trim,
+      size_t _count, double *_drive, double *_heelingMoment) const;
+
+  /// \brief The forces at one trim.
+  /// \param[in] _wind The apparent wind velocity (body frame).
+  /// \param[in] _trim The trim in radians.
+  /// \return The forces.
+  public: SailTrimResult Evaluate(const Vector3d &_wind,
+      double _trim) const;
+
+  /// \brief The sail.
+  private: BoatSurface sail;
+
+  /// \brief The options.
+  private: SailTrimOptions options;
+
+  /// \brief Each panel's centre of pressure relative to the trim
+  /// origin, forward and upward directions at zero trim (body frame),
+  /// split into the components parallel and perpendicular to the trim
+  /// axis and the cross product with the axis, so that the rotation by
+  /// a trim is parallel + cos * perpendicular + sin * cross.
+  private: std::vector<Vector3d> cpParallel;
+  private: std::vector<Vector3d> cpPerpendicular;
+  private: std::vector<Vector3d> cpCross;
+  private: std::vector<Vector3d> forwardParallel;
+  private: std::vector<Vector3d> forwardPerpendicular;
+  private: std::vector<Vector3d> forwardCross;
+  private: std::vector<Vector3d> upwardParallel;
+  private: std::vector<Vector3d> upwardPerpendicular;
+  private: std::vector<Vector3d> upwardCross;
+};
+
+}  // namespace core
+}  // namespace asv
+
+#endif  // ASV_CORE_SAILTRIM_HH_
@@ -0,0 +1,172 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#ifndef ASV_CORE_VECTOR3_HH_
+#define ASV_CORE_VECTOR3_HH_
+
+#include <cmath>
+
+namespace asv
+{
+namespace core
+{
+/// \brief A minimal 3 vector for the force models, so they build and
+/// inline without gz-math.
+///
+/// The operations follow gz::math::Vector3d, including Normalize
+/// leaving a vector of near zero length unchanged.
+struct Vector3d
+{
+  /// \brief x component.
+  double x = 0.0;
+
+  /// \brief y component.
+  double y = 0.0;
+
+  /// \brief z component.
+  double z = 0.0;
+
+  /// \brief Constructor, the zero vector.
+  constexpr Vector3d() = default;
+
+  /// \brief Constructor.
+  constexpr Vector3d(double _x, double _y, double _z)
+      : x(_x), y(_y), z(_z)
+  {
+  }
+
+  /// \brief Dot product.
+  constexpr double Dot(const Vector3d &_v) const
+  {
+    return this->x * _v.x + this->y * _v.y + this->z * _v.z;
+  }
+
+  /// \brief Cross product.
+  constexpr Vector3d Cross(const Vector3d &_v) const
+  {
+    return Vector3d(this->y * _v.z - this->z * _v.y,
+                    this->z * _v.x - this->x * _v.z,
+                    this->x * _v.y - this->y * _v.x);
+  }
+
+  /// \brief Squared length.
+  constexpr double SquaredLength() const
+  {
+    return this->Dot(*this);
+  }
+
+  /// \brief Length.
+  double Length() const
+  {
+    return std::sqrt(this->SquaredLength());
+  }
+
+  /// \brief Normalize in place, unless the length is near zero.
+  /// \return The vector.
+  Vector3d &Normalize()
+  {
+    double d = this->Length();
+    if (std::fabs(d) > 1.0E-6)
+    {
+      this->x /= d;
+      this->y /= d;
+      this->z /= d;
+    }
+    return *this;
+  }
+
+  /// \brief A normalized copy, unless the length is near zero.
+  Vector3d Normalized() const
+  {
+    Vector3d v = *this;
+    return v.Normalize();
+  }
+
+  /// \brief True if all components are finite.
+  bool IsFinite() const
+  {
+    return std::isfinite(this->x) && std::isfinite(this->y) &&
+        std::isfinite(this->z);
+  }
+
+  /// \brief Addition.
+  constexpr Vector3d operator+(const Vector3d &_v) const
+  {
+    return Vector3d(this->x + _v.x, this->y + _v.y, this->z + _v.z);
+  }
+
+  /// \brief Subtraction.
+  constexpr Vector3d operator-(const Vector3d &_v) const
+  {
+    return Vector3d(this->x - _v.x, this->y - _v.y, this->z - _v.z);
+  }
+
+  /// \brief Negation.
+  constexpr Vector3d operator-() const
+  {
+    return Vector3d(-this->x, -this->y, -this->z);
+  }
+
+  /// \brief Scale.
+  constexpr Vector3d operator*(double _s) const
+  {
+    return Vector3d(this->x * _s, this->y * _s, this->z * _s);
+  }
+
+  /// \brief Divide.
+  constexpr Vector3d operator/(double _s) const
+  {
+    return Vector3d(this->x / _s, this->y / _s, this->z / _s);
+  }
+
+  /// \brief Add in place.
+  Vector3d &operator+=(const Vector3d &_v)
+  {
+    this->x += _v.x;
+    this->y += _v.y;
+    this->z += _v.z;
+    return *this;
+  }
+
+  /// \brief Subtract in place.
+  Vector3d &operator-=(const Vector3d &_v)
+  {
+    this->x -= _v.x;
+    this->y -= _v.y;
+    this->z -= _v.z;
+    return *this;
+  }
+
+  /// \brief Scale in place.
+  Vector3d &operator*=(double _s)
+  {
+    this->x *= _s;
+    this->y *= _s;
+    this->z *= _s;
+    return *this;
+  }
+};
+
+/// \brief Scale.
+constexpr Vector3d operator*(double _s, const Vector3d &_v)
+{
+  return _v * _s;
+}
+
+}  // namespace core
+}  // namespace asv
+
+#endif  // ASV_CORE_VECTOR3_HH_
@@ -0,0 +1,210 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#ifndef ASV_CORE_VPP_HH_
+#define ASV_CORE_VPP_HH_
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "asv/core/Boat.hh"
+
+namespace asv
+{
+namespace core
+{
+/// \brief Options for the velocity prediction program.
+struct VppOptions
+{
+  /// \brief Acceleration due to gravity.
+  double gravity = 9.80665;
+
+  /// \brief Largest heel in radians, or 0 for no limit. Trims that heel
+  /// the boat further are rejected, so the sails are eased to depower.
+  double maxHeel = 0.0;
+
+  /// \brief Number of points in the initial sweep of each trim.
+  size_t trimSamples = 13;
+
+  /// \brief Tolerance of the trim search in radians.
+  double trimTolerance = 1.0e-3;
+
+  /// \brief Number of passes over the trims when there is more than one
+  /// trimmable sail.
+  size_t trimPasses = 2;
+
+  /// \brief Largest number of Newton iterations of the force balance.
+  size_t maxIterations = 50;
+
+  /// \brief Tolerance of the force balance, relative to the dynamic
+  /// pressure of the true wind on the sail area.
+  double tolerance = 1.0e-6;
+
+  /// \brief Number of threads for a polar, or 0 for one per core.
+  size_t threads = 0;
+};
+
+/// \brief A steady sailing state.
+struct VppPoint
+{
+  /// \brief True wind speed.
+  double tws = 0.0;
+
+  /// \brief True wind angle in radians, from the course to the
+  /// direction the wind comes from, positive with the wind on the port
+  /// side.
+  double twa = 0.0;
+
+  /// \brief Boat speed through the water.
+  double speed = 0.0;
+
+  /// \brief Velocity made good, towards the wind.
+  double vmg = 0.0;
+
+  /// \brief Leeway in radians, from the heading to the course.
+  double leeway = 0.0;
+
+  /// \brief Heel in radians, the roll of the body.
+  double heel = 0.0;
+
+  /// \brief Apparent wind speed and angle (radians, from the heading).
+  double aws = 0.0;
+  double awa = 0.0;
+
+  /// \brief Trim of each trimmable sail in radians, in the order of
+  /// Boat::surfaces.
+  std::vector<double> trim;
+
+  /// \brief Unbalanced yaw moment, which the rudder would have to
+  /// balance.
+  double yawMoment = 0.0;
+
+  /// \brief True if the force balance converged.
+  bool converged = false;
+};
+
+/// \brief A velocity prediction program: the steady boat speed, leeway
+/// and heel for a true wind, found by balancing the surge and sway
+/// forces and the heeling moment, with the sails trimmed for the
+/// largest speed.
+///
+/// The forces are those of the simulation: each surface is evaluated
+/// with BoatSurface::AddWrench, the hull resistance with
+/// BoatHull::Resistance and the righting moment is from the metacentric
+/// height. Pitch and yaw are not balanced; the yaw moment the rudder
+/// would have to balance is reported.
+///
+/// Each point is solved independently, so a polar is the same whatever
+/// the number of threads.
+class Vpp
+{
+  /// \brief Constructor.
+  /// \param[in] _boat The boat.
+  /// \param[in] _options The options.
+  public: explicit Vpp(const Boat &_boat,
+      const VppOptions &_options = VppOptions());
+
+  /// \brief The boat.
+  public: const Boat &BoatModel() const;
+
+  /// \brief The options.
+  public: const VppOptions &Options() const;
+
+  /// \brief Solve for one true wind, trimming the sails.
+  /// \param[in] _tws True wind speed.
+  /// \param[in] _twa True wind angle in radians.
+  /// \return The sailing state.
+  public: VppPoint Solve(double _tws, double _twa) const;
+
+  /// \brief Solve for one true wind with fixed trims.
+  /// \param[in] _tws True wind speed.
+  /// \param[in] _twa True wind angle in radians.
+  /// \param[in] _trim Trim of each trimmable sail in radians.
+  /// \return The sailing state.
+  public: VppPoint Solve(double _tws, double _twa,
+      const std::vector<double> &_trim) const;
+
+  /// \brief Solve a polar on a thread pool.
+  /// \param[in] _tws True wind speeds.
+  /// \param[in] _twa True wind angles in radians.
+  /// \return The points ordered by wind speed then angle.
+  public: std::vector<VppPoint> Polar(const std::vector<double> &_tws,
+      const std::vector<double> &_twa) const;
+
+  /// \brief The net force and moment on the boat.
+  /// \param[in] _tws True wind speed.
+  /// \param[in] _twa True wind angle in radians.
+  /// \param[in] _trim Trim of each trimmable sail in radians.
+  /// \param[in] _speed Boat speed.
+  /// \param[in] _leeway Leeway in radians.
+  /// \param[in] _heel Heel in radians.
+  /// \param[out] _force Force (heading frame: x forward, z up).
+  /// \param[out] _torque Torque about the body origin (heading frame).
+  public: void Wrench(double _tws, double _twa,
+      const std::vector<double> &_trim,
+      double _speed, double _leeway, double _heel,
+      Vector3d &_force, Vector3d &_torque) const;
+
+  /// \brief Solve the force balance with a damped Newton method.
+  /// \param[in] _tws True wind speed.
+  /// \param[in] _twa True wind angle in radians.
+  /// \param[in] _trim Trim of each trimmable sail in radians.
+  /// \param[in,out] _x Speed, leeway and heel, on input the first guess.
+  /// \return True if converged.
+  private: bool Balance(double _tws, double _twa,
+      const std::vector<double> &_trim, std::array<double, 3> &_x) const;
+
+  /// \brief Solve the force balance from a list of first guesses.
+  /// \param[in] _tws True wind speed.
+  /// \param[in] _twa True wind angle in radians.
+  /// \param[in] _trim Trim of each trimmable sail in radians.
+  /// \param[in,out] _x Speed, leeway and heel, on input the first guess
+  /// and on output the solution if converged.
+  /// \return True if converged.
+  private: bool BalanceFrom(double _tws, double _twa,
+      const std::vector<double> &_trim, std::array<double, 3> &_x) const;
+
+  /// \brief Solve the force balance and fill in a sailing state.
+  /// \param[in] _tws True wind speed.
+  /// \param[in] _twa True wind angle in radians.
+  /// \param[in] _trim Trim of each trimmable sail in radians.
+  /// \param[in] _x First guess of the speed, leeway and heel.
+  /// \return The sailing state.
+  private: VppPoint Point(double _tws, double _twa,
+      const std::vector<double> &_trim, std::array<double, 3> _x) const;
+
+  /// \brief The boat.
+  private: Boat boat;
+
+  /// \brief The options.
+  private: VppOptions options;
+
+  /// \brief Index of each trimmable sail in boat.surfaces.
+  private: std::vector<size_t> trimmed;
+
+  /// \brief Half the air density times the sail area, which scales the
+  /// force residuals with the square of the wind speed.
+  private: double sailScale = 1.0;
+
+  /// \brief Length that scales the moment residual.
+  private: double lengthScale = 1.0;
+};
+
+}  // namespace core
+}  // namespace asv
+
+#endif  // ASV_CORE_VPP_HH_
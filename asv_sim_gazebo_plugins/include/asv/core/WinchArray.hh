@@ -0,0 +1,118 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ASV_CORE_WINCHARRAY_HH_
+#define ASV_CORE_WINCHARRAY_HH_
+
+#include <cstddef>
+#include <vector>
+
+namespace asv
+{
+namespace core
+{
+/// \brief The limits and rope properties of a sheet winch.
+///
+/// The sheet is expressed in the coordinate of the joint it controls,
+/// so for a boom joint a length is the largest angle the sheet allows
+/// (rad), the stiffness is in N m / rad and the force is a joint torque.
+struct WinchParams
+{
+  /// \brief Fastest rate the sheet is hauled in or eased.
+  double maxSpeed = 0.5;
+
+  /// \brief Largest tension the winch holds before the sheet slips.
+  double maxForce = 1000.0;
+
+  /// \brief Largest power available to haul in, zero for no limit.
+  double maxPower = 0.0;
+
+  /// \brief Sheet stiffness.
+  double stiffness = 10000.0;
+
+  /// \brief Sheet damping, only while the sheet is under tension.
+  double damping = 100.0;
+
+  /// \brief Winch speed per unit of length error.
+  double gain = 5.0;
+};
+
+/// \brief A set of sheet winches stored as contiguous arrays, so a
+/// controller for many sails updates them in one tight loop.
+///
+/// Each winch pays out a sheet length L towards its target at a speed
+/// limited by maxSpeed and, when hauling in under tension, by maxPower.
+/// The sheet is a tension-only spring and damper: it pulls the joint
+/// towards zero when |position| > L and is slack otherwise. If the
+/// tension exceeds maxForce the sheet slips on the drum, paying out
+/// until the tension is back at the limit.
+class WinchArray
+{
+  /// \brief Add a winch.
+  /// \param[in] _params The winch limits and sheet properties.
+  /// \param[in] _length The initial sheet length.
+  /// \return The index of the winch.
+  public: size_t Add(const WinchParams &_params, double _length = 0.0);
+
+  /// \brief The number of winches.
+  public: size_t Size() const;
+
+  /// \brief Reset every winch to a sheet length.
+  /// \param[in] _length The sheet length.
+  public: void Reset(double _length);
+
+  /// \brief The sheet length of a winch.
+  /// \param[in] _index The winch index.
+  public: double Length(size_t _index) const;
+
+  /// \brief The sheet tension of a winch from the last update.
+  /// \param[in] _index The winch index.
+  public: double Tension(size_t _index) const;
+
+  /// \brief Update one winch.
+  /// \param[in] _index The winch index.
+  /// \param[in] _target The target sheet length.
+  /// \param[in] _position The joint position.
+  /// \param[in] _dt The time step in seconds.
+  /// \return The joint force.
+  public: double Update(size_t _index, double _target, double _position,
+      double _dt);
+
+  /// \brief Update every winch.
+  /// \param[in] _target The target sheet length of each winch.
+  /// \param[in] _position The joint position of each winch.
+  /// \param[in] _dt The time step in seconds.
+  /// \param[out] _force The joint force of each winch.
+  public: void Update(const double *_target, const double *_position,
+      double _dt, double *_force);
+
+  /// \brief Limits and sheet properties.
+  private: std::vector<double> maxSpeed;
+  private: std::vector<double> maxForce;
+  private: std::vector<double> maxPower;
+  private: std::vector<double> stiffness;
+  private: std::vector<double> damping;
+  private: std::vector<double> gain;
+
+  /// \brief Sheet length, tension and the last |position|.
+  private: std::vector<double> length;
+  private: std::vector<double> tension;
+  private: std::vector<double> extentLast;
+};
+
+}  // namespace core
+}  // namespace asv
+
+#endif  // ASV_CORE_WINCHARRAY_HH_
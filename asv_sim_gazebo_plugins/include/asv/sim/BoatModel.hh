@@ -0,0 +1,66 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#ifndef ASV_SIM_BOATMODEL_HH_
+#define ASV_SIM_BOATMODEL_HH_
+
+#include <memory>
+#include <string>
+
+#include <sdf/sdf.hh>
+
+#include "asv/core/Boat.hh"
+
+namespace asv
+{
+/// \brief Find a model by name, or the first model, in the root of a
+/// file or its first world.
+/// \param[in] _root The root <sdf> element.
+/// \param[in] _name The model name, or empty for the first model.
+/// \return The <model> element, or null if not found.
+sdf::ElementPtr FindModel(const sdf::ElementPtr &_root,
+    const std::string &_name);
+
+/// \brief Load the description of a boat for the offline tools from a
+/// <model> element, so they use the parameters of the simulation.
+///
+/// - Each SailLiftDrag and FoilLiftDrag plugin of the model adds a
+///   surface with the lift and drag parameters of asv::LiftDragModel and
+///   the <cp> or <strips> of the plugin. The wind shear parameters are
+///   used for strips only, as in the plugin.
+/// - A surface on a revolute joint turns about the joint axis, within
+///   the joint limits, with the joint damping and the moment of inertia
+///   of its link about the axis. The VPP trims the sails only.
+/// - The hull mass, centre of mass and inertia about the centre of mass
+///   are the totals of the links.
+/// - Each Mooring plugin adds a mooring at the origin of its link.
+/// - Each joint of a SailPositionController plugin adds a controller
+///   for the sail on that joint, with the gains and winch of the plugin.
+/// - The initial pose of the boat is the model pose.
+///
+/// Link poses are taken to be relative to the model frame, and the
+/// joint pose and axis relative to the child link. The hull resistance,
+/// metacentric heights and waterplane are left at their defaults since
+/// they come from the hydrodynamics, which are not modelled offline.
+/// \param[in] _model The <model> element.
+/// \param[out] _boat The boat.
+/// \return True if successful.
+bool LoadBoat(const std::shared_ptr<const sdf::Element> &_model,
+    core::Boat &_boat);
+
+}  // namespace asv
+
+#endif  // ASV_SIM_BOATMODEL_HH_
@@ -0,0 +1,53 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#ifndef ASV_SIM_CORETYPES_HH_
+#define ASV_SIM_CORETYPES_HH_
+
+#include <gz/math/Quaternion.hh>
+#include <gz/math/Vector3.hh>
+
+#include "asv/core/Quaternion.hh"
+#include "asv/core/Vector3.hh"
+
+namespace asv
+{
+/// \brief Convert a gz-math vector to the core type.
+inline core::Vector3d ToCore(const gz::math::Vector3d &_v)
+{
+  return core::Vector3d(_v.X(), _v.Y(), _v.Z());
+}
+
+/// \brief Convert a gz-math quaternion to the core type.
+inline core::Quaterniond ToCore(const gz::math::Quaterniond &_q)
+{
+  return core::Quaterniond(_q.W(), _q.X(), _q.Y(), _q.Z());
+}
+
+/// \brief Convert a core vector to gz-math.
+inline gz::math::Vector3d ToGz(const core::Vector3d &_v)
+{
+  return gz::math::Vector3d(_v.x, _v.y, _v.z);
+}
+
+/// \brief Convert a core quaternion to gz-math.
+inline gz::math::Quaterniond ToGz(const core::Quaterniond &_q)
+{
+  return gz::math::Quaterniond(_q.w, _q.x, _q.y, _q.z);
+}
+}  // namespace asv
+
+#endif  // ASV_SIM_CORETYPES_HH_
@@ -0,0 +1,77 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ASV_SIM_FLEETWORLD_HH_
+#define ASV_SIM_FLEETWORLD_HH_
+
+#include <cstddef>
+#include <string>
+
+namespace asv
+{
+
+/// \brief Options for a generated fleet world.
+struct FleetWorldOptions
+{
+  /// \brief World name.
+  std::string name = "fleet";
+
+  /// \brief Number of vessels, laid out on a square grid.
+  size_t boats = 1;
+
+  /// \brief Distance between neighbouring vessels.
+  double spacing = 20.0;
+
+  /// \brief Physics step size in seconds.
+  double stepSize = 0.001;
+
+  /// \brief Wind velocity (world frame), x and y components.
+  double windX = 0.0;
+  double windY = -10.0;
+
+  /// \brief Add a sail with SailLiftDrag to each vessel.
+  bool sails = true;
+
+  /// \brief Add a SailPositionController for the sail.
+  bool controllers = true;
+
+  /// \brief Add a keel with FoilLiftDrag to each vessel.
+  bool foils = true;
+
+  /// \brief Add an anemometer to each vessel.
+  bool anemometers = true;
+
+  /// \brief Moor each vessel with the Mooring system.
+  bool moorings = true;
+
+  /// \brief Add the Metrics system to the world.
+  bool metrics = false;
+};
+
+/// \brief Generate an SDF world with a fleet of identical vessels for
+/// benchmarks and integration tests.
+///
+/// Based on the mooring and anemometer example worlds: each vessel is a
+/// floating box hull (graded buoyancy, no wave model) with a sail on a
+/// revolute joint, a keel, an anemometer and a mooring with the anchor
+/// offset from the vessel so the catenary solver runs every step. The
+/// world has no rendering systems so it can be run headless.
+/// \param[in] _options The options.
+/// \return The SDF world as a string.
+std::string GenerateFleetWorld(const FleetWorldOptions &_options);
+
+}  // namespace asv
+
+#endif  // ASV_SIM_FLEETWORLD_HH_
@@ -0,0 +1,192 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ASV_SIM_FLIGHTRECORDER_HH_
+#define ASV_SIM_FLIGHTRECORDER_HH_
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace asv
+{
+/// \brief The maximum number of values in a flight record.
+constexpr size_t kFlightRecordValues = 12;
+
+/// \brief A record decoded from a flight recorder file.
+struct FlightRecord
+{
+  /// \brief Position in the order records were written.
+  uint64_t sequence{0};
+
+  /// \brief Simulation time in seconds.
+  double time{0.0};
+
+  /// \brief The entity.
+  uint64_t entity{0};
+
+  /// \brief The record type, a FlightRecorder::Type.
+  uint16_t type{0};
+
+  /// \brief Number of values.
+  uint16_t count{0};
+
+  /// \brief The values.
+  std::array<double, kFlightRecordValues> values{};
+};
+
+/// \brief The contents of a flight recorder file.
+struct FlightLog
+{
+  /// \brief True if the recorder was frozen.
+  bool frozen{false};
+
+  /// \brief Simulation time of the freeze.
+  double frozenTime{0.0};
+
+  /// \brief Reason given for the freeze.
+  std::string reason;
+
+  /// \brief Number of slots in the ring.
+  size_t numSlots{0};
+
+  /// \brief The complete records, oldest first.
+  std::vector<FlightRecord> records;
+};
+
+/// \brief An always-on ring of the most recent per-step state, in a
+/// memory-mapped file, for post-mortem debugging of diverging runs.
+///
+/// Systems write a compact fixed-size record each step. A record is
+/// copied into the next slot of the ring, so the file always holds the
+/// last numSlots records and writing costs no more than a few stores.
+/// When a system detects a non-finite force or a solver failure it
+/// calls Freeze: later records are ignored so the state leading up to
+/// the failure is kept, and the file is synced to disk. The mapping is
+/// shared so the file also survives a crash. The file is removed when
+/// a recorder that was not frozen is closed.
+///
+/// Files are decoded with Read or the asv_sim_flight_decode tool.
+class FlightRecorder
+{
+  /// \brief Record types.
+  public: enum Type : uint16_t
+  {
+    /// \brief alpha, speed, cl, cd, lift x, y, z and drag x, y, z.
+    kLiftDrag = 1,
+
+    /// \brief Chain force x, y, z on the link and v, h distances to
+    /// the anchor.
+    kMooring = 2,
+
+    /// \brief command, position and force of a sail joint.
+    kSailController = 3
+  };
+
+  /// \brief The process-wide recorder. On first use it is opened on
+  /// the file named by the ASV_SIM_FLIGHT_RECORDER environment
+  /// variable, or asv_sim_flight_<pid>.ring in the temporary directory
+  /// if not set. Set the variable to "off" to disable it.
+  public: static FlightRecorder &Instance();
+
+  /// \brief Constructor.
+  public: FlightRecorder();
+
+  /// \brief Destructor. Closes the file.
+  public: ~FlightRecorder();
+
+  /// \brief Not copyable, the recorder owns the mapping.
+  public: FlightRecorder(const FlightRecorder &) = delete;
+  public: FlightRecorder &operator=(const FlightRecorder &) = delete;
+
+  /// \brief Open and map a file, replacing any existing file.
+  /// \param[in] _path The file path.
+  /// \param[in] _numSlots The number of records in the ring.
+  /// \return True if successful.
+  public: bool Open(const std::string &_path, size_t _numSlots);
+
+  /// \brief Unmap the file, removing it unless frozen.
+  public: void Close();
+
+  /// \brief True if a file is mapped.
+  public: bool IsOpen() const;
+
+  /// \brief The path of the file.
+  public: const std::string &Path() const;
+
+  /// \brief Write a record. Safe to call from several threads, and a
+  /// no-op if closed or frozen.
+  /// \param[in] _type The record type.
+  /// \param[in] _time Simulation time in seconds.
+  /// \param[in] _entity The entity.
+  /// \param[in] _values The values.
+  /// \param[in] _count The number of values, at most
+  /// kFlightRecordValues.
+  public: void Write(uint16_t _type, double _time, uint64_t _entity,
+      const double *_values, size_t _count);
+
+  /// \brief Stop recording and sync the file to disk.
+  /// \param[in] _reason A description of the failure.
+  /// \param[in] _time Simulation time in seconds.
+  /// \return True if this call froze the recorder.
+  public: bool Freeze(const std::string &_reason, double _time);
+
+  /// \brief True if frozen.
+  public: bool Frozen() const;
+
+  /// \brief Read a flight recorder file.
+  /// \param[in] _path The file path.
+  /// \param[out] _log The contents.
+  /// \return True if successful.
+  public: static bool Read(const std::string &_path, FlightLog &_log);
+
+  /// \brief The name of a record type.
+  /// \param[in] _type The record type.
+  public: static std::string TypeName(uint16_t _type);
+
+  /// \brief The value names of a record type.
+  /// \param[in] _type The record type.
+  public: static std::vector<std::string> FieldNames(uint16_t _type);
+
+  /// \brief Layout of the mapped file.
+  private: struct Header;
+  private: struct Slot;
+
+  /// \brief The file path.
+  private: std::string path;
+
+  /// \brief File descriptor, -1 if closed.
+  private: int fd{-1};
+
+  /// \brief The mapping.
+  private: void *map{nullptr};
+
+  /// \brief Size of the mapping.
+  private: size_t mapSize{0};
+
+  /// \brief The header at the start of the mapping.
+  private: Header *header{nullptr};
+
+  /// \brief The ring after the header.
+  private: Slot *slots{nullptr};
+
+  /// \brief Number of slots.
+  private: uint64_t numSlots{0};
+};
+
+}  // namespace asv
+
+#endif  // ASV_SIM_FLIGHTRECORDER_HH_
@@ -34,18 +34,26 @@
 #ifndef ASV_SIM_LIFTDRAGMODEL_HH_
 #define ASV_SIM_LIFTDRAGMODEL_HH_
 
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 #include <gz/math/Pose3.hh>
+#include <gz/math/Quaternion.hh>
 #include <gz/math/Vector3.hh>
 
 #include <sdf/sdf.hh>
 
+#include "asv/core/LiftDrag.hh"
+
 namespace asv
 {
 class LiftDragModelPrivate;
 
 /// \brief A class to calculate lift / drag.
+///
+/// This is the SDF and gz-math adapter for the kernels in
+/// asv/core/LiftDrag.hh, which code outside gz-sim can use directly.
 class LiftDragModel
 {
   /// \brief Destructor.
@@ -59,6 +67,19 @@ class LiftDragModel
   public: static LiftDragModel* Create(
       const std::shared_ptr<const sdf::Element> &_sdf);
 
+  /// \brief Create a new LiftDragModel from core parameters.
+  /// \param[in] _params The parameters.
+  public: static LiftDragModel* Create(const core::LiftDragParams &_params);
+
+  /// \brief Load the core parameters from SDF.
+  /// \param[in] _sdf A pointer to an SDF element containing parameters.
+  /// \param[in,out] _params The parameters, unchanged where the element
+  /// does not set them.
+  /// \return False if the parameters are not supported.
+  public: static bool LoadParams(
+      const std::shared_ptr<const sdf::Element> &_sdf,
+      core::LiftDragParams &_params);
+
   /// \brief Compute the lift and drag forces in the world frame.
   /// param[in] _velU     Free-stream velocity vector.
   /// param[out] _lift    Lift vector.
@@ -87,6 +108,59 @@ class LiftDragModel
     double &_cl,
     double &_cd) const;
 
+  /// \brief Compute the lift and drag forces in the world frame for
+  /// a batch of surfaces that share this model's coefficients, for
+  /// instance the spanwise strips of a sail.
+  ///
+  /// The output vectors are resized to match the inputs, so reusing
+  /// them between calls avoids any allocation.
+  /// param[in] _velU     Free-stream velocity vector for each surface.
+  /// param[in] _bodyRot  Orientation of each surface (world frame).
+  /// param[in] _area     Area of each surface.
+  /// param[out] _lift    Lift vector for each surface.
+  /// param[out] _drag    Drag vector for each surface.
+  /// param[out] _alpha   If not null, the angle of attack of each surface,
+  ///                     0 where the free stream is too slow.
+  /// param[out] _u       If not null, the free-stream speed, as above.
+  /// param[out] _cl      If not null, the lift coefficient, as above.
+  /// param[out] _cd      If not null, the drag coefficient, as above.
+  public: void Compute(
+    const std::vector<gz::math::Vector3d> &_velU,
+    const std::vector<gz::math::Quaterniond> &_bodyRot,
+    const std::vector<double> &_area,
+    std::vector<gz::math::Vector3d> &_lift,
+    std::vector<gz::math::Vector3d> &_drag,
+    std::vector<double> *_alpha = nullptr,
+    std::vector<double> *_u = nullptr,
+    std::vector<double> *_cl = nullptr,
+    std::vector<double> *_cd = nullptr) const;
+
+  /// \brief Compute the lift and drag forces in the world frame for
+  /// a batch of surfaces held in flat arrays, for instance NumPy arrays
+  /// from the Python bindings, without copying them.
+  /// param[in] _count    The number of surfaces.
+  /// param[in] _velU     Free-stream velocity of each surface, x, y, z.
+  /// param[in] _bodyRot  Orientation of each surface (world frame), w, x,
+  ///                     y, z, or null for the identity.
+  /// param[in] _area     Area of each surface, or null for the model
+  ///                     area.
+  /// param[out] _lift    Lift of each surface, x, y, z.
+  /// param[out] _drag    Drag of each surface, x, y, z.
+  /// param[out] _alpha   If not null, the angle of attack of each surface,
+  ///                     0 where the free stream is too slow.
+  /// param[out] _cl      If not null, the lift coefficient, as above.
+  /// param[out] _cd      If not null, the drag coefficient, as above.
+  public: void Compute(
+    size_t _count,
+    const double *_velU,
+    const double *_bodyRot,
+    const double *_area,
+    double *_lift,
+    double *_drag,
+    double *_alpha = nullptr,
+    double *_cl = nullptr,
+    double *_cd = nullptr) const;
+
   /// \brief The lift coefficient as a function of the angle of attack.
   /// \param[in] _alpha Angle of attack in radians.
   public: double LiftCoefficient(double _alpha) const;
@@ -95,6 +169,41 @@ class LiftDragModel
   /// \param[in] _alpha Angle of attack in radians.
   public: double DragCoefficient(double _alpha) const;
 
+  /// \brief The foil area.
+  public: double Area() const;
+
+  /// \brief The fluid density.
+  public: double FluidDensity() const;
+
+  /// \brief The foil forward direction (body frame).
+  public: const gz::math::Vector3d &Forward() const;
+
+  /// \brief The foil upward direction (body frame).
+  public: const gz::math::Vector3d &Upward() const;
+
+  /// \brief The core parameters.
+  public: const core::LiftDragParams &Params() const;
+
+  /// \brief Trace each computation on the "LiftDragModel" channel of
+  /// asv::Tracer for an entity, usually the link the foil is attached to.
+  /// \param[in] _entity The entity.
+  public: void SetTraceEntity(uint64_t _entity);
+
+  /// \internal
+  /// \brief Compute the lift and drag forces given the foil axes
+  /// in the world frame.
+  private: void Compute(
+    const gz::math::Vector3d &_velU,
+    const gz::math::Vector3d &_forwardI,
+    const gz::math::Vector3d &_upwardI,
+    double _area,
+    gz::math::Vector3d &_lift,
+    gz::math::Vector3d &_drag,
+    double &_alpha,
+    double &_u,
+    double &_cl,
+    double &_cd) const;
+
   /// \internal
   /// \brief Constructor, ownership transferred from data.
   private: LiftDragModel(std::unique_ptr<LiftDragModelPrivate> &_data);
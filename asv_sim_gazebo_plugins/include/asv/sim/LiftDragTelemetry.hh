@@ -0,0 +1,145 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ASV_SIM_LIFTDRAGTELEMETRY_HH_
+#define ASV_SIM_LIFTDRAGTELEMETRY_HH_
+
+#include <gz/msgs/double_v.pb.h>
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include <gz/math/Vector3.hh>
+
+#include "asv/sim/TransportRegistry.hh"
+
+namespace asv
+{
+/// \brief Publishes the lift and drag state of a surface at a fixed
+/// rate of simulation time.
+///
+/// The message is a gz::msgs::Double_V with the fields listed in
+/// LiftDragTelemetry::Field, stamped with the simulation time. Vectors
+/// are in the world frame and the torque is about the link origin. The
+/// message is allocated once and reused, and the publisher is only
+/// advertised, through asv::TransportRegistry, when the first message
+/// is sent, so a disabled telemetry costs one comparison per step.
+class LiftDragTelemetry
+{
+  /// \brief The position of each value in the message data.
+  public: enum Field
+  {
+    /// \brief Angle of attack.
+    kAlpha = 0,
+
+    /// \brief Free-stream speed.
+    kSpeed = 1,
+
+    /// \brief Lift coefficient.
+    kCl = 2,
+
+    /// \brief Drag coefficient.
+    kCd = 3,
+
+    /// \brief Lift x, y, z.
+    kLift = 4,
+
+    /// \brief Drag x, y, z.
+    kDrag = 7,
+
+    /// \brief Torque x, y, z.
+    kTorque = 10,
+
+    /// \brief Number of values.
+    kSize = 13
+  };
+
+  /// \brief Enable publishing.
+  /// \param[in] _topic The topic.
+  /// \param[in] _rate The publish rate in Hz of simulation time. Zero
+  /// publishes every step.
+  public: void Configure(const std::string &_topic, double _rate);
+
+  /// \brief True if publishing is enabled.
+  public: bool Enabled() const;
+
+  /// \brief True if a message is due at a simulation time. A time
+  /// earlier than the last message (for example after a reset) is due.
+  /// \param[in] _simTime The simulation time.
+  public: bool Due(const std::chrono::steady_clock::duration &_simTime) const;
+
+  /// \brief Fill and publish the message.
+  /// \param[in] _simTime The simulation time.
+  /// \param[in] _alpha The angle of attack.
+  /// \param[in] _u The free-stream speed.
+  /// \param[in] _cl The lift coefficient.
+  /// \param[in] _cd The drag coefficient.
+  /// \param[in] _lift The lift (world frame).
+  /// \param[in] _drag The drag (world frame).
+  /// \param[in] _torque The torque about the link origin (world frame).
+  public: void Publish(const std::chrono::steady_clock::duration &_simTime,
+      double _alpha, double _u, double _cl, double _cd,
+      const gz::math::Vector3d &_lift,
+      const gz::math::Vector3d &_drag,
+      const gz::math::Vector3d &_torque);
+
+  /// \brief Record a lift_drag sample to asv::FlightRecorder::Instance
+  /// and, if it is open, asv::Recorder::Instance. Independent of the
+  /// publish rate.
+  /// \param[in] _simTime The simulation time.
+  /// \param[in] _entity The link.
+  /// \param[in] _alpha The angle of attack.
+  /// \param[in] _u The free-stream speed.
+  /// \param[in] _cl The lift coefficient.
+  /// \param[in] _cd The drag coefficient.
+  /// \param[in] _lift The lift (world frame).
+  /// \param[in] _drag The drag (world frame).
+  /// \param[in] _wind The apparent wind (world frame).
+  public: static void Record(
+      const std::chrono::steady_clock::duration &_simTime,
+      uint64_t _entity, double _alpha, double _u, double _cl, double _cd,
+      const gz::math::Vector3d &_lift,
+      const gz::math::Vector3d &_drag,
+      const gz::math::Vector3d &_wind);
+
+  /// \brief The last message.
+  public: const gz::msgs::Double_V &Message() const;
+
+  /// \brief Set a vector in the message data.
+  private: void SetVector(size_t _field, const gz::math::Vector3d &_v);
+
+  /// \brief The topic, empty if disabled.
+  private: std::string topic;
+
+  /// \brief Time between messages.
+  private: std::chrono::steady_clock::duration period{0};
+
+  /// \brief Time of the last message.
+  private: std::chrono::steady_clock::duration lastTime{0};
+
+  /// \brief True once a message has been published.
+  private: bool published = false;
+
+  /// \brief The reused message.
+  private: gz::msgs::Double_V msg;
+
+  /// \brief The publisher, advertised on first use.
+  private: TransportRegistry::Publisher pub;
+};
+
+}  // namespace asv
+
+#endif  // ASV_SIM_LIFTDRAGTELEMETRY_HH_
@@ -0,0 +1,137 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ASV_SIM_LOG_HH_
+#define ASV_SIM_LOG_HH_
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+#include <gz/common/Console.hh>
+
+namespace asv
+{
+/// \brief Rate limiting for one warning or error site, used through the
+/// asvwarn and asverr macros.
+///
+/// Each site has a token bucket: a burst of messages is printed, then at
+/// most one per second. Suppressed messages are counted, and the next
+/// printed message notes how many were suppressed. Every 10 seconds of
+/// wall clock time in which any site is hit, a summary of the sites that
+/// suppressed messages is printed. A site reports what it suppressed
+/// since the last summary when it is destroyed, at exit for the sites
+/// in the macros.
+class LogSite
+{
+  /// \brief Constructor.
+  /// \param[in] _file The source file.
+  /// \param[in] _line The source line.
+  /// \param[in] _rate Messages per second once the burst is used.
+  /// \param[in] _burst The number of messages printed without delay.
+  public: LogSite(const char *_file, int _line, double _rate = 1.0,
+      double _burst = 5.0);
+
+  /// \brief Destructor.
+  public: ~LogSite();
+
+  /// \brief Not copyable, the site is registered by address.
+  public: LogSite(const LogSite &) = delete;
+  public: LogSite &operator=(const LogSite &) = delete;
+
+  /// \brief Count an occurrence and take a token.
+  /// \return True if the message should be printed.
+  public: bool Allow();
+
+  /// \brief Count an occurrence and take a token at a given time.
+  /// \param[in] _now Wall clock time in seconds.
+  /// \return True if the message should be printed.
+  public: bool Allow(double _now);
+
+  /// \brief A note of the messages suppressed since the last printed
+  /// message, or empty. Resets the count.
+  public: std::string Note();
+
+  /// \brief The number of occurrences.
+  public: uint64_t Count() const;
+
+  /// \brief The number of suppressed occurrences.
+  public: uint64_t SuppressedCount() const;
+
+  /// \brief A summary of the sites that suppressed messages since the
+  /// last summary, one line per site, or empty.
+  public: static std::string Summary();
+
+  /// \brief Wall clock time in seconds.
+  public: static double Now();
+
+  /// \brief The summary line of this site. The site must be locked.
+  private: std::string SummaryLine() const;
+
+  /// \brief Print the summary if it is due.
+  /// \param[in] _now Wall clock time in seconds.
+  private: static void MaybeSummarise(double _now);
+
+  /// \brief The source file.
+  private: const char *file;
+
+  /// \brief The source line.
+  private: int line;
+
+  /// \brief Tokens per second.
+  private: double rate;
+
+  /// \brief Bucket size.
+  private: double burst;
+
+  /// \brief Protects the state below.
+  private: mutable std::mutex mutex;
+
+  /// \brief Tokens in the bucket.
+  private: double tokens;
+
+  /// \brief Time the bucket was last filled.
+  private: double last{-1.0};
+
+  /// \brief Number of occurrences.
+  private: uint64_t count{0};
+
+  /// \brief Number of suppressed occurrences.
+  private: uint64_t suppressed{0};
+
+  /// \brief Suppressed since the last printed message.
+  private: uint64_t suppressedSinceNote{0};
+
+  /// \brief Suppressed since the last summary.
+  private: uint64_t suppressedSinceSummary{0};
+};
+}  // namespace asv
+
+/// \brief Rate limited gzwarn for code that may run every step. Each use
+/// is a separate site.
+///
+/// \code
+/// asvwarn << "SailLiftDrag: overflow in lift calculation.\n";
+/// \endcode
+#define asvwarn \
+  if (static asv::LogSite asvLogSite(__FILE__, __LINE__); \
+      !asvLogSite.Allow()) {} else gzwarn << asvLogSite.Note()
+
+/// \brief Rate limited gzerr for code that may run every step.
+#define asverr \
+  if (static asv::LogSite asvLogSite(__FILE__, __LINE__); \
+      !asvLogSite.Allow()) {} else gzerr << asvLogSite.Note()
+
+#endif  // ASV_SIM_LOG_HH_
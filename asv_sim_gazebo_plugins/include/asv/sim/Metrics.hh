@@ -0,0 +1,245 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ASV_SIM_METRICS_HH_
+#define ASV_SIM_METRICS_HH_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace asv
+{
+class MetricsPrivate;
+
+/// \brief One metric: a histogram of samples, for instance latencies in
+/// nanoseconds or solver iterations, or a counter.
+///
+/// Samples are binned by their base 2 logarithm, so quantiles are
+/// accurate to a factor of 2. All updates are relaxed atomics and may be
+/// made from any thread.
+class Metric
+{
+  /// \brief The kind of metric.
+  public: enum class Kind
+  {
+    /// \brief Latency in nanoseconds, see MetricTimer.
+    kLatency,
+
+    /// \brief A histogram of other values.
+    kValue,
+
+    /// \brief A counter.
+    kCounter
+  };
+
+  /// \brief The number of histogram buckets.
+  public: static constexpr size_t kBuckets = 48;
+
+  /// \brief Constructor.
+  /// \param[in] _kind The kind of metric.
+  public: explicit Metric(Kind _kind);
+
+  /// \brief Add a sample to the histogram.
+  /// \param[in] _value The sample.
+  public: void Add(uint64_t _value);
+
+  /// \brief Add to the counter.
+  /// \param[in] _count The amount to add.
+  public: void Increment(uint64_t _count = 1)
+  {
+    this->count.fetch_add(_count, std::memory_order_relaxed);
+  }
+
+  /// \brief Add allocations made while timing.
+  /// \param[in] _count The number of allocations.
+  public: void AddAllocations(uint64_t _count)
+  {
+    this->allocations.fetch_add(_count, std::memory_order_relaxed);
+  }
+
+  /// \brief The kind of metric.
+  public: Kind MetricKind() const;
+
+  /// \brief The number of samples, or the counter value.
+  public: uint64_t Count() const;
+
+  /// \brief The sum of the samples.
+  public: uint64_t Sum() const;
+
+  /// \brief The smallest sample, or 0 if there are none.
+  public: uint64_t Min() const;
+
+  /// \brief The largest sample.
+  public: uint64_t Max() const;
+
+  /// \brief The number of allocations.
+  public: uint64_t Allocations() const;
+
+  /// \brief An upper bound on a quantile of the samples.
+  /// \param[in] _q The quantile in [0, 1].
+  /// \return The upper bound, or 0 if there are no samples.
+  public: uint64_t Quantile(double _q) const;
+
+  /// \brief Clear the metric.
+  public: void Reset();
+
+  /// \brief The kind of metric.
+  private: Kind kind;
+
+  /// \brief Number of samples in each bucket.
+  private: std::array<std::atomic<uint64_t>, kBuckets> buckets;
+
+  /// \brief Number of samples or counter value.
+  private: std::atomic<uint64_t> count{0};
+
+  /// \brief Sum of samples.
+  private: std::atomic<uint64_t> sum{0};
+
+  /// \brief Smallest sample.
+  private: std::atomic<uint64_t> min{UINT64_MAX};
+
+  /// \brief Largest sample.
+  private: std::atomic<uint64_t> max{0};
+
+  /// \brief Number of allocations.
+  private: std::atomic<uint64_t> allocations{0};
+};
+
+/// \brief The metrics of the asv_sim systems, always collected.
+///
+/// Each system times its update phases with MetricTimer, counts calls
+/// per entity and records solver iterations. Metrics are looked up once,
+/// usually in Configure, and the references stay valid for the life of
+/// the process. The Metrics system publishes them periodically on
+/// /asv_sim/metrics and can write them to a CSV file.
+///
+/// Allocations are counted per phase from the calling thread's count of
+/// CountAllocation calls. An executable that replaces the global
+/// operator new can call it to have its allocations attributed;
+/// otherwise the count stays zero.
+class Metrics
+{
+  /// \brief No entity, for metrics of a whole system.
+  public: static constexpr uint64_t kNoEntity = UINT64_MAX;
+
+  /// \brief The process-wide metrics.
+  public: static Metrics &Instance();
+
+  /// \brief Constructor.
+  public: Metrics();
+
+  /// \brief Destructor.
+  public: ~Metrics();
+
+  /// \brief The latency metric of a phase, created on first use.
+  /// \param[in] _system The system name.
+  /// \param[in] _phase The phase, for example PreUpdate.
+  /// \param[in] _entity The entity, or kNoEntity.
+  public: Metric &Latency(const std::string &_system,
+      const std::string &_phase, uint64_t _entity = kNoEntity);
+
+  /// \brief A histogram of values, created on first use.
+  /// \param[in] _system The system name.
+  /// \param[in] _name The name, for example solver_iterations.
+  /// \param[in] _entity The entity, or kNoEntity.
+  public: Metric &Value(const std::string &_system,
+      const std::string &_name, uint64_t _entity = kNoEntity);
+
+  /// \brief A counter, created on first use.
+  /// \param[in] _system The system name.
+  /// \param[in] _name The name, for example calls.
+  /// \param[in] _entity The entity, or kNoEntity.
+  public: Metric &Counter(const std::string &_system,
+      const std::string &_name, uint64_t _entity = kNoEntity);
+
+  /// \brief The metrics as CSV, one row per metric in order of system,
+  /// name and entity. Latencies are in nanoseconds.
+  public: std::string Csv() const;
+
+  /// \brief Write the metrics as CSV.
+  /// \param[in] _path The file path.
+  /// \return True if the file was written.
+  public: bool WriteCsv(const std::string &_path) const;
+
+  /// \brief Visit the metrics in order of system, name and entity.
+  /// \param[in] _visitor Called with the system, name, entity and
+  /// metric. It must not look up metrics.
+  public: void ForEach(const std::function<void(const std::string &,
+      const std::string &, uint64_t, const Metric &)> &_visitor) const;
+
+  /// \brief Clear all metrics, keeping the references valid.
+  public: void Reset();
+
+  /// \brief Count an allocation by the calling thread.
+  public: static void CountAllocation();
+
+  /// \brief The number of allocations counted for the calling thread.
+  public: static uint64_t ThreadAllocations();
+
+  /// \brief Find or create a metric.
+  private: Metric &Get(Metric::Kind _kind, const std::string &_system,
+      const std::string &_name, uint64_t _entity);
+
+  /// \brief Pointer to the class private data.
+  private: std::unique_ptr<MetricsPrivate> data;
+};
+
+/// \brief Adds the time and allocations of a scope to a latency metric.
+///
+/// \code
+/// asv::MetricTimer timer(this->dataPtr->preUpdateLatency);
+/// \endcode
+class MetricTimer
+{
+  /// \brief Constructor, starts the timer.
+  /// \param[in] _metric The latency metric.
+  public: explicit MetricTimer(Metric &_metric)
+    : metric(_metric), allocations(Metrics::ThreadAllocations()),
+      start(std::chrono::steady_clock::now())
+  {
+  }
+
+  /// \brief Destructor, adds the elapsed time.
+  public: ~MetricTimer()
+  {
+    auto elapsed = std::chrono::steady_clock::now() - this->start;
+    this->metric.Add(static_cast<uint64_t>(std::chrono::duration_cast<
+        std::chrono::nanoseconds>(elapsed).count()));
+    uint64_t allocs = Metrics::ThreadAllocations() - this->allocations;
+    if (allocs != 0)
+      this->metric.AddAllocations(allocs);
+  }
+
+  /// \brief Not copyable.
+  public: MetricTimer(const MetricTimer &) = delete;
+  public: MetricTimer &operator=(const MetricTimer &) = delete;
+
+  /// \brief The latency metric.
+  private: Metric &metric;
+
+  /// \brief Allocations at the start.
+  private: uint64_t allocations;
+
+  /// \brief Time at the start.
+  private: std::chrono::steady_clock::time_point start;
+};
+}  // namespace asv
+
+#endif  // ASV_SIM_METRICS_HH_
@@ -0,0 +1,90 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ASV_SIM_RECORDREADER_HH_
+#define ASV_SIM_RECORDREADER_HH_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "asv/sim/Recorder.hh"
+
+namespace asv
+{
+/// \brief Reads a file written by asv::Recorder into columns.
+///
+/// Record types are indexed by the id they were registered with. Each
+/// type has a time column, an entity column and a column per field, all
+/// with one row per sample in the order they were written.
+class RecordReader
+{
+  /// \brief Read a file.
+  /// \param[in] _filename The file name.
+  /// \return True if successful.
+  public: bool Open(const std::string &_filename);
+
+  /// \brief The number of record types.
+  public: size_t TypeCount() const;
+
+  /// \brief The schema of a record type.
+  /// \param[in] _type The type id.
+  public: const RecordSchema &Schema(size_t _type) const;
+
+  /// \brief The id of a record type.
+  /// \param[in] _name The record type name.
+  /// \return The type id, or -1 if not found.
+  public: int FindType(const std::string &_name) const;
+
+  /// \brief The index of a field.
+  /// \param[in] _type The type id.
+  /// \param[in] _name The field name.
+  /// \return The field index, or -1 if not found.
+  public: int FindField(size_t _type, const std::string &_name) const;
+
+  /// \brief The number of samples of a record type.
+  /// \param[in] _type The type id.
+  public: size_t RowCount(size_t _type) const;
+
+  /// \brief The simulation time of each sample.
+  /// \param[in] _type The type id.
+  public: const std::vector<double> &Time(size_t _type) const;
+
+  /// \brief The entity of each sample.
+  /// \param[in] _type The type id.
+  public: const std::vector<uint64_t> &Entity(size_t _type) const;
+
+  /// \brief The values of a field.
+  /// \param[in] _type The type id.
+  /// \param[in] _field The field index.
+  public: const std::vector<double> &Column(size_t _type,
+      size_t _field) const;
+
+  /// \brief The columns of a record type.
+  private: struct Table
+  {
+    RecordSchema schema;
+    std::vector<double> time;
+    std::vector<uint64_t> entity;
+    std::vector<std::vector<double>> columns;
+  };
+
+  /// \brief The tables by type id.
+  private: std::vector<Table> tables;
+};
+
+}  // namespace asv
+
+#endif  // ASV_SIM_RECORDREADER_HH_
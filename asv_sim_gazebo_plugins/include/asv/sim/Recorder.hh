@@ -0,0 +1,117 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ASV_SIM_RECORDER_HH_
+#define ASV_SIM_RECORDER_HH_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace asv
+{
+class RecorderPrivate;
+
+/// \brief The name and field names of a record type.
+struct RecordSchema
+{
+  /// \brief Record type name.
+  std::string name;
+
+  /// \brief Field names.
+  std::vector<std::string> fields;
+};
+
+/// \brief Records fixed-size samples from the simulation to a columnar
+/// binary file for offline analysis (see asv::RecordReader).
+///
+/// A record is a simulation time, an entity and up to kMaxFields double
+/// values whose names are given by the schema of its record type. Each
+/// thread that calls Record gets its own lock-free single-producer ring
+/// buffer, so recording a sample is a copy into the ring. A background
+/// thread drains the rings, gathers the records of each type into
+/// blocks of columns and writes them. Each column is compressed by
+/// XOR with the previous value and dropping the leading zero bytes,
+/// which suits slowly varying traces. If a ring is full the sample is
+/// dropped and counted rather than blocking the simulation.
+///
+/// Systems share the process-wide Instance, which is opened by the
+/// TraceRecorder system, and check IsOpen before assembling a sample.
+class Recorder
+{
+  /// \brief The largest number of fields in a record.
+  public: static constexpr size_t kMaxFields = 16;
+
+  /// \brief The type id returned when registration fails.
+  public: static constexpr uint32_t kInvalidType = UINT32_MAX;
+
+  /// \brief The process-wide recorder.
+  public: static Recorder &Instance();
+
+  /// \brief Destructor. Closes the file.
+  public: ~Recorder();
+
+  /// \brief Constructor.
+  /// \param[in] _ringSize The number of records each thread buffers.
+  /// \param[in] _blockRows The number of rows in a block of columns.
+  public: explicit Recorder(size_t _ringSize = 8192,
+      size_t _blockRows = 4096);
+
+  /// \brief Open a file and start the writer thread. Any open file is
+  /// closed first.
+  /// \param[in] _filename The file name.
+  /// \return True if successful.
+  public: bool Open(const std::string &_filename);
+
+  /// \brief Write all buffered records, stop the writer and close the
+  /// file.
+  public: void Close();
+
+  /// \brief True if a file is open.
+  public: bool IsOpen() const;
+
+  /// \brief Register a record type. Registering an existing name with
+  /// the same fields returns its id.
+  /// \param[in] _name The record type name.
+  /// \param[in] _fields The field names.
+  /// \return The type id, or kInvalidType on error.
+  public: uint32_t RegisterType(const std::string &_name,
+      const std::vector<std::string> &_fields);
+
+  /// \brief Record a sample. Lock-free and does not allocate after the
+  /// first call from a thread.
+  /// \param[in] _type The type id.
+  /// \param[in] _time The simulation time in seconds.
+  /// \param[in] _entity The entity.
+  /// \param[in] _values The field values, as many as the schema has.
+  /// \return False if the recorder is closed or the sample was dropped.
+  public: bool Record(uint32_t _type, double _time, uint64_t _entity,
+      const double *_values);
+
+  /// \brief The number of samples dropped because a ring was full.
+  public: uint64_t DroppedCount() const;
+
+  /// \brief The number of samples written.
+  public: uint64_t WrittenCount() const;
+
+  /// \internal
+  /// \brief Pointer to the class private data.
+  private: std::unique_ptr<RecorderPrivate> data;
+};
+
+}  // namespace asv
+
+#endif  // ASV_SIM_RECORDER_HH_
@@ -0,0 +1,80 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ASV_SIM_SAILCOMMANDBUFFER_HH_
+#define ASV_SIM_SAILCOMMANDBUFFER_HH_
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace asv
+{
+/// \brief A sail position command addressed by model and joint name.
+struct SailCommand
+{
+  /// \brief Scoped name of the model.
+  std::string model;
+
+  /// \brief Name of the joint in the model.
+  std::string joint;
+
+  /// \brief Commanded joint position.
+  double position = 0.0;
+};
+
+/// \brief Hands batches of sail commands from a transport thread to the
+/// simulation thread without locking.
+///
+/// The buffer holds three batches: one owned by the writer, one owned
+/// by the reader, and one in between that is exchanged atomically. When
+/// the writer begins a batch it takes back any batch the reader has not
+/// read yet and appends to it, so no command is lost or reordered when
+/// several messages arrive within one step. There must be a single
+/// writer thread and a single reader thread.
+class SailCommandBuffer
+{
+  /// \brief Begin a batch of commands.
+  /// \return The batch to append commands to. It holds any commands
+  /// published earlier that have not been read.
+  public: std::vector<SailCommand> &BeginWrite();
+
+  /// \brief Make the write batch available to the reader.
+  public: void Publish();
+
+  /// \brief Take the latest published commands.
+  /// \return The commands, or nullptr if none were published since the
+  /// last call. The batch is valid until the next call.
+  public: const std::vector<SailCommand> *Read();
+
+  /// \brief Flag set in the shared state when it holds unread commands.
+  private: static constexpr unsigned int kDirty = 4;
+
+  /// \brief The three batches.
+  private: std::vector<SailCommand> batch[3];
+
+  /// \brief Index of the batch owned by the writer.
+  private: unsigned int writeIndex = 0;
+
+  /// \brief Index of the batch owned by the reader.
+  private: unsigned int readIndex = 1;
+
+  /// \brief Index of the shared batch and the dirty flag.
+  private: std::atomic<unsigned int> shared{2};
+};
+
+}  // namespace asv
+
+#endif  // ASV_SIM_SAILCOMMANDBUFFER_HH_
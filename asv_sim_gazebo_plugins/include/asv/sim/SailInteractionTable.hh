@@ -0,0 +1,168 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ASV_SIM_SAILINTERACTIONTABLE_HH_
+#define ASV_SIM_SAILINTERACTIONTABLE_HH_
+
+#include <string>
+#include <vector>
+
+#include <gz/math/Pose3.hh>
+#include <gz/math/Vector3.hh>
+
+#include "asv/sim/SailPlanform.hh"
+
+namespace asv
+{
+/// \brief The geometry of a sail used to generate an interaction table.
+struct InteractionSail
+{
+  /// \brief Spanwise strips (sail frame).
+  std::vector<SailStrip> strips;
+
+  /// \brief Foil forward direction (sail frame).
+  gz::math::Vector3d forward{1, 0, 0};
+
+  /// \brief Foil upward direction (sail frame).
+  gz::math::Vector3d upward{0, 1, 0};
+
+  /// \brief Pose of the sail in the base frame at zero trim.
+  gz::math::Pose3d pose;
+};
+
+/// \brief Precomputed aerodynamic interaction between the sails of a rig.
+///
+/// For each ordered pair of sails (i, j) the table stores the mean
+/// upwash induced on sail i by sail j, as a fraction of the free-stream
+/// speed, on a regular grid of the trims of the two sails and the
+/// apparent wind angle. The upwash is along the upward direction of
+/// sail i, so the free stream at a strip of sail i is corrected by
+/// adding the interpolated upwash times the strip speed along the strip
+/// normal.
+///
+/// Angles are in the base frame and in radians. The trim of a sail is
+/// the heading of its forward direction, atan2(f_y, f_x), and the
+/// apparent wind angle is the direction the wind comes from,
+/// atan2(-v_y, -v_x). Values outside the grid are clamped.
+///
+/// The table is generated offline with a vortex lattice (see
+/// asv::VortexLattice) and stored as a compact binary file with single
+/// precision values.
+class SailInteractionTable
+{
+  /// \brief Resize the table and zero the values.
+  /// \param[in] _numSails The number of sails.
+  /// \param[in] _numTrim The number of trim grid points.
+  /// \param[in] _trimMin The smallest trim.
+  /// \param[in] _trimMax The largest trim.
+  /// \param[in] _numAwa The number of apparent wind angle grid points.
+  /// \param[in] _awaMin The smallest apparent wind angle.
+  /// \param[in] _awaMax The largest apparent wind angle.
+  public: void Resize(size_t _numSails,
+      size_t _numTrim, double _trimMin, double _trimMax,
+      size_t _numAwa, double _awaMin, double _awaMax);
+
+  /// \brief The number of sails.
+  public: size_t SailCount() const;
+
+  /// \brief The number of trim grid points.
+  public: size_t TrimCount() const;
+
+  /// \brief The number of apparent wind angle grid points.
+  public: size_t AwaCount() const;
+
+  /// \brief The trim at a grid point.
+  /// \param[in] _index The grid index.
+  public: double Trim(size_t _index) const;
+
+  /// \brief The apparent wind angle at a grid point.
+  /// \param[in] _index The grid index.
+  public: double Awa(size_t _index) const;
+
+  /// \brief Access a grid value.
+  /// \param[in] _i The sail the upwash acts on.
+  /// \param[in] _j The sail inducing the upwash.
+  /// \param[in] _trimI The trim grid index of sail i.
+  /// \param[in] _trimJ The trim grid index of sail j.
+  /// \param[in] _awa The apparent wind angle grid index.
+  public: float &Value(size_t _i, size_t _j,
+      size_t _trimI, size_t _trimJ, size_t _awa);
+
+  /// \brief The upwash on sail i induced by sail j, interpolated
+  /// from the grid.
+  /// \param[in] _i The sail the upwash acts on.
+  /// \param[in] _j The sail inducing the upwash.
+  /// \param[in] _trimI The trim of sail i.
+  /// \param[in] _trimJ The trim of sail j.
+  /// \param[in] _awa The apparent wind angle.
+  public: double Lookup(size_t _i, size_t _j,
+      double _trimI, double _trimJ, double _awa) const;
+
+  /// \brief The total upwash on every sail from all the other sails.
+  /// \param[in] _trim The trim of each sail.
+  /// \param[in] _awa The apparent wind angle.
+  /// \param[out] _upwash The upwash on each sail.
+  public: void Upwash(const std::vector<double> &_trim, double _awa,
+      std::vector<double> &_upwash) const;
+
+  /// \brief Fill the table using a vortex lattice for each pair of sails.
+  /// \param[in] _sails The sails, in the order of the table.
+  /// \return True if successful.
+  public: bool Generate(const std::vector<InteractionSail> &_sails);
+
+  /// \brief Save the table to a binary file.
+  /// \param[in] _filename The file name.
+  /// \return True if successful.
+  public: bool Save(const std::string &_filename) const;
+
+  /// \brief Load the table from a binary file.
+  /// \param[in] _filename The file name.
+  /// \return True if successful.
+  public: bool Load(const std::string &_filename);
+
+  /// \brief The trim of a sail from its orientation in the base frame.
+  /// \param[in] _rot The sail orientation in the base frame.
+  /// \param[in] _forward The foil forward direction (sail frame).
+  public: static double TrimAngle(const gz::math::Quaterniond &_rot,
+      const gz::math::Vector3d &_forward);
+
+  /// \brief The apparent wind angle of a free stream in the base frame.
+  /// \param[in] _velU The free-stream velocity (base frame).
+  public: static double ApparentWindAngle(const gz::math::Vector3d &_velU);
+
+  /// \brief Index of the first value of an ordered pair of sails.
+  private: size_t PairOffset(size_t _i, size_t _j) const;
+
+  /// \brief Number of sails.
+  private: size_t numSails = 0;
+
+  /// \brief Trim grid.
+  private: size_t numTrim = 0;
+  private: double trimMin = 0.0;
+  private: double trimMax = 0.0;
+
+  /// \brief Apparent wind angle grid.
+  private: size_t numAwa = 0;
+  private: double awaMin = 0.0;
+  private: double awaMax = 0.0;
+
+  /// \brief Values ordered by pair, trim i, trim j, apparent wind angle.
+  /// The diagonal pairs are not stored.
+  private: std::vector<float> values;
+};
+
+}  // namespace asv
+
+#endif  // ASV_SIM_SAILINTERACTIONTABLE_HH_
@@ -0,0 +1,123 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ASV_SIM_SAILPLANFORM_HH_
+#define ASV_SIM_SAILPLANFORM_HH_
+
+#include <memory>
+#include <vector>
+
+#include <gz/math/Vector3.hh>
+
+#include <sdf/sdf.hh>
+
+namespace asv
+{
+
+/// \brief A spanwise strip of a sail.
+struct SailStrip
+{
+  /// \brief Centre of pressure (quarter chord) in the link frame.
+  gz::math::Vector3d cp = gz::math::Vector3d::Zero;
+
+  /// \brief Leading edge at the lower boundary of the strip (link frame).
+  gz::math::Vector3d leLower = gz::math::Vector3d::Zero;
+
+  /// \brief Leading edge at the upper boundary of the strip (link frame).
+  gz::math::Vector3d leUpper = gz::math::Vector3d::Zero;
+
+  /// \brief Mean chord of the strip.
+  double chord = 0.0;
+
+  /// \brief Spanwise length of the strip.
+  double span = 0.0;
+
+  /// \brief Strip area.
+  double area = 0.0;
+
+  /// \brief Twist about the span axis in radians, relative to the foot.
+  double twist = 0.0;
+};
+
+/// \brief A trapezoidal sail planform defined by its luff, the chord
+/// at the foot and head, and a linear twist distribution.
+///
+/// # Parameters
+///
+/// The planform is loaded from a <strips> element:
+///
+/// \code
+/// <strips>
+///   <num_strips>8</num_strips>
+///   <luff_foot>0 0 0.2</luff_foot>
+///   <luff_head>0 0 2.0</luff_head>
+///   <foot_chord>0.6</foot_chord>
+///   <head_chord>0.1</head_chord>
+///   <head_twist>0.15</head_twist>
+/// </strips>
+/// \endcode
+///
+/// 1. <num_strips> (int, default: 1)
+///   Number of spanwise strips.
+///
+/// 2. <luff_foot>, <luff_head> (Vector3d)
+///   Leading edge at the foot and head of the sail (link frame).
+///
+/// 3. <foot_chord>, <head_chord> (double, default: 1)
+///   Chord at the foot and head of the sail.
+///
+/// 4. <head_twist> (double, default: 0)
+///   Twist at the head relative to the foot in radians.
+///
+class SailPlanform
+{
+  /// \brief Leading edge at the foot of the sail (link frame).
+  public: gz::math::Vector3d luffFoot = gz::math::Vector3d::Zero;
+
+  /// \brief Leading edge at the head of the sail (link frame).
+  public: gz::math::Vector3d luffHead = gz::math::Vector3d::UnitZ;
+
+  /// \brief Chord at the foot of the sail.
+  public: double footChord = 1.0;
+
+  /// \brief Chord at the head of the sail.
+  public: double headChord = 1.0;
+
+  /// \brief Twist at the head relative to the foot in radians.
+  public: double headTwist = 0.0;
+
+  /// \brief Number of spanwise strips.
+  public: int numStrips = 1;
+
+  /// \brief Load the planform from SDF.
+  /// \param[in] _sdf A pointer to a <strips> element.
+  /// \param[out] _planform The planform.
+  /// \return True if the planform is valid.
+  public: static bool Load(
+      const std::shared_ptr<const sdf::Element> &_sdf,
+      SailPlanform &_planform);
+
+  /// \brief Discretise the planform into spanwise strips.
+  /// \param[in] _forward Foil forward direction (link frame). The
+  /// trailing edge lies aft of the luff along this direction.
+  /// \param[out] _strips The strips, ordered from foot to head.
+  public: void Discretise(
+      const gz::math::Vector3d &_forward,
+      std::vector<SailStrip> &_strips) const;
+};
+
+}  // namespace asv
+
+#endif  // ASV_SIM_SAILPLANFORM_HH_
@@ -0,0 +1,209 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ASV_SIM_TRACE_HH_
+#define ASV_SIM_TRACE_HH_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace asv
+{
+class TraceChannel;
+class TracerPrivate;
+
+/// \brief Runtime-switchable debug tracing for the asv_sim systems.
+///
+/// Each system owns a TraceChannel per entity it traces, named by the
+/// system and listing its fields. Channels are disabled until a rule
+/// enables them, so the cost in a running simulation is one branch on
+/// a flag. An enabled channel copies its values into a ring of binary
+/// records and a background thread formats them, one line per record,
+/// to the console (or another sink).
+///
+/// Rules are set with Enable and Disable, or at runtime through the
+/// /asv_sim/trace service (gz::msgs::StringMsg request and response)
+/// of the process-wide Instance, for example:
+///
+/// \code
+/// gz service -s /asv_sim/trace --reqtype gz.msgs.StringMsg
+///   --reptype gz.msgs.StringMsg --timeout 1000
+///   --req 'data: "enable Mooring"'
+/// \endcode
+///
+/// Commands:
+/// - enable <system|*> [entity|*] [rate]
+/// - disable <system|*> [entity|*]
+/// - list
+///
+/// The rate is in Hz of wall clock time, zero traces every call, and
+/// if omitted the channel default is used.
+class Tracer
+{
+  /// \brief Matches any entity in a rule.
+  public: static constexpr uint64_t kAnyEntity = UINT64_MAX;
+
+  /// \brief The largest number of values in a record.
+  public: static constexpr size_t kMaxValues = 32;
+
+  /// \brief The process-wide tracer, which advertises the service.
+  public: static Tracer &Instance();
+
+  /// \brief Constructor.
+  /// \param[in] _capacity The number of records buffered for the
+  /// formatting thread. Records beyond it are dropped.
+  public: explicit Tracer(size_t _capacity = 4096);
+
+  /// \brief Destructor. Formats the buffered records.
+  public: ~Tracer();
+
+  /// \brief Enable the channels of a system.
+  /// \param[in] _system The system name, or * for all.
+  /// \param[in] _entity The entity, or kAnyEntity for all.
+  /// \param[in] _rate The rate in Hz, negative for the channel default.
+  public: void Enable(const std::string &_system,
+      uint64_t _entity = kAnyEntity, double _rate = -1.0);
+
+  /// \brief Remove the rules of a system.
+  /// \param[in] _system The system name, or * for all.
+  /// \param[in] _entity The entity, or kAnyEntity for all.
+  public: void Disable(const std::string &_system,
+      uint64_t _entity = kAnyEntity);
+
+  /// \brief Run a command, as received by the service.
+  /// \param[in] _command The command.
+  /// \param[out] _reply A description of the result.
+  /// \return True if the command was valid.
+  public: bool Command(const std::string &_command, std::string &_reply);
+
+  /// \brief Replace the console as the destination of formatted lines.
+  /// \param[in] _sink Called from the formatting thread for each line.
+  public: void SetSink(const std::function<void(const std::string &)> &_sink);
+
+  /// \brief Wait until the buffered records are formatted.
+  public: void Flush();
+
+  /// \brief The number of records dropped because the ring was full.
+  public: uint64_t DroppedCount() const;
+
+  /// \brief Add a channel and apply the rules to it.
+  private: void Register(TraceChannel *_channel);
+
+  /// \brief Remove a channel.
+  private: void Unregister(TraceChannel *_channel);
+
+  /// \brief Apply the rules to a channel. The lock must be held.
+  private: void Apply(TraceChannel *_channel);
+
+  /// \brief Queue a record.
+  private: void Push(const TraceChannel *_channel, double _time,
+      const double *_values, size_t _count);
+
+  /// \brief Pointer to the class private data.
+  private: std::unique_ptr<TracerPrivate> data;
+
+  friend class TraceChannel;
+};
+
+/// \brief A named source of trace records, usually one per system and
+/// entity.
+///
+/// Fields are given by name, with an optional width for vectors, for
+/// example {"alpha", "lift:3"}. Write takes the values of all fields in
+/// order.
+class TraceChannel
+{
+  /// \brief Constructor.
+  /// \param[in] _system The system name.
+  /// \param[in] _fields The field names.
+  /// \param[in] _entity The entity.
+  /// \param[in] _tracer The tracer.
+  public: TraceChannel(const std::string &_system,
+      const std::vector<std::string> &_fields,
+      uint64_t _entity = Tracer::kAnyEntity,
+      Tracer &_tracer = Tracer::Instance());
+
+  /// \brief Destructor.
+  public: ~TraceChannel();
+
+  /// \brief Not copyable, the tracer refers to the channel.
+  public: TraceChannel(const TraceChannel &) = delete;
+  public: TraceChannel &operator=(const TraceChannel &) = delete;
+
+  /// \brief Set the entity and apply the rules again.
+  /// \param[in] _entity The entity.
+  public: void SetEntity(uint64_t _entity);
+
+  /// \brief Set the rate used when a rule does not give one.
+  /// \param[in] _rate The rate in Hz, zero for every call.
+  public: void SetDefaultRate(double _rate);
+
+  /// \brief True if the channel is enabled. Check before assembling the
+  /// values.
+  public: bool Enabled() const
+  {
+    return this->enabled.load(std::memory_order_relaxed);
+  }
+
+  /// \brief Write a record if enabled and due.
+  /// \param[in] _time Simulation time in seconds, or NaN if unknown.
+  /// \param[in] _values The values of all fields.
+  public: void Write(double _time, std::initializer_list<double> _values);
+
+  /// \brief The system name.
+  public: const std::string &System() const;
+
+  /// \brief The entity.
+  public: uint64_t Entity() const;
+
+  /// \brief The field names.
+  public: const std::vector<std::string> &Fields() const;
+
+  /// \brief The tracer.
+  private: Tracer &tracer;
+
+  /// \brief The system name.
+  private: std::string system;
+
+  /// \brief The field names.
+  private: std::vector<std::string> fields;
+
+  /// \brief The entity.
+  private: uint64_t entity;
+
+  /// \brief The default period in nanoseconds.
+  private: int64_t defaultPeriod{0};
+
+  /// \brief Set by the tracer.
+  private: std::atomic<bool> enabled{false};
+
+  /// \brief Minimum time between records in nanoseconds, set by the
+  /// tracer.
+  private: std::atomic<int64_t> period{0};
+
+  /// \brief Wall clock time of the last record in nanoseconds.
+  private: int64_t lastWrite{INT64_MIN};
+
+  friend class Tracer;
+};
+
+}  // namespace asv
+
+#endif  // ASV_SIM_TRACE_HH_
@@ -0,0 +1,164 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ASV_SIM_TRANSPORTREGISTRY_HH_
+#define ASV_SIM_TRANSPORTREGISTRY_HH_
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include <gz/transport/Node.hh>
+
+namespace asv
+{
+/// \brief A process-wide registry of transport subscriptions and
+/// publishers shared by all the asv_sim systems and sensors.
+///
+/// Every system used to own a gz::transport::Node, and each node adds
+/// discovery state and threads. The registry instead holds a single
+/// node, created when it is first needed and destroyed when the last
+/// handle is released. Each topic is subscribed to once and messages
+/// are dispatched to every callback registered on it, and a publisher
+/// is advertised once per topic and shared.
+///
+/// Services are also advertised on the shared node.
+///
+/// A subscription lasts as long as the returned handle. Releasing the
+/// handle waits for a dispatch in progress to finish, so a callback is
+/// never called after its owner has released the handle. Callbacks run
+/// without the registry locks, so a callback can subscribe and
+/// unsubscribe, its own subscription included.
+class TransportRegistry
+{
+  /// \brief A subscription, removed when the last copy is released.
+  public: using Subscription = std::shared_ptr<void>;
+
+  /// \brief A shared publisher.
+  public: using Publisher = std::shared_ptr<gz::transport::Node::Publisher>;
+
+  /// \brief Subscribe to a topic.
+  /// \param[in] _topic The topic.
+  /// \param[in] _callback The callback for each message.
+  /// \return The subscription, or nullptr if it failed.
+  public: template <typename M>
+  static Subscription Subscribe(const std::string &_topic,
+      const std::function<void(const M &)> &_callback)
+  {
+    return SubscribeImpl(_topic, M().GetTypeName(),
+        [_callback](const gz::transport::ProtoMsg &_msg)
+        {
+          _callback(static_cast<const M &>(_msg));
+        },
+        [](gz::transport::Node &_node, const std::string &_t,
+            const Callback &_dispatch)
+        {
+          std::function<void(const M &)> cb = [_dispatch](const M &_msg)
+          {
+            _dispatch(_msg);
+          };
+          return _node.Subscribe(_t, cb);
+        });
+  }
+
+  /// \brief Subscribe a member function to a topic.
+  /// \param[in] _topic The topic.
+  /// \param[in] _callback The member function.
+  /// \param[in] _obj The object to call it on.
+  /// \return The subscription, or nullptr if it failed.
+  public: template <typename C, typename M>
+  static Subscription Subscribe(const std::string &_topic,
+      void (C::*_callback)(const M &), C *_obj)
+  {
+    return Subscribe<M>(_topic, std::function<void(const M &)>(
+        [_callback, _obj](const M &_msg)
+        {
+          (_obj->*_callback)(_msg);
+        }));
+  }
+
+  /// \brief The publisher for a topic, advertised on first use.
+  /// \param[in] _topic The topic.
+  /// \return The publisher, or nullptr if it failed.
+  public: template <typename M>
+  static Publisher Advertise(const std::string &_topic)
+  {
+    return AdvertiseImpl(_topic, M().GetTypeName(),
+        [](gz::transport::Node &_node, const std::string &_t)
+        {
+          return _node.Advertise<M>(_t);
+        });
+  }
+
+  /// \brief Advertise a service on the shared node.
+  /// \param[in] _service The service name.
+  /// \param[in] _callback The callback for each request.
+  /// \return A handle that unadvertises the service when the last copy
+  /// is released, or nullptr if it failed.
+  public: template <typename Req, typename Rep>
+  static Subscription AdvertiseService(const std::string &_service,
+      const std::function<bool(const Req &, Rep &)> &_callback)
+  {
+    return AdvertiseServiceImpl(_service,
+        [_callback](gz::transport::Node &_node, const std::string &_s)
+        {
+          std::function<bool(const Req &, Rep &)> cb = _callback;
+          return _node.Advertise(_s, cb);
+        });
+  }
+
+  /// \brief The number of topics subscribed to.
+  public: static size_t SubscribedTopicCount();
+
+  /// \brief The number of topics advertised.
+  public: static size_t AdvertisedTopicCount();
+
+  /// \brief True if the shared node exists.
+  public: static bool HasNode();
+
+  /// \brief A type erased message callback.
+  private: using Callback =
+      std::function<void(const gz::transport::ProtoMsg &)>;
+
+  /// \brief Subscribes the shared node to a topic.
+  private: using NodeSubscriber = std::function<bool(
+      gz::transport::Node &, const std::string &, const Callback &)>;
+
+  /// \brief Advertises a topic on the shared node.
+  private: using NodeAdvertiser = std::function<
+      gz::transport::Node::Publisher(gz::transport::Node &,
+          const std::string &)>;
+
+  /// \brief Advertises a service on the shared node.
+  private: using ServiceAdvertiser = std::function<bool(
+      gz::transport::Node &, const std::string &)>;
+
+  /// \brief Add a callback to a topic, subscribing if needed.
+  private: static Subscription SubscribeImpl(const std::string &_topic,
+      const std::string &_type, const Callback &_callback,
+      const NodeSubscriber &_subscriber);
+
+  /// \brief Find or advertise the publisher for a topic.
+  private: static Publisher AdvertiseImpl(const std::string &_topic,
+      const std::string &_type, const NodeAdvertiser &_advertiser);
+
+  /// \brief Advertise a service if not already advertised.
+  private: static Subscription AdvertiseServiceImpl(
+      const std::string &_service, const ServiceAdvertiser &_advertiser);
+};
+
+}  // namespace asv
+
+#endif  // ASV_SIM_TRANSPORTREGISTRY_HH_
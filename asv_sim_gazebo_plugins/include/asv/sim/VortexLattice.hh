@@ -0,0 +1,124 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ASV_SIM_VORTEXLATTICE_HH_
+#define ASV_SIM_VORTEXLATTICE_HH_
+
+#include <memory>
+#include <vector>
+
+#include <gz/math/Pose3.hh>
+#include <gz/math/Vector3.hh>
+
+#include "asv/sim/SailPlanform.hh"
+
+namespace asv
+{
+class VortexLatticePrivate;
+
+/// \brief A vortex lattice solver for a set of interacting lifting
+/// surfaces, such as the main and jib of a rig.
+///
+/// Each spanwise strip of a surface is modelled as a horseshoe vortex
+/// with the bound vortex at the quarter chord and the control point
+/// at the three quarter chord. The influence matrix depends only on
+/// the relative geometry of the surfaces, so its LU factorisation is
+/// cached and only recomputed when a surface rotates by more than the
+/// refactorisation threshold. Between refactorisations each solve is a
+/// back-substitution.
+///
+/// All positions and velocities are expressed in a common reference
+/// frame, usually the frame of the model's base link.
+class VortexLattice
+{
+  /// \brief Destructor.
+  public: virtual ~VortexLattice();
+
+  /// \brief Constructor.
+  public: VortexLattice();
+
+  /// \brief Add a lifting surface.
+  /// \param[in] _strips Spanwise strips in the surface frame.
+  /// \param[in] _forward Foil forward direction (surface frame).
+  /// \param[in] _upward Foil upward direction (surface frame).
+  /// \return The index of the surface.
+  public: size_t AddSurface(
+      const std::vector<SailStrip> &_strips,
+      const gz::math::Vector3d &_forward,
+      const gz::math::Vector3d &_upward);
+
+  /// \brief The number of surfaces.
+  public: size_t SurfaceCount() const;
+
+  /// \brief The total number of panels.
+  public: size_t PanelCount() const;
+
+  /// \brief The index of the first panel of a surface. The panels of
+  /// a surface are contiguous and ordered as its strips.
+  /// \param[in] _surface The surface index.
+  public: size_t PanelOffset(size_t _surface) const;
+
+  /// \brief Set the rotation, in radians, a surface may move through
+  /// before the influence matrix is refactorised.
+  /// \param[in] _angle The refactorisation threshold.
+  public: void SetRefactorThreshold(double _angle);
+
+  /// \brief Set the pose of a surface in the reference frame.
+  /// \param[in] _surface The surface index.
+  /// \param[in] _pose The surface pose.
+  public: void SetSurfacePose(size_t _surface,
+      const gz::math::Pose3d &_pose);
+
+  /// \brief The midpoint of the bound vortex of a panel, where the
+  /// panel force acts (reference frame).
+  /// \param[in] _panel The panel index.
+  public: const gz::math::Vector3d &BoundMidpoint(size_t _panel) const;
+
+  /// \brief The control point of a panel (reference frame).
+  /// \param[in] _panel The panel index.
+  public: const gz::math::Vector3d &ControlPoint(size_t _panel) const;
+
+  /// \brief The velocity induced at a point by the circulation on the
+  /// panels of one surface from the last solve.
+  /// \param[in] _point The point (reference frame).
+  /// \param[in] _surface The surface index.
+  public: gz::math::Vector3d InducedVelocity(
+      const gz::math::Vector3d &_point, size_t _surface) const;
+
+  /// \brief Solve for the circulation and compute the panel forces.
+  /// \param[in] _velU Free-stream velocity at each panel.
+  /// \param[in] _fluidDensity The fluid density.
+  /// \param[out] _force The force on each panel.
+  /// \return True if successful.
+  public: bool Solve(
+      const std::vector<gz::math::Vector3d> &_velU,
+      double _fluidDensity,
+      std::vector<gz::math::Vector3d> &_force);
+
+  /// \brief The circulation of a panel from the last solve.
+  /// \param[in] _panel The panel index.
+  public: double Circulation(size_t _panel) const;
+
+  /// \brief The number of times the influence matrix has been factorised.
+  public: size_t FactorisationCount() const;
+
+  /// \internal
+  /// \brief Pointer to the class private data.
+  private: std::unique_ptr<VortexLatticePrivate> data;
+};
+
+}  // namespace asv
+
+#endif  // ASV_SIM_VORTEXLATTICE_HH_
@@ -0,0 +1,94 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ASV_SIM_WAKEBUFFER_HH_
+#define ASV_SIM_WAKEBUFFER_HH_
+
+#include <vector>
+
+#include <gz/math/Vector3.hh>
+
+namespace asv
+{
+/// \brief A fixed-size ring buffer of the wake state shed by a foil,
+/// used to delay its effect on a downstream foil by the convection time.
+///
+/// Samples are stored at a fixed period so the span of history held
+/// does not depend on the simulation step. The storage is allocated in
+/// the constructor and the buffer does not allocate after that.
+class WakeBuffer
+{
+  /// \brief Constructor.
+  /// \param[in] _capacity The number of samples held.
+  /// \param[in] _period The time between samples in seconds.
+  public: WakeBuffer(size_t _capacity = 256, double _period = 0.01);
+
+  /// \brief The number of samples held.
+  public: size_t Size() const;
+
+  /// \brief The longest delay that can be sampled.
+  public: double Span() const;
+
+  /// \brief Remove all samples.
+  public: void Clear();
+
+  /// \brief Add a sample. Samples closer than the period to the last
+  /// stored sample are ignored, and a time earlier than the last sample
+  /// (for example after a reset) clears the buffer.
+  /// \param[in] _time The sample time.
+  /// \param[in] _value The wake state.
+  public: void Push(double _time, const gz::math::Vector3d &_value);
+
+  /// \brief The wake state at a time, interpolated between samples.
+  /// Times before the oldest sample return the oldest sample, and times
+  /// after the newest sample return the newest sample.
+  /// \param[in] _time The time to sample at.
+  /// \return The wake state, or zero if the buffer is empty.
+  public: gz::math::Vector3d Sample(double _time) const;
+
+  /// \brief Index of the n-th oldest sample in the storage.
+  private: size_t Index(size_t _n) const;
+
+  /// \brief Time between samples.
+  private: double period;
+
+  /// \brief Sample times.
+  private: std::vector<double> time;
+
+  /// \brief Sample values.
+  private: std::vector<gz::math::Vector3d> value;
+
+  /// \brief Index of the oldest sample.
+  private: size_t head = 0;
+
+  /// \brief Number of samples held.
+  private: size_t count = 0;
+};
+
+/// \brief Distance the free stream carries the wake from an upstream
+/// point to a downstream point.
+/// \param[in] _upstream Position of the upstream foil.
+/// \param[in] _downstream Position of the downstream foil.
+/// \param[in] _velocity Free stream at the downstream foil.
+/// \return The distance along the free stream, or zero if the
+/// downstream point is not downstream or the free stream is too slow.
+double ConvectionDistance(
+    const gz::math::Vector3d &_upstream,
+    const gz::math::Vector3d &_downstream,
+    const gz::math::Vector3d &_velocity);
+
+}  // namespace asv
+
+#endif  // ASV_SIM_WAKEBUFFER_HH_
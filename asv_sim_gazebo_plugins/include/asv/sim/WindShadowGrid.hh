@@ -0,0 +1,125 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ASV_SIM_WINDSHADOWGRID_HH_
+#define ASV_SIM_WINDSHADOWGRID_HH_
+
+#include <cstdint>
+#include <vector>
+
+#include <gz/math/Vector3.hh>
+
+namespace asv
+{
+/// \brief The wake cone shed downwind of a sail.
+struct WindShadowCone
+{
+  /// \brief Apex of the cone, at the sail centre of effort.
+  gz::math::Vector3d apex;
+
+  /// \brief Unit direction the wind blows towards. Only the horizontal
+  /// components are used.
+  gz::math::Vector3d direction{1, 0, 0};
+
+  /// \brief Radius of the cone at the apex, about half the sail chord.
+  double radius = 1.0;
+
+  /// \brief Length of the cone.
+  double length = 50.0;
+
+  /// \brief Half angle of the cone in radians.
+  double halfAngle = 0.2;
+
+  /// \brief Fractional wind speed deficit at the apex on the cone axis.
+  double deficit = 0.3;
+
+  /// \brief Identifier of the source, such as its model entity.
+  /// Surfaces are not shadowed by cones with their own source.
+  uint64_t source = 0;
+};
+
+/// \brief A uniform spatial hash grid of sail wake cones.
+///
+/// Each cone is inserted into the hash buckets of every horizontal grid
+/// cell its bounding box overlaps, and a query only tests the cones in
+/// the bucket of the query point. Building and querying the grid for N
+/// boats is therefore O(N) for a fleet spread over open water, rather
+/// than the O(N^2) of testing every pair.
+///
+/// The deficit inside a cone falls linearly to zero along its length
+/// and quadratically to zero at its edge, and the deficits of
+/// overlapping cones combine multiplicatively. Bucket storage is kept
+/// between steps, so rebuilding the grid does not allocate once the
+/// fleet has been seen.
+class WindShadowGrid
+{
+  /// \brief Constructor.
+  /// \param[in] _cellSize Length of the side of a grid cell.
+  /// \param[in] _numBuckets Number of hash buckets, rounded up to a
+  /// power of two.
+  public: explicit WindShadowGrid(double _cellSize = 10.0,
+      size_t _numBuckets = 4096);
+
+  /// \brief Remove all cones.
+  public: void Clear();
+
+  /// \brief Insert a cone.
+  /// \param[in] _cone The cone.
+  /// \return The index of the cone.
+  public: size_t Insert(const WindShadowCone &_cone);
+
+  /// \brief The number of cones.
+  public: size_t ConeCount() const;
+
+  /// \brief The factor the wind speed is reduced by at a point.
+  /// \param[in] _point The point.
+  /// \param[in] _source The source of the surface at the point, whose
+  /// own cones are ignored.
+  /// \return The wind speed factor, in (0, 1].
+  public: double Factor(const gz::math::Vector3d &_point,
+      uint64_t _source) const;
+
+  /// \brief The deficit of a single cone at a point.
+  /// \param[in] _cone The cone.
+  /// \param[in] _point The point.
+  /// \return The fractional wind speed deficit, zero outside the cone.
+  public: static double Deficit(const WindShadowCone &_cone,
+      const gz::math::Vector3d &_point);
+
+  /// \brief The bucket of a grid cell.
+  private: size_t Bucket(int64_t _i, int64_t _j) const;
+
+  /// \brief The grid cell of a coordinate.
+  private: int64_t Cell(double _x) const;
+
+  /// \brief Length of the side of a grid cell.
+  private: double cellSize;
+
+  /// \brief Mask applied to the cell hash to give a bucket.
+  private: size_t mask;
+
+  /// \brief The cones.
+  private: std::vector<WindShadowCone> cones;
+
+  /// \brief Indices of the cones overlapping the cells of each bucket.
+  private: std::vector<std::vector<uint32_t>> buckets;
+
+  /// \brief Buckets that are not empty, so clearing is O(cones).
+  private: std::vector<size_t> used;
+};
+
+}  // namespace asv
+
+#endif  // ASV_SIM_WINDSHADOWGRID_HH_
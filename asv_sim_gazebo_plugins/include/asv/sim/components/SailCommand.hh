@@ -0,0 +1,41 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ASV_SIM_COMPONENTS_SAILCOMMAND_HH_
+#define ASV_SIM_COMPONENTS_SAILCOMMAND_HH_
+
+#include <gz/sim/components/Component.hh>
+#include <gz/sim/components/Factory.hh>
+#include <gz/sim/config.hh>
+
+namespace gz
+{
+namespace sim
+{
+// Inline bracket to help doxygen filtering.
+inline namespace GZ_SIM_VERSION_NAMESPACE {
+namespace components
+{
+/// \brief The position commanded for a sail joint by the fleet command
+/// topic. Updated by the SailFleetCommand system.
+using SailPositionCmd = Component<double, class SailPositionCmdTag>;
+GZ_SIM_REGISTER_COMPONENT(
+    "asv_sim.components.SailPositionCmd", SailPositionCmd)
+}
+}
+}
+}
+
+#endif  // ASV_SIM_COMPONENTS_SAILCOMMAND_HH_
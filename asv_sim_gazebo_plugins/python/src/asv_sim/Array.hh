@@ -0,0 +1,121 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ASV_SIM_PYTHON_ARRAY_HH_
+#define ASV_SIM_PYTHON_ARRAY_HH_
+
+#include <string>
+#include <vector>
+
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+
+namespace asv
+{
+namespace python
+{
+/// \brief A float64 input array. A C contiguous float64 array is used
+/// in place; anything else is converted to one.
+using InputArray = pybind11::array_t<double,
+    pybind11::array::c_style | pybind11::array::forcecast>;
+
+/// \brief A float64 output array, which is always written in place.
+using OutputArray = pybind11::array_t<double, pybind11::array::c_style>;
+
+/// \brief Check the shape of an array.
+/// \param[in] _array The array.
+/// \param[in] _name The name of the argument, for the error.
+/// \param[in] _count The number of rows.
+/// \param[in] _width The number of columns, or 0 for a 1-D array.
+/// \throw pybind11::value_error if the shape does not match.
+inline void CheckShape(const pybind11::array &_array, const char *_name,
+    pybind11::ssize_t _count, pybind11::ssize_t _width)
+{
+  bool valid = _width == 0 ?
+      _array.ndim() == 1 && _array.shape(0) == _count :
+      _array.ndim() == 2 && _array.shape(0) == _count &&
+          _array.shape(1) == _width;
+  if (!valid)
+  {
+    throw pybind11::value_error(std::string(_name) + " must have shape (" +
+        std::to_string(_count) +
+        (_width == 0 ? "," : ", " + std::to_string(_width)) + ")");
+  }
+}
+
+/// \brief An optional input array.
+/// \param[in] _object The argument, or None.
+/// \param[in] _name The name of the argument, for the error.
+/// \param[in] _count The number of rows.
+/// \param[in] _width The number of columns, or 0 for a 1-D array.
+/// \param[out] _array The array, which keeps the data alive.
+/// \return The data, or null if the argument is None.
+inline const double *OptionalInput(const pybind11::object &_object,
+    const char *_name, pybind11::ssize_t _count, pybind11::ssize_t _width,
+    InputArray &_array)
+{
+  if (_object.is_none())
+    return nullptr;
+  _array = _object.cast<InputArray>();
+  CheckShape(_array, _name, _count, _width);
+  return _array.data();
+}
+
+/// \brief An output array, new or given by the caller.
+/// \param[in] _object The argument, or None for a new array.
+/// \param[in] _name The name of the argument, for the error.
+/// \param[in] _count The number of rows.
+/// \param[in] _width The number of columns, or 0 for a 1-D array.
+/// \return The array.
+/// \throw pybind11::type_error if the argument is not a C contiguous
+/// float64 array, since a copy would not be seen by the caller.
+inline OutputArray Output(const pybind11::object &_object,
+    const char *_name, pybind11::ssize_t _count, pybind11::ssize_t _width)
+{
+  if (_object.is_none())
+  {
+    if (_width == 0)
+      return OutputArray(_count);
+    return OutputArray({_count, _width});
+  }
+  if (!pybind11::isinstance<OutputArray>(_object))
+  {
+    throw pybind11::type_error(std::string(_name) +
+        " must be a C contiguous float64 array");
+  }
+  auto array = pybind11::reinterpret_borrow<OutputArray>(_object);
+  CheckShape(array, _name, _count, _width);
+  return array;
+}
+
+/// \brief Whether an argument is a single number, a Python int or float
+/// or a numpy scalar, rather than an array or a sequence.
+inline bool IsScalar(const pybind11::handle &_object)
+{
+  return !pybind11::isinstance<pybind11::array>(_object) &&
+      PyNumber_Check(_object.ptr());
+}
+
+/// \brief The shape of an array.
+inline std::vector<pybind11::ssize_t> Shape(const pybind11::array &_array)
+{
+  return std::vector<pybind11::ssize_t>(_array.shape(),
+      _array.shape() + _array.ndim());
+}
+
+}  // namespace python
+}  // namespace asv
+
+#endif  // ASV_SIM_PYTHON_ARRAY_HH_
@@ -0,0 +1,109 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "Catenary.hh"
+
+#include <pybind11/numpy.h>
+
+#include "asv/core/Catenary.hh"
+
+#include "Array.hh"
+
+namespace py = pybind11;
+
+namespace asv
+{
+namespace python
+{
+namespace
+{
+/////////////////////////////////////////////////
+/// \brief The tension of a batch of mooring chains.
+py::tuple BatchTension(const InputArray &_V, const InputArray &_H,
+    const InputArray &_L, const InputArray &_w, double _xtol, int _maxfev)
+{
+  auto shape = Shape(_V);
+  for (const auto *array : {&_H, &_L, &_w})
+  {
+    if (Shape(*array) != shape)
+      throw py::value_error("V, H, L and w must have the same shape");
+  }
+  py::array_t<double> tr(shape);
+  py::array_t<double> tz(shape);
+  py::array_t<int> status(shape);
+  const double *V = _V.data();
+  const double *H = _H.data();
+  const double *L = _L.data();
+  const double *w = _w.data();
+  double *trData = tr.mutable_data();
+  double *tzData = tz.mutable_data();
+  int *statusData = status.mutable_data();
+  {
+    py::gil_scoped_release release;
+    core::CatenaryHSolver solver;
+    solver.xtol = _xtol;
+    solver.maxfev = _maxfev;
+    core::CatenaryTension(static_cast<size_t>(_V.size()), V, H, L, w,
+        solver, trData, tzData, statusData);
+  }
+  return py::make_tuple(tr, tz, status);
+}
+}  // namespace
+
+/////////////////////////////////////////////////
+void DefineCatenary(py::module &_module)
+{
+  _module.attr("CATENARY_CONVERGED") =
+      core::CatenaryHSolver::kConverged;
+  _module.attr("CATENARY_TOO_MANY_EVALUATIONS") =
+      core::CatenaryHSolver::kTooManyEvaluations;
+  _module.attr("CATENARY_NOT_MAKING_PROGRESS") =
+      core::CatenaryHSolver::kNotMakingProgress;
+
+  _module.def("catenary_tension",
+      [](const py::object &_V, const py::object &_H, const py::object &_L,
+          const py::object &_w, double _xtol, int _maxfev)
+      {
+        if (!IsScalar(_V) || !IsScalar(_H) || !IsScalar(_L) ||
+            !IsScalar(_w))
+        {
+          return BatchTension(_V.cast<InputArray>(), _H.cast<InputArray>(),
+              _L.cast<InputArray>(), _w.cast<InputArray>(), _xtol, _maxfev);
+        }
+        core::CatenaryHSolver solver;
+        solver.xtol = _xtol;
+        solver.maxfev = _maxfev;
+        double tr = 0.0;
+        double tz = 0.0;
+        int status = core::CatenaryTension(_V.cast<double>(),
+            _H.cast<double>(), _L.cast<double>(), _w.cast<double>(), solver,
+            tr, tz);
+        return py::make_tuple(tr, tz, status);
+      },
+      py::arg("V"), py::arg("H"), py::arg("L"), py::arg("w"),
+      py::arg("xtol") = 0.001, py::arg("maxfev") = 20,
+      "The tension of a mooring chain at the vessel, as the Mooring "
+      "system computes it. V and H are the vertical and horizontal "
+      "distances from the vessel to the anchor, L the length of the "
+      "chain and w its weight per unit length. Returns the horizontal "
+      "tension, negative towards the anchor, the vertical tension, "
+      "negative downwards, and the solver status, CATENARY_CONVERGED "
+      "if it converged. If any of V, H, L and w is an array they must "
+      "all be arrays of the same shape, and the results are arrays of "
+      "that shape.");
+}
+
+}  // namespace python
+}  // namespace asv
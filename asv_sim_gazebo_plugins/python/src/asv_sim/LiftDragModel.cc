@@ -0,0 +1,272 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "LiftDragModel.hh"
+
+#include <array>
+#include <string>
+
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+
+#include <sdf/sdf.hh>
+
+#include "asv/core/LiftDrag.hh"
+#include "asv/sim/LiftDragModel.hh"
+
+#include "Array.hh"
+
+namespace py = pybind11;
+
+namespace asv
+{
+namespace python
+{
+namespace
+{
+/////////////////////////////////////////////////
+/// \brief The parameters in a dict, with the names of the SDF elements.
+core::LiftDragParams ParamsFromDict(const py::dict &_dict)
+{
+  core::LiftDragParams params;
+  auto vector = [](const py::handle &_value)
+  {
+    auto v = _value.cast<std::array<double, 3>>();
+    return core::Vector3d(v[0], v[1], v[2]);
+  };
+  for (const auto &item : _dict)
+  {
+    auto key = item.first.cast<std::string>();
+    const auto &value = item.second;
+    if (key == "fluid_density")
+      params.fluidDensity = value.cast<double>();
+    else if (key == "forward")
+      params.forward = vector(value);
+    else if (key == "upward")
+      params.upward = vector(value);
+    else if (key == "area")
+      params.area = value.cast<double>();
+    else if (key == "a0")
+      params.alpha0 = value.cast<double>();
+    else if (key == "cla")
+      params.cla = value.cast<double>();
+    else if (key == "alpha_stall")
+      params.alphaStall = value.cast<double>();
+    else if (key == "cla_stall")
+      params.claStall = value.cast<double>();
+    else if (key == "cda")
+      params.cda = value.cast<double>();
+    else if (key == "radial_symmetry")
+    {
+      // Only support radially symmetric lift-drag coefficients at present
+      if (!value.cast<bool>())
+      {
+        throw py::value_error(
+            "LiftDragModel only supports radially symmetric foils");
+      }
+    }
+    else
+    {
+      throw py::key_error("Unknown LiftDragModel parameter [" + key + "]");
+    }
+  }
+  return params;
+}
+
+/////////////////////////////////////////////////
+/// \brief The parameters as a dict, as above.
+py::dict ParamsToDict(const core::LiftDragParams &_params)
+{
+  py::dict dict;
+  dict["fluid_density"] = _params.fluidDensity;
+  dict["forward"] = py::make_tuple(
+      _params.forward.x, _params.forward.y, _params.forward.z);
+  dict["upward"] = py::make_tuple(
+      _params.upward.x, _params.upward.y, _params.upward.z);
+  dict["area"] = _params.area;
+  dict["a0"] = _params.alpha0;
+  dict["cla"] = _params.cla;
+  dict["alpha_stall"] = _params.alphaStall;
+  dict["cla_stall"] = _params.claStall;
+  dict["cda"] = _params.cda;
+  return dict;
+}
+
+/////////////////////////////////////////////////
+/// \brief Create a model from SDF: a document, a <plugin> element or
+/// the parameter elements of a plugin.
+LiftDragModel *FromSdf(const std::string &_sdf)
+{
+  std::string text = _sdf;
+  if (text.find("<sdf") == std::string::npos)
+  {
+    if (text.find("<plugin") == std::string::npos)
+    {
+      text = "<plugin name='lift_drag' filename='lift_drag'>" + text +
+          "</plugin>";
+    }
+    text = "<sdf version='1.6'><model name='model'>" + text +
+        "</model></sdf>";
+  }
+
+  sdf::SDFPtr parsed(new sdf::SDF());
+  sdf::init(parsed);
+  if (!sdf::readString(text, parsed))
+    throw py::value_error("Failed to parse the SDF");
+
+  // The first plugin of the first model, in the root or a world.
+  auto parent = parsed->Root();
+  if (!parent->HasElement("model") && parent->HasElement("world"))
+    parent = parent->GetElement("world");
+  if (!parent->HasElement("model") ||
+      !parent->GetElement("model")->HasElement("plugin"))
+  {
+    throw py::value_error("No <model> with a <plugin> in the SDF");
+  }
+  auto plugin = parent->GetElement("model")->GetElement("plugin");
+
+  auto model = LiftDragModel::Create(plugin);
+  if (!model)
+    throw py::value_error("Invalid LiftDragModel parameters");
+  return model;
+}
+
+/////////////////////////////////////////////////
+/// \brief Evaluate a function of one variable on an array.
+template <typename F>
+py::array_t<double> Map(const InputArray &_input, F _function)
+{
+  py::array_t<double> output(Shape(_input));
+  const double *in = _input.data();
+  double *out = output.mutable_data();
+  const py::ssize_t n = _input.size();
+  {
+    py::gil_scoped_release release;
+    for (py::ssize_t i = 0; i < n; ++i)
+      out[i] = _function(in[i]);
+  }
+  return output;
+}
+
+/////////////////////////////////////////////////
+/// \brief Evaluate a function of one variable on a number or an array.
+/// \return A float for a number, otherwise an array of the input shape.
+template <typename F>
+py::object Apply(const py::object &_input, F _function)
+{
+  if (IsScalar(_input))
+    return py::float_(_function(_input.cast<double>()));
+  return Map(_input.cast<InputArray>(), _function);
+}
+
+/////////////////////////////////////////////////
+/// \brief The batch LiftDragModel::Compute.
+py::tuple Compute(const LiftDragModel &_model, const InputArray &_velU,
+    const py::object &_bodyRot, const py::object &_area,
+    const py::object &_lift, const py::object &_drag)
+{
+  if (_velU.ndim() != 2 || _velU.shape(1) != 3)
+    throw py::value_error("vel_u must have shape (n, 3)");
+  const py::ssize_t n = _velU.shape(0);
+
+  InputArray bodyRotArray;
+  InputArray areaArray;
+  const double *bodyRot = OptionalInput(_bodyRot, "body_rot", n, 4,
+      bodyRotArray);
+  const double *area = OptionalInput(_area, "area", n, 0, areaArray);
+  auto lift = Output(_lift, "lift", n, 3);
+  auto drag = Output(_drag, "drag", n, 3);
+  const double *velU = _velU.data();
+  double *liftData = lift.mutable_data();
+  double *dragData = drag.mutable_data();
+  {
+    py::gil_scoped_release release;
+    _model.Compute(static_cast<size_t>(n), velU, bodyRot, area,
+        liftData, dragData);
+  }
+  return py::make_tuple(lift, drag);
+}
+}  // namespace
+
+/////////////////////////////////////////////////
+void DefineLiftDragModel(py::module &_module)
+{
+  py::class_<LiftDragModel>(_module, "LiftDragModel",
+      "The lift and drag of a radially symmetric foil, as used by the "
+      "SailLiftDrag and FoilLiftDrag systems.")
+    .def(py::init([](const py::dict &_params)
+        {
+          return LiftDragModel::Create(ParamsFromDict(_params));
+        }),
+        py::arg("params") = py::dict(),
+        "Create a model from a dict of parameters named as the SDF "
+        "elements: fluid_density, forward, upward, area, a0, cla, "
+        "alpha_stall, cla_stall, cda and radial_symmetry. Parameters "
+        "that are not given have the defaults of the SDF.")
+    .def_static("from_sdf", &FromSdf,
+        py::arg("sdf"),
+        "Create a model from SDF: a document, whose first model's first "
+        "plugin is used, a <plugin> element, or the parameter elements "
+        "of a plugin.")
+    .def_property_readonly("params",
+        [](const LiftDragModel &_self)
+        {
+          return ParamsToDict(_self.Params());
+        },
+        "The parameters as a dict, as for the constructor.")
+    .def_property_readonly("area", &LiftDragModel::Area,
+        "The foil area.")
+    .def_property_readonly("fluid_density", &LiftDragModel::FluidDensity,
+        "The fluid density.")
+    .def("lift_coefficient",
+        [](const LiftDragModel &_self, const py::object &_alpha)
+        {
+          return Apply(_alpha, [&_self](double _a)
+              {
+                return _self.LiftCoefficient(_a);
+              });
+        },
+        py::arg("alpha"),
+        "The lift coefficient at an angle of attack in [0, pi], or at "
+        "an array of them.")
+    .def("drag_coefficient",
+        [](const LiftDragModel &_self, const py::object &_alpha)
+        {
+          return Apply(_alpha, [&_self](double _a)
+              {
+                return _self.DragCoefficient(_a);
+              });
+        },
+        py::arg("alpha"),
+        "The drag coefficient at an angle of attack in [0, pi], or at "
+        "an array of them.")
+    .def("compute", &Compute,
+        py::arg("vel_u"),
+        py::arg("body_rot") = py::none(),
+        py::arg("area") = py::none(),
+        py::arg("lift") = py::none(),
+        py::arg("drag") = py::none(),
+        "Compute the lift and drag (world frame) of a batch of foils "
+        "with this model's coefficients. vel_u is the free-stream "
+        "velocity of each foil, shape (n, 3), body_rot the orientation "
+        "of each foil as a quaternion w, x, y, z, shape (n, 4), and area "
+        "the area of each foil, shape (n,); by default the foils are "
+        "unrotated and have the model's area. Returns the arrays lift "
+        "and drag, shape (n, 3), which may be given to be written in "
+        "place.");
+}
+
+}  // namespace python
+}  // namespace asv
@@ -0,0 +1,32 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ASV_SIM_PYTHON_LIFTDRAGMODEL_HH_
+#define ASV_SIM_PYTHON_LIFTDRAGMODEL_HH_
+
+#include <pybind11/pybind11.h>
+
+namespace asv
+{
+namespace python
+{
+/// \brief Define a pybind11 wrapper for asv::LiftDragModel.
+/// \param[in] _module The module to add the class to.
+void DefineLiftDragModel(pybind11::module &_module);
+
+}  // namespace python
+}  // namespace asv
+
+#endif  // ASV_SIM_PYTHON_LIFTDRAGMODEL_HH_
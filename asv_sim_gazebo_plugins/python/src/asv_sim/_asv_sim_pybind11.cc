@@ -0,0 +1,29 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <pybind11/pybind11.h>
+
+#include "Catenary.hh"
+#include "LiftDragModel.hh"
+
+PYBIND11_MODULE(BINDINGS_MODULE_NAME, m)
+{
+  m.doc() = "Python bindings for the asv_sim force models. The batch "
+      "methods take and return NumPy arrays, use C contiguous float64 "
+      "arrays in place and release the GIL while they run.";
+
+  asv::python::DefineLiftDragModel(m);
+  asv::python::DefineCatenary(m);
+}
@@ -0,0 +1,96 @@
+# Copyright (C) 2019-2023 Rhys Mainwaring
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+import unittest
+
+import numpy as np
+
+from asv_sim2 import (CATENARY_CONVERGED, CATENARY_NOT_MAKING_PROGRESS,
+                      catenary_tension)
+
+
+class CatenaryTEST(unittest.TestCase):
+
+    def test_scalar(self):
+        # The chain drops vertically.
+        tr, tz, status = catenary_tension(20.0, 4.0, 25.0, 10.0)
+        self.assertEqual(status, CATENARY_CONVERGED)
+        self.assertEqual(tr, 0.0)
+        self.assertEqual(tz, -200.0)
+
+        # A catenary pulls towards the anchor and lifts chain off the
+        # floor.
+        tr, tz, status = catenary_tension(20.0, 10.0, 25.0, 10.0)
+        self.assertEqual(status, CATENARY_CONVERGED)
+        self.assertLess(tr, 0.0)
+        self.assertLess(tz, -200.0)
+        self.assertGreater(tz, -250.0)
+
+        # The chain is too short to reach the anchor.
+        _, _, status = catenary_tension(30.0, 5.0, 25.0, 10.0)
+        self.assertEqual(status, CATENARY_NOT_MAKING_PROGRESS)
+
+        # Python ints and numpy scalars are numbers too.
+        tr, tz, status = catenary_tension(20.0, 10.0, 25.0, 10.0)
+        for args in ((20, 10, 25, 10), (20, 10.0, 25, 10.0),
+                     (np.int64(20), np.float64(10.0), 25, 10)):
+            tr1, tz1, status1 = catenary_tension(*args)
+            self.assertIsInstance(tr1, float)
+            self.assertIsInstance(tz1, float)
+            self.assertEqual(tr1, tr)
+            self.assertEqual(tz1, tz)
+            self.assertEqual(status1, status)
+
+    def test_batch(self):
+        H = np.linspace(6.0, 15.0, 50)
+        V = np.full_like(H, 20.0)
+        L = np.full_like(H, 25.0)
+        w = np.full_like(H, 10.0)
+        tr, tz, status = catenary_tension(V, H, L, w)
+        self.assertEqual(tr.shape, H.shape)
+        self.assertEqual(tz.shape, H.shape)
+        self.assertTrue(np.all(status == CATENARY_CONVERGED))
+
+        # Each chain matches the single calculation.
+        for i in range(H.size):
+            tr1, tz1, status1 = catenary_tension(V[i], H[i], L[i], w[i])
+            self.assertEqual(tr[i], tr1)
+            self.assertEqual(tz[i], tz1)
+            self.assertEqual(status[i], status1)
+
+        # A longer span pulls harder.
+        self.assertTrue(np.all(np.diff(tr) < 0.0))
+
+        # Any shape.
+        tr2, _, _ = catenary_tension(V.reshape(5, 10), H.reshape(5, 10),
+                                     L.reshape(5, 10), w.reshape(5, 10))
+        np.testing.assert_array_equal(tr2, tr.reshape(5, 10))
+
+        with self.assertRaises(ValueError):
+            catenary_tension(V, H[:-1], L, w)
+
+        # A size 1 array of another type is still a batch.
+        tr3, tz3, status3 = catenary_tension(np.array([20]), np.array([10]),
+                                             np.array([25]), np.array([10]))
+        self.assertIsInstance(tr3, np.ndarray)
+        self.assertEqual(tr3.shape, (1,))
+        tr1, tz1, status1 = catenary_tension(20.0, 10.0, 25.0, 10.0)
+        self.assertEqual(tr3[0], tr1)
+        self.assertEqual(tz3[0], tz1)
+        self.assertEqual(status3[0], status1)
+
+
+if __name__ == '__main__':
+    unittest.main()
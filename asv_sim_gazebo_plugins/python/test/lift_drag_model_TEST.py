@@ -0,0 +1,154 @@
+# Copyright (C) 2019-2023 Rhys Mainwaring
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+import math
+import unittest
+
+import numpy as np
+
+from asv_sim2 import LiftDragModel
+
+SDF = """
+<plugin name='wing_sail_liftdrag' filename='libSailPlugin.so'>
+  <a0>0.0</a0>
+  <cla>6.2832</cla>
+  <alpha_stall>0.1592</alpha_stall>
+  <cla_stall>-0.7083</cla_stall>
+  <cda>0.63662</cda>
+  <area>0.4858</area>
+  <fluid_density>1.2</fluid_density>
+  <forward>1 0 0</forward>
+  <upward>0 1 0</upward>
+  <radial_symmetry>true</radial_symmetry>
+</plugin>
+"""
+
+
+class LiftDragModelTEST(unittest.TestCase):
+
+    def test_params(self):
+        model = LiftDragModel({'cla': 5.0, 'area': 2.0,
+                               'forward': (2.0, 0.0, 0.0)})
+        params = model.params
+        self.assertEqual(params['cla'], 5.0)
+        self.assertEqual(params['forward'], (1.0, 0.0, 0.0))
+        self.assertEqual(model.area, 2.0)
+        self.assertEqual(LiftDragModel(params).params, params)
+
+        with self.assertRaises(KeyError):
+            LiftDragModel({'clb': 5.0})
+        with self.assertRaises(ValueError):
+            LiftDragModel({'radial_symmetry': False})
+
+    def test_from_sdf(self):
+        model = LiftDragModel.from_sdf(SDF)
+        self.assertAlmostEqual(model.params['cla'], 6.2832)
+        self.assertEqual(model.params['upward'], (0.0, 1.0, 0.0))
+        self.assertAlmostEqual(model.area, 0.4858)
+        self.assertAlmostEqual(model.fluid_density, 1.2)
+
+        # The parameter elements alone.
+        model = LiftDragModel.from_sdf('<cla>5.0</cla><area>2.0</area>')
+        self.assertEqual(model.params['cla'], 5.0)
+        self.assertEqual(model.area, 2.0)
+
+        with self.assertRaises(ValueError):
+            LiftDragModel.from_sdf('<plugin')
+
+    def test_coefficients(self):
+        model = LiftDragModel.from_sdf(SDF)
+        alpha = np.linspace(0.0, math.pi, 101)
+        cl = model.lift_coefficient(alpha)
+        cd = model.drag_coefficient(alpha)
+        self.assertEqual(cl.shape, alpha.shape)
+        self.assertEqual(cd.shape, alpha.shape)
+        for i, a in enumerate(alpha):
+            self.assertEqual(cl[i], model.lift_coefficient(float(a)))
+            self.assertEqual(cd[i], model.drag_coefficient(float(a)))
+
+        # Python ints are numbers too.
+        self.assertIsInstance(model.lift_coefficient(1), float)
+        self.assertEqual(model.lift_coefficient(1),
+                         model.lift_coefficient(1.0))
+        self.assertIsInstance(model.drag_coefficient(1), float)
+        self.assertEqual(model.drag_coefficient(1),
+                         model.drag_coefficient(1.0))
+
+        # A size 1 array of another type is still an array.
+        cl = model.lift_coefficient(np.array([1]))
+        self.assertIsInstance(cl, np.ndarray)
+        self.assertEqual(cl.shape, (1,))
+        self.assertEqual(cl[0], model.lift_coefficient(1.0))
+        cd = model.drag_coefficient(np.array([1]))
+        self.assertIsInstance(cd, np.ndarray)
+        self.assertEqual(cd[0], model.drag_coefficient(1.0))
+
+        # Lift is antisymmetric and drag symmetric about pi/2.
+        np.testing.assert_allclose(cl, -cl[::-1], atol=1e-12)
+        np.testing.assert_allclose(cd, cd[::-1], atol=1e-12)
+
+    def test_compute(self):
+        model = LiftDragModel.from_sdf(SDF)
+        n = 8
+        i = np.arange(n)
+        yaw = -math.pi + i * math.pi / 4
+        vel_u = np.column_stack([-10.0 + i, 0.5 * i, np.zeros(n)])
+        body_rot = np.column_stack([np.cos(0.5 * yaw), np.zeros(n),
+                                    np.zeros(n), np.sin(0.5 * yaw)])
+        area = 0.1 * (i + 1)
+        lift, drag = model.compute(vel_u, body_rot, area)
+        self.assertEqual(lift.shape, (n, 3))
+        self.assertEqual(drag.shape, (n, 3))
+
+        # Each foil matches the foil alone, scaled by the ratio of areas.
+        for k in range(n):
+            lift1, drag1 = model.compute(vel_u[k:k + 1], body_rot[k:k + 1])
+            scale = area[k] / model.area
+            np.testing.assert_allclose(lift[k], scale * lift1[0],
+                                       atol=1e-12)
+            np.testing.assert_allclose(drag[k], scale * drag1[0],
+                                       atol=1e-12)
+
+        # An angle of attack of 45 degrees.
+        q = 0.5 * model.fluid_density * 10.0 ** 2
+        rot = [[math.cos(math.pi / 8), 0.0, 0.0, math.sin(math.pi / 8)]]
+        lift1, drag1 = model.compute(np.array([[-10.0, 0.0, 0.0]]), rot)
+        cl = model.lift_coefficient(math.pi / 4)
+        cd = model.drag_coefficient(math.pi / 4)
+        np.testing.assert_allclose(lift1[0], [0.0, cl * q * model.area, 0.0],
+                                   atol=1e-9)
+        np.testing.assert_allclose(drag1[0],
+                                   [-cd * q * model.area, 0.0, 0.0],
+                                   atol=1e-9)
+
+        # The outputs may be written in place.
+        out_lift = np.empty((n, 3))
+        out_drag = np.empty((n, 3))
+        result = model.compute(vel_u, body_rot, area, lift=out_lift,
+                               drag=out_drag)
+        self.assertIs(result[0], out_lift)
+        self.assertIs(result[1], out_drag)
+        np.testing.assert_array_equal(out_lift, lift)
+
+        with self.assertRaises(TypeError):
+            model.compute(vel_u, lift=np.empty((n, 3), dtype=np.float32))
+        with self.assertRaises(ValueError):
+            model.compute(vel_u[:, :2])
+        with self.assertRaises(ValueError):
+            model.compute(vel_u, area=area[:-1])
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,361 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+// Steady-state allocation checks for the per-step code paths.
+//
+// The test replaces the global operator new so every allocation on a
+// thread is counted through asv::Metrics::CountAllocation. Each check
+// runs its step once to warm up, which may size buffers, then requires
+// that further steps do not allocate.
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <gz/math/Pose3.hh>
+#include <gz/math/Vector3.hh>
+#include <sdf/sdf.hh>
+
+#include "asv/core/Catenary.hh"
+#include "asv/core/PidArray.hh"
+#include "asv/core/WinchArray.hh"
+#include "asv/sim/FlightRecorder.hh"
+#include "asv/sim/LiftDragModel.hh"
+#include "asv/sim/Log.hh"
+#include "asv/sim/Metrics.hh"
+#include "asv/sim/Recorder.hh"
+#include "asv/sim/SailCommandBuffer.hh"
+#include "asv/sim/SailPlanform.hh"
+#include "asv/sim/Trace.hh"
+#include "asv/sim/VortexLattice.hh"
+#include "asv/sim/WakeBuffer.hh"
+#include "asv/sim/WindShadowGrid.hh"
+
+/////////////////////////////////////////////////
+void *operator new(std::size_t _size)
+{
+  asv::Metrics::CountAllocation();
+  if (void *ptr = std::malloc(_size > 0 ? _size : 1))
+    return ptr;
+  throw std::bad_alloc();
+}
+
+/////////////////////////////////////////////////
+void *operator new[](std::size_t _size)
+{
+  return ::operator new(_size);
+}
+
+/////////////////////////////////////////////////
+void *operator new(std::size_t _size, const std::nothrow_t &) noexcept
+{
+  asv::Metrics::CountAllocation();
+  return std::malloc(_size > 0 ? _size : 1);
+}
+
+/////////////////////////////////////////////////
+void *operator new[](std::size_t _size, const std::nothrow_t &_tag) noexcept
+{
+  return ::operator new(_size, _tag);
+}
+
+/////////////////////////////////////////////////
+void operator delete(void *_ptr) noexcept
+{
+  std::free(_ptr);
+}
+
+/////////////////////////////////////////////////
+void operator delete[](void *_ptr) noexcept
+{
+  std::free(_ptr);
+}
+
+/////////////////////////////////////////////////
+void operator delete(void *_ptr, std::size_t) noexcept
+{
+  std::free(_ptr);
+}
+
+/////////////////////////////////////////////////
+void operator delete[](void *_ptr, std::size_t) noexcept
+{
+  std::free(_ptr);
+}
+
+/////////////////////////////////////////////////
+/// \brief Count the allocations of a number of steps after the warm-up
+/// steps. Rotating buffers, such as the triple buffer of
+/// asv::SailCommandBuffer, size each slot on its first use so warm up
+/// takes a few steps.
+template <typename Step>
+uint64_t SteadyStateAllocations(Step _step, int _steps = 100,
+    int _warmUpSteps = 3)
+{
+  for (int i = 0; i < _warmUpSteps; ++i)
+    _step(i);
+  uint64_t start = asv::Metrics::ThreadAllocations();
+  for (int i = _warmUpSteps; i < _warmUpSteps + _steps; ++i)
+    _step(i);
+  return asv::Metrics::ThreadAllocations() - start;
+}
+
+/////////////////////////////////////////////////
+/// \brief A rectangular planform with span along z and chord along x.
+std::vector<asv::SailStrip> rectangular_strips(double _span, double _chord,
+    int _n)
+{
+  asv::SailPlanform planform;
+  planform.luffFoot = gz::math::Vector3d(0.0, 0.0, -0.5 * _span);
+  planform.luffHead = gz::math::Vector3d(0.0, 0.0, 0.5 * _span);
+  planform.footChord = _chord;
+  planform.headChord = _chord;
+  planform.numStrips = _n;
+
+  std::vector<asv::SailStrip> strips;
+  planform.Discretise(gz::math::Vector3d(1.0, 0.0, 0.0), strips);
+  return strips;
+}
+
+/////////////////////////////////////////////////
+TEST(Allocation, Counted)
+{
+    // The harness must see allocations for the other tests to mean
+    // anything.
+    auto allocs = SteadyStateAllocations([](int _i)
+    {
+      std::vector<double> values(16 + _i);
+      EXPECT_EQ(values.size(), 16u + _i);
+    }, 10, 1);
+    EXPECT_EQ(allocs, 10u);
+}
+
+/////////////////////////////////////////////////
+TEST(Allocation, LiftDragModel)
+{
+    sdf::SDFPtr model(new sdf::SDF());
+    sdf::init(model);
+    ASSERT_TRUE(sdf::readString(
+        "<sdf version='1.6'>"
+        "<model name='wing_sail'>"
+        "  <plugin name='wing_sail_liftdrag' filename='libSailPlugin.so'>"
+        "    <a0>0.0</a0>"
+        "    <cla>6.2832</cla>"
+        "    <alpha_stall>0.1592</alpha_stall>"
+        "    <cla_stall>-0.7083</cla_stall>"
+        "    <cda>0.63662</cda>"
+        "    <area>0.4858</area>"
+        "    <fluid_density>1.2</fluid_density>"
+        "    <forward>1 0 0</forward>"
+        "    <upward>0 1 0</upward>"
+        "  </plugin>"
+        "</model>"
+        "</sdf>", model));
+    sdf::ElementPtr plugin
+        = model->Root()->GetElement("model")->GetElement("plugin");
+    std::unique_ptr<asv::LiftDragModel> liftDrag(
+        asv::LiftDragModel::Create(plugin));
+    ASSERT_NE(liftDrag, nullptr);
+
+    // One surface.
+    auto allocs = SteadyStateAllocations([&](int _i)
+    {
+      gz::math::Vector3d vel(-5.0, 0.1 * _i, 0.0);
+      gz::math::Vector3d lift, drag;
+      double alpha, u, cl, cd;
+      liftDrag->Compute(vel, gz::math::Pose3d::Zero, lift, drag,
+          alpha, u, cl, cd);
+    });
+    EXPECT_EQ(allocs, 0u);
+
+    // A batch of strips, reusing the outputs.
+    std::vector<gz::math::Vector3d> vel(10, gz::math::Vector3d(-5, 1, 0));
+    std::vector<gz::math::Quaterniond> rot(10);
+    std::vector<double> area(10, 0.1);
+    std::vector<gz::math::Vector3d> lift, drag;
+    allocs = SteadyStateAllocations([&](int)
+    {
+      liftDrag->Compute(vel, rot, area, lift, drag);
+    });
+    EXPECT_EQ(allocs, 0u);
+}
+
+/////////////////////////////////////////////////
+TEST(Allocation, Controllers)
+{
+    asv::core::PidArray pid;
+    asv::core::WinchArray winch;
+    for (int k = 0; k < 8; ++k)
+    {
+      pid.Add(1.0, 0.1, 0.01, 1.0, -1.0, 10.0, -10.0, 0.0);
+      winch.Add(asv::core::WinchParams(), 0.5);
+    }
+    std::vector<double> error(8, 0.1);
+    std::vector<double> cmd(8);
+    std::vector<double> target(8, 0.2);
+    std::vector<double> position(8, 0.3);
+    std::vector<double> force(8);
+
+    auto allocs = SteadyStateAllocations([&](int)
+    {
+      pid.Update(0, 0.1, 0.001);
+      pid.Update(error.data(), 0.001, cmd.data());
+      winch.Update(0, 0.2, 0.3, 0.001);
+      winch.Update(target.data(), position.data(), 0.001, force.data());
+    });
+    EXPECT_EQ(allocs, 0u);
+}
+
+/////////////////////////////////////////////////
+TEST(Allocation, Catenary)
+{
+    // The mooring solve as the vessel drifts on a taut chain, the
+    // single chain and batch forms.
+    asv::core::CatenaryHSolver solver;
+    double V[4] = {10.0, 10.0, 12.0, 8.0};
+    double H[4] = {};
+    double L[4] = {30.0, 30.0, 35.0, 25.0};
+    double w[4] = {10.0, 10.0, 12.0, 8.0};
+    double tr[4] = {};
+    double tz[4] = {};
+    int status[4] = {};
+
+    auto allocs = SteadyStateAllocations([&](int _i)
+    {
+      double tr0 = 0.0, tz0 = 0.0;
+      ASSERT_EQ(asv::core::CatenaryTension(10.0, 25.0 + 0.01 * _i, 30.0,
+          10.0, solver, tr0, tz0), asv::core::CatenaryHSolver::kConverged);
+      for (int k = 0; k < 4; ++k)
+        H[k] = L[k] - 0.5 * V[k] + 0.01 * _i;
+      ASSERT_EQ(asv::core::CatenaryTension(4, V, H, L, w, solver, tr, tz,
+          status), 4u);
+    });
+    EXPECT_EQ(allocs, 0u);
+}
+
+/////////////////////////////////////////////////
+TEST(Allocation, WakeAndShadow)
+{
+    asv::WakeBuffer wake(64, 0.01);
+    asv::WindShadowGrid grid(5.0, 64);
+    asv::WindShadowCone cone;
+    cone.direction = gz::math::Vector3d(1.0, 0.0, 0.0);
+
+    auto allocs = SteadyStateAllocations([&](int _i)
+    {
+      double time = 0.001 * _i;
+      wake.Push(time, gz::math::Vector3d(0.0, 1.0, 0.0));
+      wake.Sample(time - 0.05);
+
+      grid.Clear();
+      for (int k = 0; k < 8; ++k)
+      {
+        cone.apex = gz::math::Vector3d(0.0, 20.0 * k, 5.0);
+        cone.source = k;
+        grid.Insert(cone);
+      }
+      grid.Factor(gz::math::Vector3d(10.0, 0.0, 5.0), 1);
+    });
+    EXPECT_EQ(allocs, 0u);
+}
+
+/////////////////////////////////////////////////
+TEST(Allocation, VortexLattice)
+{
+    asv::VortexLattice vlm;
+    vlm.AddSurface(rectangular_strips(8.0, 1.0, 20),
+        gz::math::Vector3d(1.0, 0.0, 0.0),
+        gz::math::Vector3d(0.0, 1.0, 0.0));
+    std::vector<gz::math::Vector3d> vel(vlm.PanelCount(),
+        gz::math::Vector3d(-10.0, 1.0, 0.0));
+    std::vector<gz::math::Vector3d> force;
+
+    // Small trim changes reuse the factorisation and its storage.
+    auto allocs = SteadyStateAllocations([&](int _i)
+    {
+      vlm.SetSurfacePose(0,
+          gz::math::Pose3d(0.0, 0.0, 0.0, 0.0, 0.0, 1.0E-4 * _i));
+      ASSERT_TRUE(vlm.Solve(vel, 1.2, force));
+    });
+    EXPECT_EQ(allocs, 0u);
+}
+
+/////////////////////////////////////////////////
+TEST(Allocation, SailCommandBuffer)
+{
+    asv::SailCommandBuffer buffer;
+    auto allocs = SteadyStateAllocations([&](int _i)
+    {
+      auto &commands = buffer.BeginWrite();
+      commands.resize(4);
+      commands[0].position = 0.01 * _i;
+      buffer.Publish();
+      ASSERT_NE(buffer.Read(), nullptr);
+    });
+    EXPECT_EQ(allocs, 0u);
+}
+
+/////////////////////////////////////////////////
+TEST(Allocation, Diagnostics)
+{
+    // Flight and trace recorders.
+    asv::FlightRecorder flight;
+    ASSERT_TRUE(flight.Open(testing::TempDir() + "allocation.ring", 64));
+    asv::Recorder recorder(1024, 100);
+    uint32_t type = recorder.RegisterType("force", {"fx", "fy", "fz"});
+    ASSERT_TRUE(recorder.Open(testing::TempDir() + "allocation.asvr"));
+
+    // Tracing, one channel enabled and one not.
+    asv::Tracer tracer;
+    tracer.SetSink([](const std::string &) {});
+    asv::TraceChannel on("On", {"v:3"}, 1, tracer);
+    asv::TraceChannel off("Off", {"v:3"}, 1, tracer);
+    tracer.Enable("On");
+
+    // Metrics and rate-limited logging.
+    asv::Metric latency(asv::Metric::Kind::kLatency);
+    asv::Metric counter(asv::Metric::Kind::kCounter);
+    asv::LogSite site(__FILE__, __LINE__);
+
+    const double values[] = {1.0, 2.0, 3.0};
+    auto allocs = SteadyStateAllocations([&](int _i)
+    {
+      asv::MetricTimer timer(latency);
+      counter.Increment();
+      double time = 0.001 * _i;
+      flight.Write(asv::FlightRecorder::kLiftDrag, time, 1, values, 3);
+      recorder.Record(type, time, 1, values);
+      if (on.Enabled())
+        on.Write(time, {1.0, 2.0, 3.0});
+      if (off.Enabled())
+        off.Write(time, {1.0, 2.0, 3.0});
+      site.Allow(time);
+    });
+    EXPECT_EQ(allocs, 0u);
+
+    recorder.Close();
+    flight.Close();
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,469 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#include "asv/sim/BoatModel.hh"
+
+#include <string>
+#include <vector>
+
+#include <gz/common/Console.hh>
+#include <gz/math/Pose3.hh>
+#include <gz/math/Quaternion.hh>
+#include <gz/math/Vector3.hh>
+
+#include "asv/sim/CoreTypes.hh"
+#include "asv/sim/LiftDragModel.hh"
+#include "asv/sim/SailPlanform.hh"
+
+namespace asv
+{
+namespace
+{
+/////////////////////////////////////////////////
+/// \brief Find a child element by name attribute.
+std::shared_ptr<const sdf::Element> FindNamed(
+    const std::shared_ptr<const sdf::Element> &_parent,
+    const std::string &_type, const std::string &_name)
+{
+  auto elem = _parent->FindElement(_type);
+  while (elem)
+  {
+    if (elem->Get<std::string>("name") == _name)
+      return elem;
+    elem = elem->GetNextElement(_type);
+  }
+  return nullptr;
+}
+
+/////////////////////////////////////////////////
+/// \brief The revolute joint with a link as its child.
+std::shared_ptr<const sdf::Element> FindChildJoint(
+    const std::shared_ptr<const sdf::Element> &_model,
+    const std::string &_link)
+{
+  auto elem = _model->FindElement("joint");
+  while (elem)
+  {
+    if (elem->Get<std::string>("type") == "revolute" &&
+        elem->Get<std::string>("child") == _link)
+    {
+      return elem;
+    }
+    elem = elem->GetNextElement("joint");
+  }
+  return nullptr;
+}
+
+/////////////////////////////////////////////////
+/// \brief The mass properties of a link in the model frame.
+struct LinkInertial
+{
+  double mass = 0.0;
+  gz::math::Vector3d com = gz::math::Vector3d::Zero;
+  double inertia[3][3] = {{0.0}};
+};
+
+/////////////////////////////////////////////////
+/// \brief Load the <inertial> of a link.
+/// \return False if the link has none.
+bool LoadInertial(const std::shared_ptr<const sdf::Element> &_link,
+    LinkInertial &_inertial)
+{
+  if (!_link->HasElement("inertial"))
+    return false;
+  auto inertial = _link->FindElement("inertial");
+  auto linkPose =
+      _link->Get<gz::math::Pose3d>("pose", gz::math::Pose3d::Zero).first;
+  auto comPose = linkPose * inertial->Get<gz::math::Pose3d>(
+      "pose", gz::math::Pose3d::Zero).first;
+  _inertial.mass = inertial->Get<double>("mass", 1.0).first;
+  _inertial.com = comPose.Pos();
+
+  // Inertia tensor in the inertial frame, rotated to the model frame.
+  double local[3][3] = {{1.0, 0.0, 0.0}, {0.0, 1.0, 0.0}, {0.0, 0.0, 1.0}};
+  if (inertial->HasElement("inertia"))
+  {
+    auto elem = inertial->FindElement("inertia");
+    local[0][0] = elem->Get<double>("ixx", 1.0).first;
+    local[1][1] = elem->Get<double>("iyy", 1.0).first;
+    local[2][2] = elem->Get<double>("izz", 1.0).first;
+    local[0][1] = local[1][0] = elem->Get<double>("ixy", 0.0).first;
+    local[0][2] = local[2][0] = elem->Get<double>("ixz", 0.0).first;
+    local[1][2] = local[2][1] = elem->Get<double>("iyz", 0.0).first;
+  }
+  gz::math::Vector3d axes[3] = {
+      comPose.Rot().RotateVector(gz::math::Vector3d::UnitX),
+      comPose.Rot().RotateVector(gz::math::Vector3d::UnitY),
+      comPose.Rot().RotateVector(gz::math::Vector3d::UnitZ)};
+  for (int i = 0; i < 3; ++i)
+  {
+    for (int j = 0; j < 3; ++j)
+    {
+      double sum = 0.0;
+      for (int k = 0; k < 3; ++k)
+      {
+        for (int l = 0; l < 3; ++l)
+          sum += axes[k][i] * local[k][l] * axes[l][j];
+      }
+      _inertial.inertia[i][j] = sum;
+    }
+  }
+  return true;
+}
+
+/////////////////////////////////////////////////
+/// \brief The moment of inertia of a link about an axis.
+/// \param[in] _inertial The link mass properties (model frame).
+/// \param[in] _origin A point on the axis (model frame).
+/// \param[in] _axis The axis (model frame, unit).
+double AxisInertia(const LinkInertial &_inertial,
+    const gz::math::Vector3d &_origin, const gz::math::Vector3d &_axis)
+{
+  double moment = 0.0;
+  for (int i = 0; i < 3; ++i)
+  {
+    for (int j = 0; j < 3; ++j)
+      moment += _axis[i] * _inertial.inertia[i][j] * _axis[j];
+  }
+  auto r = _inertial.com - _origin;
+  auto rPerp = r - r.Dot(_axis) * _axis;
+  return moment + _inertial.mass * rPerp.SquaredLength();
+}
+
+/////////////////////////////////////////////////
+/// \brief Load a SailLiftDrag or FoilLiftDrag plugin.
+bool LoadSurface(const std::shared_ptr<const sdf::Element> &_model,
+    const std::shared_ptr<const sdf::Element> &_plugin, bool _sail,
+    core::BoatSurface &_surface)
+{
+  _surface.sail = _sail;
+  if (!LiftDragModel::LoadParams(_plugin, _surface.params))
+    return false;
+
+  if (!_plugin->HasElement("link_name"))
+  {
+    gzerr << "LoadBoat: plugin requires a <link_name>\n";
+    return false;
+  }
+  _surface.name = _plugin->Get<std::string>("link_name");
+  auto link = FindNamed(_model, "link", _surface.name);
+  if (!link)
+  {
+    gzerr << "LoadBoat: link [" << _surface.name << "] not found\n";
+    return false;
+  }
+  auto linkPose =
+      link->Get<gz::math::Pose3d>("pose", gz::math::Pose3d::Zero).first;
+  _surface.position = ToCore(linkPose.Pos());
+  _surface.rotation = ToCore(linkPose.Rot());
+
+  // Panels: the spanwise strips or the centre of pressure.
+  _surface.panels.clear();
+  if (_plugin->HasElement("strips"))
+  {
+    SailPlanform planform;
+    if (!SailPlanform::Load(_plugin->FindElement("strips"), planform))
+    {
+      gzerr << "LoadBoat: invalid <strips> for [" << _surface.name << "]\n";
+      return false;
+    }
+    std::vector<SailStrip> strips;
+    auto forward = ToGz(_surface.params.forward);
+    planform.Discretise(forward, strips);
+
+    // Twist is about the span axis, normal to the lift-drag plane.
+    auto spanAxis = forward.Cross(ToGz(_surface.params.upward)).Normalize();
+    for (const auto &strip : strips)
+    {
+      _surface.panels.push_back({ToCore(strip.cp), strip.area,
+          ToCore(gz::math::Quaterniond(spanAxis, strip.twist))});
+    }
+
+    _surface.windShearExponent = _plugin->Get<double>(
+        "wind_shear_exponent", _surface.windShearExponent).first;
+    _surface.windReferenceHeight = _plugin->Get<double>(
+        "wind_reference_height", _surface.windReferenceHeight).first;
+  }
+  else
+  {
+    if (!_plugin->HasElement("cp"))
+    {
+      gzerr << "LoadBoat: plugin for [" << _surface.name
+            << "] requires a <cp> or <strips>\n";
+      return false;
+    }
+    _surface.panels.push_back({
+        ToCore(_plugin->Get<gz::math::Vector3d>("cp")),
+        _surface.params.area, core::Quaterniond()});
+  }
+
+  // A surface on a revolute joint is trimmed about its axis.
+  auto joint = FindChildJoint(_model, _surface.name);
+  if (joint)
+  {
+    auto jointPose = linkPose * joint->Get<gz::math::Pose3d>(
+        "pose", gz::math::Pose3d::Zero).first;
+    auto axis = gz::math::Vector3d::UnitZ;
+    if (joint->HasElement("axis"))
+    {
+      auto axisElem = joint->FindElement("axis");
+      axis = axisElem->Get<gz::math::Vector3d>("xyz", axis).first;
+      if (axisElem->HasElement("limit"))
+      {
+        auto limit = axisElem->FindElement("limit");
+        _surface.trimMin = limit->Get<double>(
+            "lower", _surface.trimMin).first;
+        _surface.trimMax = limit->Get<double>(
+            "upper", _surface.trimMax).first;
+      }
+      if (axisElem->HasElement("dynamics"))
+      {
+        _surface.jointDamping = axisElem->FindElement("dynamics")->Get<double>(
+            "damping", _surface.jointDamping).first;
+      }
+    }
+    _surface.trimmable = true;
+    _surface.jointName = joint->Get<std::string>("name");
+    _surface.trimOrigin = ToCore(jointPose.Pos());
+    _surface.trimAxis = ToCore(jointPose.Rot().RotateVector(
+        axis.Normalized()));
+
+    LinkInertial inertial;
+    if (LoadInertial(link, inertial))
+    {
+      _surface.jointInertia = AxisInertia(inertial, jointPose.Pos(),
+          ToGz(_surface.trimAxis));
+    }
+  }
+  return true;
+}
+
+/////////////////////////////////////////////////
+/// \brief Load a Mooring plugin.
+bool LoadMooring(const std::shared_ptr<const sdf::Element> &_model,
+    const std::shared_ptr<const sdf::Element> &_plugin,
+    core::BoatMooring &_mooring)
+{
+  for (auto name : {"link_name", "anchor_position", "chain_length",
+      "chain_mass_per_metre"})
+  {
+    if (!_plugin->HasElement(name))
+    {
+      gzerr << "LoadBoat: Mooring plugin requires a <" << name << ">\n";
+      return false;
+    }
+  }
+  auto linkName = _plugin->Get<std::string>("link_name");
+  auto link = FindNamed(_model, "link", linkName);
+  if (!link)
+  {
+    gzerr << "LoadBoat: link [" << linkName << "] not found\n";
+    return false;
+  }
+  _mooring.attachment = ToCore(link->Get<gz::math::Pose3d>(
+      "pose", gz::math::Pose3d::Zero).first.Pos());
+  _mooring.anchor = ToCore(
+      _plugin->Get<gz::math::Vector3d>("anchor_position"));
+  _mooring.length = _plugin->Get<double>("chain_length");
+
+  // The Mooring system uses this value of gravity.
+  _mooring.weightPerMetre =
+      9.81 * _plugin->Get<double>("chain_mass_per_metre");
+  return true;
+}
+
+/////////////////////////////////////////////////
+/// \brief Load a SailPositionController plugin, one controller for each
+/// of its joints.
+bool LoadController(const std::shared_ptr<const sdf::Element> &_plugin,
+    core::Boat &_boat)
+{
+  core::BoatSailController controller;
+  auto get = [&](const char *_name, double &_value)
+  {
+    _value = _plugin->Get<double>(_name, _value).first;
+  };
+  get("p_gain", controller.p);
+  get("i_gain", controller.i);
+  get("d_gain", controller.d);
+  get("i_max", controller.iMax);
+  get("i_min", controller.iMin);
+  get("cmd_max", controller.cmdMax);
+  get("cmd_min", controller.cmdMin);
+  get("cmd_offset", controller.cmdOffset);
+  get("initial_position", controller.initialPosition);
+  if (_plugin->HasElement("winch"))
+  {
+    auto winch = _plugin->FindElement("winch");
+    auto &params = controller.winchParams;
+    params.maxSpeed = winch->Get<double>("max_speed", params.maxSpeed).first;
+    params.maxForce = winch->Get<double>("max_force", params.maxForce).first;
+    params.maxPower = winch->Get<double>("max_power", params.maxPower).first;
+    params.stiffness =
+        winch->Get<double>("stiffness", params.stiffness).first;
+    params.damping = winch->Get<double>("damping", params.damping).first;
+    params.gain = winch->Get<double>("gain", params.gain).first;
+    controller.winch = true;
+  }
+
+  auto jointElem = _plugin->FindElement("joint_name");
+  while (jointElem)
+  {
+    // Joint names may be scoped; the surfaces carry the unscoped name.
+    auto name = jointElem->Get<std::string>();
+    auto pos = name.rfind("::");
+    if (pos != std::string::npos)
+      name = name.substr(pos + 2);
+
+    bool found = false;
+    for (size_t k = 0; k < _boat.surfaces.size() && !found; ++k)
+    {
+      if (_boat.surfaces[k].sail && _boat.surfaces[k].jointName == name)
+      {
+        controller.surface = k;
+        _boat.controllers.push_back(controller);
+        found = true;
+      }
+    }
+    if (!found)
+    {
+      gzerr << "LoadBoat: no sail on joint [" << name << "]\n";
+      return false;
+    }
+    jointElem = jointElem->GetNextElement("joint_name");
+  }
+  return true;
+}
+}  // namespace
+
+/////////////////////////////////////////////////
+sdf::ElementPtr FindModel(const sdf::ElementPtr &_root,
+    const std::string &_name)
+{
+  auto parent = _root;
+  if (!parent->HasElement("model") && parent->HasElement("world"))
+    parent = parent->GetElement("world");
+  if (!parent->HasElement("model"))
+    return nullptr;
+
+  auto model = parent->GetElement("model");
+  while (model && !_name.empty() &&
+      model->Get<std::string>("name") != _name)
+  {
+    model = model->GetNextElement("model");
+  }
+  return model;
+}
+
+/////////////////////////////////////////////////
+bool LoadBoat(const std::shared_ptr<const sdf::Element> &_model,
+    core::Boat &_boat)
+{
+  _boat = core::Boat();
+  if (!_model || _model->GetName() != "model")
+  {
+    gzerr << "LoadBoat: a <model> element is required\n";
+    return false;
+  }
+
+  _boat.position = ToCore(_model->Get<gz::math::Pose3d>(
+      "pose", gz::math::Pose3d::Zero).first.Pos());
+  _boat.rotation = ToCore(_model->Get<gz::math::Pose3d>(
+      "pose", gz::math::Pose3d::Zero).first.Rot());
+
+  // Mass properties of the links as one rigid body.
+  std::vector<LinkInertial> inertials;
+  gz::math::Vector3d moment = gz::math::Vector3d::Zero;
+  auto link = _model->FindElement("link");
+  while (link)
+  {
+    LinkInertial inertial;
+    if (LoadInertial(link, inertial))
+    {
+      _boat.hull.mass += inertial.mass;
+      moment += inertial.mass * inertial.com;
+      inertials.push_back(inertial);
+    }
+    link = link->GetNextElement("link");
+  }
+  if (_boat.hull.mass > 0.0)
+  {
+    auto com = moment / _boat.hull.mass;
+    double total[3][3] = {{0.0}};
+    for (const auto &inertial : inertials)
+    {
+      auto r = inertial.com - com;
+      for (int i = 0; i < 3; ++i)
+      {
+        for (int j = 0; j < 3; ++j)
+        {
+          total[i][j] += inertial.inertia[i][j] + inertial.mass *
+              ((i == j ? r.SquaredLength() : 0.0) - r[i] * r[j]);
+        }
+      }
+    }
+    _boat.hull.centreOfMass = ToCore(com);
+    _boat.hull.inertia = core::Vector3d(total[0][0], total[1][1],
+        total[2][2]);
+    _boat.hull.inertiaProducts = core::Vector3d(total[0][1], total[0][2],
+        total[1][2]);
+  }
+
+  // Sails and foils.
+  auto plugin = _model->FindElement("plugin");
+  while (plugin)
+  {
+    auto name = plugin->Get<std::string>("name");
+    bool sail = name == "gz::sim::systems::SailLiftDrag";
+    if (sail || name == "gz::sim::systems::FoilLiftDrag")
+    {
+      core::BoatSurface surface;
+      if (!LoadSurface(_model, plugin, sail, surface))
+        return false;
+      _boat.surfaces.push_back(surface);
+    }
+    else if (name == "gz::sim::systems::Mooring")
+    {
+      core::BoatMooring mooring;
+      if (!LoadMooring(_model, plugin, mooring))
+        return false;
+      _boat.moorings.push_back(mooring);
+    }
+    plugin = plugin->GetNextElement("plugin");
+  }
+
+  // Controllers, once the sails are known.
+  plugin = _model->FindElement("plugin");
+  while (plugin)
+  {
+    if (plugin->Get<std::string>("name") ==
+        "gz::sim::systems::SailPositionController" &&
+        !LoadController(plugin, _boat))
+    {
+      return false;
+    }
+    plugin = plugin->GetNextElement("plugin");
+  }
+  if (_boat.surfaces.empty())
+  {
+    gzerr << "LoadBoat: no SailLiftDrag or FoilLiftDrag plugins in ["
+          << _model->Get<std::string>("name") << "]\n";
+    return false;
+  }
+  return true;
+}
+
+}  // namespace asv
@@ -0,0 +1,254 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include <sdf/sdf.hh>
+
+#include "asv/core/Vpp.hh"
+#include "asv/sim/BoatModel.hh"
+#include "asv/sim/FleetWorld.hh"
+
+namespace
+{
+/////////////////////////////////////////////////
+/// \brief The first model of an SDF string.
+sdf::ElementPtr FirstModel(const std::string &_sdf, sdf::SDFPtr &_parsed)
+{
+  _parsed.reset(new sdf::SDF());
+  sdf::init(_parsed);
+  if (!sdf::readString(_sdf, _parsed))
+    return nullptr;
+  return asv::FindModel(_parsed->Root(), "");
+}
+
+/////////////////////////////////////////////////
+std::string StripSail()
+{
+  return
+    "<sdf version='1.6'>"
+    "<model name='dinghy'>"
+    "  <link name='base_link'>"
+    "    <inertial><mass>100</mass></inertial>"
+    "  </link>"
+    "  <link name='sail_link'>"
+    "    <pose>1 0 0.5 0 0 0</pose>"
+    "    <inertial><mass>2</mass></inertial>"
+    "  </link>"
+    "  <joint name='sail_joint' type='revolute'>"
+    "    <pose>0 0 0.5 0 0 0</pose>"
+    "    <parent>base_link</parent>"
+    "    <child>sail_link</child>"
+    "  </joint>"
+    "  <plugin filename='asv_sim2-sail-lift-drag-system'"
+    "      name='gz::sim::systems::SailLiftDrag'>"
+    "    <link_name>sail_link</link_name>"
+    "    <forward>1 0 0</forward>"
+    "    <upward>0 1 0</upward>"
+    "    <area>2</area>"
+    "    <wind_shear_exponent>0.14</wind_shear_exponent>"
+    "    <strips>"
+    "      <num_strips>4</num_strips>"
+    "      <luff_foot>0 0 0</luff_foot>"
+    "      <luff_head>0 0 4</luff_head>"
+    "      <foot_chord>1</foot_chord>"
+    "      <head_chord>0</head_chord>"
+    "    </strips>"
+    "  </plugin>"
+    "</model>"
+    "</sdf>";
+}
+}  // namespace
+
+/////////////////////////////////////////////////
+TEST(BoatModel, FleetWorld)
+{
+    asv::FleetWorldOptions options;
+    sdf::SDFPtr parsed;
+    auto model = FirstModel(asv::GenerateFleetWorld(options), parsed);
+    ASSERT_NE(model, nullptr);
+
+    asv::core::Boat boat;
+    ASSERT_TRUE(asv::LoadBoat(model, boat));
+    ASSERT_EQ(boat.surfaces.size(), 2u);
+    EXPECT_EQ(boat.TrimCount(), 1u);
+    EXPECT_DOUBLE_EQ(boat.hull.mass, 205.0);
+    EXPECT_NEAR(boat.hull.centreOfMass.z, 10.0 / 205.0, 1.0E-12);
+
+    // The sail on its joint.
+    const auto &sail = boat.surfaces[0];
+    EXPECT_EQ(sail.name, "sail_link");
+    EXPECT_TRUE(sail.sail);
+    EXPECT_TRUE(sail.trimmable);
+    EXPECT_DOUBLE_EQ(sail.trimMin, -1.5);
+    EXPECT_DOUBLE_EQ(sail.trimMax, 1.5);
+    EXPECT_DOUBLE_EQ(sail.trimOrigin.x, 0.5);
+    EXPECT_DOUBLE_EQ(sail.trimOrigin.z, 2.0);
+    EXPECT_DOUBLE_EQ(sail.trimAxis.z, 1.0);
+    EXPECT_DOUBLE_EQ(sail.params.area, 3.0);
+    EXPECT_DOUBLE_EQ(sail.params.fluidDensity, 1.2);
+    ASSERT_EQ(sail.panels.size(), 1u);
+    EXPECT_DOUBLE_EQ(sail.panels[0].cp.z, 0.5);
+
+    // The keel on the hull.
+    const auto &keel = boat.surfaces[1];
+    EXPECT_EQ(keel.name, "base_link");
+    EXPECT_FALSE(keel.sail);
+    EXPECT_FALSE(keel.trimmable);
+    EXPECT_DOUBLE_EQ(keel.params.fluidDensity, 1025.0);
+    EXPECT_DOUBLE_EQ(keel.panels[0].cp.z, -0.5);
+
+    // The sail turns on its joint about its centre of mass. The world
+    // is written to six figures.
+    EXPECT_EQ(sail.jointName, "main_sail_joint");
+    EXPECT_DOUBLE_EQ(sail.jointDamping, 10.0);
+    EXPECT_NEAR(sail.jointInertia, 5.0 * (0.01 + 0.0004) / 12.0, 1.0E-8);
+
+    // Inertia of the links about the centre of mass.
+    const double mu = 200.0 * 5.0 / 205.0;
+    EXPECT_NEAR(boat.hull.inertia.x,
+        200.0 * 1.25 / 12.0 + 5.0 * 9.0004 / 12.0 + mu * 4.0, 1.0E-3);
+    EXPECT_NEAR(boat.hull.inertia.y,
+        200.0 * 16.25 / 12.0 + 5.0 * 9.01 / 12.0 + mu * 4.25, 1.0E-3);
+    EXPECT_NEAR(boat.hull.inertia.z,
+        200.0 * 17.0 / 12.0 + 5.0 * 0.0104 / 12.0 + mu * 0.25, 1.0E-3);
+    EXPECT_NEAR(boat.hull.inertiaProducts.x, 0.0, 1.0E-12);
+    EXPECT_NEAR(boat.hull.inertiaProducts.y, -mu, 1.0E-9);
+    EXPECT_NEAR(boat.hull.inertiaProducts.z, 0.0, 1.0E-12);
+
+    // The sheet controller.
+    ASSERT_EQ(boat.controllers.size(), 1u);
+    EXPECT_EQ(boat.controllers[0].surface, 0u);
+    EXPECT_DOUBLE_EQ(boat.controllers[0].p, 100.0);
+    EXPECT_DOUBLE_EQ(boat.controllers[0].i, 0.1);
+    EXPECT_DOUBLE_EQ(boat.controllers[0].initialPosition, 0.5);
+    EXPECT_FALSE(boat.controllers[0].winch);
+
+    // The mooring.
+    ASSERT_EQ(boat.moorings.size(), 1u);
+    const auto &mooring = boat.moorings[0];
+    EXPECT_DOUBLE_EQ(mooring.anchor.x, boat.position.x + 10.0);
+    EXPECT_DOUBLE_EQ(mooring.anchor.z, -20.0);
+    EXPECT_DOUBLE_EQ(mooring.length, 25.0);
+    EXPECT_DOUBLE_EQ(mooring.weightPerMetre, 9.81);
+
+    // The boat sails once it has some resistance.
+    boat.hull.quadraticDrag = asv::core::Vector3d(20.0, 200.0, 0.0);
+    auto point = asv::core::Vpp(boat).Solve(5.0, 1.5);
+    EXPECT_TRUE(point.converged);
+    EXPECT_GT(point.speed, 0.0);
+}
+
+/////////////////////////////////////////////////
+TEST(BoatModel, Strips)
+{
+    sdf::SDFPtr parsed;
+    auto model = FirstModel(StripSail(), parsed);
+    ASSERT_NE(model, nullptr);
+
+    asv::core::Boat boat;
+    ASSERT_TRUE(asv::LoadBoat(model, boat));
+    ASSERT_EQ(boat.surfaces.size(), 1u);
+    const auto &sail = boat.surfaces[0];
+    ASSERT_EQ(sail.panels.size(), 4u);
+    EXPECT_DOUBLE_EQ(sail.windShearExponent, 0.14);
+    EXPECT_DOUBLE_EQ(boat.hull.mass, 102.0);
+
+    // The strip areas sum to the planform area.
+    double area = 0.0;
+    for (const auto &panel : sail.panels)
+      area += panel.area;
+    EXPECT_NEAR(area, 2.0, 1.0E-9);
+
+    // The joint is 0.5 above the link origin.
+    EXPECT_DOUBLE_EQ(sail.trimOrigin.x, 1.0);
+    EXPECT_DOUBLE_EQ(sail.trimOrigin.z, 1.0);
+
+    // Trimming rotates the link about the joint.
+    asv::core::Vector3d position;
+    asv::core::Quaterniond rotation;
+    sail.Pose(M_PI / 2.0, position, rotation);
+    EXPECT_NEAR(position.x, 1.0, 1.0E-12);
+    EXPECT_NEAR(position.y, 0.0, 1.0E-12);
+    EXPECT_NEAR(position.z, 0.5, 1.0E-12);
+    auto forward = rotation.RotateVector(sail.params.forward);
+    EXPECT_NEAR(forward.y, 1.0, 1.0E-12);
+}
+
+/////////////////////////////////////////////////
+TEST(BoatModel, FindModel)
+{
+    sdf::SDFPtr parsed(new sdf::SDF());
+    sdf::init(parsed);
+    ASSERT_TRUE(sdf::readString(
+        "<sdf version='1.6'><world name='fleet'>"
+        "<model name='boat1'><link name='base_link'/></model>"
+        "<model name='boat2'><link name='base_link'/></model>"
+        "</world></sdf>", parsed));
+
+    // The first model, or a model by name, in the first world.
+    auto model = asv::FindModel(parsed->Root(), "");
+    ASSERT_NE(model, nullptr);
+    EXPECT_EQ(model->Get<std::string>("name"), "boat1");
+    model = asv::FindModel(parsed->Root(), "boat2");
+    ASSERT_NE(model, nullptr);
+    EXPECT_EQ(model->Get<std::string>("name"), "boat2");
+    EXPECT_EQ(asv::FindModel(parsed->Root(), "boat3"), nullptr);
+}
+
+/////////////////////////////////////////////////
+TEST(BoatModel, Invalid)
+{
+    asv::core::Boat boat;
+    EXPECT_FALSE(asv::LoadBoat(nullptr, boat));
+
+    // A plugin on a missing link.
+    std::string text = StripSail();
+    text.replace(text.find("<link_name>sail_link"), 20,
+        "<link_name>jib_link");
+    sdf::SDFPtr parsed;
+    auto model = FirstModel(text, parsed);
+    ASSERT_NE(model, nullptr);
+    EXPECT_FALSE(asv::LoadBoat(model, boat));
+
+    // A controller for a joint with no sail.
+    text = StripSail();
+    text.replace(text.find("</model>"), 0,
+        "<plugin filename='asv_sim2-sail-position-controller-system'"
+        "    name='gz::sim::systems::SailPositionController'>"
+        "  <joint_name>dinghy::jib_joint</joint_name>"
+        "</plugin>");
+    model = FirstModel(text, parsed);
+    ASSERT_NE(model, nullptr);
+    EXPECT_FALSE(asv::LoadBoat(model, boat));
+
+    // No sails or foils.
+    model = FirstModel(
+        "<sdf version='1.6'><model name='box'><link name='base_link'/>"
+        "</model></sdf>", parsed);
+    ASSERT_NE(model, nullptr);
+    EXPECT_FALSE(asv::LoadBoat(model, boat));
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
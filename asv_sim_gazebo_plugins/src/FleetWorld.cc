@@ -0,0 +1,219 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#include "asv/sim/FleetWorld.hh"
+
+#include <cmath>
+#include <sstream>
+
+namespace asv
+{
+namespace
+{
+/////////////////////////////////////////////////
+/// \brief Write an inertial element for a box.
+void BoxInertial(std::ostream &_out, double _mass, double _x, double _y,
+    double _z)
+{
+  _out << "        <inertial>\n"
+       << "          <mass>" << _mass << "</mass>\n"
+       << "          <inertia>\n"
+       << "            <ixx>" << _mass * (_y * _y + _z * _z) / 12.0
+       << "</ixx>\n"
+       << "            <iyy>" << _mass * (_x * _x + _z * _z) / 12.0
+       << "</iyy>\n"
+       << "            <izz>" << _mass * (_x * _x + _y * _y) / 12.0
+       << "</izz>\n"
+       << "          </inertia>\n"
+       << "        </inertial>\n";
+}
+
+/////////////////////////////////////////////////
+/// \brief Write a box collision.
+void BoxCollision(std::ostream &_out, double _x, double _y, double _z)
+{
+  _out << "        <collision name=\"collision\">\n"
+       << "          <geometry>\n"
+       << "            <box><size>" << _x << " " << _y << " " << _z
+       << "</size></box>\n"
+       << "          </geometry>\n"
+       << "        </collision>\n";
+}
+
+/////////////////////////////////////////////////
+/// \brief Lift-drag parameters of a symmetric foil.
+void LiftDragParams(std::ostream &_out, double _fluidDensity, double _area)
+{
+  _out << "        <a0>0</a0>\n"
+       << "        <cla>6.2832</cla>\n"
+       << "        <alpha_stall>0.1592</alpha_stall>\n"
+       << "        <cla_stall>-0.7083</cla_stall>\n"
+       << "        <cda>0.63662</cda>\n"
+       << "        <area>" << _area << "</area>\n"
+       << "        <fluid_density>" << _fluidDensity << "</fluid_density>\n"
+       << "        <forward>1 0 0</forward>\n"
+       << "        <upward>0 1 0</upward>\n";
+}
+
+/////////////////////////////////////////////////
+/// \brief Write one vessel.
+void Boat(std::ostream &_out, const FleetWorldOptions &_options,
+    size_t _index, double _x, double _y)
+{
+  std::string name = "boat" + std::to_string(_index);
+
+  _out << "    <model name=\"" << name << "\">\n"
+       << "      <pose>" << _x << " " << _y << " 0 0 0 0</pose>\n"
+       << "      <enable_wind>true</enable_wind>\n"
+       << "      <link name=\"base_link\">\n";
+  BoxInertial(_out, 200.0, 4.0, 1.0, 0.5);
+  BoxCollision(_out, 4.0, 1.0, 0.5);
+  if (_options.anemometers)
+  {
+    _out << "        <sensor name=\"anemometer\" type=\"custom\" "
+         << "gz:type=\"anemometer\">\n"
+         << "          <pose>0 0 1 0 0 0</pose>\n"
+         << "          <always_on>1</always_on>\n"
+         << "          <update_rate>30</update_rate>\n"
+         << "          <topic>/" << name << "/anemometer</topic>\n"
+         << "          <gz:anemometer/>\n"
+         << "        </sensor>\n";
+  }
+  _out << "      </link>\n";
+
+  if (_options.sails)
+  {
+    _out << "      <link name=\"sail_link\">\n"
+         << "        <pose>0.5 0 2 0 0 0</pose>\n";
+    BoxInertial(_out, 5.0, 0.1, 0.02, 3.0);
+    BoxCollision(_out, 0.1, 0.02, 3.0);
+    _out << "      </link>\n"
+         << "      <joint name=\"main_sail_joint\" type=\"revolute\">\n"
+         << "        <parent>base_link</parent>\n"
+         << "        <child>sail_link</child>\n"
+         << "        <axis>\n"
+         << "          <xyz>0 0 1</xyz>\n"
+         << "          <limit><lower>-1.5</lower><upper>1.5</upper></limit>\n"
+         << "          <dynamics><damping>10</damping></dynamics>\n"
+         << "        </axis>\n"
+         << "      </joint>\n"
+         << "      <plugin filename=\"asv_sim2-sail-lift-drag-system\"\n"
+         << "          name=\"gz::sim::systems::SailLiftDrag\">\n"
+         << "        <link_name>sail_link</link_name>\n"
+         << "        <cp>0 0 0.5</cp>\n";
+    LiftDragParams(_out, 1.2, 3.0);
+    _out << "      </plugin>\n";
+
+    if (_options.controllers)
+    {
+      _out << "      <plugin filename=\"asv_sim2-sail-position-controller-"
+           << "system\"\n"
+           << "          name=\"gz::sim::systems::SailPositionController\">\n"
+           << "        <joint_name>main_sail_joint</joint_name>\n"
+           << "        <p_gain>100</p_gain>\n"
+           << "        <initial_position>0.5</initial_position>\n"
+           << "      </plugin>\n";
+    }
+  }
+
+  if (_options.foils)
+  {
+    _out << "      <plugin filename=\"asv_sim2-foil-lift-drag-system\"\n"
+         << "          name=\"gz::sim::systems::FoilLiftDrag\">\n"
+         << "        <link_name>base_link</link_name>\n"
+         << "        <cp>0 0 -0.5</cp>\n";
+    LiftDragParams(_out, 1025.0, 0.5);
+    _out << "      </plugin>\n";
+  }
+
+  if (_options.moorings)
+  {
+    // Offset the anchor so the chain is not vertical and the catenary
+    // solver runs.
+    _out << "      <plugin filename=\"asv_sim2-mooring-system\"\n"
+         << "          name=\"gz::sim::systems::Mooring\">\n"
+         << "        <link_name>base_link</link_name>\n"
+         << "        <anchor_position>" << _x + 10.0 << " " << _y
+         << " -20</anchor_position>\n"
+         << "        <chain_length>25</chain_length>\n"
+         << "        <chain_mass_per_metre>1</chain_mass_per_metre>\n"
+         << "      </plugin>\n";
+  }
+
+  _out << "    </model>\n";
+}
+}  // namespace
+
+/////////////////////////////////////////////////
+std::string GenerateFleetWorld(const FleetWorldOptions &_options)
+{
+  std::ostringstream out;
+  out << "<?xml version=\"1.0\" ?>\n"
+      << "<sdf version=\"1.6\">\n"
+      << "  <world name=\"" << _options.name << "\">\n"
+      << "    <physics name=\"step\" type=\"ignored\">\n"
+      << "      <max_step_size>" << _options.stepSize << "</max_step_size>\n"
+      << "      <real_time_factor>0</real_time_factor>\n"
+      << "    </physics>\n"
+      << "    <plugin filename=\"gz-sim-physics-system\"\n"
+      << "        name=\"gz::sim::systems::Physics\">\n"
+      << "    </plugin>\n"
+      << "    <plugin filename=\"gz-sim-buoyancy-system\"\n"
+      << "        name=\"gz::sim::systems::Buoyancy\">\n"
+      << "      <graded_buoyancy>\n"
+      << "        <default_density>1025</default_density>\n"
+      << "        <density_change>\n"
+      << "          <above_depth>0</above_depth>\n"
+      << "          <density>1.2</density>\n"
+      << "        </density_change>\n"
+      << "      </graded_buoyancy>\n"
+      << "    </plugin>\n"
+      << "    <plugin filename=\"asv_sim2-wind-system\"\n"
+      << "        name=\"gz::sim::systems::Wind\">\n"
+      << "      <topic>/wind</topic>\n"
+      << "    </plugin>\n";
+  if (_options.anemometers)
+  {
+    out << "    <plugin filename=\"asv_sim2-anemometer-system\"\n"
+        << "        name=\"gz::sim::systems::Anemometer\">\n"
+        << "    </plugin>\n";
+  }
+  if (_options.metrics)
+  {
+    out << "    <plugin filename=\"asv_sim2-metrics-system\"\n"
+        << "        name=\"gz::sim::systems::Metrics\">\n"
+        << "    </plugin>\n";
+  }
+  out << "    <wind>\n"
+      << "      <linear_velocity>" << _options.windX << " " << _options.windY
+      << " 0</linear_velocity>\n"
+      << "    </wind>\n";
+
+  size_t columns = static_cast<size_t>(
+      std::ceil(std::sqrt(static_cast<double>(_options.boats))));
+  for (size_t i = 0; i < _options.boats; ++i)
+  {
+    double x = _options.spacing * static_cast<double>(i % columns);
+    double y = _options.spacing * static_cast<double>(i / columns);
+    Boat(out, _options, i, x, y);
+  }
+
+  out << "  </world>\n"
+      << "</sdf>\n";
+  return out.str();
+}
+
+}  // namespace asv
@@ -0,0 +1,98 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include <sdf/Root.hh>
+#include <sdf/World.hh>
+
+#include "asv/sim/FleetWorld.hh"
+
+namespace
+{
+/////////////////////////////////////////////////
+size_t Count(const std::string &_text, const std::string &_pattern)
+{
+  size_t n = 0;
+  for (size_t pos = _text.find(_pattern); pos != std::string::npos;
+      pos = _text.find(_pattern, pos + 1))
+  {
+    ++n;
+  }
+  return n;
+}
+}  // namespace
+
+/////////////////////////////////////////////////
+TEST(FleetWorld, Generate)
+{
+    asv::FleetWorldOptions options;
+    options.boats = 10;
+    std::string world = asv::GenerateFleetWorld(options);
+
+    EXPECT_EQ(Count(world, "<model name=\"boat"), 10u);
+    EXPECT_EQ(Count(world, "gz::sim::systems::SailLiftDrag"), 10u);
+    EXPECT_EQ(Count(world, "gz::sim::systems::SailPositionController"), 10u);
+    EXPECT_EQ(Count(world, "gz::sim::systems::FoilLiftDrag"), 10u);
+    EXPECT_EQ(Count(world, "gz::sim::systems::Mooring"), 10u);
+    EXPECT_EQ(Count(world, "gz:type=\"anemometer\""), 10u);
+    EXPECT_EQ(Count(world, "gz::sim::systems::Anemometer\""), 1u);
+    EXPECT_EQ(Count(world, "gz::sim::systems::Metrics"), 0u);
+
+    // 4 columns and 3 rows, the last row partly filled.
+    EXPECT_NE(world.find("<pose>60 20 0 0 0 0</pose>"), std::string::npos);
+    EXPECT_NE(world.find("<pose>20 40 0 0 0 0</pose>"), std::string::npos);
+    EXPECT_EQ(world.find("<pose>40 40 0 0 0 0</pose>"), std::string::npos);
+    EXPECT_EQ(world.find("<pose>80 "), std::string::npos);
+
+    sdf::Root root;
+    sdf::Errors errors = root.LoadSdfString(world);
+    EXPECT_TRUE(errors.empty());
+    ASSERT_EQ(root.WorldCount(), 1u);
+    EXPECT_EQ(root.WorldByIndex(0)->ModelCount(), 10u);
+}
+
+/////////////////////////////////////////////////
+TEST(FleetWorld, Options)
+{
+    asv::FleetWorldOptions options;
+    options.boats = 3;
+    options.sails = false;
+    options.anemometers = false;
+    options.moorings = false;
+    options.metrics = true;
+    std::string world = asv::GenerateFleetWorld(options);
+
+    EXPECT_EQ(Count(world, "<model name=\"boat"), 3u);
+    EXPECT_EQ(Count(world, "SailLiftDrag"), 0u);
+    EXPECT_EQ(Count(world, "SailPositionController"), 0u);
+    EXPECT_EQ(Count(world, "anemometer"), 0u);
+    EXPECT_EQ(Count(world, "Mooring"), 0u);
+    EXPECT_EQ(Count(world, "gz::sim::systems::FoilLiftDrag"), 3u);
+    EXPECT_EQ(Count(world, "gz::sim::systems::Metrics"), 1u);
+
+    options.boats = 0;
+    world = asv::GenerateFleetWorld(options);
+    EXPECT_EQ(Count(world, "<model"), 0u);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,350 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "asv/sim/FlightRecorder.hh"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <new>
+
+#include <gz/common/Console.hh>
+#include <gz/common/Filesystem.hh>
+
+namespace asv
+{
+namespace
+{
+/// \brief File format version.
+const uint32_t kVersion = 1;
+
+/// \brief Default number of slots, 8 MB.
+const size_t kDefaultSlots = 1 << 16;
+}  // namespace
+
+/////////////////////////////////////////////////
+/// \brief The start of the file, 256 bytes.
+struct FlightRecorder::Header
+{
+  char magic[4];
+  uint32_t version;
+  uint32_t numSlots;
+  uint32_t slotSize;
+
+  /// \brief Sequence number of the next record.
+  std::atomic<uint64_t> next;
+
+  /// \brief Non-zero once frozen.
+  std::atomic<uint32_t> frozen;
+  uint32_t padding;
+  double frozenTime;
+  char reason[216];
+};
+
+/////////////////////////////////////////////////
+/// \brief A record in the ring, 128 bytes.
+struct FlightRecorder::Slot
+{
+  /// \brief Sequence number plus one, zero while being written.
+  std::atomic<uint64_t> sequence;
+  double time;
+  uint64_t entity;
+  uint16_t type;
+  uint16_t count;
+  uint32_t padding;
+  double values[kFlightRecordValues];
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+    "flight recorder needs lock-free atomics in shared memory");
+
+/////////////////////////////////////////////////
+FlightRecorder &FlightRecorder::Instance()
+{
+  static std::unique_ptr<FlightRecorder> recorder = []()
+  {
+    auto r = std::make_unique<FlightRecorder>();
+    const char *env = std::getenv("ASV_SIM_FLIGHT_RECORDER");
+    std::string path = env ? env : "";
+    if (path == "off")
+      return r;
+    if (path.empty())
+    {
+      path = gz::common::joinPaths(gz::common::tempDirectoryPath(),
+          "asv_sim_flight_" + std::to_string(getpid()) + ".ring");
+    }
+    r->Open(path, kDefaultSlots);
+    return r;
+  }();
+  return *recorder;
+}
+
+/////////////////////////////////////////////////
+FlightRecorder::FlightRecorder() = default;
+
+/////////////////////////////////////////////////
+FlightRecorder::~FlightRecorder()
+{
+  this->Close();
+}
+
+/////////////////////////////////////////////////
+bool FlightRecorder::Open(const std::string &_path, size_t _numSlots)
+{
+  static_assert(sizeof(Header) == 256, "flight recorder header layout");
+  static_assert(sizeof(Slot) == 128, "flight recorder slot layout");
+
+  this->Close();
+
+  if (_numSlots == 0 || _numSlots > UINT32_MAX)
+  {
+    gzerr << "Invalid flight recorder size [" << _numSlots << "].\n";
+    return false;
+  }
+
+  this->fd = ::open(_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (this->fd < 0)
+  {
+    gzerr << "Failed to open flight recorder [" << _path << "].\n";
+    return false;
+  }
+
+  this->mapSize = sizeof(Header) + _numSlots * sizeof(Slot);
+  if (::ftruncate(this->fd, static_cast<off_t>(this->mapSize)) != 0)
+  {
+    gzerr << "Failed to size flight recorder [" << _path << "].\n";
+    ::close(this->fd);
+    ::unlink(_path.c_str());
+    this->fd = -1;
+    return false;
+  }
+
+  this->map = ::mmap(nullptr, this->mapSize, PROT_READ | PROT_WRITE,
+      MAP_SHARED, this->fd, 0);
+  if (this->map == MAP_FAILED)
+  {
+    gzerr << "Failed to map flight recorder [" << _path << "].\n";
+    ::close(this->fd);
+    ::unlink(_path.c_str());
+    this->fd = -1;
+    this->map = nullptr;
+    return false;
+  }
+
+  // The file is zero filled, so only the header needs setting.
+  this->header = new (this->map) Header();
+  std::memcpy(this->header->magic, "ASVF", 4);
+  this->header->version = kVersion;
+  this->header->numSlots = static_cast<uint32_t>(_numSlots);
+  this->header->slotSize = sizeof(Slot);
+  this->header->next = 0;
+  this->header->frozen = 0;
+  this->slots = reinterpret_cast<Slot *>(
+      static_cast<char *>(this->map) + sizeof(Header));
+  this->numSlots = _numSlots;
+  this->path = _path;
+  return true;
+}
+
+/////////////////////////////////////////////////
+void FlightRecorder::Close()
+{
+  if (!this->map)
+    return;
+
+  bool frozen = this->Frozen();
+  ::munmap(this->map, this->mapSize);
+  ::close(this->fd);
+  if (!frozen)
+    ::unlink(this->path.c_str());
+
+  this->map = nullptr;
+  this->header = nullptr;
+  this->slots = nullptr;
+  this->numSlots = 0;
+  this->fd = -1;
+}
+
+/////////////////////////////////////////////////
+bool FlightRecorder::IsOpen() const
+{
+  return this->map != nullptr;
+}
+
+/////////////////////////////////////////////////
+const std::string &FlightRecorder::Path() const
+{
+  return this->path;
+}
+
+/////////////////////////////////////////////////
+void FlightRecorder::Write(uint16_t _type, double _time, uint64_t _entity,
+    const double *_values, size_t _count)
+{
+  if (!this->header ||
+      this->header->frozen.load(std::memory_order_relaxed))
+    return;
+
+  uint64_t seq = this->header->next.fetch_add(1, std::memory_order_relaxed);
+  Slot &slot = this->slots[seq % this->numSlots];
+
+  // A slot with a zero sequence is skipped by the reader, so a record
+  // interrupted by a crash is not mistaken for a complete one.
+  slot.sequence.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  _count = std::min(_count, kFlightRecordValues);
+  slot.time = _time;
+  slot.entity = _entity;
+  slot.type = _type;
+  slot.count = static_cast<uint16_t>(_count);
+  std::copy(_values, _values + _count, slot.values);
+  slot.sequence.store(seq + 1, std::memory_order_release);
+}
+
+/////////////////////////////////////////////////
+bool FlightRecorder::Freeze(const std::string &_reason, double _time)
+{
+  if (!this->header)
+    return false;
+
+  uint32_t expected = 0;
+  if (!this->header->frozen.compare_exchange_strong(expected, 1))
+    return false;
+
+  this->header->frozenTime = _time;
+  size_t n = std::min(_reason.size(), sizeof(this->header->reason) - 1);
+  std::memcpy(this->header->reason, _reason.data(), n);
+  this->header->reason[n] = '\0';
+  ::msync(this->map, this->mapSize, MS_SYNC);
+
+  gzerr << "Flight recorder frozen at t=" << _time << " (" << _reason
+        << "). The preceding state is in [" << this->path << "], decode "
+        << "it with asv_sim_flight_decode.\n";
+  return true;
+}
+
+/////////////////////////////////////////////////
+bool FlightRecorder::Frozen() const
+{
+  return this->header &&
+      this->header->frozen.load(std::memory_order_relaxed) != 0;
+}
+
+/////////////////////////////////////////////////
+bool FlightRecorder::Read(const std::string &_path, FlightLog &_log)
+{
+  _log = FlightLog();
+
+  std::ifstream file(_path, std::ios::binary);
+  if (!file)
+  {
+    gzerr << "Failed to open flight recorder file [" << _path << "].\n";
+    return false;
+  }
+  std::vector<char> bytes((std::istreambuf_iterator<char>(file)),
+      std::istreambuf_iterator<char>());
+
+  if (bytes.size() < sizeof(Header) ||
+      std::memcmp(bytes.data(), "ASVF", 4) != 0)
+  {
+    gzerr << "File [" << _path << "] is not a flight recorder file.\n";
+    return false;
+  }
+
+  const auto *header = reinterpret_cast<const Header *>(bytes.data());
+  if (header->version != kVersion || header->slotSize != sizeof(Slot) ||
+      bytes.size() < sizeof(Header) + header->numSlots * sizeof(Slot))
+  {
+    gzerr << "Flight recorder file [" << _path << "] has an unsupported "
+          << "version or is truncated.\n";
+    return false;
+  }
+
+  _log.frozen = header->frozen.load() != 0;
+  _log.frozenTime = header->frozenTime;
+  _log.reason = std::string(header->reason,
+      strnlen(header->reason, sizeof(header->reason)));
+  _log.numSlots = header->numSlots;
+
+  const auto *slots = reinterpret_cast<const Slot *>(
+      bytes.data() + sizeof(Header));
+  for (size_t i = 0; i < header->numSlots; ++i)
+  {
+    const Slot &slot = slots[i];
+    uint64_t seq = slot.sequence.load();
+    if (seq == 0)
+      continue;
+
+    FlightRecord record;
+    record.sequence = seq - 1;
+    record.time = slot.time;
+    record.entity = slot.entity;
+    record.type = slot.type;
+    record.count = std::min<uint16_t>(slot.count, kFlightRecordValues);
+    std::copy(slot.values, slot.values + record.count,
+        record.values.begin());
+    _log.records.push_back(record);
+  }
+
+  std::sort(_log.records.begin(), _log.records.end(),
+      [](const FlightRecord &_a, const FlightRecord &_b)
+      {
+        return _a.sequence < _b.sequence;
+      });
+  return true;
+}
+
+/////////////////////////////////////////////////
+std::string FlightRecorder::TypeName(uint16_t _type)
+{
+  switch (_type)
+  {
+    case kLiftDrag:
+      return "lift_drag";
+    case kMooring:
+      return "mooring";
+    case kSailController:
+      return "sail_controller";
+    default:
+      return "type_" + std::to_string(_type);
+  }
+}
+
+/////////////////////////////////////////////////
+std::vector<std::string> FlightRecorder::FieldNames(uint16_t _type)
+{
+  switch (_type)
+  {
+    case kLiftDrag:
+      return {"alpha", "speed", "cl", "cd", "lift_x", "lift_y", "lift_z",
+          "drag_x", "drag_y", "drag_z"};
+    case kMooring:
+      return {"force_x", "force_y", "force_z", "v", "h"};
+    case kSailController:
+      return {"command", "position", "force"};
+    default:
+      return {};
+  }
+}
+
+}  // namespace asv
@@ -0,0 +1,145 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "asv/sim/FlightRecorder.hh"
+
+/////////////////////////////////////////////////
+TEST(FlightRecorder, Ring)
+{
+    const std::string path = testing::TempDir() + "flight_ring.ring";
+    asv::FlightRecorder recorder;
+    EXPECT_FALSE(recorder.IsOpen());
+    ASSERT_TRUE(recorder.Open(path, 8));
+    EXPECT_TRUE(recorder.IsOpen());
+    EXPECT_EQ(recorder.Path(), path);
+
+    // The ring keeps the last 8 of 20 records.
+    for (int i = 0; i < 20; ++i)
+    {
+      double values[3] = {1.0 * i, 2.0 * i, 3.0 * i};
+      recorder.Write(asv::FlightRecorder::kSailController, 0.1 * i, 5,
+          values, 3);
+    }
+
+    asv::FlightLog log;
+    ASSERT_TRUE(asv::FlightRecorder::Read(path, log));
+    EXPECT_FALSE(log.frozen);
+    EXPECT_EQ(log.numSlots, 8u);
+    ASSERT_EQ(log.records.size(), 8u);
+    for (size_t i = 0; i < 8; ++i)
+    {
+      const auto &record = log.records[i];
+      EXPECT_EQ(record.sequence, 12 + i);
+      EXPECT_DOUBLE_EQ(record.time, 0.1 * (12 + i));
+      EXPECT_EQ(record.entity, 5u);
+      EXPECT_EQ(record.type, asv::FlightRecorder::kSailController);
+      ASSERT_EQ(record.count, 3u);
+      EXPECT_DOUBLE_EQ(record.values[2], 3.0 * (12 + i));
+    }
+
+    // A recorder that was not frozen removes its file.
+    recorder.Close();
+    EXPECT_FALSE(recorder.IsOpen());
+    EXPECT_NE(access(path.c_str(), F_OK), 0);
+}
+
+/////////////////////////////////////////////////
+TEST(FlightRecorder, Freeze)
+{
+    const std::string path = testing::TempDir() + "flight_freeze.ring";
+    asv::FlightRecorder recorder;
+    ASSERT_TRUE(recorder.Open(path, 16));
+    EXPECT_FALSE(recorder.Frozen());
+
+    double values[5] = {1.0, 2.0, 3.0, 4.0, 5.0};
+    recorder.Write(asv::FlightRecorder::kMooring, 1.0, 3, values, 5);
+    EXPECT_TRUE(recorder.Freeze("[Mooring] force is not finite", 1.0));
+    EXPECT_FALSE(recorder.Freeze("second failure", 2.0));
+    EXPECT_TRUE(recorder.Frozen());
+
+    // Records after the freeze are ignored.
+    recorder.Write(asv::FlightRecorder::kMooring, 2.0, 3, values, 5);
+    recorder.Close();
+
+    // The frozen file is kept.
+    asv::FlightLog log;
+    ASSERT_TRUE(asv::FlightRecorder::Read(path, log));
+    EXPECT_TRUE(log.frozen);
+    EXPECT_DOUBLE_EQ(log.frozenTime, 1.0);
+    EXPECT_EQ(log.reason, "[Mooring] force is not finite");
+    ASSERT_EQ(log.records.size(), 1u);
+    EXPECT_DOUBLE_EQ(log.records[0].values[4], 5.0);
+    EXPECT_EQ(asv::FlightRecorder::TypeName(log.records[0].type),
+        "mooring");
+    EXPECT_EQ(asv::FlightRecorder::FieldNames(log.records[0].type).size(),
+        5u);
+    unlink(path.c_str());
+
+    EXPECT_FALSE(asv::FlightRecorder::Read(path, log));
+}
+
+/////////////////////////////////////////////////
+TEST(FlightRecorder, Threads)
+{
+    const std::string path = testing::TempDir() + "flight_threads.ring";
+    asv::FlightRecorder recorder;
+    ASSERT_TRUE(recorder.Open(path, 4096));
+
+    const size_t numThreads = 4;
+    const size_t n = 1000;
+    std::vector<std::thread> threads;
+    for (size_t k = 0; k < numThreads; ++k)
+    {
+      threads.emplace_back([&recorder, k]()
+      {
+        for (size_t i = 0; i < n; ++i)
+        {
+          double value = static_cast<double>(i);
+          recorder.Write(asv::FlightRecorder::kLiftDrag, 0.0, k, &value, 1);
+        }
+      });
+    }
+    for (auto &thread : threads)
+      thread.join();
+    recorder.Freeze("test", 0.0);
+    recorder.Close();
+
+    // Every record is kept once, in the order of each thread.
+    asv::FlightLog log;
+    ASSERT_TRUE(asv::FlightRecorder::Read(path, log));
+    ASSERT_EQ(log.records.size(), numThreads * n);
+    std::vector<double> next(numThreads, 0.0);
+    for (const auto &record : log.records)
+    {
+      ASSERT_LT(record.entity, numThreads);
+      EXPECT_EQ(record.values[0], next[record.entity]);
+      next[record.entity] += 1.0;
+    }
+    unlink(path.c_str());
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
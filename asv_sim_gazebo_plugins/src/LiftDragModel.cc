@@ -33,49 +33,34 @@
 
 #include "asv/sim/LiftDragModel.hh"
 
+#include <cmath>
 #include <string>
+#include <vector>
 
 #include <gz/math/Pose3.hh>
+#include <gz/math/Quaternion.hh>
 #include <gz/math/Vector3.hh>
 
+#include "asv/core/LiftDrag.hh"
+#include "asv/sim/CoreTypes.hh"
+#include "asv/sim/Trace.hh"
 #include "asv/sim/Utilities.hh"
 
 namespace asv
 {
 class LiftDragModelPrivate
 {
-  /// \brief Fluid density
-  public: double fluidDensity = 1.2;
+  /// \brief The model parameters, evaluated by the core kernels.
+  public: core::LiftDragParams params;
 
-  /// \brief True if the foil is symmetric about its chord.
-  public: bool radialSymmetry = true;
-
-  /// \brief Foil forward direction (body frame), usually parallel
-  /// to the foil chord.
+  /// \brief Foil forward direction (body frame), as params.forward.
   public: gz::math::Vector3d forward = gz::math::Vector3d(1, 0, 0);
 
-  /// \brief Foil upward direction (body frame), usually perpendicular
-  /// to the foil chord in the direction of positive lift for the foil
-  /// in its intended configuration.
+  /// \brief Foil upward direction (body frame), as params.upward.
   public: gz::math::Vector3d upward = gz::math::Vector3d(0, 0, 1);
 
-  /// \brief Foil area
-  public: double area = 1.0;
-
-  /// \brief Angle of attack at zero lift.
-  public: double alpha0 = 0.0;
-
-  /// \brief Slope of lift coefficient before stall.
-  public: double cla = 2.0 * GZ_PI;
-
-  /// \brief Angle of attack at stall.
-  public: double alphaStall = 1.0 / 2.0 / GZ_PI;
-
-  /// \brief Slope of lift coefficient after stall.
-  public: double claStall = -(2 * GZ_PI) / (GZ_PI * GZ_PI - 1.0);
-
-  /// \brief Slope of drag coefficient.
-  public: double cda = 2.0 / GZ_PI;
+  /// \brief Debug trace, created by SetTraceEntity.
+  public: std::unique_ptr<TraceChannel> trace;
 };
 
 /////////////////////////////////////////////////
@@ -94,37 +79,61 @@ LiftDragModel::LiftDragModel(std::unique_ptr<LiftDragModelPrivate> &_data)
 }
 
 /////////////////////////////////////////////////
-LiftDragModel* LiftDragModel::Create(
-    const std::shared_ptr<const sdf::Element> &_sdf)
+bool LiftDragModel::LoadParams(
+    const std::shared_ptr<const sdf::Element> &_sdf,
+    core::LiftDragParams &_params)
 {
-  std::unique_ptr<LiftDragModelPrivate> data(
-      std::make_unique<LiftDragModelPrivate>());
+  bool radialSymmetry = true;
+  gz::math::Vector3d forward = ToGz(_params.forward);
+  gz::math::Vector3d upward = ToGz(_params.upward);
 
   // Parameters
-  asv::LoadParam(_sdf, "fluid_density", data->fluidDensity,
-      data->fluidDensity);
-  asv::LoadParam(_sdf, "radial_symmetry", data->radialSymmetry,
-      data->radialSymmetry);
-  asv::LoadParam(_sdf, "forward", data->forward, data->forward);
-  asv::LoadParam(_sdf, "upward", data->upward, data->upward);
-  asv::LoadParam(_sdf, "area", data->area, data->area);
-  asv::LoadParam(_sdf, "a0", data->alpha0, data->alpha0);
-  asv::LoadParam(_sdf, "alpha_stall", data->alphaStall, data->alphaStall);
-  asv::LoadParam(_sdf, "cla", data->cla, data->cla);
-  asv::LoadParam(_sdf, "cla_stall", data->claStall, data->claStall);
-  asv::LoadParam(_sdf, "cda", data->cda, data->cda);
+  asv::LoadParam(_sdf, "fluid_density", _params.fluidDensity,
+      _params.fluidDensity);
+  asv::LoadParam(_sdf, "radial_symmetry", radialSymmetry, radialSymmetry);
+  asv::LoadParam(_sdf, "forward", forward, forward);
+  asv::LoadParam(_sdf, "upward", upward, upward);
+  asv::LoadParam(_sdf, "area", _params.area, _params.area);
+  asv::LoadParam(_sdf, "a0", _params.alpha0, _params.alpha0);
+  asv::LoadParam(_sdf, "alpha_stall", _params.alphaStall,
+      _params.alphaStall);
+  asv::LoadParam(_sdf, "cla", _params.cla, _params.cla);
+  asv::LoadParam(_sdf, "cla_stall", _params.claStall, _params.claStall);
+  asv::LoadParam(_sdf, "cda", _params.cda, _params.cda);
 
   // Only support radially symmetric lift-drag coefficients at present
-  if (!data->radialSymmetry)
+  if (!radialSymmetry)
   {
     gzerr << "LiftDragModel only supports radially symmetric foils\n";
-    return nullptr;
+    return false;
   }
 
   // Normalise
-  data->forward.Normalize();
-  data->upward.Normalize();
+  _params.forward = ToCore(forward.Normalize());
+  _params.upward = ToCore(upward.Normalize());
+  return true;
+}
 
+/////////////////////////////////////////////////
+LiftDragModel* LiftDragModel::Create(
+    const std::shared_ptr<const sdf::Element> &_sdf)
+{
+  core::LiftDragParams params;
+  if (!LoadParams(_sdf, params))
+    return nullptr;
+  return Create(params);
+}
+
+/////////////////////////////////////////////////
+LiftDragModel* LiftDragModel::Create(const core::LiftDragParams &_params)
+{
+  std::unique_ptr<LiftDragModelPrivate> data(
+      std::make_unique<LiftDragModelPrivate>());
+  data->params = _params;
+  data->params.forward.Normalize();
+  data->params.upward.Normalize();
+  data->forward = ToGz(data->params.forward);
+  data->upward = ToGz(data->params.upward);
   return new LiftDragModel(data);
 }
 
@@ -150,146 +159,210 @@ void LiftDragModel::Compute(
   double &_cl,
   double &_cd) const
 {
-  // Unit free stream velocity (world frame).
-  auto velUnit = _velU;
-  velUnit.Normalize();
-
-  // Avoid division by zero issues.
-  if (_velU.Length() <= 0.01)
-  {
-    _lift = gz::math::Vector3d::Zero;
-    _drag = gz::math::Vector3d::Zero;
-    return;
-  }
-
   // Rotate forward and upward vectors into the world frame.
   auto forwardI = _bodyPose.Rot().RotateVector(this->data->forward);
   auto upwardI = _bodyPose.Rot().RotateVector(this->data->upward);
 
-  // The span vector is normal to lift-drag-plane (world frame)
-  auto spanI = forwardI.Cross(upwardI).Normalize();
-
-  // Compute the angle of attack, alpha:
-  // This is the angle between the free stream velocity
-  // projected into the lift-drag plane and the forward vector
-  auto velLD = _velU - _velU.Dot(spanI) * spanI;
-
-  // Get direction of drag
-  auto dragUnit = velLD;
-  dragUnit.Normalize();
-
-  // Get direction of lift
-  auto liftUnit = dragUnit.Cross(spanI);
-  liftUnit.Normalize();
-
-  // Compute angle of attack.
-  double sgnAlpha =  forwardI.Dot(liftUnit) < 0 ? -1.0 : 1.0;
-  double cosAlpha = -forwardI.Dot(dragUnit);
-  // lift-drag coefficients assume alpha > 0 if foil is symmetric
-  double alpha = acos(cosAlpha);
-
-  // Compute dynamic pressure.
-  double u = velLD.Length();
-  double q = 0.5 * this->data->fluidDensity * u * u;
+  this->Compute(_velU, forwardI, upwardI, this->data->params.area,
+      _lift, _drag, _alpha, _u, _cl, _cd);
+}
 
-  // Compute lift coefficient and set sign.
-  double cl = this->LiftCoefficient(alpha) * sgnAlpha;
+/////////////////////////////////////////////////
+void LiftDragModel::Compute(
+  const std::vector<gz::math::Vector3d> &_velU,
+  const std::vector<gz::math::Quaterniond> &_bodyRot,
+  const std::vector<double> &_area,
+  std::vector<gz::math::Vector3d> &_lift,
+  std::vector<gz::math::Vector3d> &_drag,
+  std::vector<double> *_alpha,
+  std::vector<double> *_u,
+  std::vector<double> *_cl,
+  std::vector<double> *_cd) const
+{
+  const size_t n = _velU.size();
+  if (_bodyRot.size() != n || _area.size() != n)
+  {
+    gzerr << "LiftDragModel batch inputs must have the same size\n";
+    return;
+  }
+  _lift.resize(n);
+  _drag.resize(n);
+  for (auto *out : {_alpha, _u, _cl, _cd})
+  {
+    if (out)
+      out->resize(n);
+  }
 
-  // Compute lift force.
-  _lift = cl * q * this->data->area * liftUnit;
+  const auto &forward = this->data->forward;
+  const auto &upward = this->data->upward;
+  for (size_t i = 0; i < n; ++i)
+  {
+    double alpha = 0.0, u = 0.0, cl = 0.0, cd = 0.0;
+    this->Compute(_velU[i],
+        _bodyRot[i].RotateVector(forward),
+        _bodyRot[i].RotateVector(upward),
+        _area[i], _lift[i], _drag[i], alpha, u, cl, cd);
+    if (_alpha)
+      (*_alpha)[i] = alpha;
+    if (_u)
+      (*_u)[i] = u;
+    if (_cl)
+      (*_cl)[i] = cl;
+    if (_cd)
+      (*_cd)[i] = cd;
+  }
+}
 
-  // Compute drag coefficient.
-  double cd = this->DragCoefficient(alpha);
+/////////////////////////////////////////////////
+void LiftDragModel::Compute(
+  size_t _count,
+  const double *_velU,
+  const double *_bodyRot,
+  const double *_area,
+  double *_lift,
+  double *_drag,
+  double *_alpha,
+  double *_cl,
+  double *_cd) const
+{
+  const auto &forward = this->data->forward;
+  const auto &upward = this->data->upward;
+  for (size_t i = 0; i < _count; ++i)
+  {
+    gz::math::Vector3d velU(_velU[3 * i], _velU[3 * i + 1],
+        _velU[3 * i + 2]);
+    gz::math::Vector3d forwardI = forward;
+    gz::math::Vector3d upwardI = upward;
+    if (_bodyRot)
+    {
+      gz::math::Quaterniond rot(_bodyRot[4 * i], _bodyRot[4 * i + 1],
+          _bodyRot[4 * i + 2], _bodyRot[4 * i + 3]);
+      forwardI = rot.RotateVector(forward);
+      upwardI = rot.RotateVector(upward);
+    }
+    double area = _area ? _area[i] : this->data->params.area;
+
+    gz::math::Vector3d lift;
+    gz::math::Vector3d drag;
+    double alpha = 0.0, u = 0.0, cl = 0.0, cd = 0.0;
+    this->Compute(velU, forwardI, upwardI, area, lift, drag,
+        alpha, u, cl, cd);
+    for (size_t k = 0; k < 3; ++k)
+    {
+      _lift[3 * i + k] = lift[k];
+      _drag[3 * i + k] = drag[k];
+    }
+    if (_alpha)
+      _alpha[i] = alpha;
+    if (_cl)
+      _cl[i] = cl;
+    if (_cd)
+      _cd[i] = cd;
+  }
+}
 
-  // Compute drag force.
-  _drag = cd * q * this->data->area * dragUnit;
+/////////////////////////////////////////////////
+void LiftDragModel::Compute(
+  const gz::math::Vector3d &_velU,
+  const gz::math::Vector3d &_forwardI,
+  const gz::math::Vector3d &_upwardI,
+  double _area,
+  gz::math::Vector3d &_lift,
+  gz::math::Vector3d &_drag,
+  double &_alpha,
+  double &_u,
+  double &_cl,
+  double &_cd) const
+{
+  core::LiftDragResult result;
+  bool valid = core::ComputeLiftDrag(this->data->params, ToCore(_velU),
+      ToCore(_forwardI), ToCore(_upwardI), _area, result);
+  _lift = ToGz(result.lift);
+  _drag = ToGz(result.drag);
+  if (!valid)
+    return;
 
   // Outputs
-  _alpha = alpha;
-  _u = u;
-  _cl = cl;
-  _cd = cd;
-
-  // DEBUG
-#if 0
-  gzmsg << "velU:         " << _velU << "\n";
-  gzmsg << "velUnit:      " << velUnit << "\n";
-  gzmsg << "body_pos:     " << _bodyPose.Pos() << "\n";
-  gzmsg << "body_rot:     " << _bodyPose.Rot().Euler() << "\n";
-  gzmsg << "forward:      " << this->data->forward << "\n";
-  gzmsg << "upward:       " << this->data->upward << "\n";
-  gzmsg << "forwardI:     " << forwardI << "\n";
-  gzmsg << "upwardI:      " << upwardI << "\n";
-  gzmsg << "spanI:        " << spanI << "\n";
-  gzmsg << "velLD:        " << velLD << "\n";
-  gzmsg << "dragUnit:     " << dragUnit << "\n";
-  gzmsg << "liftUnit:     " << liftUnit << "\n";
-  gzmsg << "alpha:        " << alpha << "\n";
-  gzmsg << "u:            " << _u << "\n";
-  gzmsg << "cl:           " << _cl << "\n";
-  gzmsg << "cd:           " << _cd << "\n";
-  gzmsg << "lift:         " << _lift << "\n";
-  gzmsg << "drag:         " << _drag << "\n\n";
-#endif
+  _alpha = result.alpha;
+  _u = result.u;
+  _cl = result.cl;
+  _cd = result.cd;
+
+  if (this->data->trace && this->data->trace->Enabled())
+  {
+    const auto &spanI = result.spanUnit;
+    const auto velLD = result.u * result.dragUnit;
+    const auto &dragUnit = result.dragUnit;
+    const auto &liftUnit = result.liftUnit;
+    this->data->trace->Write(std::nan(""), {
+        _velU.X(), _velU.Y(), _velU.Z(),
+        _forwardI.X(), _forwardI.Y(), _forwardI.Z(),
+        _upwardI.X(), _upwardI.Y(), _upwardI.Z(),
+        spanI.x, spanI.y, spanI.z,
+        velLD.x, velLD.y, velLD.z,
+        dragUnit.x, dragUnit.y, dragUnit.z,
+        liftUnit.x, liftUnit.y, liftUnit.z,
+        _alpha, _u, _cl, _cd,
+        _lift.X(), _lift.Y(), _lift.Z(),
+        _drag.X(), _drag.Y(), _drag.Z()});
+  }
 }
 
 /////////////////////////////////////////////////
-/// Lift is piecewise linear and symmetric about alpha = PI/2
 double LiftDragModel::LiftCoefficient(double _alpha) const
 {
-  double alpha0     = this->data->alpha0;
-  double cla        = this->data->cla;
-  double alphaStall = this->data->alphaStall;
-  double claStall   = this->data->claStall;
+  return core::LiftCoefficient(this->data->params, _alpha);
+}
 
-  auto f1 = [=](auto _x)
-  {
-    return cla * (_x - alpha0);
-  };
+/////////////////////////////////////////////////
+double LiftDragModel::DragCoefficient(double _alpha) const
+{
+  return core::DragCoefficient(this->data->params, _alpha);
+}
 
-  auto f2 = [=](auto _x)
-  {
-    if (_x < alphaStall)
-      return f1(_x);
-    else
-      return claStall * (_x - alphaStall) + f1(alphaStall);
-  };
-
-  double cl = 0.0;
-  if (_alpha < GZ_PI/2.0)
-  {
-    cl = f2(_alpha);
-  }
-  else
-  {
-    cl = -f2(GZ_PI - _alpha);
-  }
+/////////////////////////////////////////////////
+double LiftDragModel::Area() const
+{
+  return this->data->params.area;
+}
 
-  return cl;
+/////////////////////////////////////////////////
+double LiftDragModel::FluidDensity() const
+{
+  return this->data->params.fluidDensity;
 }
 
 /////////////////////////////////////////////////
-/// Drag is piecewise linear and symmetric about alpha = PI/2
-double LiftDragModel::DragCoefficient(double _alpha) const
+const gz::math::Vector3d &LiftDragModel::Forward() const
 {
-  double cda = this->data->cda;
+  return this->data->forward;
+}
 
-  auto f1 = [=](auto _x)
-  {
-    return cda * _x;
-  };
+/////////////////////////////////////////////////
+const gz::math::Vector3d &LiftDragModel::Upward() const
+{
+  return this->data->upward;
+}
 
-  double cd = 0.0;
-  if (_alpha < GZ_PI/2.0)
-  {
-    cd = f1(_alpha);
-  }
-  else
+/////////////////////////////////////////////////
+const core::LiftDragParams &LiftDragModel::Params() const
+{
+  return this->data->params;
+}
+
+/////////////////////////////////////////////////
+void LiftDragModel::SetTraceEntity(uint64_t _entity)
+{
+  if (this->data->trace)
   {
-    cd = f1(GZ_PI - _alpha);
+    this->data->trace->SetEntity(_entity);
+    return;
   }
-
-  return cd;
+  this->data->trace = std::make_unique<TraceChannel>("LiftDragModel",
+      std::vector<std::string>{"velU:3", "forwardI:3", "upwardI:3",
+          "spanI:3", "velLD:3", "dragUnit:3", "liftUnit:3", "alpha", "u",
+          "cl", "cd", "lift:3", "drag:3"},
+      _entity);
 }
 
 }  // namespace asv
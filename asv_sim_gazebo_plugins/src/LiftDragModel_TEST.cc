@@ -16,6 +16,7 @@
 #include <gtest/gtest.h>
 
 #include <memory>
+#include <vector>
 
 #include "asv/sim/LiftDragModel.hh"
 
@@ -173,6 +174,196 @@ TEST(LiftDragModel, Quadrants)
     }
 }
 
+/////////////////////////////////////////////////
+TEST(LiftDragModel, Batch)
+{
+    // create SDF data
+    sdf::SDFPtr model(new sdf::SDF());
+    sdf::init(model);
+    ASSERT_TRUE(sdf::readString(get_sdf_string(), model));
+
+    sdf::ElementPtr plugin
+        = model->Root()->GetElement("model")->GetElement("plugin");
+
+    // create from SDF
+    std::unique_ptr<asv::LiftDragModel> ld_model(
+        asv::LiftDragModel::Create(plugin));
+
+    // A batch of surfaces at different angles of attack and areas.
+    std::vector<gz::math::Vector3d> velU;
+    std::vector<gz::math::Quaterniond> bodyRot;
+    std::vector<double> area;
+    for (int i = 0; i < 8; ++i)
+    {
+      velU.push_back(gz::math::Vector3d(-10.0 + i, 0.5 * i, 0.0));
+      bodyRot.push_back(gz::math::Quaterniond(0.0, 0.0, -M_PI + i * M_PI/4));
+      area.push_back(0.1 * (i + 1));
+    }
+
+    std::vector<gz::math::Vector3d> lift;
+    std::vector<gz::math::Vector3d> drag;
+    std::vector<double> alpha, u, cl, cd;
+    ld_model->Compute(velU, bodyRot, area, lift, drag, &alpha, &u, &cl, &cd);
+    ASSERT_EQ(lift.size(), velU.size());
+    ASSERT_EQ(drag.size(), velU.size());
+    ASSERT_EQ(alpha.size(), velU.size());
+    ASSERT_EQ(cd.size(), velU.size());
+
+    // Each element matches the single surface calculation
+    // scaled by the ratio of the areas.
+    for (size_t i = 0; i < velU.size(); ++i)
+    {
+      gz::math::Pose3d bodyPose(gz::math::Vector3d::Zero, bodyRot[i]);
+      gz::math::Vector3d lift1;
+      gz::math::Vector3d drag1;
+      double alpha1 = 0.0, u1 = 0.0, cl1 = 0.0, cd1 = 0.0;
+      ld_model->Compute(velU[i], bodyPose, lift1, drag1,
+          alpha1, u1, cl1, cd1);
+      EXPECT_DOUBLE_EQ(alpha[i], alpha1);
+      EXPECT_DOUBLE_EQ(u[i], u1);
+      EXPECT_DOUBLE_EQ(cl[i], cl1);
+      EXPECT_DOUBLE_EQ(cd[i], cd1);
+
+      double scale = area[i] / ld_model->Area();
+      EXPECT_NEAR(lift[i].X(), scale * lift1.X(), 1.0E-12);
+      EXPECT_NEAR(lift[i].Y(), scale * lift1.Y(), 1.0E-12);
+      EXPECT_NEAR(lift[i].Z(), scale * lift1.Z(), 1.0E-12);
+      EXPECT_NEAR(drag[i].X(), scale * drag1.X(), 1.0E-12);
+      EXPECT_NEAR(drag[i].Y(), scale * drag1.Y(), 1.0E-12);
+      EXPECT_NEAR(drag[i].Z(), scale * drag1.Z(), 1.0E-12);
+    }
+}
+
+/////////////////////////////////////////////////
+TEST(LiftDragModel, FlatBatch)
+{
+    // create SDF data
+    sdf::SDFPtr model(new sdf::SDF());
+    sdf::init(model);
+    ASSERT_TRUE(sdf::readString(get_sdf_string(), model));
+
+    sdf::ElementPtr plugin
+        = model->Root()->GetElement("model")->GetElement("plugin");
+
+    // create from SDF
+    std::unique_ptr<asv::LiftDragModel> ld_model(
+        asv::LiftDragModel::Create(plugin));
+
+    // The same batch as above in flat arrays, with one surface in a
+    // free stream that is too slow.
+    const size_t n = 9;
+    std::vector<double> velU;
+    std::vector<double> bodyRot;
+    std::vector<double> area;
+    for (size_t i = 0; i < n; ++i)
+    {
+      gz::math::Vector3d v(-10.0 + i, 0.5 * i, 0.0);
+      if (i == n - 1)
+        v = gz::math::Vector3d(0.001, 0.0, 0.0);
+      gz::math::Quaterniond q(0.0, 0.0, -M_PI + i * M_PI/4);
+      velU.insert(velU.end(), {v.X(), v.Y(), v.Z()});
+      bodyRot.insert(bodyRot.end(), {q.W(), q.X(), q.Y(), q.Z()});
+      area.push_back(0.1 * (i + 1));
+    }
+
+    std::vector<double> lift(3 * n);
+    std::vector<double> drag(3 * n);
+    std::vector<double> alpha(n, -1.0);
+    std::vector<double> cl(n, -1.0);
+    std::vector<double> cd(n, -1.0);
+    ld_model->Compute(n, velU.data(), bodyRot.data(), area.data(),
+        lift.data(), drag.data(), alpha.data(), cl.data(), cd.data());
+
+    for (size_t i = 0; i < n; ++i)
+    {
+      gz::math::Vector3d v(velU[3 * i], velU[3 * i + 1], velU[3 * i + 2]);
+      gz::math::Quaterniond q(bodyRot[4 * i], bodyRot[4 * i + 1],
+          bodyRot[4 * i + 2], bodyRot[4 * i + 3]);
+      gz::math::Pose3d bodyPose(gz::math::Vector3d::Zero, q);
+      gz::math::Vector3d lift1;
+      gz::math::Vector3d drag1;
+      double alpha1 = 0.0, u1 = 0.0, cl1 = 0.0, cd1 = 0.0;
+      ld_model->Compute(v, bodyPose, lift1, drag1, alpha1, u1, cl1, cd1);
+
+      double scale = area[i] / ld_model->Area();
+      for (size_t k = 0; k < 3; ++k)
+      {
+        EXPECT_NEAR(lift[3 * i + k], scale * lift1[k], 1.0E-12);
+        EXPECT_NEAR(drag[3 * i + k], scale * drag1[k], 1.0E-12);
+      }
+      EXPECT_DOUBLE_EQ(alpha[i], alpha1);
+      EXPECT_DOUBLE_EQ(cl[i], cl1);
+      EXPECT_DOUBLE_EQ(cd[i], cd1);
+    }
+
+    // Without orientations or areas the model's are used.
+    std::vector<double> lift2(3 * n);
+    std::vector<double> drag2(3 * n);
+    ld_model->Compute(n, velU.data(), nullptr, nullptr, lift2.data(),
+        drag2.data());
+    for (size_t i = 0; i < n; ++i)
+    {
+      gz::math::Vector3d v(velU[3 * i], velU[3 * i + 1], velU[3 * i + 2]);
+      gz::math::Vector3d lift1;
+      gz::math::Vector3d drag1;
+      ld_model->Compute(v, gz::math::Pose3d::Zero, lift1, drag1);
+      for (size_t k = 0; k < 3; ++k)
+      {
+        EXPECT_NEAR(lift2[3 * i + k], lift1[k], 1.0E-12);
+        EXPECT_NEAR(drag2[3 * i + k], drag1[k], 1.0E-12);
+      }
+    }
+}
+
+/////////////////////////////////////////////////
+TEST(LiftDragModel, Core)
+{
+    // create SDF data
+    sdf::SDFPtr model(new sdf::SDF());
+    sdf::init(model);
+    ASSERT_TRUE(sdf::readString(get_sdf_string(), model));
+
+    sdf::ElementPtr plugin
+        = model->Root()->GetElement("model")->GetElement("plugin");
+
+    // The SDF adapter loads the core parameters.
+    asv::core::LiftDragParams params;
+    ASSERT_TRUE(asv::LiftDragModel::LoadParams(plugin, params));
+    EXPECT_DOUBLE_EQ(params.area, 0.4858);
+    EXPECT_DOUBLE_EQ(params.cla, 6.2832);
+    EXPECT_DOUBLE_EQ(params.upward.y, 1.0);
+
+    // A model created from the parameters matches one created from SDF,
+    // and both match the core kernel.
+    std::unique_ptr<asv::LiftDragModel> fromSdf(
+        asv::LiftDragModel::Create(plugin));
+    std::unique_ptr<asv::LiftDragModel> fromParams(
+        asv::LiftDragModel::Create(params));
+    ASSERT_NE(fromSdf, nullptr);
+    ASSERT_NE(fromParams, nullptr);
+
+    gz::math::Vector3d velU(-8.0, 1.5, 0.5);
+    gz::math::Pose3d bodyPose(0.0, 0.0, 0.0, 0.1, 0.2, 0.3);
+    gz::math::Vector3d lift1, drag1, lift2, drag2;
+    fromSdf->Compute(velU, bodyPose, lift1, drag1);
+    fromParams->Compute(velU, bodyPose, lift2, drag2);
+    EXPECT_EQ(lift1, lift2);
+    EXPECT_EQ(drag1, drag2);
+
+    asv::core::LiftDragResult result;
+    const auto &rot = bodyPose.Rot();
+    ASSERT_TRUE(asv::core::ComputeLiftDrag(params,
+        asv::core::Vector3d(velU.X(), velU.Y(), velU.Z()),
+        asv::core::Quaterniond(rot.W(), rot.X(), rot.Y(), rot.Z()),
+        result));
+    EXPECT_NEAR(result.lift.x, lift1.X(), 1.0E-12);
+    EXPECT_NEAR(result.lift.y, lift1.Y(), 1.0E-12);
+    EXPECT_NEAR(result.lift.z, lift1.Z(), 1.0E-12);
+    EXPECT_NEAR(result.drag.x, drag1.X(), 1.0E-12);
+    EXPECT_NEAR(result.drag.y, drag1.Y(), 1.0E-12);
+    EXPECT_NEAR(result.drag.z, drag1.Z(), 1.0E-12);
+}
+
 /////////////////////////////////////////////////
 int main(int argc, char **argv)
 {
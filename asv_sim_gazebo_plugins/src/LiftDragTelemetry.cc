@@ -0,0 +1,140 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "asv/sim/LiftDragTelemetry.hh"
+
+#include <gz/msgs/Utility.hh>
+
+#include <string>
+
+#include <gz/common/Console.hh>
+
+#include "asv/sim/FlightRecorder.hh"
+#include "asv/sim/Recorder.hh"
+
+namespace asv
+{
+/////////////////////////////////////////////////
+void LiftDragTelemetry::Configure(const std::string &_topic, double _rate)
+{
+  this->topic = _topic;
+  std::chrono::duration<double> period{_rate > 0.0 ? 1.0 / _rate : 0.0};
+  this->period = std::chrono::duration_cast<
+      std::chrono::steady_clock::duration>(period);
+  this->published = false;
+  this->pub.reset();
+
+  // Allocate the message once.
+  this->msg.mutable_data()->Resize(kSize, 0.0);
+}
+
+/////////////////////////////////////////////////
+bool LiftDragTelemetry::Enabled() const
+{
+  return !this->topic.empty();
+}
+
+/////////////////////////////////////////////////
+bool LiftDragTelemetry::Due(
+    const std::chrono::steady_clock::duration &_simTime) const
+{
+  if (this->topic.empty())
+    return false;
+  return !this->published || _simTime < this->lastTime ||
+      _simTime - this->lastTime >= this->period;
+}
+
+/////////////////////////////////////////////////
+void LiftDragTelemetry::Publish(
+    const std::chrono::steady_clock::duration &_simTime,
+    double _alpha, double _u, double _cl, double _cd,
+    const gz::math::Vector3d &_lift,
+    const gz::math::Vector3d &_drag,
+    const gz::math::Vector3d &_torque)
+{
+  if (this->topic.empty())
+    return;
+
+  if (!this->pub)
+  {
+    this->pub = TransportRegistry::Advertise<gz::msgs::Double_V>(
+        this->topic);
+    if (!this->pub)
+    {
+      gzerr << "LiftDragTelemetry: failed to advertise [" << this->topic
+            << "]. Telemetry disabled.\n";
+      this->topic.clear();
+      return;
+    }
+  }
+
+  *this->msg.mutable_header()->mutable_stamp() =
+      gz::msgs::Convert(_simTime);
+  auto *data = this->msg.mutable_data();
+  data->Set(kAlpha, _alpha);
+  data->Set(kSpeed, _u);
+  data->Set(kCl, _cl);
+  data->Set(kCd, _cd);
+  this->SetVector(kLift, _lift);
+  this->SetVector(kDrag, _drag);
+  this->SetVector(kTorque, _torque);
+
+  this->pub->Publish(this->msg);
+  this->lastTime = _simTime;
+  this->published = true;
+}
+
+/////////////////////////////////////////////////
+void LiftDragTelemetry::Record(
+    const std::chrono::steady_clock::duration &_simTime,
+    uint64_t _entity, double _alpha, double _u, double _cl, double _cd,
+    const gz::math::Vector3d &_lift,
+    const gz::math::Vector3d &_drag,
+    const gz::math::Vector3d &_wind)
+{
+  const double time = std::chrono::duration<double>(_simTime).count();
+  const double values[] = {_alpha, _u, _cl, _cd,
+      _lift.X(), _lift.Y(), _lift.Z(), _drag.X(), _drag.Y(), _drag.Z(),
+      _wind.X(), _wind.Y(), _wind.Z()};
+  FlightRecorder::Instance().Write(FlightRecorder::kLiftDrag, time,
+      _entity, values, 10);
+
+  auto &recorder = Recorder::Instance();
+  if (!recorder.IsOpen())
+    return;
+
+  static const uint32_t type = recorder.RegisterType("lift_drag",
+      {"alpha", "speed", "cl", "cd", "lift_x", "lift_y", "lift_z",
+       "drag_x", "drag_y", "drag_z", "wind_x", "wind_y", "wind_z"});
+  recorder.Record(type, time, _entity, values);
+}
+
+/////////////////////////////////////////////////
+const gz::msgs::Double_V &LiftDragTelemetry::Message() const
+{
+  return this->msg;
+}
+
+/////////////////////////////////////////////////
+void LiftDragTelemetry::SetVector(size_t _field,
+    const gz::math::Vector3d &_v)
+{
+  auto *data = this->msg.mutable_data();
+  data->Set(_field, _v.X());
+  data->Set(_field + 1, _v.Y());
+  data->Set(_field + 2, _v.Z());
+}
+
+}  // namespace asv
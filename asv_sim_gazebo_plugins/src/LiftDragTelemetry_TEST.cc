@@ -0,0 +1,108 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+
+#include "asv/sim/LiftDragTelemetry.hh"
+#include "asv/sim/RecordReader.hh"
+#include "asv/sim/Recorder.hh"
+
+using namespace std::chrono_literals;
+
+/////////////////////////////////////////////////
+TEST(LiftDragTelemetry, Rate)
+{
+    asv::LiftDragTelemetry telemetry;
+    EXPECT_FALSE(telemetry.Enabled());
+    EXPECT_FALSE(telemetry.Due(1s));
+
+    const std::string topic = "/asv_sim/test/lift_drag_telemetry";
+    std::atomic<int> count{0};
+    std::function<void(const gz::msgs::Double_V &)> cb =
+        [&count](const gz::msgs::Double_V &) { ++count; };
+    auto sub = asv::TransportRegistry::Subscribe(topic, cb);
+
+    telemetry.Configure(topic, 10.0);
+    EXPECT_TRUE(telemetry.Enabled());
+    EXPECT_TRUE(telemetry.Due(0s));
+    telemetry.Publish(0s, 0.1, 5.0, 1.2, 0.1,
+        gz::math::Vector3d(1, 2, 3), gz::math::Vector3d(4, 5, 6),
+        gz::math::Vector3d(7, 8, 9));
+
+    // At most one message per period.
+    EXPECT_FALSE(telemetry.Due(50ms));
+    EXPECT_TRUE(telemetry.Due(100ms));
+
+    // A reset is due immediately.
+    telemetry.Publish(200ms, 0, 0, 0, 0, {}, {}, {});
+    EXPECT_TRUE(telemetry.Due(10ms));
+
+    for (int i = 0; i < 100 && count < 2; ++i)
+      std::this_thread::sleep_for(10ms);
+    EXPECT_EQ(count, 2);
+
+    // The reused message holds the last values.
+    const auto &msg = telemetry.Message();
+    ASSERT_EQ(msg.data_size(), asv::LiftDragTelemetry::kSize);
+    EXPECT_DOUBLE_EQ(msg.data(asv::LiftDragTelemetry::kSpeed), 0.0);
+    telemetry.Publish(300ms, 0.1, 5.0, 1.2, 0.1,
+        gz::math::Vector3d(1, 2, 3), gz::math::Vector3d(4, 5, 6),
+        gz::math::Vector3d(7, 8, 9));
+    EXPECT_DOUBLE_EQ(msg.data(asv::LiftDragTelemetry::kSpeed), 5.0);
+    EXPECT_DOUBLE_EQ(msg.data(asv::LiftDragTelemetry::kDrag + 1), 5.0);
+    EXPECT_DOUBLE_EQ(msg.data(asv::LiftDragTelemetry::kTorque + 2), 9.0);
+}
+
+/////////////////////////////////////////////////
+TEST(LiftDragTelemetry, Record)
+{
+    // Nothing is recorded unless the recorder is open.
+    asv::LiftDragTelemetry::Record(0s, 1, 0, 0, 0, 0, {}, {}, {});
+
+    const std::string filename =
+        testing::TempDir() + "lift_drag_telemetry.asvr";
+    auto &recorder = asv::Recorder::Instance();
+    ASSERT_TRUE(recorder.Open(filename));
+    asv::LiftDragTelemetry::Record(1500ms, 42, 0.1, 5.0, 1.2, 0.1,
+        gz::math::Vector3d(1, 2, 3), gz::math::Vector3d(4, 5, 6),
+        gz::math::Vector3d(7, 8, 9));
+    recorder.Close();
+
+    asv::RecordReader reader;
+    ASSERT_TRUE(reader.Open(filename));
+    int type = reader.FindType("lift_drag");
+    ASSERT_GE(type, 0);
+    ASSERT_EQ(reader.RowCount(type), 1u);
+    EXPECT_DOUBLE_EQ(reader.Time(type)[0], 1.5);
+    EXPECT_EQ(reader.Entity(type)[0], 42u);
+    EXPECT_DOUBLE_EQ(reader.Column(type, reader.FindField(type, "cl"))[0],
+        1.2);
+    EXPECT_DOUBLE_EQ(
+        reader.Column(type, reader.FindField(type, "drag_y"))[0], 5.0);
+    EXPECT_DOUBLE_EQ(
+        reader.Column(type, reader.FindField(type, "wind_z"))[0], 9.0);
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,196 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#include "asv/sim/Log.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace asv
+{
+namespace
+{
+/// \brief Wall clock seconds between summaries.
+const double kSummaryPeriod = 10.0;
+
+/////////////////////////////////////////////////
+/// \brief The registered sites.
+struct Sites
+{
+  std::mutex mutex;
+  std::vector<LogSite *> sites;
+
+  /// \brief Time of the next summary, or negative before the first
+  /// message. Read without the mutex on every message.
+  std::atomic<double> nextSummary{-1.0};
+};
+
+/////////////////////////////////////////////////
+Sites &Registry()
+{
+  static Sites sites;
+  return sites;
+}
+}  // namespace
+
+/////////////////////////////////////////////////
+LogSite::LogSite(const char *_file, int _line, double _rate, double _burst)
+  : file(_file), line(_line), rate(std::max(_rate, 0.0)),
+    burst(std::max(_burst, 1.0)), tokens(burst)
+{
+  auto &registry = Registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  registry.sites.push_back(this);
+}
+
+/////////////////////////////////////////////////
+LogSite::~LogSite()
+{
+  auto &registry = Registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  auto &sites = registry.sites;
+  sites.erase(std::remove(sites.begin(), sites.end(), this), sites.end());
+
+  // Report what the site suppressed since the last summary, so a site
+  // that went quiet is not lost. The sites in the macros are destroyed
+  // at exit, when the console may already be gone, so this goes
+  // straight to stderr.
+  std::lock_guard<std::mutex> siteLock(this->mutex);
+  if (this->suppressedSinceSummary > 0)
+  {
+    std::cerr << "Suppressed messages not yet reported:\n"
+              << this->SummaryLine();
+  }
+}
+
+/////////////////////////////////////////////////
+bool LogSite::Allow()
+{
+  return this->Allow(Now());
+}
+
+/////////////////////////////////////////////////
+bool LogSite::Allow(double _now)
+{
+  bool allow = false;
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    ++this->count;
+    if (this->last >= 0.0)
+    {
+      this->tokens = std::min(this->burst,
+          this->tokens + (_now - this->last) * this->rate);
+    }
+    this->last = _now;
+
+    if (this->tokens >= 1.0)
+    {
+      this->tokens -= 1.0;
+      allow = true;
+    }
+    else
+    {
+      ++this->suppressed;
+      ++this->suppressedSinceNote;
+      ++this->suppressedSinceSummary;
+    }
+  }
+
+  MaybeSummarise(_now);
+  return allow;
+}
+
+/////////////////////////////////////////////////
+std::string LogSite::Note()
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  if (this->suppressedSinceNote == 0)
+    return std::string();
+  std::string note = "(" + std::to_string(this->suppressedSinceNote) +
+      " similar messages suppressed) ";
+  this->suppressedSinceNote = 0;
+  return note;
+}
+
+/////////////////////////////////////////////////
+uint64_t LogSite::Count() const
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->count;
+}
+
+/////////////////////////////////////////////////
+uint64_t LogSite::SuppressedCount() const
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->suppressed;
+}
+
+/////////////////////////////////////////////////
+std::string LogSite::Summary()
+{
+  auto &registry = Registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  std::ostringstream out;
+  for (auto *site : registry.sites)
+  {
+    std::lock_guard<std::mutex> siteLock(site->mutex);
+    if (site->suppressedSinceSummary == 0)
+      continue;
+    out << site->SummaryLine();
+    site->suppressedSinceSummary = 0;
+  }
+  return out.str();
+}
+
+/////////////////////////////////////////////////
+std::string LogSite::SummaryLine() const
+{
+  return std::string(this->file) + ":" + std::to_string(this->line) + ": " +
+      std::to_string(this->suppressedSinceSummary) + " suppressed, " +
+      std::to_string(this->count) + " in total\n";
+}
+
+/////////////////////////////////////////////////
+double LogSite::Now()
+{
+  return std::chrono::duration<double>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/////////////////////////////////////////////////
+void LogSite::MaybeSummarise(double _now)
+{
+  // Only the caller that moves the time on prints the summary.
+  auto &registry = Registry();
+  double next = registry.nextSummary.load(std::memory_order_relaxed);
+  if (next >= 0.0 && _now < next)
+    return;
+  if (!registry.nextSummary.compare_exchange_strong(next,
+      _now + kSummaryPeriod, std::memory_order_relaxed) || next < 0.0)
+  {
+    return;
+  }
+
+  std::string summary = Summary();
+  if (!summary.empty())
+    gzwarn << "Suppressed messages in the last period:\n" << summary;
+}
+}  // namespace asv
@@ -0,0 +1,127 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "asv/sim/Log.hh"
+
+/////////////////////////////////////////////////
+TEST(Log, TokenBucket)
+{
+    asv::LogSite site("file.cc", 10, 1.0, 3.0);
+
+    // The burst is allowed, then nothing until a token is added.
+    EXPECT_TRUE(site.Allow(0.0));
+    EXPECT_TRUE(site.Allow(0.0));
+    EXPECT_TRUE(site.Allow(0.0));
+    EXPECT_FALSE(site.Allow(0.0));
+    EXPECT_FALSE(site.Allow(0.5));
+    EXPECT_TRUE(site.Allow(1.0));
+    EXPECT_FALSE(site.Allow(1.0));
+
+    // The bucket refills to the burst size.
+    EXPECT_TRUE(site.Allow(100.0));
+    EXPECT_TRUE(site.Allow(100.0));
+    EXPECT_TRUE(site.Allow(100.0));
+    EXPECT_FALSE(site.Allow(100.0));
+
+    EXPECT_EQ(site.Count(), 11u);
+    EXPECT_EQ(site.SuppressedCount(), 4u);
+}
+
+/////////////////////////////////////////////////
+TEST(Log, Note)
+{
+    asv::LogSite site("file.cc", 20, 1.0, 1.0);
+    EXPECT_TRUE(site.Allow(0.0));
+    EXPECT_EQ(site.Note(), "");
+    for (int i = 0; i < 1000; ++i)
+      EXPECT_FALSE(site.Allow(0.0));
+    EXPECT_TRUE(site.Allow(2.0));
+    EXPECT_EQ(site.Note(), "(1000 similar messages suppressed) ");
+    EXPECT_EQ(site.Note(), "");
+}
+
+/////////////////////////////////////////////////
+TEST(Log, Summary)
+{
+    // Clear the summaries of other tests.
+    asv::LogSite::Summary();
+
+    asv::LogSite quiet("quiet.cc", 1, 1.0, 5.0);
+    asv::LogSite noisy("noisy.cc", 2, 1.0, 1.0);
+    quiet.Allow(0.0);
+    noisy.Allow(0.0);
+    noisy.Allow(0.0);
+    noisy.Allow(0.0);
+
+    EXPECT_EQ(asv::LogSite::Summary(),
+        "noisy.cc:2: 2 suppressed, 3 in total\n");
+    EXPECT_EQ(asv::LogSite::Summary(), "");
+}
+
+/////////////////////////////////////////////////
+TEST(Log, Destructor)
+{
+    // Clear the summaries of other tests.
+    asv::LogSite::Summary();
+
+    // A site that goes quiet reports its suppressed messages when it is
+    // destroyed.
+    testing::internal::CaptureStderr();
+    {
+      asv::LogSite site("quiet.cc", 3, 1.0, 1.0);
+      for (int i = 0; i < 5; ++i)
+        site.Allow(0.0);
+    }
+    EXPECT_NE(testing::internal::GetCapturedStderr().find(
+        "quiet.cc:3: 4 suppressed, 5 in total\n"), std::string::npos);
+
+    // Nothing is repeated once a summary has reported it.
+    testing::internal::CaptureStderr();
+    {
+      asv::LogSite site("quiet.cc", 4, 1.0, 1.0);
+      site.Allow(0.0);
+      site.Allow(0.0);
+      EXPECT_EQ(asv::LogSite::Summary(),
+          "quiet.cc:4: 1 suppressed, 2 in total\n");
+    }
+    EXPECT_EQ(testing::internal::GetCapturedStderr(), "");
+}
+
+/////////////////////////////////////////////////
+TEST(Log, Macros)
+{
+    int printed = 0;
+    for (int i = 0; i < 100; ++i)
+    {
+      // The macro is one statement and binds to the enclosing if.
+      if (i >= 0)
+        asvwarn << "warning " << ++printed << "\n";
+      else
+        FAIL();
+    }
+    EXPECT_GE(printed, 5);
+    EXPECT_LT(printed, 100);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
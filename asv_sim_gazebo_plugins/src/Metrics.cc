@@ -0,0 +1,331 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#include "asv/sim/Metrics.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <tuple>
+
+#include <gz/common/Console.hh>
+
+namespace asv
+{
+namespace
+{
+/// \brief Allocations counted for each thread.
+thread_local uint64_t tAllocations = 0;
+
+/////////////////////////////////////////////////
+/// \brief The histogram bucket of a value: 0 for 0, otherwise one more
+/// than the index of the highest set bit.
+size_t Bucket(uint64_t _value)
+{
+  size_t bucket = 0;
+  while (_value != 0)
+  {
+    _value >>= 1;
+    ++bucket;
+  }
+  return std::min(bucket, Metric::kBuckets - 1);
+}
+
+/////////////////////////////////////////////////
+/// \brief The name of a kind of metric.
+const char *KindName(Metric::Kind _kind)
+{
+  switch (_kind)
+  {
+    case Metric::Kind::kLatency:
+      return "latency";
+    case Metric::Kind::kValue:
+      return "value";
+    case Metric::Kind::kCounter:
+    default:
+      return "counter";
+  }
+}
+
+/////////////////////////////////////////////////
+/// \brief Lock-free maximum and minimum.
+void AtomicMax(std::atomic<uint64_t> &_a, uint64_t _v)
+{
+  uint64_t cur = _a.load(std::memory_order_relaxed);
+  while (_v > cur &&
+      !_a.compare_exchange_weak(cur, _v, std::memory_order_relaxed))
+  {
+  }
+}
+
+void AtomicMin(std::atomic<uint64_t> &_a, uint64_t _v)
+{
+  uint64_t cur = _a.load(std::memory_order_relaxed);
+  while (_v < cur &&
+      !_a.compare_exchange_weak(cur, _v, std::memory_order_relaxed))
+  {
+  }
+}
+}  // namespace
+
+/////////////////////////////////////////////////
+Metric::Metric(Kind _kind)
+  : kind(_kind)
+{
+  for (auto &bucket : this->buckets)
+    bucket.store(0, std::memory_order_relaxed);
+}
+
+/////////////////////////////////////////////////
+void Metric::Add(uint64_t _value)
+{
+  this->buckets[Bucket(_value)].fetch_add(1, std::memory_order_relaxed);
+  this->count.fetch_add(1, std::memory_order_relaxed);
+  this->sum.fetch_add(_value, std::memory_order_relaxed);
+  AtomicMin(this->min, _value);
+  AtomicMax(this->max, _value);
+}
+
+/////////////////////////////////////////////////
+Metric::Kind Metric::MetricKind() const
+{
+  return this->kind;
+}
+
+/////////////////////////////////////////////////
+uint64_t Metric::Count() const
+{
+  return this->count.load(std::memory_order_relaxed);
+}
+
+/////////////////////////////////////////////////
+uint64_t Metric::Sum() const
+{
+  return this->sum.load(std::memory_order_relaxed);
+}
+
+/////////////////////////////////////////////////
+uint64_t Metric::Min() const
+{
+  uint64_t value = this->min.load(std::memory_order_relaxed);
+  return value == UINT64_MAX ? 0 : value;
+}
+
+/////////////////////////////////////////////////
+uint64_t Metric::Max() const
+{
+  return this->max.load(std::memory_order_relaxed);
+}
+
+/////////////////////////////////////////////////
+uint64_t Metric::Allocations() const
+{
+  return this->allocations.load(std::memory_order_relaxed);
+}
+
+/////////////////////////////////////////////////
+uint64_t Metric::Quantile(double _q) const
+{
+  std::array<uint64_t, kBuckets> counts;
+  uint64_t total = 0;
+  for (size_t i = 0; i < kBuckets; ++i)
+  {
+    counts[i] = this->buckets[i].load(std::memory_order_relaxed);
+    total += counts[i];
+  }
+  if (total == 0)
+    return 0;
+
+  // The rank of the sample, counting from 1.
+  double q = std::clamp(_q, 0.0, 1.0);
+  uint64_t rank = std::max<uint64_t>(1,
+      static_cast<uint64_t>(std::ceil(q * static_cast<double>(total))));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < kBuckets; ++i)
+  {
+    seen += counts[i];
+    if (seen >= rank)
+    {
+      uint64_t bound = i == 0 ? 0 : (uint64_t(1) << i) - 1;
+      if (i == kBuckets - 1)
+        bound = UINT64_MAX;
+      return std::clamp(bound, this->Min(), this->Max());
+    }
+  }
+  return this->Max();
+}
+
+/////////////////////////////////////////////////
+void Metric::Reset()
+{
+  for (auto &bucket : this->buckets)
+    bucket.store(0, std::memory_order_relaxed);
+  this->count.store(0, std::memory_order_relaxed);
+  this->sum.store(0, std::memory_order_relaxed);
+  this->min.store(UINT64_MAX, std::memory_order_relaxed);
+  this->max.store(0, std::memory_order_relaxed);
+  this->allocations.store(0, std::memory_order_relaxed);
+}
+
+/////////////////////////////////////////////////
+class MetricsPrivate
+{
+  /// \brief Key of a metric, in CSV order.
+  public: using Key = std::tuple<std::string, std::string, uint64_t>;
+
+  /// \brief Protects the map, not the metrics.
+  public: mutable std::mutex mutex;
+
+  /// \brief The metrics.
+  public: std::map<Key, std::unique_ptr<Metric>> metrics;
+};
+
+/////////////////////////////////////////////////
+Metrics &Metrics::Instance()
+{
+  static Metrics metrics;
+  return metrics;
+}
+
+/////////////////////////////////////////////////
+Metrics::Metrics()
+  : data(std::make_unique<MetricsPrivate>())
+{
+}
+
+/////////////////////////////////////////////////
+Metrics::~Metrics() = default;
+
+/////////////////////////////////////////////////
+Metric &Metrics::Latency(const std::string &_system,
+    const std::string &_phase, uint64_t _entity)
+{
+  return this->Get(Metric::Kind::kLatency, _system, _phase, _entity);
+}
+
+/////////////////////////////////////////////////
+Metric &Metrics::Value(const std::string &_system,
+    const std::string &_name, uint64_t _entity)
+{
+  return this->Get(Metric::Kind::kValue, _system, _name, _entity);
+}
+
+/////////////////////////////////////////////////
+Metric &Metrics::Counter(const std::string &_system,
+    const std::string &_name, uint64_t _entity)
+{
+  return this->Get(Metric::Kind::kCounter, _system, _name, _entity);
+}
+
+/////////////////////////////////////////////////
+Metric &Metrics::Get(Metric::Kind _kind, const std::string &_system,
+    const std::string &_name, uint64_t _entity)
+{
+  std::lock_guard<std::mutex> lock(this->data->mutex);
+  auto &metric = this->data->metrics[{_system, _name, _entity}];
+  if (!metric)
+  {
+    metric = std::make_unique<Metric>(_kind);
+  }
+  else if (metric->MetricKind() != _kind)
+  {
+    gzwarn << "Metric [" << _system << " " << _name << "] is a "
+           << KindName(metric->MetricKind()) << ", not a "
+           << KindName(_kind) << ".\n";
+  }
+  return *metric;
+}
+
+/////////////////////////////////////////////////
+std::string Metrics::Csv() const
+{
+  std::ostringstream out;
+  out << "kind,system,name,entity,count,sum,min,max,p50,p90,p99,"
+      << "allocations\n";
+
+  std::lock_guard<std::mutex> lock(this->data->mutex);
+  for (const auto &[key, metric] : this->data->metrics)
+  {
+    out << KindName(metric->MetricKind()) << ","
+        << std::get<0>(key) << ","
+        << std::get<1>(key) << ",";
+    if (std::get<2>(key) != kNoEntity)
+      out << std::get<2>(key);
+    out << "," << metric->Count();
+    if (metric->MetricKind() == Metric::Kind::kCounter)
+    {
+      out << ",,,,,,,";
+    }
+    else
+    {
+      out << "," << metric->Sum()
+          << "," << metric->Min()
+          << "," << metric->Max()
+          << "," << metric->Quantile(0.5)
+          << "," << metric->Quantile(0.9)
+          << "," << metric->Quantile(0.99)
+          << "," << metric->Allocations();
+    }
+    out << "\n";
+  }
+  return out.str();
+}
+
+/////////////////////////////////////////////////
+bool Metrics::WriteCsv(const std::string &_path) const
+{
+  std::ofstream file(_path);
+  if (!file)
+  {
+    gzerr << "Failed to open [" << _path << "] for the metrics.\n";
+    return false;
+  }
+  file << this->Csv();
+  return static_cast<bool>(file);
+}
+
+/////////////////////////////////////////////////
+void Metrics::ForEach(const std::function<void(const std::string &,
+    const std::string &, uint64_t, const Metric &)> &_visitor) const
+{
+  std::lock_guard<std::mutex> lock(this->data->mutex);
+  for (const auto &[key, metric] : this->data->metrics)
+    _visitor(std::get<0>(key), std::get<1>(key), std::get<2>(key), *metric);
+}
+
+/////////////////////////////////////////////////
+void Metrics::Reset()
+{
+  std::lock_guard<std::mutex> lock(this->data->mutex);
+  for (auto &metric : this->data->metrics)
+    metric.second->Reset();
+}
+
+/////////////////////////////////////////////////
+void Metrics::CountAllocation()
+{
+  ++tAllocations;
+}
+
+/////////////////////////////////////////////////
+uint64_t Metrics::ThreadAllocations()
+{
+  return tAllocations;
+}
+}  // namespace asv
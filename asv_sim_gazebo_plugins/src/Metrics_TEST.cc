@@ -0,0 +1,143 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "asv/sim/Metrics.hh"
+
+/////////////////////////////////////////////////
+TEST(Metrics, Histogram)
+{
+    asv::Metric metric(asv::Metric::Kind::kValue);
+    EXPECT_EQ(metric.Count(), 0u);
+    EXPECT_EQ(metric.Quantile(0.5), 0u);
+
+    for (uint64_t i = 1; i <= 100; ++i)
+      metric.Add(i);
+    EXPECT_EQ(metric.Count(), 100u);
+    EXPECT_EQ(metric.Sum(), 5050u);
+    EXPECT_EQ(metric.Min(), 1u);
+    EXPECT_EQ(metric.Max(), 100u);
+
+    // Quantiles are upper bounds within a factor of 2.
+    uint64_t p50 = metric.Quantile(0.5);
+    EXPECT_GE(p50, 50u);
+    EXPECT_LT(p50, 100u);
+    EXPECT_EQ(metric.Quantile(1.0), 100u);
+    EXPECT_EQ(metric.Quantile(0.0), 1u);
+
+    metric.Reset();
+    EXPECT_EQ(metric.Count(), 0u);
+    EXPECT_EQ(metric.Min(), 0u);
+}
+
+/////////////////////////////////////////////////
+TEST(Metrics, Registry)
+{
+    asv::Metrics metrics;
+    asv::Metric &a = metrics.Latency("A", "PreUpdate");
+    asv::Metric &b = metrics.Counter("A", "calls", 7);
+    EXPECT_EQ(&a, &metrics.Latency("A", "PreUpdate"));
+    EXPECT_NE(&a, &metrics.Latency("B", "PreUpdate"));
+    EXPECT_NE(&b, &metrics.Counter("A", "calls", 8));
+
+    {
+      asv::MetricTimer timer(a);
+      asv::Metrics::CountAllocation();
+      asv::Metrics::CountAllocation();
+    }
+    b.Increment(3);
+    EXPECT_EQ(a.Count(), 1u);
+    EXPECT_EQ(a.Allocations(), 2u);
+    EXPECT_EQ(b.Count(), 3u);
+
+    std::istringstream csv(metrics.Csv());
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(csv, line);)
+      lines.push_back(line);
+    ASSERT_EQ(lines.size(), 5u);
+    EXPECT_EQ(lines[0], "kind,system,name,entity,count,sum,min,max,p50,p90,"
+        "p99,allocations");
+    EXPECT_EQ(lines[1].find("latency,A,PreUpdate,,1,"), 0u);
+    EXPECT_EQ(lines[1].substr(lines[1].size() - 2), ",2");
+    EXPECT_EQ(lines[2], "counter,A,calls,7,3,,,,,,,");
+    EXPECT_EQ(lines[3], "counter,A,calls,8,0,,,,,,,");
+
+    std::vector<std::string> names;
+    metrics.ForEach([&](const std::string &_system,
+        const std::string &_name, uint64_t, const asv::Metric &_metric)
+        {
+          names.push_back(_system + "." + _name + "=" +
+              std::to_string(_metric.Count()));
+        });
+    ASSERT_EQ(names.size(), 4u);
+    EXPECT_EQ(names[0], "A.PreUpdate=1");
+    EXPECT_EQ(names[1], "A.calls=3");
+
+    metrics.Reset();
+    EXPECT_EQ(a.Count(), 0u);
+    EXPECT_EQ(b.Count(), 0u);
+}
+
+/////////////////////////////////////////////////
+TEST(Metrics, Threads)
+{
+    asv::Metrics metrics;
+    asv::Metric &metric = metrics.Value("A", "iterations");
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+    {
+      threads.emplace_back([&metric]()
+          {
+            for (uint64_t i = 0; i < 10000; ++i)
+              metric.Add(i % 16);
+          });
+    }
+    for (auto &thread : threads)
+      thread.join();
+    EXPECT_EQ(metric.Count(), 40000u);
+    EXPECT_EQ(metric.Sum(), 4u * 625u * 120u);
+    EXPECT_EQ(metric.Max(), 15u);
+}
+
+/////////////////////////////////////////////////
+TEST(Metrics, WriteCsv)
+{
+    asv::Metrics metrics;
+    metrics.Value("A", "iterations").Add(4);
+    std::string path = testing::TempDir() + "metrics.csv";
+    ASSERT_TRUE(metrics.WriteCsv(path));
+    std::ifstream file(path);
+    std::stringstream content;
+    content << file.rdbuf();
+    EXPECT_EQ(content.str(), metrics.Csv());
+    std::remove(path.c_str());
+
+    EXPECT_FALSE(metrics.WriteCsv("/nonexistent/metrics.csv"));
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,293 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "asv/sim/RecordReader.hh"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include <gz/common/Console.hh>
+
+namespace asv
+{
+namespace
+{
+/////////////////////////////////////////////////
+/// \brief Reads little-endian values from a byte buffer.
+class ByteReader
+{
+  public: ByteReader(const uint8_t *_begin, const uint8_t *_end)
+      : pos(_begin), end(_end) {}
+
+  /// \brief True if all reads were in bounds.
+  public: bool Ok() const { return this->ok; }
+
+  /// \brief True if there is nothing left to read.
+  public: bool AtEnd() const { return this->pos >= this->end; }
+
+  /// \brief The number of bytes left.
+  public: size_t Remaining() const
+  {
+    return this->pos < this->end ? this->end - this->pos : 0;
+  }
+
+  /// \brief Read an integer.
+  public: template <typename T> T Get()
+  {
+    if (this->Remaining() < sizeof(T))
+    {
+      this->ok = false;
+      this->pos = this->end;
+      return 0;
+    }
+    uint64_t value = 0;
+    for (size_t i = 0; i < sizeof(T); ++i)
+      value |= static_cast<uint64_t>(this->pos[i]) << (8 * i);
+    this->pos += sizeof(T);
+    return static_cast<T>(value);
+  }
+
+  /// \brief Read a length-prefixed string.
+  public: std::string GetString()
+  {
+    size_t size = this->Get<uint16_t>();
+    if (this->Remaining() < size)
+    {
+      this->ok = false;
+      this->pos = this->end;
+      return std::string();
+    }
+    std::string str(reinterpret_cast<const char *>(this->pos), size);
+    this->pos += size;
+    return str;
+  }
+
+  /// \brief Read a compressed column of _rows values, appending them
+  /// as bit patterns.
+  public: template <typename T> void GetColumn(size_t _rows,
+      std::vector<T> &_values)
+  {
+    size_t numCounts = (_rows + 1) / 2;
+    if (this->Remaining() < numCounts)
+    {
+      this->ok = false;
+      this->pos = this->end;
+      return;
+    }
+    const uint8_t *counts = this->pos;
+    this->pos += numCounts;
+
+    uint64_t prev = 0;
+    for (size_t i = 0; i < _rows; ++i)
+    {
+      uint8_t len = (counts[i / 2] >> (4 * (i % 2))) & 0x0f;
+      if (len > 8 || this->Remaining() < len)
+      {
+        this->ok = false;
+        this->pos = this->end;
+        return;
+      }
+      uint64_t delta = 0;
+      for (uint8_t b = 0; b < len; ++b)
+        delta |= static_cast<uint64_t>(this->pos[b]) << (8 * b);
+      this->pos += len;
+      prev ^= delta;
+
+      T value;
+      static_assert(sizeof(T) == sizeof(prev), "64 bit columns only");
+      std::memcpy(&value, &prev, sizeof(value));
+      _values.push_back(value);
+    }
+  }
+
+  /// \brief Skip bytes.
+  public: void Skip(size_t _size)
+  {
+    if (this->Remaining() < _size)
+      this->ok = false;
+    this->pos = this->Remaining() < _size ? this->end : this->pos + _size;
+  }
+
+  private: const uint8_t *pos;
+  private: const uint8_t *end;
+  private: bool ok{true};
+};
+}  // namespace
+
+/////////////////////////////////////////////////
+bool RecordReader::Open(const std::string &_filename)
+{
+  this->tables.clear();
+
+  std::ifstream file(_filename, std::ios::binary);
+  if (!file)
+  {
+    gzerr << "Failed to open record file [" << _filename << "].\n";
+    return false;
+  }
+  std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)),
+      std::istreambuf_iterator<char>());
+
+  ByteReader in(bytes.data(), bytes.data() + bytes.size());
+  if (bytes.size() < 8 || std::memcmp(bytes.data(), "ASVR", 4) != 0)
+  {
+    gzerr << "File [" << _filename << "] is not a record file.\n";
+    return false;
+  }
+  in.Skip(4);
+  uint32_t version = in.Get<uint32_t>();
+  if (version != 1)
+  {
+    gzerr << "Record file [" << _filename << "] has unsupported version ["
+          << version << "].\n";
+    return false;
+  }
+
+  bool complete = false;
+  bool valid = true;
+  while (valid && in.Ok() && !in.AtEnd() && !complete)
+  {
+    uint8_t tag = in.Get<uint8_t>();
+    if (tag == 'E')
+    {
+      complete = true;
+    }
+    else if (tag == 'S')
+    {
+      uint32_t type = in.Get<uint32_t>();
+      RecordSchema schema;
+      schema.name = in.GetString();
+      uint16_t numFields = in.Get<uint16_t>();
+      for (uint16_t i = 0; i < numFields && in.Ok(); ++i)
+        schema.fields.push_back(in.GetString());
+      // Type ids are small, a large one is a corrupt file.
+      valid = type < 0x10000;
+      if (!valid || !in.Ok())
+        break;
+
+      if (type >= this->tables.size())
+        this->tables.resize(type + 1);
+      this->tables[type].schema = schema;
+      this->tables[type].columns.resize(numFields);
+    }
+    else if (tag == 'B')
+    {
+      uint32_t type = in.Get<uint32_t>();
+      uint32_t rows = in.Get<uint32_t>();
+      uint32_t size = in.Get<uint32_t>();
+      valid = in.Remaining() >= size;
+      if (!valid || !in.Ok())
+        break;
+      if (type >= this->tables.size() ||
+          this->tables[type].schema.name.empty())
+      {
+        gzwarn << "Skipping block of unknown record type [" << type
+               << "].\n";
+        in.Skip(size);
+        continue;
+      }
+
+      auto &table = this->tables[type];
+      in.GetColumn(rows, table.time);
+      in.GetColumn(rows, table.entity);
+      for (auto &column : table.columns)
+        in.GetColumn(rows, column);
+    }
+    else
+    {
+      gzerr << "Unknown block [" << static_cast<int>(tag)
+            << "] in record file [" << _filename << "].\n";
+      this->tables.clear();
+      return false;
+    }
+  }
+
+  if (!valid || !in.Ok())
+  {
+    gzerr << "Record file [" << _filename << "] is corrupt.\n";
+    this->tables.clear();
+    return false;
+  }
+
+  // The blocks read from a file that was not closed are kept.
+  if (!complete)
+  {
+    gzwarn << "Record file [" << _filename << "] is incomplete.\n";
+  }
+  return true;
+}
+
+/////////////////////////////////////////////////
+size_t RecordReader::TypeCount() const
+{
+  return this->tables.size();
+}
+
+/////////////////////////////////////////////////
+const RecordSchema &RecordReader::Schema(size_t _type) const
+{
+  return this->tables.at(_type).schema;
+}
+
+/////////////////////////////////////////////////
+int RecordReader::FindType(const std::string &_name) const
+{
+  for (size_t i = 0; i < this->tables.size(); ++i)
+  {
+    if (this->tables[i].schema.name == _name)
+      return static_cast<int>(i);
+  }
+  return -1;
+}
+
+/////////////////////////////////////////////////
+int RecordReader::FindField(size_t _type, const std::string &_name) const
+{
+  const auto &fields = this->tables.at(_type).schema.fields;
+  for (size_t i = 0; i < fields.size(); ++i)
+  {
+    if (fields[i] == _name)
+      return static_cast<int>(i);
+  }
+  return -1;
+}
+
+/////////////////////////////////////////////////
+size_t RecordReader::RowCount(size_t _type) const
+{
+  return this->tables.at(_type).time.size();
+}
+
+/////////////////////////////////////////////////
+const std::vector<double> &RecordReader::Time(size_t _type) const
+{
+  return this->tables.at(_type).time;
+}
+
+/////////////////////////////////////////////////
+const std::vector<uint64_t> &RecordReader::Entity(size_t _type) const
+{
+  return this->tables.at(_type).entity;
+}
+
+/////////////////////////////////////////////////
+const std::vector<double> &RecordReader::Column(size_t _type,
+    size_t _field) const
+{
+  return this->tables.at(_type).columns.at(_field);
+}
+
+}  // namespace asv
@@ -0,0 +1,556 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "asv/sim/Recorder.hh"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include <gz/common/Console.hh>
+
+namespace asv
+{
+namespace
+{
+/// \brief File format version.
+const uint32_t kVersion = 1;
+
+/// \brief Source of recorder ids for the thread-local ring cache.
+std::atomic<uint64_t> nextRecorderId{1};
+
+/////////////////////////////////////////////////
+/// \brief Append the little-endian bytes of an integer.
+template <typename T>
+void Put(std::vector<uint8_t> &_out, T _value)
+{
+  for (size_t i = 0; i < sizeof(T); ++i)
+    _out.push_back(static_cast<uint8_t>(
+        static_cast<uint64_t>(_value) >> (8 * i)));
+}
+
+/////////////////////////////////////////////////
+/// \brief Append a length-prefixed string.
+void PutString(std::vector<uint8_t> &_out, const std::string &_str)
+{
+  Put<uint16_t>(_out, static_cast<uint16_t>(_str.size()));
+  _out.insert(_out.end(), _str.begin(), _str.end());
+}
+
+/////////////////////////////////////////////////
+/// \brief The bit pattern of a double.
+uint64_t Bits(double _value)
+{
+  uint64_t bits;
+  std::memcpy(&bits, &_value, sizeof(bits));
+  return bits;
+}
+
+/////////////////////////////////////////////////
+/// \brief Append a compressed column. Each value is XORed with the
+/// previous one and only its significant bytes are kept. The byte
+/// counts are packed two to a byte ahead of the bytes themselves.
+template <typename T, typename F>
+void PutColumn(std::vector<uint8_t> &_out, const std::vector<T> &_values,
+    F _bits)
+{
+  size_t n = _values.size();
+  size_t counts = _out.size();
+  _out.resize(counts + (n + 1) / 2, 0);
+
+  uint64_t prev = 0;
+  for (size_t i = 0; i < n; ++i)
+  {
+    uint64_t bits = _bits(_values[i]);
+    uint64_t delta = bits ^ prev;
+    prev = bits;
+
+    uint8_t len = 0;
+    while (len < 8 && (delta >> (8 * len)) != 0)
+      ++len;
+    _out[counts + i / 2] |= static_cast<uint8_t>(len << (4 * (i % 2)));
+    for (uint8_t b = 0; b < len; ++b)
+      _out.push_back(static_cast<uint8_t>(delta >> (8 * b)));
+  }
+}
+}  // namespace
+
+/////////////////////////////////////////////////
+class RecorderPrivate
+{
+  /// \brief The largest number of record types.
+  public: static constexpr size_t kMaxTypes = 256;
+
+  /// \brief A sample as copied into a ring.
+  public: struct Sample
+  {
+    uint32_t type;
+    double time;
+    uint64_t entity;
+    std::array<double, Recorder::kMaxFields> values;
+  };
+
+  /// \brief A single-producer single-consumer ring of samples.
+  public: struct Ring
+  {
+    explicit Ring(size_t _size) : slots(_size), mask(_size - 1) {}
+
+    std::vector<Sample> slots;
+    const uint64_t mask;
+
+    /// \brief Written by the producer.
+    alignas(64) std::atomic<uint64_t> head{0};
+
+    /// \brief Written by the writer thread.
+    alignas(64) std::atomic<uint64_t> tail{0};
+  };
+
+  /// \brief The columns of a record type waiting to be written.
+  public: struct Block
+  {
+    std::vector<double> time;
+    std::vector<uint64_t> entity;
+    std::vector<std::vector<double>> fields;
+    bool schemaWritten{false};
+  };
+
+  /// \brief The ring of the calling thread.
+  public: Ring *ThreadRing();
+
+  /// \brief Writer thread loop.
+  public: void Run();
+
+  /// \brief Move the samples in the rings to the blocks.
+  /// \return The number of samples moved.
+  public: size_t Drain();
+
+  /// \brief Append a sample to the block of its type.
+  public: void Append(const Sample &_sample);
+
+  /// \brief Write the schema of a record type if not already written.
+  public: void WriteSchema(uint32_t _type);
+
+  /// \brief Write and clear the block of a record type.
+  public: void WriteBlock(uint32_t _type);
+
+  /// \brief Write the buffer to the file and clear it.
+  public: void Flush();
+
+  /// \brief Unique id of this recorder.
+  public: const uint64_t id{nextRecorderId++};
+
+  /// \brief Number of samples in each ring (a power of 2).
+  public: size_t ringSize;
+
+  /// \brief Number of rows in a block.
+  public: size_t blockRows;
+
+  /// \brief The field count plus one of each type, 0 if unregistered.
+  public: std::array<std::atomic<uint32_t>, kMaxTypes> fieldCounts{};
+
+  /// \brief Protects schemas.
+  public: std::mutex schemaMutex;
+
+  /// \brief The schemas by type id.
+  public: std::vector<RecordSchema> schemas;
+
+  /// \brief Protects rings and ringList.
+  public: std::mutex ringMutex;
+
+  /// \brief The rings by producer thread.
+  public: std::unordered_map<std::thread::id, std::unique_ptr<Ring>> rings;
+
+  /// \brief The rings in registration order.
+  public: std::vector<Ring *> ringList;
+
+  /// \brief The blocks by type id. Writer thread only.
+  public: std::vector<Block> blocks;
+
+  /// \brief Bytes waiting to be written. Writer thread only.
+  public: std::vector<uint8_t> buffer;
+
+  /// \brief The open file.
+  public: std::FILE *file{nullptr};
+
+  /// \brief The writer thread.
+  public: std::thread writer;
+
+  /// \brief Wakes the writer thread to stop.
+  public: std::condition_variable wake;
+
+  /// \brief Protects stop for the condition variable.
+  public: std::mutex wakeMutex;
+
+  /// \brief Set to stop the writer thread.
+  public: bool stop{false};
+
+  /// \brief True while a file is open.
+  public: std::atomic<bool> open{false};
+
+  /// \brief Number of samples dropped.
+  public: std::atomic<uint64_t> dropped{0};
+
+  /// \brief Number of samples written.
+  public: std::atomic<uint64_t> written{0};
+};
+
+/////////////////////////////////////////////////
+RecorderPrivate::Ring *RecorderPrivate::ThreadRing()
+{
+  thread_local uint64_t cachedId = 0;
+  thread_local Ring *cachedRing = nullptr;
+  if (cachedId == this->id)
+    return cachedRing;
+
+  std::lock_guard<std::mutex> lock(this->ringMutex);
+  auto &ring = this->rings[std::this_thread::get_id()];
+  if (!ring)
+  {
+    ring = std::make_unique<Ring>(this->ringSize);
+    this->ringList.push_back(ring.get());
+  }
+  cachedId = this->id;
+  cachedRing = ring.get();
+  return cachedRing;
+}
+
+/////////////////////////////////////////////////
+void RecorderPrivate::Run()
+{
+  while (true)
+  {
+    bool stopping;
+    {
+      std::unique_lock<std::mutex> lock(this->wakeMutex);
+      stopping = this->stop;
+    }
+
+    // Drain once more after the stop is seen.
+    size_t n = this->Drain();
+    if (stopping && n == 0)
+      break;
+    if (n == 0)
+    {
+      std::unique_lock<std::mutex> lock(this->wakeMutex);
+      this->wake.wait_for(lock, std::chrono::milliseconds(1),
+          [this] { return this->stop; });
+    }
+  }
+
+  for (uint32_t type = 0; type < this->blocks.size(); ++type)
+    this->WriteBlock(type);
+
+  // Registered types without samples are listed too.
+  size_t numTypes;
+  {
+    std::lock_guard<std::mutex> lock(this->schemaMutex);
+    numTypes = this->schemas.size();
+  }
+  for (uint32_t type = 0; type < numTypes; ++type)
+    this->WriteSchema(type);
+
+  this->buffer.push_back('E');
+  this->Flush();
+}
+
+/////////////////////////////////////////////////
+size_t RecorderPrivate::Drain()
+{
+  size_t n = 0;
+  std::lock_guard<std::mutex> lock(this->ringMutex);
+  for (auto *ring : this->ringList)
+  {
+    uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+    uint64_t head = ring->head.load(std::memory_order_acquire);
+    for (uint64_t i = tail; i < head; ++i)
+      this->Append(ring->slots[i & ring->mask]);
+    ring->tail.store(head, std::memory_order_release);
+    n += head - tail;
+  }
+  this->Flush();
+  return n;
+}
+
+/////////////////////////////////////////////////
+void RecorderPrivate::Append(const Sample &_sample)
+{
+  if (_sample.type >= this->blocks.size())
+    this->blocks.resize(_sample.type + 1);
+
+  auto &block = this->blocks[_sample.type];
+  uint32_t numFields = this->fieldCounts[_sample.type].load(
+      std::memory_order_relaxed) - 1;
+  if (block.fields.size() != numFields)
+  {
+    block.fields.resize(numFields);
+    block.time.reserve(this->blockRows);
+    block.entity.reserve(this->blockRows);
+    for (auto &field : block.fields)
+      field.reserve(this->blockRows);
+  }
+
+  block.time.push_back(_sample.time);
+  block.entity.push_back(_sample.entity);
+  for (uint32_t i = 0; i < numFields; ++i)
+    block.fields[i].push_back(_sample.values[i]);
+
+  if (block.time.size() >= this->blockRows)
+    this->WriteBlock(_sample.type);
+}
+
+/////////////////////////////////////////////////
+void RecorderPrivate::WriteSchema(uint32_t _type)
+{
+  if (_type >= this->blocks.size())
+    this->blocks.resize(_type + 1);
+  auto &block = this->blocks[_type];
+  if (block.schemaWritten)
+    return;
+
+  RecordSchema schema;
+  {
+    std::lock_guard<std::mutex> lock(this->schemaMutex);
+    schema = this->schemas[_type];
+  }
+
+  this->buffer.push_back('S');
+  Put<uint32_t>(this->buffer, _type);
+  PutString(this->buffer, schema.name);
+  Put<uint16_t>(this->buffer, static_cast<uint16_t>(schema.fields.size()));
+  for (const auto &field : schema.fields)
+    PutString(this->buffer, field);
+  block.schemaWritten = true;
+}
+
+/////////////////////////////////////////////////
+void RecorderPrivate::WriteBlock(uint32_t _type)
+{
+  auto &block = this->blocks[_type];
+  size_t rows = block.time.size();
+  if (rows == 0)
+    return;
+
+  this->WriteSchema(_type);
+
+  this->buffer.push_back('B');
+  Put<uint32_t>(this->buffer, _type);
+  Put<uint32_t>(this->buffer, static_cast<uint32_t>(rows));
+  size_t sizePos = this->buffer.size();
+  Put<uint32_t>(this->buffer, 0);
+  size_t start = this->buffer.size();
+
+  PutColumn(this->buffer, block.time, Bits);
+  PutColumn(this->buffer, block.entity, [](uint64_t _v) { return _v; });
+  for (const auto &field : block.fields)
+    PutColumn(this->buffer, field, Bits);
+
+  uint32_t size = static_cast<uint32_t>(this->buffer.size() - start);
+  for (size_t i = 0; i < sizeof(size); ++i)
+    this->buffer[sizePos + i] = static_cast<uint8_t>(size >> (8 * i));
+
+  block.time.clear();
+  block.entity.clear();
+  for (auto &field : block.fields)
+    field.clear();
+  this->written += rows;
+}
+
+/////////////////////////////////////////////////
+void RecorderPrivate::Flush()
+{
+  if (this->buffer.empty())
+    return;
+  if (std::fwrite(this->buffer.data(), 1, this->buffer.size(), this->file)
+      != this->buffer.size())
+  {
+    gzerr << "Failed to write record file.\n";
+  }
+  this->buffer.clear();
+}
+
+/////////////////////////////////////////////////
+Recorder &Recorder::Instance()
+{
+  static Recorder recorder;
+  return recorder;
+}
+
+/////////////////////////////////////////////////
+Recorder::~Recorder()
+{
+  this->Close();
+}
+
+/////////////////////////////////////////////////
+Recorder::Recorder(size_t _ringSize, size_t _blockRows)
+    : data(std::make_unique<RecorderPrivate>())
+{
+  // Round the ring up to a power of 2 so the index is a mask.
+  size_t size = 2;
+  while (size < _ringSize)
+    size *= 2;
+  this->data->ringSize = size;
+  this->data->blockRows = std::max<size_t>(1, _blockRows);
+}
+
+/////////////////////////////////////////////////
+bool Recorder::Open(const std::string &_filename)
+{
+  this->Close();
+
+  auto &d = *this->data;
+  d.file = std::fopen(_filename.c_str(), "wb");
+  if (!d.file)
+  {
+    gzerr << "Failed to open record file [" << _filename << "].\n";
+    return false;
+  }
+
+  // Discard samples left from a previous file.
+  {
+    std::lock_guard<std::mutex> lock(d.ringMutex);
+    for (auto *ring : d.ringList)
+    {
+      ring->tail.store(ring->head.load(std::memory_order_acquire),
+          std::memory_order_release);
+    }
+  }
+  d.blocks.clear();
+  d.written = 0;
+  d.dropped = 0;
+
+  d.buffer.assign({'A', 'S', 'V', 'R'});
+  Put<uint32_t>(d.buffer, kVersion);
+
+  d.stop = false;
+  d.writer = std::thread(&RecorderPrivate::Run, &d);
+  d.open = true;
+  return true;
+}
+
+/////////////////////////////////////////////////
+void Recorder::Close()
+{
+  auto &d = *this->data;
+  if (!d.writer.joinable())
+    return;
+
+  d.open = false;
+  {
+    std::lock_guard<std::mutex> lock(d.wakeMutex);
+    d.stop = true;
+  }
+  d.wake.notify_one();
+  d.writer.join();
+
+  std::fclose(d.file);
+  d.file = nullptr;
+}
+
+/////////////////////////////////////////////////
+bool Recorder::IsOpen() const
+{
+  return this->data->open.load(std::memory_order_relaxed);
+}
+
+/////////////////////////////////////////////////
+uint32_t Recorder::RegisterType(const std::string &_name,
+    const std::vector<std::string> &_fields)
+{
+  auto &d = *this->data;
+  if (_fields.size() > kMaxFields)
+  {
+    gzerr << "Record type [" << _name << "] has " << _fields.size()
+          << " fields, the maximum is " << kMaxFields << ".\n";
+    return kInvalidType;
+  }
+
+  std::lock_guard<std::mutex> lock(d.schemaMutex);
+  for (uint32_t type = 0; type < d.schemas.size(); ++type)
+  {
+    if (d.schemas[type].name != _name)
+      continue;
+    if (d.schemas[type].fields != _fields)
+    {
+      gzerr << "Record type [" << _name
+            << "] is already registered with different fields.\n";
+      return kInvalidType;
+    }
+    return type;
+  }
+
+  if (d.schemas.size() >= RecorderPrivate::kMaxTypes)
+  {
+    gzerr << "Too many record types to register [" << _name << "].\n";
+    return kInvalidType;
+  }
+
+  uint32_t type = static_cast<uint32_t>(d.schemas.size());
+  d.schemas.push_back({_name, _fields});
+  d.fieldCounts[type].store(static_cast<uint32_t>(_fields.size() + 1),
+      std::memory_order_release);
+  return type;
+}
+
+/////////////////////////////////////////////////
+bool Recorder::Record(uint32_t _type, double _time, uint64_t _entity,
+    const double *_values)
+{
+  auto &d = *this->data;
+  if (!d.open.load(std::memory_order_relaxed) ||
+      _type >= RecorderPrivate::kMaxTypes)
+    return false;
+
+  uint32_t numFields = d.fieldCounts[_type].load(std::memory_order_acquire);
+  if (numFields-- == 0)
+    return false;
+
+  auto *ring = d.ThreadRing();
+  uint64_t head = ring->head.load(std::memory_order_relaxed);
+  if (head - ring->tail.load(std::memory_order_acquire) > ring->mask)
+  {
+    d.dropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  auto &sample = ring->slots[head & ring->mask];
+  sample.type = _type;
+  sample.time = _time;
+  sample.entity = _entity;
+  std::copy(_values, _values + numFields, sample.values.begin());
+  ring->head.store(head + 1, std::memory_order_release);
+  return true;
+}
+
+/////////////////////////////////////////////////
+uint64_t Recorder::DroppedCount() const
+{
+  return this->data->dropped.load(std::memory_order_relaxed);
+}
+
+/////////////////////////////////////////////////
+uint64_t Recorder::WrittenCount() const
+{
+  return this->data->written.load(std::memory_order_relaxed);
+}
+
+}  // namespace asv
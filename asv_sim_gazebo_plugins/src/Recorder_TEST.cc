@@ -0,0 +1,211 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "asv/sim/RecordReader.hh"
+#include "asv/sim/Recorder.hh"
+
+namespace
+{
+/////////////////////////////////////////////////
+std::string TempFile(const std::string &_name)
+{
+  return testing::TempDir() + _name;
+}
+}  // namespace
+
+/////////////////////////////////////////////////
+TEST(Recorder, RegisterType)
+{
+    asv::Recorder recorder;
+    uint32_t a = recorder.RegisterType("a", {"x", "y"});
+    uint32_t b = recorder.RegisterType("b", {});
+    EXPECT_EQ(a, 0u);
+    EXPECT_EQ(b, 1u);
+    EXPECT_EQ(recorder.RegisterType("a", {"x", "y"}), a);
+    EXPECT_EQ(recorder.RegisterType("a", {"x"}),
+        asv::Recorder::kInvalidType);
+
+    std::vector<std::string> fields(asv::Recorder::kMaxFields + 1, "f");
+    EXPECT_EQ(recorder.RegisterType("c", fields),
+        asv::Recorder::kInvalidType);
+
+    // Nothing is recorded while closed.
+    double values[2] = {1.0, 2.0};
+    EXPECT_FALSE(recorder.IsOpen());
+    EXPECT_FALSE(recorder.Record(a, 0.0, 1, values));
+}
+
+/////////////////////////////////////////////////
+TEST(Recorder, RoundTrip)
+{
+    std::string filename = TempFile("recorder_round_trip.asvr");
+
+    // Small blocks so the file has several.
+    asv::Recorder recorder(1024, 100);
+    uint32_t force = recorder.RegisterType("force", {"fx", "fy", "fz"});
+    uint32_t empty = recorder.RegisterType("empty", {"x"});
+    uint32_t tick = recorder.RegisterType("tick", {});
+    ASSERT_TRUE(recorder.Open(filename));
+    EXPECT_TRUE(recorder.IsOpen());
+
+    const size_t n = 950;
+    for (size_t i = 0; i < n; ++i)
+    {
+      double t = 0.001 * i;
+      double f[3] = {std::sin(t), -1.0E6 * t, 0.0};
+      EXPECT_TRUE(recorder.Record(force, t, 7 + i % 3, f));
+      if (i % 10 == 0)
+      {
+        EXPECT_TRUE(recorder.Record(tick, t, 0, nullptr));
+      }
+
+      // Let the writer keep up with the small ring.
+      if (i % 500 == 0)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    recorder.Close();
+    EXPECT_FALSE(recorder.IsOpen());
+    EXPECT_EQ(recorder.DroppedCount(), 0u);
+    EXPECT_EQ(recorder.WrittenCount(), n + 95);
+
+    asv::RecordReader reader;
+    ASSERT_TRUE(reader.Open(filename));
+    ASSERT_EQ(reader.TypeCount(), 3u);
+    EXPECT_EQ(reader.FindType("force"), static_cast<int>(force));
+    EXPECT_EQ(reader.FindType("empty"), static_cast<int>(empty));
+    EXPECT_EQ(reader.FindType("missing"), -1);
+    EXPECT_EQ(reader.Schema(force).fields.size(), 3u);
+    EXPECT_EQ(reader.FindField(force, "fy"), 1);
+    EXPECT_EQ(reader.RowCount(empty), 0u);
+    EXPECT_EQ(reader.RowCount(tick), 95u);
+
+    // Values are restored exactly.
+    ASSERT_EQ(reader.RowCount(force), n);
+    for (size_t i = 0; i < n; ++i)
+    {
+      double t = 0.001 * i;
+      EXPECT_EQ(reader.Time(force)[i], t);
+      EXPECT_EQ(reader.Entity(force)[i], 7 + i % 3);
+      EXPECT_EQ(reader.Column(force, 0)[i], std::sin(t));
+      EXPECT_EQ(reader.Column(force, 1)[i], -1.0E6 * t);
+      EXPECT_EQ(reader.Column(force, 2)[i], 0.0);
+    }
+
+    // Constant and slowly varying columns compress.
+    std::FILE *file = std::fopen(filename.c_str(), "rb");
+    ASSERT_NE(file, nullptr);
+    std::fseek(file, 0, SEEK_END);
+    long size = std::ftell(file);
+    std::fclose(file);
+    EXPECT_LT(size, static_cast<long>(n * 5 * sizeof(double) * 3 / 4));
+
+    // Reopening starts a new file.
+    ASSERT_TRUE(recorder.Open(filename));
+    double f[3] = {1.0, 2.0, 3.0};
+    EXPECT_TRUE(recorder.Record(force, 1.0, 1, f));
+    recorder.Close();
+    ASSERT_TRUE(reader.Open(filename));
+    EXPECT_EQ(reader.RowCount(force), 1u);
+    EXPECT_EQ(reader.Column(force, 2)[0], 3.0);
+}
+
+/////////////////////////////////////////////////
+TEST(Recorder, Threads)
+{
+    std::string filename = TempFile("recorder_threads.asvr");
+
+    asv::Recorder recorder(1 << 16);
+    uint32_t type = recorder.RegisterType("sample", {"index"});
+    ASSERT_TRUE(recorder.Open(filename));
+
+    const size_t numThreads = 4;
+    const size_t n = 10000;
+    std::vector<std::thread> threads;
+    for (size_t k = 0; k < numThreads; ++k)
+    {
+      threads.emplace_back([&recorder, type, k]()
+      {
+        for (size_t i = 0; i < n; ++i)
+        {
+          double value = static_cast<double>(i);
+          recorder.Record(type, 0.0, k, &value);
+        }
+      });
+    }
+    for (auto &thread : threads)
+      thread.join();
+    recorder.Close();
+    EXPECT_EQ(recorder.DroppedCount(), 0u);
+
+    // Each thread's samples are written in order.
+    asv::RecordReader reader;
+    ASSERT_TRUE(reader.Open(filename));
+    ASSERT_EQ(reader.RowCount(type), numThreads * n);
+    std::vector<double> next(numThreads, 0.0);
+    for (size_t i = 0; i < reader.RowCount(type); ++i)
+    {
+      uint64_t k = reader.Entity(type)[i];
+      ASSERT_LT(k, numThreads);
+      EXPECT_EQ(reader.Column(type, 0)[i], next[k]);
+      next[k] += 1.0;
+    }
+}
+
+/////////////////////////////////////////////////
+TEST(Recorder, Dropped)
+{
+    std::string filename = TempFile("recorder_dropped.asvr");
+
+    // Samples beyond a full ring are dropped, not blocked on.
+    asv::Recorder recorder(4);
+    uint32_t type = recorder.RegisterType("sample", {"x"});
+    ASSERT_TRUE(recorder.Open(filename));
+    double value = 1.0;
+    size_t recorded = 0;
+    for (size_t i = 0; i < 100000; ++i)
+      recorded += recorder.Record(type, 0.0, 0, &value) ? 1 : 0;
+    recorder.Close();
+    EXPECT_EQ(recorded + recorder.DroppedCount(), 100000u);
+    EXPECT_EQ(recorder.WrittenCount(), recorded);
+}
+
+/////////////////////////////////////////////////
+TEST(RecordReader, Invalid)
+{
+    asv::RecordReader reader;
+    EXPECT_FALSE(reader.Open(TempFile("recorder_missing.asvr")));
+
+    std::string filename = TempFile("recorder_invalid.asvr");
+    std::FILE *file = std::fopen(filename.c_str(), "wb");
+    ASSERT_NE(file, nullptr);
+    std::fputs("not a record file", file);
+    std::fclose(file);
+    EXPECT_FALSE(reader.Open(filename));
+    EXPECT_EQ(reader.TypeCount(), 0u);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,61 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "asv/sim/SailCommandBuffer.hh"
+
+#include <vector>
+
+namespace asv
+{
+/////////////////////////////////////////////////
+std::vector<SailCommand> &SailCommandBuffer::BeginWrite()
+{
+  // Take back the shared batch, leaving the writer's batch in its place.
+  unsigned int prev = this->shared.exchange(
+      this->writeIndex, std::memory_order_acq_rel);
+  this->writeIndex = prev & ~kDirty;
+
+  // Unread commands are kept so new commands are applied after them.
+  auto &commands = this->batch[this->writeIndex];
+  if (!(prev & kDirty))
+    commands.clear();
+  return commands;
+}
+
+/////////////////////////////////////////////////
+void SailCommandBuffer::Publish()
+{
+  // Only the writer sets the dirty flag, so the batch returned is free.
+  unsigned int prev = this->shared.exchange(
+      this->writeIndex | kDirty, std::memory_order_acq_rel);
+  this->writeIndex = prev & ~kDirty;
+}
+
+/////////////////////////////////////////////////
+const std::vector<SailCommand> *SailCommandBuffer::Read()
+{
+  if (!(this->shared.load(std::memory_order_relaxed) & kDirty))
+    return nullptr;
+
+  // The writer may have taken the batch back since the check.
+  unsigned int prev = this->shared.exchange(
+      this->readIndex, std::memory_order_acq_rel);
+  this->readIndex = prev & ~kDirty;
+  if (!(prev & kDirty))
+    return nullptr;
+  return &this->batch[this->readIndex];
+}
+
+}  // namespace asv
@@ -0,0 +1,88 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "asv/sim/SailCommandBuffer.hh"
+
+/////////////////////////////////////////////////
+TEST(SailCommandBuffer, Merge)
+{
+    asv::SailCommandBuffer buffer;
+    EXPECT_EQ(buffer.Read(), nullptr);
+
+    // Two batches published before a read are merged in order.
+    buffer.BeginWrite().push_back({"boat1", "main_sail_joint", 0.5});
+    buffer.Publish();
+    buffer.BeginWrite().push_back({"boat2", "main_sail_joint", 0.7});
+    buffer.Publish();
+
+    auto commands = buffer.Read();
+    ASSERT_NE(commands, nullptr);
+    ASSERT_EQ(commands->size(), 2u);
+    EXPECT_EQ((*commands)[0].model, "boat1");
+    EXPECT_EQ((*commands)[1].model, "boat2");
+    EXPECT_DOUBLE_EQ((*commands)[1].position, 0.7);
+    EXPECT_EQ(buffer.Read(), nullptr);
+
+    // Batches already read are not repeated.
+    buffer.BeginWrite().push_back({"boat3", "jib_sail_joint", 0.1});
+    buffer.Publish();
+    commands = buffer.Read();
+    ASSERT_NE(commands, nullptr);
+    ASSERT_EQ(commands->size(), 1u);
+    EXPECT_EQ((*commands)[0].model, "boat3");
+}
+
+/////////////////////////////////////////////////
+TEST(SailCommandBuffer, Threads)
+{
+    asv::SailCommandBuffer buffer;
+    const int n = 100000;
+
+    std::thread writer([&buffer]()
+    {
+      for (int i = 0; i < n; ++i)
+      {
+        buffer.BeginWrite().push_back({"boat", "joint", double(i)});
+        buffer.Publish();
+      }
+    });
+
+    // Every command is received once and in order.
+    int expected = 0;
+    while (expected < n)
+    {
+      auto commands = buffer.Read();
+      if (!commands)
+        continue;
+      for (auto &command : *commands)
+      {
+        ASSERT_DOUBLE_EQ(command.position, expected);
+        ++expected;
+      }
+    }
+    writer.join();
+    EXPECT_EQ(buffer.Read(), nullptr);
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,383 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "asv/sim/SailInteractionTable.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+#include <gz/common/Console.hh>
+#include <gz/math/Quaternion.hh>
+
+#include "asv/sim/VortexLattice.hh"
+
+namespace asv
+{
+namespace
+{
+/// \brief File identifier and format version.
+const char kMagic[4] = {'A', 'S', 'I', 'T'};
+const uint32_t kVersion = 1;
+
+/////////////////////////////////////////////////
+/// \brief Position of _x on a regular grid as a lower index and weight.
+void GridIndex(double _x, double _min, double _max, size_t _n,
+    size_t &_index, double &_weight)
+{
+  double s = (_x - _min) / (_max - _min) * (_n - 1);
+  s = std::clamp(s, 0.0, static_cast<double>(_n - 1));
+  _index = std::min(static_cast<size_t>(s), _n - 2);
+  _weight = s - _index;
+}
+
+/////////////////////////////////////////////////
+template <typename T>
+void WriteValue(std::ofstream &_out, const T &_value)
+{
+  _out.write(reinterpret_cast<const char *>(&_value), sizeof(T));
+}
+
+/////////////////////////////////////////////////
+/// \brief The number of table values for a grid, or false if it is more
+/// than _limit, without overflowing.
+bool ValueCount(uint64_t _sails, uint64_t _trims, uint64_t _awas,
+    uint64_t _limit, uint64_t &_count)
+{
+  _count = _sails < 2 ? 0 : _sails * (_sails - 1);
+  for (uint64_t n : {_trims, _trims, _awas})
+  {
+    if (_count > _limit || (_count != 0 && n > _limit / _count))
+      return false;
+    _count *= n;
+  }
+  return _count <= _limit;
+}
+
+/////////////////////////////////////////////////
+template <typename T>
+void ReadValue(std::ifstream &_in, T &_value)
+{
+  _in.read(reinterpret_cast<char *>(&_value), sizeof(T));
+}
+}  // namespace
+
+/////////////////////////////////////////////////
+void SailInteractionTable::Resize(size_t _numSails,
+    size_t _numTrim, double _trimMin, double _trimMax,
+    size_t _numAwa, double _awaMin, double _awaMax)
+{
+  this->numSails = _numSails;
+  this->numTrim = _numTrim;
+  this->trimMin = _trimMin;
+  this->trimMax = _trimMax;
+  this->numAwa = _numAwa;
+  this->awaMin = _awaMin;
+  this->awaMax = _awaMax;
+
+  size_t numPairs = _numSails < 2 ? 0 : _numSails * (_numSails - 1);
+  this->values.assign(numPairs * _numTrim * _numTrim * _numAwa, 0.0f);
+}
+
+/////////////////////////////////////////////////
+size_t SailInteractionTable::SailCount() const
+{
+  return this->numSails;
+}
+
+/////////////////////////////////////////////////
+size_t SailInteractionTable::TrimCount() const
+{
+  return this->numTrim;
+}
+
+/////////////////////////////////////////////////
+size_t SailInteractionTable::AwaCount() const
+{
+  return this->numAwa;
+}
+
+/////////////////////////////////////////////////
+double SailInteractionTable::Trim(size_t _index) const
+{
+  return this->trimMin + (this->trimMax - this->trimMin)
+      * _index / (this->numTrim - 1);
+}
+
+/////////////////////////////////////////////////
+double SailInteractionTable::Awa(size_t _index) const
+{
+  return this->awaMin + (this->awaMax - this->awaMin)
+      * _index / (this->numAwa - 1);
+}
+
+/////////////////////////////////////////////////
+size_t SailInteractionTable::PairOffset(size_t _i, size_t _j) const
+{
+  size_t pair = _i * (this->numSails - 1) + (_j < _i ? _j : _j - 1);
+  return pair * this->numTrim * this->numTrim * this->numAwa;
+}
+
+/////////////////////////////////////////////////
+float &SailInteractionTable::Value(size_t _i, size_t _j,
+    size_t _trimI, size_t _trimJ, size_t _awa)
+{
+  return this->values[this->PairOffset(_i, _j)
+      + (_trimI * this->numTrim + _trimJ) * this->numAwa + _awa];
+}
+
+/////////////////////////////////////////////////
+double SailInteractionTable::Lookup(size_t _i, size_t _j,
+    double _trimI, double _trimJ, double _awa) const
+{
+  size_t ti, tj, ka;
+  double wi, wj, wa;
+  GridIndex(_trimI, this->trimMin, this->trimMax, this->numTrim, ti, wi);
+  GridIndex(_trimJ, this->trimMin, this->trimMax, this->numTrim, tj, wj);
+  GridIndex(_awa, this->awaMin, this->awaMax, this->numAwa, ka, wa);
+
+  // Trilinear interpolation over the enclosing cell.
+  const float *v = this->values.data() + this->PairOffset(_i, _j);
+  const size_t strideI = this->numTrim * this->numAwa;
+  const size_t strideJ = this->numAwa;
+  double result = 0.0;
+  for (size_t di = 0; di < 2; ++di)
+  {
+    double ci = di ? wi : 1.0 - wi;
+    for (size_t dj = 0; dj < 2; ++dj)
+    {
+      double cj = dj ? wj : 1.0 - wj;
+      const float *row = v + (ti + di) * strideI + (tj + dj) * strideJ + ka;
+      result += ci * cj * ((1.0 - wa) * row[0] + wa * row[1]);
+    }
+  }
+  return result;
+}
+
+/////////////////////////////////////////////////
+void SailInteractionTable::Upwash(const std::vector<double> &_trim,
+    double _awa, std::vector<double> &_upwash) const
+{
+  _upwash.resize(this->numSails);
+  for (size_t i = 0; i < this->numSails; ++i)
+  {
+    double w = 0.0;
+    for (size_t j = 0; j < this->numSails; ++j)
+    {
+      if (j != i)
+        w += this->Lookup(i, j, _trim[i], _trim[j], _awa);
+    }
+    _upwash[i] = w;
+  }
+}
+
+/////////////////////////////////////////////////
+bool SailInteractionTable::Generate(
+    const std::vector<InteractionSail> &_sails)
+{
+  if (_sails.size() != this->numSails || this->numTrim < 2 ||
+      this->numAwa < 2)
+  {
+    gzerr << "SailInteractionTable: table must be sized for ["
+          << _sails.size() << "] sails with at least two grid points "
+          << "on each axis before generating\n";
+    return false;
+  }
+
+  // Heading of each sail at zero trim.
+  std::vector<double> trim0(_sails.size());
+  for (size_t s = 0; s < _sails.size(); ++s)
+  {
+    trim0[s] = TrimAngle(_sails[s].pose.Rot(), _sails[s].forward);
+  }
+
+  // Each pair is solved once and gives the upwash in both directions.
+  for (size_t i = 0; i < _sails.size(); ++i)
+  {
+    for (size_t j = i + 1; j < _sails.size(); ++j)
+    {
+      const InteractionSail *sail[2] = {&_sails[i], &_sails[j]};
+      const size_t index[2] = {i, j};
+
+      VortexLattice vlm;
+      vlm.SetRefactorThreshold(1.0E-9);
+      for (auto s : sail)
+        vlm.AddSurface(s->strips, s->forward, s->upward);
+
+      std::vector<gz::math::Vector3d> velU(vlm.PanelCount());
+      std::vector<gz::math::Vector3d> force(vlm.PanelCount());
+
+      for (size_t ti = 0; ti < this->numTrim; ++ti)
+      {
+        for (size_t tj = 0; tj < this->numTrim; ++tj)
+        {
+          const size_t t[2] = {ti, tj};
+          gz::math::Quaterniond rot[2];
+          for (size_t s = 0; s < 2; ++s)
+          {
+            double yaw = this->Trim(t[s]) - trim0[index[s]];
+            rot[s] = gz::math::Quaterniond(0, 0, yaw) * sail[s]->pose.Rot();
+            vlm.SetSurfacePose(s,
+                gz::math::Pose3d(sail[s]->pose.Pos(), rot[s]));
+          }
+
+          for (size_t ka = 0; ka < this->numAwa; ++ka)
+          {
+            double awa = this->Awa(ka);
+            gz::math::Vector3d u(-std::cos(awa), -std::sin(awa), 0.0);
+            std::fill(velU.begin(), velU.end(), u);
+            if (!vlm.Solve(velU, 1.0, force))
+              return false;
+
+            // Area weighted mean upwash on each sail from the other.
+            for (size_t s = 0; s < 2; ++s)
+            {
+              auto normal = rot[s].RotateVector(sail[s]->upward).Normalize();
+              size_t offset = vlm.PanelOffset(s);
+              double w = 0.0;
+              double area = 0.0;
+              for (size_t k = 0; k < sail[s]->strips.size(); ++k)
+              {
+                auto v = vlm.InducedVelocity(
+                    vlm.ControlPoint(offset + k), 1 - s);
+                w += sail[s]->strips[k].area * normal.Dot(v);
+                area += sail[s]->strips[k].area;
+              }
+              float value = area > 0.0 ? static_cast<float>(w / area) : 0.0f;
+              if (s == 0)
+                this->Value(i, j, ti, tj, ka) = value;
+              else
+                this->Value(j, i, tj, ti, ka) = value;
+            }
+          }
+        }
+      }
+    }
+  }
+  return true;
+}
+
+/////////////////////////////////////////////////
+bool SailInteractionTable::Save(const std::string &_filename) const
+{
+  std::ofstream out(_filename, std::ios::binary);
+  if (!out)
+  {
+    gzerr << "SailInteractionTable: failed to open [" << _filename
+          << "] for writing\n";
+    return false;
+  }
+
+  out.write(kMagic, sizeof(kMagic));
+  WriteValue(out, kVersion);
+  WriteValue(out, static_cast<uint32_t>(this->numSails));
+  WriteValue(out, static_cast<uint32_t>(this->numTrim));
+  WriteValue(out, static_cast<uint32_t>(this->numAwa));
+  WriteValue(out, this->trimMin);
+  WriteValue(out, this->trimMax);
+  WriteValue(out, this->awaMin);
+  WriteValue(out, this->awaMax);
+  out.write(reinterpret_cast<const char *>(this->values.data()),
+      this->values.size() * sizeof(float));
+
+  return static_cast<bool>(out);
+}
+
+/////////////////////////////////////////////////
+bool SailInteractionTable::Load(const std::string &_filename)
+{
+  std::ifstream in(_filename, std::ios::binary);
+  if (!in)
+  {
+    gzerr << "SailInteractionTable: failed to open [" << _filename << "]\n";
+    return false;
+  }
+
+  char magic[4];
+  uint32_t version = 0;
+  uint32_t sails = 0, trims = 0, awas = 0;
+  double tMin = 0.0, tMax = 0.0, aMin = 0.0, aMax = 0.0;
+  in.read(magic, sizeof(magic));
+  ReadValue(in, version);
+  ReadValue(in, sails);
+  ReadValue(in, trims);
+  ReadValue(in, awas);
+  ReadValue(in, tMin);
+  ReadValue(in, tMax);
+  ReadValue(in, aMin);
+  ReadValue(in, aMax);
+  if (!in || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0 ||
+      version != kVersion)
+  {
+    gzerr << "SailInteractionTable: [" << _filename
+          << "] is not a sail interaction table\n";
+    return false;
+  }
+  if (trims < 2 || awas < 2 || !(tMax > tMin) || !(aMax > aMin))
+  {
+    gzerr << "SailInteractionTable: [" << _filename
+          << "] has an invalid grid\n";
+    return false;
+  }
+
+  // Check the grid against the size of the file before allocating it.
+  auto start = in.tellg();
+  in.seekg(0, std::ios::end);
+  auto end = in.tellg();
+  in.seekg(start);
+  uint64_t bytes = start < end ? static_cast<uint64_t>(end - start) : 0;
+  uint64_t count = 0;
+  if (!in || !ValueCount(sails, trims, awas, bytes / sizeof(float), count) ||
+      count * sizeof(float) != bytes)
+  {
+    gzerr << "SailInteractionTable: [" << _filename << "] has " << bytes
+          << " bytes of values, which does not match its grid of "
+          << sails << " sails, " << trims << " trims and " << awas
+          << " AWAs\n";
+    return false;
+  }
+
+  this->Resize(sails, trims, tMin, tMax, awas, aMin, aMax);
+  in.read(reinterpret_cast<char *>(this->values.data()),
+      this->values.size() * sizeof(float));
+  if (!in)
+  {
+    gzerr << "SailInteractionTable: [" << _filename << "] is truncated\n";
+    return false;
+  }
+  return true;
+}
+
+/////////////////////////////////////////////////
+double SailInteractionTable::TrimAngle(const gz::math::Quaterniond &_rot,
+    const gz::math::Vector3d &_forward)
+{
+  auto f = _rot.RotateVector(_forward);
+  return std::atan2(f.Y(), f.X());
+}
+
+/////////////////////////////////////////////////
+double SailInteractionTable::ApparentWindAngle(
+    const gz::math::Vector3d &_velU)
+{
+  return std::atan2(-_velU.Y(), -_velU.X());
+}
+
+}  // namespace asv
@@ -0,0 +1,196 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "asv/sim/SailInteractionTable.hh"
+
+/////////////////////////////////////////////////
+/// \brief A rectangular sail with luff along z and chord along x,
+/// placed at _pos in the base frame.
+asv::InteractionSail rectangular_sail(const gz::math::Vector3d &_pos)
+{
+  asv::SailPlanform planform;
+  planform.luffFoot = gz::math::Vector3d(0.0, 0.0, 0.0);
+  planform.luffHead = gz::math::Vector3d(0.0, 0.0, 6.0);
+  planform.footChord = 2.0;
+  planform.headChord = 2.0;
+  planform.numStrips = 12;
+
+  asv::InteractionSail sail;
+  sail.forward = gz::math::Vector3d(1.0, 0.0, 0.0);
+  sail.upward = gz::math::Vector3d(0.0, 1.0, 0.0);
+  sail.pose = gz::math::Pose3d(_pos, gz::math::Quaterniond::Identity);
+  planform.Discretise(sail.forward, sail.strips);
+  return sail;
+}
+
+/////////////////////////////////////////////////
+TEST(SailInteractionTable, Interpolation)
+{
+    asv::SailInteractionTable table;
+    table.Resize(3, 5, -1.0, 1.0, 9, -M_PI, M_PI);
+    ASSERT_EQ(table.SailCount(), 3u);
+
+    // A function linear in each axis is reproduced exactly.
+    auto f = [](size_t _i, size_t _j, double _ti, double _tj, double _a)
+    {
+      return 0.1 * _i - 0.2 * _j + 0.3 * _ti - 0.4 * _tj + 0.05 * _a;
+    };
+    for (size_t i = 0; i < 3; ++i)
+      for (size_t j = 0; j < 3; ++j)
+        if (i != j)
+          for (size_t ti = 0; ti < 5; ++ti)
+            for (size_t tj = 0; tj < 5; ++tj)
+              for (size_t ka = 0; ka < 9; ++ka)
+                table.Value(i, j, ti, tj, ka) = static_cast<float>(
+                    f(i, j, table.Trim(ti), table.Trim(tj), table.Awa(ka)));
+
+    EXPECT_NEAR(table.Lookup(0, 2, 0.13, -0.71, 0.4),
+        f(0, 2, 0.13, -0.71, 0.4), 1.0E-6);
+    EXPECT_NEAR(table.Lookup(2, 1, -0.5, 0.25, -2.9),
+        f(2, 1, -0.5, 0.25, -2.9), 1.0E-6);
+
+    // Values outside the grid are clamped.
+    EXPECT_NEAR(table.Lookup(1, 0, 2.0, 0.0, 0.0),
+        f(1, 0, 1.0, 0.0, 0.0), 1.0E-6);
+
+    // The upwash on each sail is the sum over the other sails.
+    std::vector<double> trim = {0.1, -0.2, 0.3};
+    std::vector<double> upwash;
+    table.Upwash(trim, 0.5, upwash);
+    ASSERT_EQ(upwash.size(), 3u);
+    EXPECT_NEAR(upwash[1],
+        f(1, 0, -0.2, 0.1, 0.5) + f(1, 2, -0.2, 0.3, 0.5), 1.0E-6);
+}
+
+/////////////////////////////////////////////////
+TEST(SailInteractionTable, SaveLoad)
+{
+    asv::SailInteractionTable table;
+    table.Resize(2, 3, -0.5, 0.5, 4, -1.0, 1.0);
+    table.Value(0, 1, 1, 2, 3) = 0.25f;
+    table.Value(1, 0, 2, 0, 1) = -0.125f;
+
+    std::string filename = "SailInteractionTable_TEST.bin";
+    ASSERT_TRUE(table.Save(filename));
+
+    asv::SailInteractionTable loaded;
+    ASSERT_TRUE(loaded.Load(filename));
+    std::remove(filename.c_str());
+
+    EXPECT_EQ(loaded.SailCount(), 2u);
+    EXPECT_EQ(loaded.TrimCount(), 3u);
+    EXPECT_EQ(loaded.AwaCount(), 4u);
+    EXPECT_DOUBLE_EQ(loaded.Trim(0), -0.5);
+    EXPECT_DOUBLE_EQ(loaded.Awa(3), 1.0);
+    EXPECT_FLOAT_EQ(loaded.Value(0, 1, 1, 2, 3), 0.25f);
+    EXPECT_FLOAT_EQ(loaded.Value(1, 0, 2, 0, 1), -0.125f);
+
+    EXPECT_FALSE(loaded.Load("does_not_exist.bin"));
+}
+
+/////////////////////////////////////////////////
+TEST(SailInteractionTable, LoadCorrupt)
+{
+    asv::SailInteractionTable table;
+    table.Resize(2, 3, -0.5, 0.5, 4, -1.0, 1.0);
+    std::string filename = "SailInteractionTable_TEST_corrupt.bin";
+    ASSERT_TRUE(table.Save(filename));
+    std::vector<char> data;
+    {
+      std::ifstream in(filename, std::ios::binary);
+      data.assign(std::istreambuf_iterator<char>(in),
+          std::istreambuf_iterator<char>());
+    }
+    auto write = [&filename](const std::vector<char> &_data)
+    {
+      std::ofstream out(filename, std::ios::binary);
+      out.write(_data.data(), _data.size());
+    };
+
+    // A truncated file.
+    std::vector<char> truncated(data.begin(), data.end() - 4);
+    write(truncated);
+    asv::SailInteractionTable loaded;
+    EXPECT_FALSE(loaded.Load(filename));
+
+    // Trailing data.
+    std::vector<char> trailing = data;
+    trailing.resize(data.size() + 4);
+    write(trailing);
+    EXPECT_FALSE(loaded.Load(filename));
+
+    // A sail count far beyond the data is rejected without allocating.
+    std::vector<char> corrupt = data;
+    const uint32_t sails = 0xffffffffu;
+    std::memcpy(corrupt.data() + 8, &sails, sizeof(sails));
+    write(corrupt);
+    EXPECT_FALSE(loaded.Load(filename));
+    EXPECT_EQ(loaded.SailCount(), 0u);
+
+    write(data);
+    EXPECT_TRUE(loaded.Load(filename));
+    EXPECT_EQ(loaded.SailCount(), 2u);
+    std::remove(filename.c_str());
+}
+
+/////////////////////////////////////////////////
+TEST(SailInteractionTable, Generate)
+{
+    // The interaction decays as the sails move apart.
+    std::vector<double> upwash;
+    for (double gap : {3.0, 12.0})
+    {
+        std::vector<asv::InteractionSail> sails = {
+            rectangular_sail(gz::math::Vector3d(0.0, 0.0, 0.0)),
+            rectangular_sail(gz::math::Vector3d(0.0, gap, 0.0))};
+
+        asv::SailInteractionTable table;
+        table.Resize(2, 3, -0.2, 0.2, 3, -0.1, 0.1);
+        ASSERT_TRUE(table.Generate(sails));
+
+        double w = table.Lookup(0, 1, 0.0, 0.0, 0.1);
+        EXPECT_TRUE(std::isfinite(w));
+        upwash.push_back(w);
+
+        // Side by side with the same trim the sails see the same
+        // interaction, mirrored by the wind angle.
+        EXPECT_NEAR(table.Lookup(0, 1, 0.0, 0.0, 0.1),
+            -table.Lookup(1, 0, 0.0, 0.0, -0.1), 1.0E-5);
+    }
+    EXPECT_GT(std::fabs(upwash[0]), 1.0E-3);
+    EXPECT_LT(std::fabs(upwash[1]), 0.5 * std::fabs(upwash[0]));
+
+    // The table size must match the sails.
+    asv::SailInteractionTable table;
+    table.Resize(3, 3, -0.2, 0.2, 3, -0.1, 0.1);
+    EXPECT_FALSE(table.Generate({rectangular_sail(gz::math::Vector3d::Zero)}));
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,100 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "asv/sim/SailPlanform.hh"
+
+#include <vector>
+
+#include <gz/math/Vector3.hh>
+
+#include "asv/sim/Utilities.hh"
+
+namespace asv
+{
+/////////////////////////////////////////////////
+bool SailPlanform::Load(
+    const std::shared_ptr<const sdf::Element> &_sdf,
+    SailPlanform &_planform)
+{
+  if (!_sdf->HasElement("luff_foot") || !_sdf->HasElement("luff_head"))
+  {
+    gzerr << "<strips> requires a <luff_foot> and <luff_head>\n";
+    return false;
+  }
+
+  asv::LoadParam(_sdf, "num_strips", _planform.numStrips,
+      _planform.numStrips);
+  asv::LoadParam(_sdf, "luff_foot", _planform.luffFoot, _planform.luffFoot);
+  asv::LoadParam(_sdf, "luff_head", _planform.luffHead, _planform.luffHead);
+  asv::LoadParam(_sdf, "foot_chord", _planform.footChord,
+      _planform.footChord);
+  asv::LoadParam(_sdf, "head_chord", _planform.headChord,
+      _planform.headChord);
+  asv::LoadParam(_sdf, "head_twist", _planform.headTwist,
+      _planform.headTwist);
+
+  if (_planform.numStrips < 1)
+  {
+    gzerr << "<num_strips> must be at least 1\n";
+    return false;
+  }
+  if (_planform.footChord < 0.0 || _planform.headChord < 0.0)
+  {
+    gzerr << "<foot_chord> and <head_chord> must be non-negative\n";
+    return false;
+  }
+  if (_planform.luffFoot == _planform.luffHead)
+  {
+    gzerr << "<luff_foot> and <luff_head> must not coincide\n";
+    return false;
+  }
+
+  return true;
+}
+
+/////////////////////////////////////////////////
+void SailPlanform::Discretise(
+    const gz::math::Vector3d &_forward,
+    std::vector<SailStrip> &_strips) const
+{
+  auto forward = _forward;
+  forward.Normalize();
+
+  const int n = this->numStrips;
+  const auto luff = this->luffHead - this->luffFoot;
+  const double span = luff.Length() / n;
+
+  _strips.resize(n);
+  for (int i = 0; i < n; ++i)
+  {
+    // Fractional span at the strip boundaries and mid-point.
+    double s0 = static_cast<double>(i) / n;
+    double s1 = static_cast<double>(i + 1) / n;
+    double sm = 0.5 * (s0 + s1);
+
+    auto &strip = _strips[i];
+    strip.leLower = this->luffFoot + s0 * luff;
+    strip.leUpper = this->luffFoot + s1 * luff;
+    strip.chord = this->footChord + sm * (this->headChord - this->footChord);
+    strip.span = span;
+    strip.area = strip.chord * strip.span;
+    strip.twist = sm * this->headTwist;
+
+    // The centre of pressure is at the quarter chord, aft of the luff.
+    strip.cp = this->luffFoot + sm * luff - 0.25 * strip.chord * forward;
+  }
+}
+
+}  // namespace asv
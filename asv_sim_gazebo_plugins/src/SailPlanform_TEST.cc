@@ -0,0 +1,112 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "asv/sim/SailPlanform.hh"
+
+/////////////////////////////////////////////////
+std::string get_sdf_string()
+{
+  std::ostringstream stream;
+  stream
+    << "<sdf version='1.6'>"
+    << "<model name='main_sail'>"
+    << "    <plugin name='main_sail_liftdrag' filename='libSailPlugin.so'>"
+    << "        <strips>"
+    << "            <num_strips>4</num_strips>"
+    << "            <luff_foot>0.0 0.0 0.5</luff_foot>"
+    << "            <luff_head>0.0 0.0 2.5</luff_head>"
+    << "            <foot_chord>0.8</foot_chord>"
+    << "            <head_chord>0.2</head_chord>"
+    << "            <head_twist>0.2</head_twist>"
+    << "        </strips>"
+    << "    </plugin>"
+    << "</model>"
+    << "</sdf>";
+
+  return stream.str();
+}
+
+/////////////////////////////////////////////////
+TEST(SailPlanform, Discretise)
+{
+    // create SDF data
+    sdf::SDFPtr model(new sdf::SDF());
+    sdf::init(model);
+    ASSERT_TRUE(sdf::readString(get_sdf_string(), model));
+
+    sdf::ElementPtr strips = model->Root()->GetElement("model")
+        ->GetElement("plugin")->GetElement("strips");
+
+    asv::SailPlanform planform;
+    ASSERT_TRUE(asv::SailPlanform::Load(strips, planform));
+    EXPECT_EQ(planform.numStrips, 4);
+
+    std::vector<asv::SailStrip> result;
+    planform.Discretise(gz::math::Vector3d(1.0, 0.0, 0.0), result);
+    ASSERT_EQ(result.size(), 4u);
+
+    // Total area is that of the trapezoid.
+    double area = 0.0;
+    for (auto &strip : result)
+    {
+      area += strip.area;
+      EXPECT_DOUBLE_EQ(strip.span, 0.5);
+      EXPECT_DOUBLE_EQ(strip.area, strip.chord * strip.span);
+    }
+    EXPECT_DOUBLE_EQ(area, 0.5 * (0.8 + 0.2) * 2.0);
+
+    // Foot strip.
+    EXPECT_DOUBLE_EQ(result[0].chord, 0.725);
+    EXPECT_DOUBLE_EQ(result[0].twist, 0.025);
+    EXPECT_DOUBLE_EQ(result[0].leLower.Z(), 0.5);
+    EXPECT_DOUBLE_EQ(result[0].leUpper.Z(), 1.0);
+    EXPECT_DOUBLE_EQ(result[0].cp.X(), -0.25 * 0.725);
+    EXPECT_DOUBLE_EQ(result[0].cp.Z(), 0.75);
+
+    // Head strip.
+    EXPECT_DOUBLE_EQ(result[3].chord, 0.275);
+    EXPECT_DOUBLE_EQ(result[3].twist, 0.175);
+    EXPECT_DOUBLE_EQ(result[3].leUpper.Z(), 2.5);
+}
+
+/////////////////////////////////////////////////
+TEST(SailPlanform, Invalid)
+{
+    sdf::SDFPtr model(new sdf::SDF());
+    sdf::init(model);
+    ASSERT_TRUE(sdf::readString(
+        "<sdf version='1.6'><model name='m'><plugin name='p' filename='f'>"
+        "<strips><num_strips>0</num_strips>"
+        "<luff_foot>0 0 0</luff_foot><luff_head>0 0 1</luff_head>"
+        "</strips></plugin></model></sdf>", model));
+
+    sdf::ElementPtr strips = model->Root()->GetElement("model")
+        ->GetElement("plugin")->GetElement("strips");
+
+    asv::SailPlanform planform;
+    EXPECT_FALSE(asv::SailPlanform::Load(strips, planform));
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
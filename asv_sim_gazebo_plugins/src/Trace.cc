@@ -0,0 +1,562 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#include "asv/sim/Trace.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+
+#include <gz/common/Console.hh>
+#include <gz/msgs/stringmsg.pb.h>
+
+#include "asv/sim/TransportRegistry.hh"
+
+namespace asv
+{
+namespace
+{
+/// \brief Name of the service of the process-wide tracer.
+const char kService[] = "/asv_sim/trace";
+
+/////////////////////////////////////////////////
+/// \brief Wall clock time in nanoseconds.
+int64_t Now()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/////////////////////////////////////////////////
+/// \brief The period in nanoseconds of a rate in Hz.
+int64_t Period(double _rate)
+{
+  if (!(_rate > 0.0))
+    return 0;
+  return static_cast<int64_t>(1.0e9 / _rate);
+}
+
+/////////////////////////////////////////////////
+/// \brief A copy of a channel's description used by the formatting
+/// thread, which may outlive the channel.
+struct Schema
+{
+  std::string system;
+  uint64_t entity;
+  std::vector<std::pair<std::string, size_t>> fields;
+};
+
+/////////////////////////////////////////////////
+/// \brief A queued record.
+struct Record
+{
+  std::shared_ptr<const Schema> schema;
+  double time;
+  size_t count;
+  double values[Tracer::kMaxValues];
+};
+
+/////////////////////////////////////////////////
+/// \brief An enable or disable rule.
+struct Rule
+{
+  std::string system;
+  uint64_t entity;
+  double rate;
+  bool enable;
+};
+
+/////////////////////////////////////////////////
+/// \brief True if a rule pattern covers a system and entity.
+bool Covers(const std::string &_system, uint64_t _entity,
+    const std::string &_s, uint64_t _e)
+{
+  return (_system == "*" || _system == _s) &&
+      (_entity == Tracer::kAnyEntity || _entity == _e);
+}
+
+/////////////////////////////////////////////////
+/// \brief Format a record as one line.
+std::string Format(const Record &_record)
+{
+  const Schema &schema = *_record.schema;
+  std::ostringstream out;
+  out << "[" << schema.system;
+  if (schema.entity != Tracer::kAnyEntity)
+    out << " " << schema.entity;
+  out << "]";
+  if (!std::isnan(_record.time))
+    out << " t=" << _record.time;
+
+  size_t i = 0;
+  for (const auto &field : schema.fields)
+  {
+    if (i + field.second > _record.count)
+      break;
+    out << " " << field.first << "=";
+    if (field.second == 1)
+    {
+      out << _record.values[i];
+    }
+    else
+    {
+      out << "(";
+      for (size_t j = 0; j < field.second; ++j)
+        out << (j ? ", " : "") << _record.values[i + j];
+      out << ")";
+    }
+    i += field.second;
+  }
+  return out.str();
+}
+}  // namespace
+
+/////////////////////////////////////////////////
+class TracerPrivate
+{
+  /// \brief The formatting thread.
+  public: void Run();
+
+  /// \brief Protects everything below.
+  public: std::mutex mutex;
+
+  /// \brief Signals queued records and shutdown.
+  public: std::condition_variable pending;
+
+  /// \brief Signals that the queue has been drained.
+  public: std::condition_variable drained;
+
+  /// \brief The registered channels and their schemas.
+  public: std::unordered_map<TraceChannel *, std::shared_ptr<const Schema>>
+      channels;
+
+  /// \brief The rules in order, the last matching rule applies.
+  public: std::vector<Rule> rules;
+
+  /// \brief Ring of queued records.
+  public: std::vector<Record> ring;
+
+  /// \brief Index of the oldest queued record.
+  public: size_t head{0};
+
+  /// \brief Number of queued records.
+  public: size_t size{0};
+
+  /// \brief True while the formatting thread works on a batch.
+  public: bool busy{false};
+
+  /// \brief Set to stop the formatting thread.
+  public: bool stop{false};
+
+  /// \brief The formatting thread, started on the first record.
+  public: std::thread thread;
+
+  /// \brief Destination of formatted lines.
+  public: std::function<void(const std::string &)> sink;
+
+  /// \brief Number of records dropped.
+  public: std::atomic<uint64_t> dropped{0};
+
+  /// \brief The service, for the process-wide tracer.
+  public: TransportRegistry::Subscription service;
+};
+
+/////////////////////////////////////////////////
+void TracerPrivate::Run()
+{
+  std::vector<Record> batch;
+  std::unique_lock<std::mutex> lock(this->mutex);
+  while (true)
+  {
+    this->pending.wait(lock, [this]{ return this->stop || this->size > 0; });
+    if (this->size == 0)
+      break;
+
+    batch.clear();
+    for (; this->size > 0; --this->size)
+    {
+      batch.push_back(std::move(this->ring[this->head]));
+      this->head = (this->head + 1) % this->ring.size();
+    }
+    auto sink = this->sink;
+    this->busy = true;
+    lock.unlock();
+
+    for (const auto &record : batch)
+    {
+      std::string line = Format(record);
+      if (sink)
+        sink(line);
+      else
+        gzmsg << line << "\n";
+    }
+    batch.clear();
+
+    lock.lock();
+    this->busy = false;
+    if (this->size == 0)
+      this->drained.notify_all();
+  }
+  this->drained.notify_all();
+}
+
+/////////////////////////////////////////////////
+Tracer &Tracer::Instance()
+{
+  static std::unique_ptr<Tracer> tracer = []()
+  {
+    auto t = std::make_unique<Tracer>();
+    Tracer *ptr = t.get();
+    t->data->service =
+        TransportRegistry::AdvertiseService<gz::msgs::StringMsg,
+            gz::msgs::StringMsg>(kService,
+        [ptr](const gz::msgs::StringMsg &_req, gz::msgs::StringMsg &_rep)
+        {
+          std::string reply;
+          bool result = ptr->Command(_req.data(), reply);
+          _rep.set_data(reply);
+          return result;
+        });
+    return t;
+  }();
+  return *tracer;
+}
+
+/////////////////////////////////////////////////
+Tracer::Tracer(size_t _capacity)
+  : data(std::make_unique<TracerPrivate>())
+{
+  this->data->ring.resize(std::max<size_t>(_capacity, 1));
+}
+
+/////////////////////////////////////////////////
+Tracer::~Tracer()
+{
+  this->data->service.reset();
+  {
+    std::lock_guard<std::mutex> lock(this->data->mutex);
+    this->data->stop = true;
+  }
+  this->data->pending.notify_all();
+  if (this->data->thread.joinable())
+    this->data->thread.join();
+}
+
+/////////////////////////////////////////////////
+void Tracer::Enable(const std::string &_system, uint64_t _entity,
+    double _rate)
+{
+  std::lock_guard<std::mutex> lock(this->data->mutex);
+  auto &rules = this->data->rules;
+  rules.erase(std::remove_if(rules.begin(), rules.end(),
+      [&](const Rule &_r)
+      {
+        return Covers(_system, _entity, _r.system, _r.entity);
+      }), rules.end());
+  rules.push_back({_system, _entity, _rate, true});
+  for (auto &channel : this->data->channels)
+    this->Apply(channel.first);
+}
+
+/////////////////////////////////////////////////
+void Tracer::Disable(const std::string &_system, uint64_t _entity)
+{
+  std::lock_guard<std::mutex> lock(this->data->mutex);
+  auto &rules = this->data->rules;
+  rules.erase(std::remove_if(rules.begin(), rules.end(),
+      [&](const Rule &_r)
+      {
+        return Covers(_system, _entity, _r.system, _r.entity);
+      }), rules.end());
+  // A broader rule may remain, for example disabling one entity after
+  // enabling every entity of a system.
+  if (!rules.empty())
+    rules.push_back({_system, _entity, -1.0, false});
+  for (auto &channel : this->data->channels)
+    this->Apply(channel.first);
+}
+
+/////////////////////////////////////////////////
+bool Tracer::Command(const std::string &_command, std::string &_reply)
+{
+  std::istringstream in(_command);
+  std::string verb;
+  in >> verb;
+
+  if (verb == "list")
+  {
+    std::lock_guard<std::mutex> lock(this->data->mutex);
+    std::ostringstream out;
+    std::vector<const TraceChannel *> channels;
+    for (const auto &channel : this->data->channels)
+      channels.push_back(channel.first);
+    std::sort(channels.begin(), channels.end(),
+        [](const TraceChannel *_a, const TraceChannel *_b)
+        {
+          return std::tie(_a->system, _a->entity) <
+              std::tie(_b->system, _b->entity);
+        });
+    for (const auto *channel : channels)
+    {
+      out << channel->system;
+      if (channel->entity != kAnyEntity)
+        out << " " << channel->entity;
+      if (channel->Enabled())
+      {
+        int64_t period = channel->period.load(std::memory_order_relaxed);
+        out << " enabled";
+        if (period > 0)
+          out << " " << 1.0e9 / static_cast<double>(period) << " Hz";
+      }
+      out << "\n";
+    }
+    _reply = out.str();
+    return true;
+  }
+
+  if (verb != "enable" && verb != "disable")
+  {
+    _reply = "unknown command [" + verb + "], expected enable, "
+        "disable or list";
+    return false;
+  }
+
+  std::string system;
+  std::string entityStr;
+  uint64_t entity = kAnyEntity;
+  double rate = -1.0;
+  if (!(in >> system))
+  {
+    _reply = "missing system name";
+    return false;
+  }
+  if (in >> entityStr && entityStr != "*")
+  {
+    try
+    {
+      size_t pos = 0;
+      entity = std::stoull(entityStr, &pos);
+      if (pos != entityStr.size())
+        throw std::invalid_argument(entityStr);
+    }
+    catch (const std::exception &)
+    {
+      _reply = "invalid entity [" + entityStr + "]";
+      return false;
+    }
+  }
+  std::string rateStr;
+  if (verb == "enable" && in >> rateStr)
+  {
+    char *end = nullptr;
+    rate = std::strtod(rateStr.c_str(), &end);
+    if (*end != '\0' || rate < 0.0)
+    {
+      _reply = "invalid rate [" + rateStr + "]";
+      return false;
+    }
+  }
+
+  if (verb == "enable")
+    this->Enable(system, entity, rate);
+  else
+    this->Disable(system, entity);
+  _reply = verb + "d " + system;
+  if (entity != kAnyEntity)
+    _reply += " " + std::to_string(entity);
+  return true;
+}
+
+/////////////////////////////////////////////////
+void Tracer::SetSink(const std::function<void(const std::string &)> &_sink)
+{
+  std::lock_guard<std::mutex> lock(this->data->mutex);
+  this->data->sink = _sink;
+}
+
+/////////////////////////////////////////////////
+void Tracer::Flush()
+{
+  std::unique_lock<std::mutex> lock(this->data->mutex);
+  if (!this->data->thread.joinable())
+    return;
+  this->data->drained.wait(lock, [this]
+      {
+        return this->data->stop ||
+            (this->data->size == 0 && !this->data->busy);
+      });
+}
+
+/////////////////////////////////////////////////
+uint64_t Tracer::DroppedCount() const
+{
+  return this->data->dropped.load(std::memory_order_relaxed);
+}
+
+/////////////////////////////////////////////////
+void Tracer::Register(TraceChannel *_channel)
+{
+  auto schema = std::make_shared<Schema>();
+  schema->system = _channel->system;
+  schema->entity = _channel->entity;
+  for (const auto &field : _channel->fields)
+  {
+    size_t colon = field.rfind(':');
+    size_t width = 1;
+    if (colon != std::string::npos)
+    {
+      width = std::max<size_t>(
+          std::strtoul(field.c_str() + colon + 1, nullptr, 10), 1);
+    }
+    schema->fields.emplace_back(field.substr(0, colon), width);
+  }
+
+  std::lock_guard<std::mutex> lock(this->data->mutex);
+  this->data->channels[_channel] = schema;
+  this->Apply(_channel);
+}
+
+/////////////////////////////////////////////////
+void Tracer::Unregister(TraceChannel *_channel)
+{
+  std::lock_guard<std::mutex> lock(this->data->mutex);
+  this->data->channels.erase(_channel);
+}
+
+/////////////////////////////////////////////////
+void Tracer::Apply(TraceChannel *_channel)
+{
+  const Rule *match = nullptr;
+  for (const auto &rule : this->data->rules)
+  {
+    if (Covers(rule.system, rule.entity, _channel->system, _channel->entity))
+      match = &rule;
+  }
+
+  bool enable = match && match->enable;
+  int64_t period = 0;
+  if (enable)
+  {
+    period = match->rate < 0.0 ? _channel->defaultPeriod :
+        Period(match->rate);
+  }
+  _channel->period.store(period, std::memory_order_relaxed);
+  _channel->enabled.store(enable, std::memory_order_relaxed);
+}
+
+/////////////////////////////////////////////////
+void Tracer::Push(const TraceChannel *_channel, double _time,
+    const double *_values, size_t _count)
+{
+  std::lock_guard<std::mutex> lock(this->data->mutex);
+  auto it = this->data->channels.find(const_cast<TraceChannel *>(_channel));
+  if (it == this->data->channels.end())
+    return;
+
+  auto &ring = this->data->ring;
+  if (this->data->size == ring.size())
+  {
+    this->data->dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  Record &record = ring[(this->data->head + this->data->size) % ring.size()];
+  record.schema = it->second;
+  record.time = _time;
+  record.count = std::min(_count, kMaxValues);
+  std::copy(_values, _values + record.count, record.values);
+  ++this->data->size;
+
+  if (!this->data->thread.joinable())
+    this->data->thread = std::thread(&TracerPrivate::Run, this->data.get());
+  this->data->pending.notify_one();
+}
+
+/////////////////////////////////////////////////
+TraceChannel::TraceChannel(const std::string &_system,
+    const std::vector<std::string> &_fields, uint64_t _entity,
+    Tracer &_tracer)
+  : tracer(_tracer), system(_system), fields(_fields), entity(_entity)
+{
+  this->tracer.Register(this);
+}
+
+/////////////////////////////////////////////////
+TraceChannel::~TraceChannel()
+{
+  this->tracer.Unregister(this);
+}
+
+/////////////////////////////////////////////////
+void TraceChannel::SetEntity(uint64_t _entity)
+{
+  this->tracer.Unregister(this);
+  this->entity = _entity;
+  this->tracer.Register(this);
+}
+
+/////////////////////////////////////////////////
+void TraceChannel::SetDefaultRate(double _rate)
+{
+  this->tracer.Unregister(this);
+  this->defaultPeriod = Period(_rate);
+  this->tracer.Register(this);
+}
+
+/////////////////////////////////////////////////
+void TraceChannel::Write(double _time, std::initializer_list<double> _values)
+{
+  if (!this->Enabled())
+    return;
+
+  int64_t period = this->period.load(std::memory_order_relaxed);
+  if (period > 0)
+  {
+    int64_t now = Now();
+    if (this->lastWrite != INT64_MIN && now - this->lastWrite < period)
+      return;
+    this->lastWrite = now;
+  }
+  this->tracer.Push(this, _time, _values.begin(), _values.size());
+}
+
+/////////////////////////////////////////////////
+const std::string &TraceChannel::System() const
+{
+  return this->system;
+}
+
+/////////////////////////////////////////////////
+uint64_t TraceChannel::Entity() const
+{
+  return this->entity;
+}
+
+/////////////////////////////////////////////////
+const std::vector<std::string> &TraceChannel::Fields() const
+{
+  return this->fields;
+}
+}  // namespace asv
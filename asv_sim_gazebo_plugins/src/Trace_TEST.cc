@@ -0,0 +1,191 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "asv/sim/Trace.hh"
+
+namespace
+{
+/////////////////////////////////////////////////
+/// \brief Collects formatted lines.
+struct Lines
+{
+  void Attach(asv::Tracer &_tracer)
+  {
+    _tracer.SetSink([this](const std::string &_line)
+        {
+          std::lock_guard<std::mutex> lock(this->mutex);
+          this->lines.push_back(_line);
+        });
+  }
+
+  std::mutex mutex;
+  std::vector<std::string> lines;
+};
+}  // namespace
+
+/////////////////////////////////////////////////
+TEST(Trace, Disabled)
+{
+    asv::Tracer tracer;
+    Lines lines;
+    lines.Attach(tracer);
+
+    asv::TraceChannel channel("A", {"x"}, 1, tracer);
+    EXPECT_FALSE(channel.Enabled());
+    channel.Write(0.0, {1.0});
+    tracer.Flush();
+    EXPECT_TRUE(lines.lines.empty());
+}
+
+/////////////////////////////////////////////////
+TEST(Trace, Format)
+{
+    asv::Tracer tracer;
+    Lines lines;
+    lines.Attach(tracer);
+
+    asv::TraceChannel channel("A", {"x", "v:3"}, 7, tracer);
+    tracer.Enable("A");
+    EXPECT_TRUE(channel.Enabled());
+    channel.Write(1.5, {2.0, 1.0, 2.0, 3.0});
+    channel.Write(std::nan(""), {4.0});
+    tracer.Flush();
+
+    ASSERT_EQ(lines.lines.size(), 2u);
+    EXPECT_EQ(lines.lines[0], "[A 7] t=1.5 x=2 v=(1, 2, 3)");
+    EXPECT_EQ(lines.lines[1], "[A 7] x=4");
+}
+
+/////////////////////////////////////////////////
+TEST(Trace, Rules)
+{
+    asv::Tracer tracer;
+    asv::TraceChannel a1("A", {"x"}, 1, tracer);
+    asv::TraceChannel a2("A", {"x"}, 2, tracer);
+    asv::TraceChannel b1("B", {"x"}, 1, tracer);
+
+    tracer.Enable("A", 2);
+    EXPECT_FALSE(a1.Enabled());
+    EXPECT_TRUE(a2.Enabled());
+    EXPECT_FALSE(b1.Enabled());
+
+    tracer.Enable("*");
+    EXPECT_TRUE(a1.Enabled());
+    EXPECT_TRUE(b1.Enabled());
+
+    tracer.Disable("A", 1);
+    EXPECT_FALSE(a1.Enabled());
+    EXPECT_TRUE(a2.Enabled());
+    EXPECT_TRUE(b1.Enabled());
+
+    // Channels created later follow the rules.
+    asv::TraceChannel b2("B", {"x"}, 2, tracer);
+    EXPECT_TRUE(b2.Enabled());
+
+    tracer.Disable("*");
+    EXPECT_FALSE(a2.Enabled());
+    EXPECT_FALSE(b1.Enabled());
+    EXPECT_FALSE(b2.Enabled());
+}
+
+/////////////////////////////////////////////////
+TEST(Trace, Command)
+{
+    asv::Tracer tracer;
+    asv::TraceChannel a1("A", {"x"}, 1, tracer);
+    asv::TraceChannel a2("A", {"x"}, 2, tracer);
+
+    std::string reply;
+    EXPECT_TRUE(tracer.Command("enable A 2 10", reply));
+    EXPECT_FALSE(a1.Enabled());
+    EXPECT_TRUE(a2.Enabled());
+
+    EXPECT_TRUE(tracer.Command("list", reply));
+    EXPECT_EQ(reply, "A 1\nA 2 enabled 10 Hz\n");
+
+    EXPECT_TRUE(tracer.Command("enable A *", reply));
+    EXPECT_TRUE(a1.Enabled());
+    EXPECT_TRUE(tracer.Command("disable A", reply));
+    EXPECT_FALSE(a1.Enabled());
+    EXPECT_FALSE(a2.Enabled());
+
+    EXPECT_FALSE(tracer.Command("start A", reply));
+    EXPECT_FALSE(tracer.Command("enable", reply));
+    EXPECT_FALSE(tracer.Command("enable A x", reply));
+    EXPECT_FALSE(tracer.Command("enable A 1 fast", reply));
+}
+
+/////////////////////////////////////////////////
+TEST(Trace, Rate)
+{
+    asv::Tracer tracer;
+    Lines lines;
+    lines.Attach(tracer);
+
+    // The default rate limits a burst to one record.
+    asv::TraceChannel channel("A", {"x"}, 1, tracer);
+    channel.SetDefaultRate(1.0);
+    tracer.Enable("A");
+    for (int i = 0; i < 100; ++i)
+      channel.Write(i, {1.0});
+    tracer.Flush();
+    EXPECT_EQ(lines.lines.size(), 1u);
+
+    // A rate of zero records every call.
+    tracer.Enable("A", asv::Tracer::kAnyEntity, 0.0);
+    for (int i = 0; i < 100; ++i)
+      channel.Write(i, {1.0});
+    tracer.Flush();
+    EXPECT_EQ(lines.lines.size(), 101u);
+}
+
+/////////////////////////////////////////////////
+TEST(Trace, Dropped)
+{
+    asv::Tracer tracer(4);
+    std::mutex block;
+    std::vector<std::string> lines;
+    tracer.SetSink([&](const std::string &_line)
+        {
+          std::lock_guard<std::mutex> lock(block);
+          lines.push_back(_line);
+        });
+
+    asv::TraceChannel channel("A", {"x"}, 1, tracer);
+    tracer.Enable("A", asv::Tracer::kAnyEntity, 0.0);
+    {
+      // Hold up the formatting thread so the ring fills.
+      std::lock_guard<std::mutex> lock(block);
+      for (int i = 0; i < 100; ++i)
+        channel.Write(i, {1.0});
+    }
+    tracer.Flush();
+    EXPECT_GT(tracer.DroppedCount(), 0u);
+    EXPECT_EQ(lines.size() + tracer.DroppedCount(), 100u);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
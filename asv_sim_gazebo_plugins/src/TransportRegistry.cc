@@ -0,0 +1,364 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "asv/sim/TransportRegistry.hh"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <gz/common/Console.hh>
+
+namespace asv
+{
+namespace
+{
+/////////////////////////////////////////////////
+/// \brief A callback registered on a topic.
+struct CallbackEntry
+{
+  /// \brief Held while the callback runs. Recursive, so that a callback
+  /// can release its own subscription.
+  std::recursive_mutex mutex;
+
+  /// \brief False once the subscription is released.
+  bool active = true;
+
+  /// \brief The callback.
+  std::function<void(const gz::transport::ProtoMsg &)> callback;
+};
+
+/////////////////////////////////////////////////
+/// \brief The callbacks registered on a topic.
+struct TopicCallbacks
+{
+  /// \brief Message type name.
+  std::string type;
+
+  /// \brief Guards the callbacks. It is not held while they run, so a
+  /// callback can subscribe and unsubscribe.
+  std::mutex mutex;
+
+  /// \brief Callbacks by id.
+  std::map<uint64_t, std::shared_ptr<CallbackEntry>> callbacks;
+};
+
+/////////////////////////////////////////////////
+/// \brief A publisher shared by topic.
+struct SharedPublisher
+{
+  /// \brief Message type name.
+  std::string type;
+
+  /// \brief The publisher, while any user holds it.
+  std::weak_ptr<gz::transport::Node::Publisher> publisher;
+};
+
+/////////////////////////////////////////////////
+/// \brief A publisher and the node it was advertised on.
+struct PublisherHolder
+{
+  /// \brief The shared node, released after the publisher.
+  std::shared_ptr<gz::transport::Node> node;
+
+  /// \brief The publisher.
+  gz::transport::Node::Publisher publisher;
+};
+
+/////////////////////////////////////////////////
+/// \brief The registry state.
+struct Registry
+{
+  /// \brief Guards the registry.
+  std::mutex mutex;
+
+  /// \brief The shared node, while any subscription or publisher uses it.
+  std::weak_ptr<gz::transport::Node> node;
+
+  /// \brief Subscribed topics.
+  std::unordered_map<std::string, std::shared_ptr<TopicCallbacks>> topics;
+
+  /// \brief Advertised topics.
+  std::unordered_map<std::string, SharedPublisher> publishers;
+
+  /// \brief Advertised services.
+  std::set<std::string> services;
+
+  /// \brief Next callback id.
+  uint64_t nextId = 0;
+};
+
+/////////////////////////////////////////////////
+Registry &Instance()
+{
+  static Registry registry;
+  return registry;
+}
+
+/////////////////////////////////////////////////
+/// \brief The shared node, created if needed. The registry must be locked.
+std::shared_ptr<gz::transport::Node> SharedNode(Registry &_registry)
+{
+  auto node = _registry.node.lock();
+  if (!node)
+  {
+    node = std::make_shared<gz::transport::Node>();
+    _registry.node = node;
+  }
+  return node;
+}
+
+/////////////////////////////////////////////////
+/// \brief Removes a callback when the subscription is released.
+struct SubscriptionToken
+{
+  /// \brief Destructor.
+  ~SubscriptionToken()
+  {
+    // Wait for the callback to return if it is running, without holding
+    // the registry, since the callback may subscribe or unsubscribe.
+    {
+      std::lock_guard<std::recursive_mutex> entryLock(this->entry->mutex);
+      this->entry->active = false;
+    }
+
+    auto &registry = Instance();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    bool empty = false;
+    {
+      std::lock_guard<std::mutex> topicLock(this->callbacks->mutex);
+      this->callbacks->callbacks.erase(this->id);
+      empty = this->callbacks->callbacks.empty();
+    }
+    if (!empty)
+      return;
+
+    auto it = registry.topics.find(this->topic);
+    if (it != registry.topics.end() && it->second == this->callbacks)
+    {
+      this->node->Unsubscribe(this->topic);
+      registry.topics.erase(it);
+    }
+  }
+
+  /// \brief The shared node.
+  std::shared_ptr<gz::transport::Node> node;
+
+  /// \brief The topic.
+  std::string topic;
+
+  /// \brief The callbacks of the topic.
+  std::shared_ptr<TopicCallbacks> callbacks;
+
+  /// \brief The callback.
+  std::shared_ptr<CallbackEntry> entry;
+
+  /// \brief The callback id.
+  uint64_t id = 0;
+};
+
+/////////////////////////////////////////////////
+/// \brief Unadvertises a service when the handle is released.
+struct ServiceToken
+{
+  /// \brief Destructor.
+  ~ServiceToken()
+  {
+    auto &registry = Instance();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    this->node->UnadvertiseSrv(this->service);
+    registry.services.erase(this->service);
+  }
+
+  /// \brief The shared node.
+  std::shared_ptr<gz::transport::Node> node;
+
+  /// \brief The service.
+  std::string service;
+};
+}  // namespace
+
+/////////////////////////////////////////////////
+TransportRegistry::Subscription TransportRegistry::SubscribeImpl(
+    const std::string &_topic, const std::string &_type,
+    const Callback &_callback, const NodeSubscriber &_subscriber)
+{
+  auto &registry = Instance();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  auto node = SharedNode(registry);
+
+  auto &callbacks = registry.topics[_topic];
+  if (!callbacks)
+  {
+    callbacks = std::make_shared<TopicCallbacks>();
+    callbacks->type = _type;
+
+    // Dispatch to every callback registered on the topic. The callbacks
+    // are copied and run without the topic lock.
+    std::weak_ptr<TopicCallbacks> weak = callbacks;
+    Callback dispatch = [weak](const gz::transport::ProtoMsg &_msg)
+    {
+      auto topicCallbacks = weak.lock();
+      if (!topicCallbacks)
+        return;
+      std::vector<std::shared_ptr<CallbackEntry>> entries;
+      {
+        std::lock_guard<std::mutex> topicLock(topicCallbacks->mutex);
+        entries.reserve(topicCallbacks->callbacks.size());
+        for (auto &callback : topicCallbacks->callbacks)
+          entries.push_back(callback.second);
+      }
+      for (auto &entry : entries)
+      {
+        std::lock_guard<std::recursive_mutex> entryLock(entry->mutex);
+        if (entry->active)
+          entry->callback(_msg);
+      }
+    };
+    if (!_subscriber(*node, _topic, dispatch))
+    {
+      gzerr << "TransportRegistry: failed to subscribe to ["
+            << _topic << "]\n";
+      registry.topics.erase(_topic);
+      return nullptr;
+    }
+  }
+  else if (callbacks->type != _type)
+  {
+    gzerr << "TransportRegistry: topic [" << _topic << "] is subscribed "
+          << "with type [" << callbacks->type << "], not ["
+          << _type << "]\n";
+    return nullptr;
+  }
+
+  auto token = std::make_shared<SubscriptionToken>();
+  token->node = node;
+  token->topic = _topic;
+  token->callbacks = callbacks;
+  token->entry = std::make_shared<CallbackEntry>();
+  token->entry->callback = _callback;
+  token->id = registry.nextId++;
+  {
+    std::lock_guard<std::mutex> topicLock(callbacks->mutex);
+    callbacks->callbacks.emplace(token->id, token->entry);
+  }
+  return token;
+}
+
+/////////////////////////////////////////////////
+TransportRegistry::Publisher TransportRegistry::AdvertiseImpl(
+    const std::string &_topic, const std::string &_type,
+    const NodeAdvertiser &_advertiser)
+{
+  auto &registry = Instance();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+
+  auto it = registry.publishers.find(_topic);
+  if (it != registry.publishers.end())
+  {
+    if (auto publisher = it->second.publisher.lock())
+    {
+      if (it->second.type != _type)
+      {
+        gzerr << "TransportRegistry: topic [" << _topic << "] is "
+              << "advertised with type [" << it->second.type << "], not ["
+              << _type << "]\n";
+        return nullptr;
+      }
+      return publisher;
+    }
+  }
+
+  auto node = SharedNode(registry);
+  auto pub = _advertiser(*node, _topic);
+  if (!pub)
+  {
+    gzerr << "TransportRegistry: failed to advertise [" << _topic << "]\n";
+    return nullptr;
+  }
+
+  // The publisher keeps the node alive.
+  auto holder = std::make_shared<PublisherHolder>();
+  holder->node = node;
+  holder->publisher = pub;
+  Publisher publisher(holder, &holder->publisher);
+  registry.publishers[_topic] = {_type, publisher};
+  return publisher;
+}
+
+/////////////////////////////////////////////////
+TransportRegistry::Subscription TransportRegistry::AdvertiseServiceImpl(
+    const std::string &_service, const ServiceAdvertiser &_advertiser)
+{
+  auto &registry = Instance();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  if (registry.services.count(_service))
+  {
+    gzerr << "TransportRegistry: service [" << _service
+          << "] is already advertised\n";
+    return nullptr;
+  }
+
+  auto node = SharedNode(registry);
+  if (!_advertiser(*node, _service))
+  {
+    gzerr << "TransportRegistry: failed to advertise service ["
+          << _service << "]\n";
+    return nullptr;
+  }
+  registry.services.insert(_service);
+
+  auto token = std::make_shared<ServiceToken>();
+  token->node = node;
+  token->service = _service;
+  return token;
+}
+
+/////////////////////////////////////////////////
+size_t TransportRegistry::SubscribedTopicCount()
+{
+  auto &registry = Instance();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  return registry.topics.size();
+}
+
+/////////////////////////////////////////////////
+size_t TransportRegistry::AdvertisedTopicCount()
+{
+  auto &registry = Instance();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  size_t count = 0;
+  for (auto &publisher : registry.publishers)
+  {
+    if (!publisher.second.publisher.expired())
+      ++count;
+  }
+  return count;
+}
+
+/////////////////////////////////////////////////
+bool TransportRegistry::HasNode()
+{
+  auto &registry = Instance();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  return !registry.node.expired();
+}
+
+}  // namespace asv
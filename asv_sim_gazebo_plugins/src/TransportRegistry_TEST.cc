@@ -0,0 +1,177 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+
+#include <gz/msgs/double.pb.h>
+#include <gz/msgs/stringmsg.pb.h>
+#include <gz/msgs/vector3d.pb.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+
+#include "asv/sim/TransportRegistry.hh"
+
+/////////////////////////////////////////////////
+/// \brief Wait up to a second for a count to be reached.
+bool WaitFor(const std::atomic<int> &_count, int _expected)
+{
+  for (int i = 0; i < 100 && _count < _expected; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  return _count == _expected;
+}
+
+/////////////////////////////////////////////////
+TEST(TransportRegistry, Shared)
+{
+    using asv::TransportRegistry;
+    const std::string topic = "/asv_sim/test/transport_registry";
+    EXPECT_FALSE(TransportRegistry::HasNode());
+
+    std::atomic<int> count1{0};
+    std::atomic<int> count2{0};
+    std::function<void(const gz::msgs::Double &)> cb1 =
+        [&count1](const gz::msgs::Double &) { ++count1; };
+    std::function<void(const gz::msgs::Double &)> cb2 =
+        [&count2](const gz::msgs::Double &) { ++count2; };
+
+    // Two subscribers share one topic subscription.
+    auto sub1 = TransportRegistry::Subscribe(topic, cb1);
+    auto sub2 = TransportRegistry::Subscribe(topic, cb2);
+    ASSERT_NE(sub1, nullptr);
+    ASSERT_NE(sub2, nullptr);
+    EXPECT_TRUE(TransportRegistry::HasNode());
+    EXPECT_EQ(TransportRegistry::SubscribedTopicCount(), 1u);
+
+    // A topic has one type.
+    std::function<void(const gz::msgs::Vector3d &)> cb3 =
+        [](const gz::msgs::Vector3d &) {};
+    EXPECT_EQ(TransportRegistry::Subscribe(topic, cb3), nullptr);
+
+    // Publishers are shared by topic.
+    auto pub1 = TransportRegistry::Advertise<gz::msgs::Double>(topic);
+    auto pub2 = TransportRegistry::Advertise<gz::msgs::Double>(topic);
+    ASSERT_NE(pub1, nullptr);
+    EXPECT_EQ(pub1, pub2);
+    EXPECT_EQ(TransportRegistry::AdvertisedTopicCount(), 1u);
+
+    gz::msgs::Double msg;
+    msg.set_data(1.0);
+    pub1->Publish(msg);
+    EXPECT_TRUE(WaitFor(count1, 1));
+    EXPECT_TRUE(WaitFor(count2, 1));
+
+    // A released subscription is no longer called.
+    sub1.reset();
+    pub1->Publish(msg);
+    EXPECT_TRUE(WaitFor(count2, 2));
+    EXPECT_EQ(count1, 1);
+
+    // The node is released with the last user.
+    sub2.reset();
+    EXPECT_EQ(TransportRegistry::SubscribedTopicCount(), 0u);
+    EXPECT_TRUE(TransportRegistry::HasNode());
+    pub1.reset();
+    pub2.reset();
+    EXPECT_EQ(TransportRegistry::AdvertisedTopicCount(), 0u);
+    EXPECT_FALSE(TransportRegistry::HasNode());
+}
+
+/////////////////////////////////////////////////
+TEST(TransportRegistry, Reentrant)
+{
+    using asv::TransportRegistry;
+    const std::string topic = "/asv_sim/test/transport_registry_reentrant";
+
+    std::atomic<int> count1{0};
+    std::atomic<int> count2{0};
+    std::atomic<int> count3{0};
+    TransportRegistry::Subscription sub1;
+    TransportRegistry::Subscription sub2;
+    TransportRegistry::Subscription sub3;
+    std::function<void(const gz::msgs::Double &)> cb2 =
+        [&count2](const gz::msgs::Double &) { ++count2; };
+    std::function<void(const gz::msgs::Double &)> cb3 =
+        [&count3](const gz::msgs::Double &) { ++count3; };
+
+    // A callback can subscribe and unsubscribe, its own subscription
+    // included.
+    std::function<void(const gz::msgs::Double &)> cb1 =
+        [&](const gz::msgs::Double &)
+        {
+          ++count1;
+          if (!sub2)
+            sub2 = TransportRegistry::Subscribe(topic, cb2);
+          sub3.reset();
+          sub1.reset();
+        };
+    sub3 = TransportRegistry::Subscribe(topic, cb3);
+    sub1 = TransportRegistry::Subscribe(topic, cb1);
+    ASSERT_NE(sub1, nullptr);
+    ASSERT_NE(sub3, nullptr);
+
+    auto pub = TransportRegistry::Advertise<gz::msgs::Double>(topic);
+    ASSERT_NE(pub, nullptr);
+    gz::msgs::Double msg;
+    msg.set_data(1.0);
+    pub->Publish(msg);
+    EXPECT_TRUE(WaitFor(count1, 1));
+    EXPECT_TRUE(WaitFor(count3, 1));
+    EXPECT_EQ(sub1, nullptr);
+    ASSERT_NE(sub2, nullptr);
+
+    // Only the new subscription is left.
+    pub->Publish(msg);
+    EXPECT_TRUE(WaitFor(count2, 1));
+    EXPECT_EQ(count1, 1);
+    EXPECT_EQ(count3, 1);
+
+    sub2.reset();
+    pub.reset();
+    EXPECT_EQ(TransportRegistry::SubscribedTopicCount(), 0u);
+    EXPECT_FALSE(TransportRegistry::HasNode());
+}
+
+/////////////////////////////////////////////////
+TEST(TransportRegistry, Service)
+{
+    using asv::TransportRegistry;
+    const std::string service = "/asv_sim/test/transport_registry_srv";
+    std::function<bool(const gz::msgs::StringMsg &, gz::msgs::StringMsg &)>
+        cb = [](const gz::msgs::StringMsg &_req, gz::msgs::StringMsg &_rep)
+        {
+          _rep.set_data(_req.data());
+          return true;
+        };
+
+    // A service is advertised once, and can be again once released.
+    auto srv = TransportRegistry::AdvertiseService(service, cb);
+    ASSERT_NE(srv, nullptr);
+    EXPECT_TRUE(TransportRegistry::HasNode());
+    EXPECT_EQ(TransportRegistry::AdvertiseService(service, cb), nullptr);
+    srv.reset();
+    EXPECT_FALSE(TransportRegistry::HasNode());
+    srv = TransportRegistry::AdvertiseService(service, cb);
+    EXPECT_NE(srv, nullptr);
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,409 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "asv/sim/VortexLattice.hh"
+
+#include <Eigen/Dense>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <gz/common/Console.hh>
+#include <gz/math/Helpers.hh>
+#include <gz/math/Quaternion.hh>
+
+namespace asv
+{
+namespace
+{
+/////////////////////////////////////////////////
+/// \brief Velocity induced at _p by a vortex segment from _a to _b
+/// with unit circulation (Biot-Savart).
+gz::math::Vector3d SegmentVelocity(
+    const gz::math::Vector3d &_p,
+    const gz::math::Vector3d &_a,
+    const gz::math::Vector3d &_b)
+{
+  auto r0 = _b - _a;
+  auto r1 = _p - _a;
+  auto r2 = _p - _b;
+  auto r1xr2 = r1.Cross(r2);
+  double d = r1xr2.SquaredLength();
+
+  // Vortex core cut-off: points on or near the segment axis.
+  const double eps = 1.0E-10;
+  double l1 = r1.Length();
+  double l2 = r2.Length();
+  if (d < eps * r0.SquaredLength() || l1 < eps || l2 < eps)
+    return gz::math::Vector3d::Zero;
+
+  double k = r0.Dot(r1 / l1 - r2 / l2) / (4.0 * GZ_PI * d);
+  return k * r1xr2;
+}
+
+/////////////////////////////////////////////////
+/// \brief The rotation angle between two orientations.
+double AngleBetween(
+    const gz::math::Quaterniond &_q1,
+    const gz::math::Quaterniond &_q2)
+{
+  double dot = _q1.W() * _q2.W() + _q1.X() * _q2.X()
+      + _q1.Y() * _q2.Y() + _q1.Z() * _q2.Z();
+  return 2.0 * std::acos(std::min(1.0, std::fabs(dot)));
+}
+}  // namespace
+
+/////////////////////////////////////////////////
+class VortexLatticePrivate
+{
+  /// \brief A lifting surface.
+  public: struct Surface
+  {
+    /// \brief Spanwise strips (surface frame).
+    std::vector<SailStrip> strips;
+
+    /// \brief Twisted forward direction of each strip (surface frame).
+    std::vector<gz::math::Vector3d> forward;
+
+    /// \brief Twisted upward direction of each strip (surface frame).
+    std::vector<gz::math::Vector3d> upward;
+
+    /// \brief Untwisted forward direction (surface frame).
+    gz::math::Vector3d chordAxis;
+
+    /// \brief Current pose (reference frame).
+    gz::math::Pose3d pose;
+
+    /// \brief Pose when the influence matrix was last factorised.
+    gz::math::Pose3d factorPose;
+
+    /// \brief Index of the first panel.
+    size_t offset = 0;
+  };
+
+  /// \brief Update the panel geometry from the surface poses.
+  public: void UpdateGeometry();
+
+  /// \brief Build and factorise the influence matrix.
+  public: void Factorise();
+
+  /// \brief Velocity induced at _p by the horseshoe vortex of panel _j.
+  public: gz::math::Vector3d HorseshoeVelocity(
+      const gz::math::Vector3d &_p, size_t _j) const;
+
+  /// \brief The surfaces.
+  public: std::vector<Surface> surfaces;
+
+  /// \brief Total number of panels.
+  public: size_t n = 0;
+
+  /// \brief Bound vortex start point for each panel.
+  public: std::vector<gz::math::Vector3d> boundA;
+
+  /// \brief Bound vortex end point for each panel.
+  public: std::vector<gz::math::Vector3d> boundB;
+
+  /// \brief Bound vortex midpoint for each panel.
+  public: std::vector<gz::math::Vector3d> boundMid;
+
+  /// \brief Control point for each panel.
+  public: std::vector<gz::math::Vector3d> controlPoint;
+
+  /// \brief Normal at the control point for each panel.
+  public: std::vector<gz::math::Vector3d> normal;
+
+  /// \brief Direction of the trailing vortices for each panel.
+  public: std::vector<gz::math::Vector3d> trailing;
+
+  /// \brief Length of the trailing vortex legs. Long compared with
+  /// the span so they approximate semi-infinite vortices.
+  public: double wakeLength = 1.0E3;
+
+  /// \brief Refactorisation threshold in radians.
+  public: double refactorThreshold = 0.01;
+
+  /// \brief True if the influence matrix must be rebuilt.
+  public: bool dirty = true;
+
+  /// \brief Number of factorisations.
+  public: size_t factorisationCount = 0;
+
+  /// \brief Cached LU factorisation of the influence matrix.
+  public: Eigen::PartialPivLU<Eigen::MatrixXd> lu;
+
+  /// \brief Velocity induced at the bound vortex midpoints by unit
+  /// circulation on each panel, one matrix per component.
+  public: Eigen::MatrixXd inducedX;
+  public: Eigen::MatrixXd inducedY;
+  public: Eigen::MatrixXd inducedZ;
+
+  /// \brief Work vectors.
+  public: Eigen::VectorXd rhs;
+  public: Eigen::VectorXd gamma;
+  public: Eigen::VectorXd velX;
+  public: Eigen::VectorXd velY;
+  public: Eigen::VectorXd velZ;
+};
+
+/////////////////////////////////////////////////
+void VortexLatticePrivate::UpdateGeometry()
+{
+  for (auto &surface : this->surfaces)
+  {
+    const auto &rot = surface.pose.Rot();
+    const auto &pos = surface.pose.Pos();
+    auto trailingDir = -rot.RotateVector(surface.chordAxis);
+    for (size_t i = 0; i < surface.strips.size(); ++i)
+    {
+      const auto &strip = surface.strips[i];
+      size_t k = surface.offset + i;
+      auto fwd = surface.forward[i];
+      auto a = strip.leLower - 0.25 * strip.chord * fwd;
+      auto b = strip.leUpper - 0.25 * strip.chord * fwd;
+      auto c = 0.5 * (strip.leLower + strip.leUpper) - 0.75 * strip.chord * fwd;
+
+      this->boundA[k] = pos + rot.RotateVector(a);
+      this->boundB[k] = pos + rot.RotateVector(b);
+      this->boundMid[k] = 0.5 * (this->boundA[k] + this->boundB[k]);
+      this->controlPoint[k] = pos + rot.RotateVector(c);
+      this->normal[k] = rot.RotateVector(surface.upward[i]);
+      this->trailing[k] = trailingDir;
+    }
+  }
+}
+
+/////////////////////////////////////////////////
+gz::math::Vector3d VortexLatticePrivate::HorseshoeVelocity(
+    const gz::math::Vector3d &_p, size_t _j) const
+{
+  const auto &a = this->boundA[_j];
+  const auto &b = this->boundB[_j];
+  auto aFar = a + this->wakeLength * this->trailing[_j];
+  auto bFar = b + this->wakeLength * this->trailing[_j];
+  return SegmentVelocity(_p, aFar, a)
+      + SegmentVelocity(_p, a, b)
+      + SegmentVelocity(_p, b, bFar);
+}
+
+/////////////////////////////////////////////////
+void VortexLatticePrivate::Factorise()
+{
+  Eigen::MatrixXd aic(this->n, this->n);
+  for (size_t j = 0; j < this->n; ++j)
+  {
+    for (size_t i = 0; i < this->n; ++i)
+    {
+      aic(i, j) = this->normal[i].Dot(
+          this->HorseshoeVelocity(this->controlPoint[i], j));
+
+      auto v = this->HorseshoeVelocity(this->boundMid[i], j);
+      this->inducedX(i, j) = v.X();
+      this->inducedY(i, j) = v.Y();
+      this->inducedZ(i, j) = v.Z();
+    }
+  }
+  this->lu.compute(aic);
+
+  for (auto &surface : this->surfaces)
+  {
+    surface.factorPose = surface.pose;
+  }
+  this->dirty = false;
+  ++this->factorisationCount;
+}
+
+/////////////////////////////////////////////////
+VortexLattice::~VortexLattice() = default;
+
+/////////////////////////////////////////////////
+VortexLattice::VortexLattice()
+    : data(std::make_unique<VortexLatticePrivate>())
+{
+}
+
+/////////////////////////////////////////////////
+size_t VortexLattice::AddSurface(
+    const std::vector<SailStrip> &_strips,
+    const gz::math::Vector3d &_forward,
+    const gz::math::Vector3d &_upward)
+{
+  VortexLatticePrivate::Surface surface;
+  surface.strips = _strips;
+  surface.chordAxis = _forward;
+  surface.chordAxis.Normalize();
+  surface.offset = this->data->n;
+
+  // Twist is about the span axis, normal to the lift-drag plane.
+  auto spanAxis = _forward.Cross(_upward).Normalize();
+  for (const auto &strip : _strips)
+  {
+    gz::math::Quaterniond twist(spanAxis, strip.twist);
+    surface.forward.push_back(twist.RotateVector(_forward).Normalize());
+    surface.upward.push_back(twist.RotateVector(_upward).Normalize());
+  }
+  this->data->surfaces.push_back(surface);
+
+  // Resize panel storage.
+  auto &d = *this->data;
+  d.n += _strips.size();
+  d.boundA.resize(d.n);
+  d.boundB.resize(d.n);
+  d.boundMid.resize(d.n);
+  d.controlPoint.resize(d.n);
+  d.normal.resize(d.n);
+  d.trailing.resize(d.n);
+  d.inducedX.resize(d.n, d.n);
+  d.inducedY.resize(d.n, d.n);
+  d.inducedZ.resize(d.n, d.n);
+  d.rhs.resize(d.n);
+  d.gamma.setZero(d.n);
+  d.velX.resize(d.n);
+  d.velY.resize(d.n);
+  d.velZ.resize(d.n);
+  d.dirty = true;
+
+  return d.surfaces.size() - 1;
+}
+
+/////////////////////////////////////////////////
+size_t VortexLattice::SurfaceCount() const
+{
+  return this->data->surfaces.size();
+}
+
+/////////////////////////////////////////////////
+size_t VortexLattice::PanelCount() const
+{
+  return this->data->n;
+}
+
+/////////////////////////////////////////////////
+size_t VortexLattice::PanelOffset(size_t _surface) const
+{
+  return this->data->surfaces[_surface].offset;
+}
+
+/////////////////////////////////////////////////
+void VortexLattice::SetRefactorThreshold(double _angle)
+{
+  this->data->refactorThreshold = _angle;
+}
+
+/////////////////////////////////////////////////
+void VortexLattice::SetSurfacePose(size_t _surface,
+    const gz::math::Pose3d &_pose)
+{
+  auto &surface = this->data->surfaces[_surface];
+  surface.pose = _pose;
+
+  if (AngleBetween(surface.pose.Rot(), surface.factorPose.Rot())
+      > this->data->refactorThreshold)
+  {
+    this->data->dirty = true;
+  }
+}
+
+/////////////////////////////////////////////////
+const gz::math::Vector3d &VortexLattice::BoundMidpoint(size_t _panel) const
+{
+  return this->data->boundMid[_panel];
+}
+
+/////////////////////////////////////////////////
+const gz::math::Vector3d &VortexLattice::ControlPoint(size_t _panel) const
+{
+  return this->data->controlPoint[_panel];
+}
+
+/////////////////////////////////////////////////
+gz::math::Vector3d VortexLattice::InducedVelocity(
+    const gz::math::Vector3d &_point, size_t _surface) const
+{
+  const auto &surface = this->data->surfaces[_surface];
+  gz::math::Vector3d vel = gz::math::Vector3d::Zero;
+  for (size_t i = 0; i < surface.strips.size(); ++i)
+  {
+    size_t k = surface.offset + i;
+    vel += this->data->gamma[k] * this->data->HorseshoeVelocity(_point, k);
+  }
+  return vel;
+}
+
+/////////////////////////////////////////////////
+bool VortexLattice::Solve(
+    const std::vector<gz::math::Vector3d> &_velU,
+    double _fluidDensity,
+    std::vector<gz::math::Vector3d> &_force)
+{
+  auto &d = *this->data;
+  if (_velU.size() != d.n)
+  {
+    gzerr << "VortexLattice expected [" << d.n << "] velocities, got ["
+          << _velU.size() << "]\n";
+    return false;
+  }
+  if (d.n == 0)
+    return false;
+
+  d.UpdateGeometry();
+  if (d.dirty)
+  {
+    d.Factorise();
+  }
+
+  // Flow tangency at the control points.
+  for (size_t i = 0; i < d.n; ++i)
+  {
+    d.rhs[i] = -_velU[i].Dot(d.normal[i]);
+  }
+  d.gamma = d.lu.solve(d.rhs);
+  if (!d.gamma.allFinite())
+  {
+    d.gamma.setZero();
+    return false;
+  }
+
+  // Induced velocity at the bound vortices.
+  d.velX.noalias() = d.inducedX * d.gamma;
+  d.velY.noalias() = d.inducedY * d.gamma;
+  d.velZ.noalias() = d.inducedZ * d.gamma;
+
+  // Kutta-Joukowski force on each bound vortex.
+  _force.resize(d.n);
+  for (size_t i = 0; i < d.n; ++i)
+  {
+    gz::math::Vector3d vel = _velU[i]
+        + gz::math::Vector3d(d.velX[i], d.velY[i], d.velZ[i]);
+    auto dl = d.boundB[i] - d.boundA[i];
+    _force[i] = _fluidDensity * d.gamma[i] * vel.Cross(dl);
+  }
+
+  return true;
+}
+
+/////////////////////////////////////////////////
+double VortexLattice::Circulation(size_t _panel) const
+{
+  return this->data->gamma[_panel];
+}
+
+/////////////////////////////////////////////////
+size_t VortexLattice::FactorisationCount() const
+{
+  return this->data->factorisationCount;
+}
+
+}  // namespace asv
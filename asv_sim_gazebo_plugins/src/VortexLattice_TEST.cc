@@ -0,0 +1,136 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+#include "asv/sim/SailPlanform.hh"
+#include "asv/sim/VortexLattice.hh"
+
+/////////////////////////////////////////////////
+/// \brief A rectangular planform with span along z and chord along x.
+std::vector<asv::SailStrip> rectangular_strips(double _span, double _chord,
+    int _n)
+{
+  asv::SailPlanform planform;
+  planform.luffFoot = gz::math::Vector3d(0.0, 0.0, -0.5 * _span);
+  planform.luffHead = gz::math::Vector3d(0.0, 0.0, 0.5 * _span);
+  planform.footChord = _chord;
+  planform.headChord = _chord;
+  planform.numStrips = _n;
+
+  std::vector<asv::SailStrip> strips;
+  planform.Discretise(gz::math::Vector3d(1.0, 0.0, 0.0), strips);
+  return strips;
+}
+
+/////////////////////////////////////////////////
+TEST(VortexLattice, RectangularWing)
+{
+    const double span = 8.0;
+    const double chord = 1.0;
+    const double rho = 1.2;
+    const double alpha = 5.0 * M_PI / 180.0;
+
+    asv::VortexLattice vlm;
+    vlm.AddSurface(rectangular_strips(span, chord, 40),
+        gz::math::Vector3d(1.0, 0.0, 0.0),
+        gz::math::Vector3d(0.0, 1.0, 0.0));
+    vlm.SetSurfacePose(0, gz::math::Pose3d::Zero);
+    ASSERT_EQ(vlm.PanelCount(), 40u);
+
+    // Free stream from ahead at angle of attack alpha.
+    const double speed = 10.0;
+    gz::math::Vector3d velU(-speed * std::cos(alpha),
+        -speed * std::sin(alpha), 0.0);
+    std::vector<gz::math::Vector3d> vel(vlm.PanelCount(), velU);
+    std::vector<gz::math::Vector3d> force;
+    ASSERT_TRUE(vlm.Solve(vel, rho, force));
+
+    gz::math::Vector3d total = gz::math::Vector3d::Zero;
+    for (auto &f : force)
+      total += f;
+
+    // Lift is normal to the free stream in the x-y plane, away from
+    // the side the flow approaches from.
+    gz::math::Vector3d liftUnit(std::sin(alpha), -std::cos(alpha), 0.0);
+    double q = 0.5 * rho * speed * speed;
+    double cl = total.Dot(liftUnit) / (q * span * chord);
+
+    // Compare with the elliptic lifting line estimate for aspect ratio 8,
+    // which is an upper bound for a rectangular wing.
+    double ar = span / chord;
+    double clExpected = 2.0 * M_PI * alpha * ar / (ar + 2.0);
+    EXPECT_LT(cl, clExpected);
+    EXPECT_NEAR(cl, clExpected, 0.1 * clExpected);
+    EXPECT_NEAR(total.Z(), 0.0, 1.0E-9);
+
+    // Induced drag is positive (along the free stream).
+    EXPECT_GT(total.Dot(velU), 0.0);
+}
+
+/////////////////////////////////////////////////
+TEST(VortexLattice, Refactorisation)
+{
+    asv::VortexLattice vlm;
+    auto strips = rectangular_strips(2.0, 0.5, 8);
+    vlm.AddSurface(strips, gz::math::Vector3d(1.0, 0.0, 0.0),
+        gz::math::Vector3d(0.0, 1.0, 0.0));
+    vlm.AddSurface(strips, gz::math::Vector3d(1.0, 0.0, 0.0),
+        gz::math::Vector3d(0.0, 1.0, 0.0));
+    vlm.SetRefactorThreshold(0.05);
+    EXPECT_EQ(vlm.SurfaceCount(), 2u);
+    EXPECT_EQ(vlm.PanelOffset(1), 8u);
+
+    std::vector<gz::math::Vector3d> vel(vlm.PanelCount(),
+        gz::math::Vector3d(-5.0, -0.5, 0.0));
+    std::vector<gz::math::Vector3d> force;
+
+    vlm.SetSurfacePose(0, gz::math::Pose3d(1.0, 0.0, 0.0, 0.0, 0.0, 0.0));
+    vlm.SetSurfacePose(1, gz::math::Pose3d(-1.0, 0.0, 0.0, 0.0, 0.0, 0.0));
+    ASSERT_TRUE(vlm.Solve(vel, 1.2, force));
+    EXPECT_EQ(vlm.FactorisationCount(), 1u);
+
+    // Small trim changes reuse the factorisation.
+    vlm.SetSurfacePose(1, gz::math::Pose3d(-1.0, 0.0, 0.0, 0.0, 0.0, 0.02));
+    ASSERT_TRUE(vlm.Solve(vel, 1.2, force));
+    EXPECT_EQ(vlm.FactorisationCount(), 1u);
+
+    // Large trim changes refactorise.
+    vlm.SetSurfacePose(1, gz::math::Pose3d(-1.0, 0.0, 0.0, 0.0, 0.0, 0.2));
+    ASSERT_TRUE(vlm.Solve(vel, 1.2, force));
+    EXPECT_EQ(vlm.FactorisationCount(), 2u);
+
+    // The downstream surface sits in the upwash of the upstream surface.
+    double gammaFront = 0.0;
+    double gammaBack = 0.0;
+    vlm.SetSurfacePose(1, gz::math::Pose3d(-1.0, 0.0, 0.0, 0.0, 0.0, 0.0));
+    ASSERT_TRUE(vlm.Solve(vel, 1.2, force));
+    for (size_t i = 0; i < 8; ++i)
+    {
+      gammaFront += vlm.Circulation(i);
+      gammaBack += vlm.Circulation(8 + i);
+    }
+    EXPECT_NE(gammaFront, gammaBack);
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
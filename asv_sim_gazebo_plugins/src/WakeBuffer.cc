@@ -0,0 +1,120 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "asv/sim/WakeBuffer.hh"
+
+#include <algorithm>
+
+namespace asv
+{
+/////////////////////////////////////////////////
+WakeBuffer::WakeBuffer(size_t _capacity, double _period)
+    : period(_period),
+      time(std::max<size_t>(_capacity, 2), 0.0),
+      value(std::max<size_t>(_capacity, 2), gz::math::Vector3d::Zero)
+{
+}
+
+/////////////////////////////////////////////////
+size_t WakeBuffer::Size() const
+{
+  return this->count;
+}
+
+/////////////////////////////////////////////////
+double WakeBuffer::Span() const
+{
+  return this->period * (this->time.size() - 1);
+}
+
+/////////////////////////////////////////////////
+void WakeBuffer::Clear()
+{
+  this->head = 0;
+  this->count = 0;
+}
+
+/////////////////////////////////////////////////
+size_t WakeBuffer::Index(size_t _n) const
+{
+  return (this->head + _n) % this->time.size();
+}
+
+/////////////////////////////////////////////////
+void WakeBuffer::Push(double _time, const gz::math::Vector3d &_value)
+{
+  if (this->count > 0)
+  {
+    double last = this->time[this->Index(this->count - 1)];
+    if (_time < last)
+      this->Clear();
+    else if (_time - last < this->period - 1.0E-9)
+      return;
+  }
+
+  if (this->count < this->time.size())
+  {
+    ++this->count;
+  }
+  else
+  {
+    this->head = this->Index(1);
+  }
+  size_t i = this->Index(this->count - 1);
+  this->time[i] = _time;
+  this->value[i] = _value;
+}
+
+/////////////////////////////////////////////////
+gz::math::Vector3d WakeBuffer::Sample(double _time) const
+{
+  if (this->count == 0)
+    return gz::math::Vector3d::Zero;
+
+  size_t oldest = this->Index(0);
+  size_t newest = this->Index(this->count - 1);
+  if (_time <= this->time[oldest])
+    return this->value[oldest];
+  if (_time >= this->time[newest])
+    return this->value[newest];
+
+  // Samples are near uniform, so start from the expected position.
+  size_t n = static_cast<size_t>(
+      (_time - this->time[oldest]) / this->period);
+  n = std::min(n, this->count - 2);
+  while (n > 0 && this->time[this->Index(n)] > _time)
+    --n;
+  while (n + 2 < this->count && this->time[this->Index(n + 1)] < _time)
+    ++n;
+
+  size_t i0 = this->Index(n);
+  size_t i1 = this->Index(n + 1);
+  double w = (_time - this->time[i0]) / (this->time[i1] - this->time[i0]);
+  return this->value[i0] + w * (this->value[i1] - this->value[i0]);
+}
+
+/////////////////////////////////////////////////
+double ConvectionDistance(
+    const gz::math::Vector3d &_upstream,
+    const gz::math::Vector3d &_downstream,
+    const gz::math::Vector3d &_velocity)
+{
+  double speed = _velocity.Length();
+  if (speed < 1.0E-6)
+    return 0.0;
+  return std::max(0.0, (_downstream - _upstream).Dot(_velocity) / speed);
+}
+
+}  // namespace asv
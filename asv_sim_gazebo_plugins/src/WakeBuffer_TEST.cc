@@ -0,0 +1,104 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+
+#include "asv/sim/WakeBuffer.hh"
+
+/////////////////////////////////////////////////
+TEST(WakeBuffer, Sample)
+{
+    asv::WakeBuffer buffer(8, 0.1);
+    EXPECT_EQ(buffer.Size(), 0u);
+    EXPECT_EQ(buffer.Sample(1.0), gz::math::Vector3d::Zero);
+    EXPECT_DOUBLE_EQ(buffer.Span(), 0.7);
+
+    // Samples closer than the period are dropped.
+    for (int i = 0; i <= 50; ++i)
+    {
+      double t = 0.01 * i;
+      buffer.Push(t, gz::math::Vector3d(t, 0.0, 0.0));
+    }
+    EXPECT_EQ(buffer.Size(), 6u);
+
+    // Linear interpolation between samples.
+    EXPECT_NEAR(buffer.Sample(0.25).X(), 0.25, 1.0E-12);
+
+    // Clamped at both ends.
+    EXPECT_NEAR(buffer.Sample(-1.0).X(), 0.0, 1.0E-12);
+    EXPECT_NEAR(buffer.Sample(1.0).X(), 0.5, 1.0E-12);
+}
+
+/////////////////////////////////////////////////
+TEST(WakeBuffer, Wrap)
+{
+    asv::WakeBuffer buffer(4, 1.0);
+    for (int i = 0; i < 10; ++i)
+    {
+      buffer.Push(i, gz::math::Vector3d(0.0, 2.0 * i, 0.0));
+    }
+    EXPECT_EQ(buffer.Size(), 4u);
+
+    // Only the last four samples are held.
+    EXPECT_NEAR(buffer.Sample(0.0).Y(), 12.0, 1.0E-12);
+    EXPECT_NEAR(buffer.Sample(7.5).Y(), 15.0, 1.0E-12);
+    EXPECT_NEAR(buffer.Sample(8.25).Y(), 16.5, 1.0E-12);
+
+    // Going back in time clears the buffer.
+    buffer.Push(1.0, gz::math::Vector3d(0.0, 0.0, 1.0));
+    EXPECT_EQ(buffer.Size(), 1u);
+    EXPECT_EQ(buffer.Sample(5.0), gz::math::Vector3d(0.0, 0.0, 1.0));
+}
+
+/////////////////////////////////////////////////
+TEST(WakeBuffer, ConvectionLag)
+{
+    // The free stream runs in -x at 4 m/s from a keel 2 m ahead of
+    // the rudder.
+    gz::math::Vector3d keel(1.5, 0.0, -1.0);
+    gz::math::Vector3d rudder(-0.5, 0.0, -1.0);
+    gz::math::Vector3d velWorld(-4.0, 0.0, 0.0);
+    double speed = velWorld.Length();
+
+    double distance = asv::ConvectionDistance(keel, rudder, velWorld);
+    EXPECT_DOUBLE_EQ(distance, 2.0);
+
+    // Only the component along the free stream counts, and a foil
+    // that is not downstream sees no lag.
+    EXPECT_DOUBLE_EQ(asv::ConvectionDistance(
+        keel, rudder + gz::math::Vector3d(0.0, 1.0, 0.0), velWorld), 2.0);
+    EXPECT_DOUBLE_EQ(asv::ConvectionDistance(rudder, keel, velWorld), 0.0);
+    EXPECT_DOUBLE_EQ(asv::ConvectionDistance(
+        keel, rudder, gz::math::Vector3d::Zero), 0.0);
+
+    // The keel wake ramps with time. The rudder samples it
+    // distance / speed = 0.5 s late.
+    asv::WakeBuffer buffer(256, 0.01);
+    double t = 0.0;
+    for (int i = 0; i <= 200; ++i)
+    {
+      t = 0.01 * i;
+      buffer.Push(t, gz::math::Vector3d(0.0, t, 0.0));
+    }
+    auto wake = buffer.Sample(t - distance / speed);
+    EXPECT_NEAR(wake.Y(), t - 0.5, 1.0E-12);
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,139 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "asv/sim/WindShadowGrid.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace asv
+{
+/////////////////////////////////////////////////
+WindShadowGrid::WindShadowGrid(double _cellSize, size_t _numBuckets)
+    : cellSize(_cellSize > 0.0 ? _cellSize : 10.0)
+{
+  size_t n = 1;
+  while (n < _numBuckets)
+    n <<= 1;
+  this->mask = n - 1;
+  this->buckets.resize(n);
+}
+
+/////////////////////////////////////////////////
+void WindShadowGrid::Clear()
+{
+  for (auto b : this->used)
+    this->buckets[b].clear();
+  this->used.clear();
+  this->cones.clear();
+}
+
+/////////////////////////////////////////////////
+size_t WindShadowGrid::ConeCount() const
+{
+  return this->cones.size();
+}
+
+/////////////////////////////////////////////////
+int64_t WindShadowGrid::Cell(double _x) const
+{
+  return static_cast<int64_t>(std::floor(_x / this->cellSize));
+}
+
+/////////////////////////////////////////////////
+size_t WindShadowGrid::Bucket(int64_t _i, int64_t _j) const
+{
+  // Large primes spread neighbouring cells over the buckets.
+  uint64_t h = static_cast<uint64_t>(_i) * 73856093u
+      ^ static_cast<uint64_t>(_j) * 19349663u;
+  return static_cast<size_t>(h) & this->mask;
+}
+
+/////////////////////////////////////////////////
+size_t WindShadowGrid::Insert(const WindShadowCone &_cone)
+{
+  size_t index = this->cones.size();
+  this->cones.push_back(_cone);
+  auto &cone = this->cones.back();
+  cone.direction.Z(0.0);
+  cone.direction.Normalize();
+
+  // Bounding box of the cone in the horizontal plane.
+  double rEnd = cone.radius + cone.length * std::tan(cone.halfAngle);
+  auto end = cone.apex + cone.length * cone.direction;
+  double xMin = std::min(cone.apex.X() - cone.radius, end.X() - rEnd);
+  double xMax = std::max(cone.apex.X() + cone.radius, end.X() + rEnd);
+  double yMin = std::min(cone.apex.Y() - cone.radius, end.Y() - rEnd);
+  double yMax = std::max(cone.apex.Y() + cone.radius, end.Y() + rEnd);
+
+  for (int64_t i = this->Cell(xMin); i <= this->Cell(xMax); ++i)
+  {
+    for (int64_t j = this->Cell(yMin); j <= this->Cell(yMax); ++j)
+    {
+      size_t b = this->Bucket(i, j);
+      auto &bucket = this->buckets[b];
+
+      // Cells of one cone that share a bucket are stored once.
+      if (!bucket.empty() && bucket.back() == index)
+        continue;
+      if (bucket.empty())
+        this->used.push_back(b);
+      bucket.push_back(static_cast<uint32_t>(index));
+    }
+  }
+  return index;
+}
+
+/////////////////////////////////////////////////
+double WindShadowGrid::Factor(const gz::math::Vector3d &_point,
+    uint64_t _source) const
+{
+  const auto &bucket = this->buckets[
+      this->Bucket(this->Cell(_point.X()), this->Cell(_point.Y()))];
+
+  double factor = 1.0;
+  for (auto index : bucket)
+  {
+    const auto &cone = this->cones[index];
+    if (cone.source != _source)
+      factor *= 1.0 - Deficit(cone, _point);
+  }
+  return factor;
+}
+
+/////////////////////////////////////////////////
+double WindShadowGrid::Deficit(const WindShadowCone &_cone,
+    const gz::math::Vector3d &_point)
+{
+  double dx = _point.X() - _cone.apex.X();
+  double dy = _point.Y() - _cone.apex.Y();
+  double ux = _cone.direction.X();
+  double uy = _cone.direction.Y();
+
+  // Distance along and from the axis.
+  double s = dx * ux + dy * uy;
+  if (s <= 0.0 || s >= _cone.length)
+    return 0.0;
+  double r = std::fabs(dy * ux - dx * uy);
+  double rCone = _cone.radius + s * std::tan(_cone.halfAngle);
+  if (r >= rCone)
+    return 0.0;
+
+  double radial = r / rCone;
+  return _cone.deficit * (1.0 - s / _cone.length) * (1.0 - radial * radial);
+}
+
+}  // namespace asv
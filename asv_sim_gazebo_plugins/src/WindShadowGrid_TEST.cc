@@ -0,0 +1,105 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "asv/sim/WindShadowGrid.hh"
+
+/////////////////////////////////////////////////
+TEST(WindShadowGrid, Deficit)
+{
+    asv::WindShadowCone cone;
+    cone.apex = gz::math::Vector3d(0.0, 0.0, 5.0);
+    cone.direction = gz::math::Vector3d(1.0, 0.0, 0.0);
+    cone.radius = 2.0;
+    cone.length = 40.0;
+    cone.halfAngle = 0.25;
+    cone.deficit = 0.4;
+
+    // On the axis the deficit falls linearly with distance.
+    EXPECT_NEAR(asv::WindShadowGrid::Deficit(cone,
+        gz::math::Vector3d(10.0, 0.0, 0.0)), 0.3, 1.0E-12);
+
+    // Upwind, beyond the end and outside the cone there is no deficit.
+    EXPECT_DOUBLE_EQ(asv::WindShadowGrid::Deficit(cone,
+        gz::math::Vector3d(-1.0, 0.0, 0.0)), 0.0);
+    EXPECT_DOUBLE_EQ(asv::WindShadowGrid::Deficit(cone,
+        gz::math::Vector3d(41.0, 0.0, 0.0)), 0.0);
+    EXPECT_DOUBLE_EQ(asv::WindShadowGrid::Deficit(cone,
+        gz::math::Vector3d(10.0, 5.0, 0.0)), 0.0);
+    EXPECT_GT(asv::WindShadowGrid::Deficit(cone,
+        gz::math::Vector3d(10.0, 4.0, 0.0)), 0.0);
+}
+
+/////////////////////////////////////////////////
+TEST(WindShadowGrid, Source)
+{
+    asv::WindShadowGrid grid(5.0, 64);
+    asv::WindShadowCone cone;
+    cone.source = 7;
+    grid.Insert(cone);
+    EXPECT_EQ(grid.ConeCount(), 1u);
+
+    gz::math::Vector3d point(10.0, 0.0, 0.0);
+    EXPECT_LT(grid.Factor(point, 1), 1.0);
+    EXPECT_DOUBLE_EQ(grid.Factor(point, 7), 1.0);
+
+    grid.Clear();
+    EXPECT_EQ(grid.ConeCount(), 0u);
+    EXPECT_DOUBLE_EQ(grid.Factor(point, 1), 1.0);
+}
+
+/////////////////////////////////////////////////
+TEST(WindShadowGrid, BruteForce)
+{
+    // The grid gives the same result as testing every cone.
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> pos(-200.0, 200.0);
+    std::uniform_real_distribution<double> angle(-M_PI, M_PI);
+
+    std::vector<asv::WindShadowCone> cones(100);
+    asv::WindShadowGrid grid(15.0, 256);
+    for (size_t i = 0; i < cones.size(); ++i)
+    {
+      auto &cone = cones[i];
+      double a = angle(gen);
+      cone.apex = gz::math::Vector3d(pos(gen), pos(gen), 0.0);
+      cone.direction = gz::math::Vector3d(std::cos(a), std::sin(a), 0.0);
+      cone.source = i;
+      grid.Insert(cone);
+    }
+
+    for (int k = 0; k < 1000; ++k)
+    {
+      gz::math::Vector3d point(pos(gen), pos(gen), 0.0);
+      double expected = 1.0;
+      for (auto &cone : cones)
+      {
+        if (cone.source != 3)
+          expected *= 1.0 - asv::WindShadowGrid::Deficit(cone, point);
+      }
+      EXPECT_NEAR(grid.Factor(point, 3), expected, 1.0E-12);
+    }
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
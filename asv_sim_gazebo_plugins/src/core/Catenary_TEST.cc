@@ -0,0 +1,152 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include "asv/core/Catenary.hh"
+
+/////////////////////////////////////////////////
+TEST(Catenary, Solve)
+{
+    const double L = 25.0;
+    const double V = 20.0;
+    asv::core::CatenaryHSolver solver;
+    for (double H : {6.0, 8.0, 10.0, 12.0, 15.0})
+    {
+      asv::core::CatenaryHSoln f(V, H, L);
+      double B = (L * L - (V * V + H * H)) / (2 * (L - H));
+      EXPECT_EQ(solver.Solve(f, B), asv::core::CatenaryHSolver::kConverged)
+          << "H: " << H;
+      EXPECT_LE(solver.nfev, solver.maxfev);
+      EXPECT_LT(B, f.UpperBound());
+
+      // The span of the catenary and the chain on the floor is H.
+      EXPECT_NEAR(f.InverseCatenaryVSoln(B), H, 1.0E-2) << "H: " << H;
+    }
+}
+
+/////////////////////////////////////////////////
+TEST(Catenary, Reuse)
+{
+    // One instance serves changing geometry.
+    asv::core::CatenaryHSoln f(20.0, 8.0, 25.0);
+    asv::core::CatenaryHSolver solver;
+    double B1 = 4.0;
+    ASSERT_EQ(solver.Solve(f, B1), asv::core::CatenaryHSolver::kConverged);
+
+    f.Set(20.0, 10.0, 25.0);
+    double B2 = 4.0;
+    ASSERT_EQ(solver.Solve(f, B2), asv::core::CatenaryHSolver::kConverged);
+
+    // A longer span lifts more chain off the floor.
+    EXPECT_LT(B2, B1);
+}
+
+/////////////////////////////////////////////////
+TEST(Catenary, Invalid)
+{
+    // The chain is too short to reach the anchor.
+    asv::core::CatenaryHSoln f(30.0, 5.0, 25.0);
+    asv::core::CatenaryHSolver solver;
+    double B = 1.0;
+    EXPECT_EQ(solver.Solve(f, B),
+        asv::core::CatenaryHSolver::kNotMakingProgress);
+    EXPECT_DOUBLE_EQ(B, 1.0);
+
+    // Too few evaluations to converge.
+    asv::core::CatenaryHSoln g(20.0, 10.0, 25.0);
+    solver.maxfev = 2;
+    B = 4.9;
+    EXPECT_EQ(solver.Solve(g, B),
+        asv::core::CatenaryHSolver::kTooManyEvaluations);
+}
+
+/////////////////////////////////////////////////
+TEST(Catenary, Tension)
+{
+    asv::core::CatenaryHSolver solver;
+    const double L = 25.0;
+    const double V = 20.0;
+    const double w = 10.0;
+
+    // A slack chain hangs vertically and the solver is not run.
+    double tr = 1.0;
+    double tz = 0.0;
+    double B = 0.0;
+    EXPECT_TRUE(asv::core::CatenarySlack(V, 5.0, L));
+    EXPECT_EQ(asv::core::CatenaryTension(V, 5.0, L, w, solver, tr, tz, &B),
+        asv::core::CatenaryHSolver::kConverged);
+    EXPECT_EQ(solver.nfev, 0);
+    EXPECT_DOUBLE_EQ(tr, 0.0);
+    EXPECT_DOUBLE_EQ(tz, -w * V);
+    EXPECT_DOUBLE_EQ(B, L - V);
+
+    // A taut chain matches the solver started from the upper bound.
+    const double H = 10.0;
+    EXPECT_FALSE(asv::core::CatenarySlack(V, H, L));
+    EXPECT_EQ(asv::core::CatenaryTension(V, H, L, w, solver, tr, tz, &B),
+        asv::core::CatenaryHSolver::kConverged);
+    asv::core::CatenaryHSoln f(V, H, L);
+    double B1 = asv::core::CatenaryBMax(V, H, L);
+    ASSERT_EQ(solver.Solve(f, B1), asv::core::CatenaryHSolver::kConverged);
+    EXPECT_DOUBLE_EQ(B, B1);
+    EXPECT_DOUBLE_EQ(tz, -w * (L - B));
+    EXPECT_DOUBLE_EQ(tr,
+        -w * asv::core::CatenaryFunction::CatenaryScalingFactor(V, B, L));
+}
+
+/////////////////////////////////////////////////
+TEST(Catenary, Batch)
+{
+    // Slack, taut and unreachable chains.
+    const double V[] = {20.0, 20.0, 20.0, 30.0};
+    const double H[] = {4.0, 10.0, 15.0, 5.0};
+    const double L[] = {25.0, 25.0, 25.0, 25.0};
+    const double w[] = {10.0, 10.0, 20.0, 10.0};
+    double tr[4];
+    double tz[4];
+    int status[4];
+    asv::core::CatenaryHSolver solver;
+    EXPECT_EQ(asv::core::CatenaryTension(4, V, H, L, w, solver, tr, tz,
+        status), 3u);
+
+    // Each chain matches the single calculation.
+    for (size_t i = 0; i < 4; ++i)
+    {
+      double tr1 = 0.0;
+      double tz1 = 0.0;
+      int status1 = asv::core::CatenaryTension(V[i], H[i], L[i], w[i],
+          solver, tr1, tz1);
+      EXPECT_EQ(status[i], status1) << i;
+      if (status1 != asv::core::CatenaryHSolver::kConverged)
+        continue;
+      EXPECT_DOUBLE_EQ(tr[i], tr1) << i;
+      EXPECT_DOUBLE_EQ(tz[i], tz1) << i;
+    }
+    EXPECT_DOUBLE_EQ(tr[0], 0.0);
+    EXPECT_DOUBLE_EQ(tz[0], -w[0] * V[0]);
+    EXPECT_LT(tr[2], tr[1]);
+    EXPECT_EQ(status[3], asv::core::CatenaryHSolver::kNotMakingProgress);
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,481 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#include "asv/core/FastSim.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#include "asv/core/Catenary.hh"
+
+namespace asv
+{
+namespace core
+{
+namespace
+{
+/////////////////////////////////////////////////
+/// \brief The splitmix64 generator, which is the same on every
+/// platform, unlike the distributions of the standard library.
+/// \param[in,out] _state The state.
+/// \return A random number.
+uint64_t SplitMix64(uint64_t &_state)
+{
+  uint64_t z = (_state += 0x9E3779B97F4A7C15ull);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  return z ^ (z >> 31);
+}
+
+/////////////////////////////////////////////////
+/// \brief A uniform random number in (0, 1].
+double Uniform(uint64_t &_state)
+{
+  return (static_cast<double>(SplitMix64(_state) >> 11) + 1.0) *
+      (1.0 / 9007199254740992.0);
+}
+
+/////////////////////////////////////////////////
+/// \brief Multiply a vector by a 3x3 matrix.
+Vector3d Multiply(const double _m[3][3], const Vector3d &_v)
+{
+  return Vector3d(
+      _m[0][0] * _v.x + _m[0][1] * _v.y + _m[0][2] * _v.z,
+      _m[1][0] * _v.x + _m[1][1] * _v.y + _m[1][2] * _v.z,
+      _m[2][0] * _v.x + _m[2][1] * _v.y + _m[2][2] * _v.z);
+}
+
+/////////////////////////////////////////////////
+/// \brief The damping about each axis, as BoatHull::Resistance.
+Vector3d Damping(const Vector3d &_linear, const Vector3d &_quadratic,
+    const Vector3d &_v)
+{
+  return Vector3d(
+      -(_linear.x + _quadratic.x * std::abs(_v.x)) * _v.x,
+      -(_linear.y + _quadratic.y * std::abs(_v.y)) * _v.y,
+      -(_linear.z + _quadratic.z * std::abs(_v.z)) * _v.z);
+}
+}  // namespace
+
+/////////////////////////////////////////////////
+FastSim::FastSim(const Boat &_boat, size_t _count,
+    const FastSimOptions &_options)
+  : boat(_boat), options(_options), count(_count)
+{
+  if (this->boat.hull.mass <= 0.0)
+    this->boat.hull.mass = 1.0;
+
+  // Inertia tensor and its inverse, the identity if singular.
+  const auto &d = this->boat.hull.inertia;
+  const auto &p = this->boat.hull.inertiaProducts;
+  const double m[3][3] = {
+      {d.x, p.x, p.y}, {p.x, d.y, p.z}, {p.y, p.z, d.z}};
+  double det = m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+      m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+      m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+  for (int i = 0; i < 3; ++i)
+  {
+    for (int j = 0; j < 3; ++j)
+    {
+      this->inertia[i][j] = std::abs(det) > 1.0e-12 ? m[i][j] :
+          (i == j ? 1.0 : 0.0);
+    }
+  }
+  if (std::abs(det) <= 1.0e-12)
+    det = 1.0;
+  for (int i = 0; i < 3; ++i)
+  {
+    for (int j = 0; j < 3; ++j)
+    {
+      // Cofactor of the transpose, the matrix is symmetric.
+      int i1 = (j + 1) % 3;
+      int i2 = (j + 2) % 3;
+      int j1 = (i + 1) % 3;
+      int j2 = (i + 2) % 3;
+      this->inertiaInv[i][j] = (this->inertia[i1][j1] * this->inertia[i2][j2]
+          - this->inertia[i1][j2] * this->inertia[i2][j1]) / det;
+    }
+  }
+
+  this->controlled.assign(this->boat.surfaces.size(), false);
+  for (const auto &controller : this->boat.controllers)
+  {
+    if (controller.surface < this->controlled.size() &&
+        this->boat.surfaces[controller.surface].trimmable)
+    {
+      this->controlled[controller.surface] = true;
+    }
+  }
+  this->Reset();
+}
+
+/////////////////////////////////////////////////
+const Boat &FastSim::BoatModel() const
+{
+  return this->boat;
+}
+
+/////////////////////////////////////////////////
+const FastSimOptions &FastSim::Options() const
+{
+  return this->options;
+}
+
+/////////////////////////////////////////////////
+size_t FastSim::Size() const
+{
+  return this->count;
+}
+
+/////////////////////////////////////////////////
+double FastSim::Time() const
+{
+  return this->time;
+}
+
+/////////////////////////////////////////////////
+void FastSim::Reset()
+{
+  const size_t n = this->count;
+  const size_t surfaces = this->boat.surfaces.size();
+  const size_t controllers = this->boat.controllers.size();
+  this->time = 0.0;
+
+  auto com = this->boat.rotation.RotateVector(this->boat.hull.centreOfMass);
+  this->position.assign(n, this->boat.position + com);
+  this->velocity.assign(n, Vector3d());
+  this->rotation.assign(n, this->boat.rotation);
+  this->angularVelocity.assign(n, Vector3d());
+  this->jointPosition.assign(n * surfaces, 0.0);
+  this->jointVelocity.assign(n * surfaces, 0.0);
+
+  this->sailCommand.resize(n * controllers);
+  this->pid = PidArray();
+  this->winch = WinchArray();
+  for (size_t b = 0; b < n; ++b)
+  {
+    for (size_t j = 0; j < controllers; ++j)
+    {
+      const auto &c = this->boat.controllers[j];
+      this->sailCommand[b * controllers + j] = c.initialPosition;
+      this->pid.Add(c.p, c.i, c.d, c.iMax, c.iMin, c.cmdMax, c.cmdMin,
+          c.cmdOffset);
+      this->winch.Add(c.winchParams, c.initialPosition);
+    }
+  }
+
+  // Each boat has its own stream, starting from the stationary
+  // distribution of the gusts.
+  this->wind.assign(n, this->options.wind);
+  this->gustSpeed.resize(n);
+  this->gustDirection.resize(n);
+  this->rng.resize(n);
+  for (size_t b = 0; b < n; ++b)
+  {
+    uint64_t state = this->options.seed ^ (0xD1B54A32D192ED03ull * (b + 1));
+    this->rng[b] = SplitMix64(state);
+    this->gustSpeed[b] = this->options.gustIntensity * this->Normal(b);
+    this->gustDirection[b] =
+        this->options.directionDeviation * this->Normal(b);
+  }
+}
+
+/////////////////////////////////////////////////
+void FastSim::Step(size_t _steps, const Callback &_callback)
+{
+  if (this->count == 0 || _steps == 0)
+    return;
+
+  size_t threads = this->options.threads;
+  if (threads == 0)
+    threads = std::max(std::thread::hardware_concurrency(), 1u);
+  threads = std::min(threads, this->count);
+
+  // The boats are independent, so each thread steps a contiguous range
+  // of boats through every step.
+  const size_t chunk = (this->count + threads - 1) / threads;
+  std::vector<std::thread> pool;
+  for (size_t begin = chunk; begin < this->count; begin += chunk)
+  {
+    pool.emplace_back(&FastSim::StepRange, this, begin,
+        std::min(begin + chunk, this->count), _steps, std::cref(_callback));
+  }
+  this->StepRange(0, std::min(chunk, this->count), _steps, _callback);
+  for (auto &thread : pool)
+    thread.join();
+
+  this->time += _steps * this->options.stepSize;
+}
+
+/////////////////////////////////////////////////
+void FastSim::StepRange(size_t _begin, size_t _end, size_t _steps,
+    const Callback &_callback)
+{
+  for (size_t s = 0; s < _steps; ++s)
+  {
+    double t = this->time + s * this->options.stepSize;
+    for (size_t b = _begin; b < _end; ++b)
+    {
+      if (_callback)
+        _callback(*this, b, t);
+      this->StepBoat(b);
+      this->StepWind(b);
+    }
+  }
+}
+
+/////////////////////////////////////////////////
+void FastSim::StepBoat(size_t _boat)
+{
+  const double dt = this->options.stepSize;
+  const double g = this->options.gravity;
+  const auto &hull = this->boat.hull;
+  const size_t surfaces = this->boat.surfaces.size();
+  const size_t controllers = this->boat.controllers.size();
+
+  const auto rot = this->rotation[_boat];
+  const auto angVel = rot.RotateVector(this->angularVelocity[_boat]);
+  const auto com = rot.RotateVector(hull.centreOfMass);
+  const auto origin = this->position[_boat] - com;
+  const auto originVel = this->velocity[_boat] - angVel.Cross(com);
+  const auto windVel = this->Wind(_boat);
+  const Vector3d zero;
+
+  // Force, and torque about the body origin (world frame).
+  Vector3d force;
+  Vector3d torque;
+  for (size_t k = 0; k < surfaces; ++k)
+  {
+    const auto &surface = this->boat.surfaces[k];
+    const size_t js = _boat * surfaces + k;
+    double &theta = this->jointPosition[js];
+    Vector3d f;
+    Vector3d tau;
+    surface.AddWrench(theta, origin, rot, originVel, angVel,
+        surface.sail ? windVel : zero, f, tau);
+
+    if (this->controlled[k])
+    {
+      // Controllers act on the joint position at the start of the step,
+      // as the systems do before the physics update.
+      double u = 0.0;
+      for (size_t j = 0; j < controllers; ++j)
+      {
+        const auto &c = this->boat.controllers[j];
+        if (c.surface != k)
+          continue;
+        const size_t jc = _boat * controllers + j;
+        const double cmd = this->sailCommand[jc];
+        const double sgn = theta < 0.0 ? -1.0 : 1.0;
+        if (c.winch)
+        {
+          u += this->winch.Update(jc, cmd, theta, dt);
+        }
+        else
+        {
+          double cmdForce = this->pid.Update(jc, theta - sgn * cmd, dt);
+          if (cmdForce * sgn <= 0.0)
+            u += cmdForce;
+        }
+      }
+
+      // The sail turns freely on its joint under the aerodynamic torque
+      // about the axis, the controller and the damping, which is
+      // implicit since a light sail on a damped joint is stiff. The hull
+      // takes the rest of the wrench and the reaction of the joint.
+      auto axis = rot.RotateVector(surface.trimAxis);
+      auto axisOrigin = rot.RotateVector(surface.trimOrigin);
+      double aero = axis.Dot(tau - axisOrigin.Cross(f));
+      double &thetaDot = this->jointVelocity[js];
+      thetaDot = (thetaDot + dt * (aero + u) / surface.jointInertia) /
+          (1.0 + dt * surface.jointDamping / surface.jointInertia);
+      double drive = u - surface.jointDamping * thetaDot;
+      theta += dt * thetaDot;
+      if (theta < surface.trimMin || theta > surface.trimMax)
+      {
+        theta = std::clamp(theta, surface.trimMin, surface.trimMax);
+        thetaDot = 0.0;
+      }
+      tau -= (aero + drive) * axis;
+    }
+    force += f;
+    torque += tau;
+  }
+
+  // Hull resistance at the body origin, and damping.
+  auto originVelBody = rot.RotateVectorReverse(originVel);
+  force += rot.RotateVector(hull.Resistance(originVelBody));
+  torque += rot.RotateVector(Damping(hull.angularLinearDrag,
+      hull.angularQuadraticDrag, this->angularVelocity[_boat]));
+
+  // Linear hydrostatics about the floating equilibrium.
+  force.z -= hull.waterDensity * g * hull.waterplaneArea * origin.z;
+  auto up = rot.RotateVectorReverse(
+      rot.RotateVector(Vector3d(0.0, 0.0, 1.0)).Cross(
+          Vector3d(0.0, 0.0, 1.0)));
+  torque += rot.RotateVector(Vector3d(
+      hull.mass * g * hull.metacentricHeight * up.x,
+      hull.mass * g * hull.longitudinalMetacentricHeight * up.y, 0.0));
+
+  // Moorings, as the Mooring system.
+  for (const auto &mooring : this->boat.moorings)
+  {
+    auto arm = rot.RotateVector(mooring.attachment);
+    auto d = origin + arm - mooring.anchor;
+    double V = std::abs(d.z);
+    double H = std::sqrt(d.x * d.x + d.y * d.y);
+    double tr = 0.0;
+    double tz = 0.0;
+    CatenaryHSolver solver;
+    CatenaryTension(V, H, mooring.length, mooring.weightPerMetre, solver,
+        tr, tz);
+    double theta = std::atan2(d.y, d.x);
+    Vector3d f(tr * std::cos(theta), tr * std::sin(theta), tz);
+    if (!f.IsFinite())
+      continue;
+    force += f;
+    torque += arm.Cross(f);
+  }
+
+  // Semi-implicit Euler, with the rotation about the centre of mass.
+  this->velocity[_boat] += (dt / hull.mass) * force;
+  this->position[_boat] += dt * this->velocity[_boat];
+
+  auto &w = this->angularVelocity[_boat];
+  auto torqueBody = rot.RotateVectorReverse(torque - com.Cross(force));
+  auto gyro = w.Cross(Multiply(this->inertia, w));
+  w += dt * Multiply(this->inertiaInv, torqueBody - gyro);
+  this->rotation[_boat] = (rot * Quaterniond::FromAxisAngle(w,
+      w.Length() * dt)).Normalize();
+}
+
+/////////////////////////////////////////////////
+void FastSim::StepWind(size_t _boat)
+{
+  double a = 0.0;
+  if (this->options.gustTimeConstant > 0.0)
+  {
+    a = std::exp(-this->options.stepSize / this->options.gustTimeConstant);
+  }
+  double s = std::sqrt(1.0 - a * a);
+  this->gustSpeed[_boat] = a * this->gustSpeed[_boat] +
+      s * this->options.gustIntensity * this->Normal(_boat);
+  this->gustDirection[_boat] = a * this->gustDirection[_boat] +
+      s * this->options.directionDeviation * this->Normal(_boat);
+}
+
+/////////////////////////////////////////////////
+double FastSim::Normal(size_t _boat)
+{
+  // Box-Muller.
+  double u1 = Uniform(this->rng[_boat]);
+  double u2 = Uniform(this->rng[_boat]);
+  return std::sqrt(-2.0 * std::log(u1)) * std::cos(2.0 * M_PI * u2);
+}
+
+/////////////////////////////////////////////////
+void FastSim::SetPose(size_t _boat, const Vector3d &_position,
+    const Quaterniond &_rotation)
+{
+  this->rotation[_boat] = _rotation;
+  this->position[_boat] = _position +
+      _rotation.RotateVector(this->boat.hull.centreOfMass);
+}
+
+/////////////////////////////////////////////////
+void FastSim::SetVelocity(size_t _boat, const Vector3d &_linear,
+    const Vector3d &_angular)
+{
+  this->velocity[_boat] = _linear;
+  this->angularVelocity[_boat] =
+      this->rotation[_boat].RotateVectorReverse(_angular);
+}
+
+/////////////////////////////////////////////////
+void FastSim::SetWind(size_t _boat, const Vector3d &_wind)
+{
+  this->wind[_boat] = _wind;
+}
+
+/////////////////////////////////////////////////
+void FastSim::SetSailCommand(size_t _boat, size_t _controller,
+    double _command)
+{
+  this->sailCommand[_boat * this->boat.controllers.size() + _controller] =
+      _command;
+}
+
+/////////////////////////////////////////////////
+void FastSim::SetJointPosition(size_t _boat, size_t _surface,
+    double _position)
+{
+  const auto &surface = this->boat.surfaces[_surface];
+  if (!surface.trimmable)
+    return;
+  const size_t js = _boat * this->boat.surfaces.size() + _surface;
+  this->jointPosition[js] =
+      std::clamp(_position, surface.trimMin, surface.trimMax);
+  this->jointVelocity[js] = 0.0;
+}
+
+/////////////////////////////////////////////////
+Vector3d FastSim::Position(size_t _boat) const
+{
+  return this->position[_boat] -
+      this->rotation[_boat].RotateVector(this->boat.hull.centreOfMass);
+}
+
+/////////////////////////////////////////////////
+Quaterniond FastSim::Rotation(size_t _boat) const
+{
+  return this->rotation[_boat];
+}
+
+/////////////////////////////////////////////////
+Vector3d FastSim::LinearVelocity(size_t _boat) const
+{
+  return this->velocity[_boat];
+}
+
+/////////////////////////////////////////////////
+Vector3d FastSim::AngularVelocity(size_t _boat) const
+{
+  return this->rotation[_boat].RotateVector(this->angularVelocity[_boat]);
+}
+
+/////////////////////////////////////////////////
+Vector3d FastSim::Wind(size_t _boat) const
+{
+  const auto &mean = this->wind[_boat];
+  double speed = mean.Length();
+  if (speed <= 0.0)
+    return mean;
+  double scale = std::max(speed + this->gustSpeed[_boat], 0.0) / speed;
+  double c = std::cos(this->gustDirection[_boat]);
+  double s = std::sin(this->gustDirection[_boat]);
+  return Vector3d(scale * (c * mean.x - s * mean.y),
+      scale * (s * mean.x + c * mean.y), scale * mean.z);
+}
+
+/////////////////////////////////////////////////
+double FastSim::JointPosition(size_t _boat, size_t _surface) const
+{
+  return this->jointPosition[_boat * this->boat.surfaces.size() + _surface];
+}
+
+}  // namespace core
+}  // namespace asv
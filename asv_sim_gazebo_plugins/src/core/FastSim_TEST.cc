@@ -0,0 +1,198 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+#include "asv/core/FastSim.hh"
+
+#include "TestBoat.hh"
+
+/////////////////////////////////////////////////
+/// \brief The test boat with its sail on a joint with a sheet controller,
+/// and the hull terms of the 6-DOF model.
+asv::core::Boat SimBoat()
+{
+    auto boat = MakeBoat();
+
+    auto &sail = boat.surfaces[0];
+    sail.panels[0].cp = asv::core::Vector3d(-0.5, 0.0, 0.5);
+    sail.jointInertia = 2.0;
+    sail.jointDamping = 5.0;
+
+    asv::core::BoatSailController controller;
+    controller.surface = 0;
+    controller.p = 100.0;
+    controller.initialPosition = 0.5;
+    boat.controllers.push_back(controller);
+
+    auto &hull = boat.hull;
+    hull.inertia = asv::core::Vector3d(100.0, 300.0, 300.0);
+    hull.waterplaneArea = 4.0;
+    hull.longitudinalMetacentricHeight = 5.0;
+    hull.linearDrag = asv::core::Vector3d(10.0, 50.0, 500.0);
+    hull.angularLinearDrag = asv::core::Vector3d(200.0, 500.0, 200.0);
+    return boat;
+}
+
+/////////////////////////////////////////////////
+/// \brief The state of every boat.
+std::vector<double> State(const asv::core::FastSim &_sim)
+{
+    std::vector<double> state;
+    for (size_t b = 0; b < _sim.Size(); ++b)
+    {
+      auto p = _sim.Position(b);
+      auto q = _sim.Rotation(b);
+      state.insert(state.end(),
+          {p.x, p.y, p.z, q.w, q.x, q.y, q.z, _sim.JointPosition(b, 0)});
+    }
+    return state;
+}
+
+/////////////////////////////////////////////////
+TEST(FastSim, Determinism)
+{
+    asv::core::FastSimOptions options;
+    options.wind = asv::core::Vector3d(0.0, -5.0, 0.0);
+    options.gustIntensity = 1.0;
+    options.directionDeviation = 0.2;
+    options.gustTimeConstant = 2.0;
+    options.seed = 42;
+
+    options.threads = 1;
+    asv::core::FastSim serial(SimBoat(), 7, options);
+    serial.Step(400);
+    auto expected = State(serial);
+    EXPECT_NEAR(serial.Time(), 2.0, 1.0E-12);
+
+    // The same whatever the number of threads.
+    options.threads = 3;
+    asv::core::FastSim parallel(SimBoat(), 7, options);
+    parallel.Step(150);
+    parallel.Step(250);
+    EXPECT_EQ(State(parallel), expected);
+
+    // The same after a reset.
+    parallel.Reset();
+    EXPECT_DOUBLE_EQ(parallel.Time(), 0.0);
+    parallel.Step(400);
+    EXPECT_EQ(State(parallel), expected);
+
+    // Each boat has its own gusts.
+    EXPECT_NE(serial.Wind(0).x, serial.Wind(1).x);
+
+    // Another seed gives other gusts.
+    options.seed = 43;
+    asv::core::FastSim other(SimBoat(), 7, options);
+    other.Step(400);
+    EXPECT_NE(State(other), expected);
+}
+
+/////////////////////////////////////////////////
+TEST(FastSim, Sailing)
+{
+    // Wind from port, on the beam.
+    asv::core::FastSimOptions options;
+    options.wind = asv::core::Vector3d(0.0, -5.0, 0.0);
+    asv::core::FastSim sim(SimBoat(), 2, options);
+
+    // The callback eases the sheet of the second boat.
+    sim.Step(6000, [](asv::core::FastSim &_sim, size_t _boat, double)
+    {
+      if (_boat == 1)
+        _sim.SetSailCommand(_boat, 0, 1.0);
+    });
+    EXPECT_NEAR(sim.Time(), 30.0, 1.0E-9);
+
+    // With no rudder the boat rounds up towards the wind. It sails
+    // forward, heeled and slipping to starboard, and floats at the
+    // waterline.
+    auto rotation = sim.Rotation(0);
+    auto xb = rotation.RotateVector(asv::core::Vector3d(1, 0, 0));
+    EXPECT_GT(std::atan2(xb.y, xb.x), 0.1);
+    auto velocity = rotation.RotateVectorReverse(sim.LinearVelocity(0));
+    EXPECT_GT(velocity.x, 0.3);
+    EXPECT_LT(velocity.y, 0.0);
+    auto zb = rotation.RotateVector(asv::core::Vector3d(0, 0, 1));
+    EXPECT_LT(zb.y, 0.0);
+    EXPECT_GT(zb.z, 0.9);
+    EXPECT_NEAR(sim.Position(0).z, 0.0, 0.05);
+
+    // The sail is out to starboard, held by the sheet near the
+    // command, and further out when the sheet is eased.
+    double eased = sim.JointPosition(1, 0);
+    EXPECT_GT(sim.JointPosition(0, 0), 0.45);
+    EXPECT_LT(sim.JointPosition(0, 0), 0.8);
+    EXPECT_GT(eased, sim.JointPosition(0, 0) + 0.2);
+    EXPECT_LT(eased, 1.2);
+
+    // The keel has no joint.
+    sim.SetJointPosition(0, 1, 0.3);
+    EXPECT_DOUBLE_EQ(sim.JointPosition(0, 1), 0.0);
+}
+
+/////////////////////////////////////////////////
+TEST(FastSim, Hydrostatics)
+{
+    asv::core::FastSim sim(SimBoat(), 1);
+    sim.SetPose(0, asv::core::Vector3d(0.0, 0.0, 0.2),
+        asv::core::Quaterniond::FromEuler(0.3, 0.05, 0.0));
+    sim.Step(6000);
+
+    // Heave, roll and pitch are restored.
+    auto zb = sim.Rotation(0).RotateVector(asv::core::Vector3d(0, 0, 1));
+    EXPECT_NEAR(zb.z, 1.0, 1.0E-4);
+    EXPECT_NEAR(sim.Position(0).z, 0.0, 1.0E-3);
+}
+
+/////////////////////////////////////////////////
+TEST(FastSim, Mooring)
+{
+    auto boat = SimBoat();
+    asv::core::BoatMooring mooring;
+    mooring.anchor = asv::core::Vector3d(0.0, 0.0, -10.0);
+    mooring.length = 20.0;
+    mooring.weightPerMetre = 9.81 * 2.0;
+    boat.moorings.push_back(mooring);
+
+    // Slack: the chain hangs from the boat.
+    asv::core::FastSim slack(boat, 1);
+    slack.SetPose(0, asv::core::Vector3d(5.0, 0.0, 0.0),
+        asv::core::Quaterniond());
+    slack.Step(1);
+    EXPECT_DOUBLE_EQ(slack.LinearVelocity(0).x, 0.0);
+    EXPECT_LT(slack.LinearVelocity(0).z, 0.0);
+
+    // Taut: the chain pulls the boat back towards the anchor.
+    asv::core::FastSim taut(boat, 1);
+    taut.SetPose(0, asv::core::Vector3d(15.0, 0.0, 0.0),
+        asv::core::Quaterniond());
+    taut.Step(200);
+    EXPECT_LT(taut.LinearVelocity(0).x, 0.0);
+    EXPECT_NEAR(taut.LinearVelocity(0).y, 0.0, 1.0E-12);
+    EXPECT_LT(taut.Position(0).x, 15.0);
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,790 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "asv/core/LiftDragCalibration.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+namespace asv
+{
+namespace core
+{
+namespace
+{
+/// \brief Number of samples in a block of the normal equations.
+constexpr size_t kBlock = 256;
+
+/// \brief Number of fitted parameters.
+constexpr size_t kParams = 5;
+
+/// \brief Size of the blocks read by CsvCalibrationSource.
+constexpr size_t kFileBuffer = 1 << 20;
+
+/////////////////////////////////////////////////
+/// \brief Cholesky decomposition of a symmetric positive definite
+/// matrix, row major, in place in its lower triangle.
+/// \return False if the matrix is not positive definite.
+bool Cholesky(std::array<double, kParams * kParams> &_a, size_t _n)
+{
+  for (size_t j = 0; j < _n; ++j)
+  {
+    double d = _a[j * _n + j];
+    for (size_t k = 0; k < j; ++k)
+      d -= _a[j * _n + k] * _a[j * _n + k];
+    if (!(d > 0.0))
+      return false;
+    d = std::sqrt(d);
+    _a[j * _n + j] = d;
+    for (size_t i = j + 1; i < _n; ++i)
+    {
+      double v = _a[i * _n + j];
+      for (size_t k = 0; k < j; ++k)
+        v -= _a[i * _n + k] * _a[j * _n + k];
+      _a[i * _n + j] = v / d;
+    }
+  }
+  return true;
+}
+
+/////////////////////////////////////////////////
+/// \brief Solve with a Cholesky decomposition, in place.
+void CholeskySolve(const std::array<double, kParams * kParams> &_l,
+    size_t _n, std::array<double, kParams> &_b)
+{
+  for (size_t i = 0; i < _n; ++i)
+  {
+    for (size_t k = 0; k < i; ++k)
+      _b[i] -= _l[i * _n + k] * _b[k];
+    _b[i] /= _l[i * _n + i];
+  }
+  for (size_t i = _n; i-- > 0;)
+  {
+    for (size_t k = i + 1; k < _n; ++k)
+      _b[i] -= _l[k * _n + i] * _b[k];
+    _b[i] /= _l[i * _n + i];
+  }
+}
+}  // namespace
+
+/////////////////////////////////////////////////
+CsvCalibrationSource::CsvCalibrationSource(size_t _threads)
+  : threads(_threads)
+{
+  if (this->threads == 0)
+    this->threads = std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+/////////////////////////////////////////////////
+bool CsvCalibrationSource::Open(const std::string &_filename)
+{
+  this->file = std::ifstream(_filename, std::ios::binary);
+  std::string header;
+  if (!this->file || !std::getline(this->file, header))
+    return false;
+
+  this->fields.clear();
+  std::array<bool, 6> found{};
+  size_t begin = 0;
+  while (begin <= header.size())
+  {
+    size_t end = std::min(header.find(',', begin), header.size());
+    std::string name = header.substr(begin, end - begin);
+    name.erase(std::remove_if(name.begin(), name.end(),
+        [](unsigned char _c) { return std::isspace(_c); }), name.end());
+    int field = -1;
+    for (size_t j = 0; j < kColumnNames.size(); ++j)
+    {
+      if (name == kColumnNames[j] && !found[j])
+      {
+        field = static_cast<int>(j);
+        found[j] = true;
+      }
+    }
+    this->fields.push_back(field);
+    begin = end + 1;
+  }
+  if (std::find(found.begin(), found.end(), false) != found.end())
+    return false;
+
+  this->start = this->file.tellg();
+  return this->Rewind();
+}
+
+/////////////////////////////////////////////////
+bool CsvCalibrationSource::Rewind()
+{
+  if (!this->file.is_open())
+    return false;
+  this->file.clear();
+  this->file.seekg(this->start);
+  this->eof = false;
+  this->pos = 0;
+  this->size = 0;
+  this->skipped = 0;
+  return static_cast<bool>(this->file);
+}
+
+/////////////////////////////////////////////////
+int CsvCalibrationSource::Parse(const char *_begin, const char *_end,
+    CalibrationSample &_sample) const
+{
+  auto blank = [](char _c)
+  {
+    return _c == ' ' || _c == '\t' || _c == '\r';
+  };
+  const char *p = _begin;
+  while (p != _end && blank(*p))
+    ++p;
+  if (p == _end || *p == '#')
+    return 0;
+
+  double values[6];
+  size_t found = 0;
+  for (size_t column = 0; ; ++column)
+  {
+    const char *comma = std::find(p, _end, ',');
+    int field = column < this->fields.size() ? this->fields[column] : -1;
+    if (field >= 0)
+    {
+      while (p != comma && blank(*p))
+        ++p;
+      auto [end, ec] = std::from_chars(p, comma, values[field]);
+      while (end != comma && blank(*end))
+        ++end;
+      if (ec != std::errc() || end != comma)
+        return 2;
+      ++found;
+    }
+    if (comma == _end)
+      break;
+    p = comma + 1;
+  }
+  if (found != kColumnNames.size())
+    return 2;
+
+  _sample.aws = values[0];
+  _sample.awa = values[1];
+  _sample.heel = values[2];
+  _sample.trim = values[3];
+  _sample.ax = values[4];
+  _sample.ay = values[5];
+  return 1;
+}
+
+/////////////////////////////////////////////////
+size_t CsvCalibrationSource::Read(CalibrationSample *_samples,
+    size_t _count)
+{
+  size_t n = 0;
+  while (n < _count)
+  {
+    // Move the unread text to the start of the buffer, then find the
+    // lines, reading more of the file as needed.
+    std::copy(this->text.begin() + this->pos,
+        this->text.begin() + this->size, this->text.begin());
+    this->size -= this->pos;
+    this->pos = 0;
+    this->lines.clear();
+    while (this->lines.size() < _count - n)
+    {
+      const char *data = this->text.data();
+      const void *newline = this->pos < this->size ?
+          std::memchr(data + this->pos, '\n', this->size - this->pos) :
+          nullptr;
+      if (newline)
+      {
+        size_t end = static_cast<const char *>(newline) - data;
+        this->lines.emplace_back(this->pos, end);
+        this->pos = end + 1;
+      }
+      else if (!this->eof)
+      {
+        if (this->text.size() < this->size + kFileBuffer)
+          this->text.resize(this->size + kFileBuffer);
+        this->file.read(this->text.data() + this->size, kFileBuffer);
+        size_t read = static_cast<size_t>(this->file.gcount());
+        this->size += read;
+        this->eof = read < kFileBuffer;
+      }
+      else
+      {
+        // The last line has no newline.
+        if (this->pos < this->size)
+          this->lines.emplace_back(this->pos, this->size);
+        this->pos = this->size;
+        break;
+      }
+    }
+    const size_t count = this->lines.size();
+    if (count == 0)
+      break;
+
+    // Parse the lines in place on a thread pool, then remove the lines
+    // that are not samples.
+    CalibrationSample *samples = _samples + n;
+    this->status.assign(count, 0);
+    auto work = [&](size_t _begin, size_t _end)
+    {
+      const char *data = this->text.data();
+      for (size_t i = _begin; i < _end; ++i)
+      {
+        this->status[i] = this->Parse(data + this->lines[i].first,
+            data + this->lines[i].second, samples[i]);
+      }
+    };
+    const size_t threads = std::max<size_t>(
+        std::min(this->threads, count / kBlock), 1);
+    std::vector<std::thread> pool;
+    for (size_t t = 1; t < threads; ++t)
+    {
+      pool.emplace_back(work, t * count / threads,
+          (t + 1) * count / threads);
+    }
+    work(0, count / threads);
+    for (auto &thread : pool)
+      thread.join();
+
+    for (size_t i = 0; i < count; ++i)
+    {
+      if (this->status[i] == 1)
+        _samples[n++] = samples[i];
+      else if (this->status[i] == 2)
+        ++this->skipped;
+    }
+  }
+  return n;
+}
+
+/////////////////////////////////////////////////
+size_t CsvCalibrationSource::Skipped() const
+{
+  return this->skipped;
+}
+
+/////////////////////////////////////////////////
+struct LiftDragCalibration::Normal
+{
+  /// \brief The upper triangle of the transpose of the Jacobian times
+  /// the Jacobian, row major.
+  std::array<double, kParams * kParams> jtj{};
+
+  /// \brief The transpose of the Jacobian times the residuals.
+  std::array<double, kParams> jtr{};
+
+  /// \brief Sum of the squared residuals.
+  double sse = 0.0;
+
+  /// \brief Sums and sums of squares of the measured x and y forces.
+  std::array<double, 2> sum{};
+  std::array<double, 2> squares{};
+
+  /// \brief Number of samples.
+  size_t count = 0;
+
+  /// \brief Add another set of samples.
+  void Add(const Normal &_other)
+  {
+    for (size_t j = 0; j < this->jtj.size(); ++j)
+      this->jtj[j] += _other.jtj[j];
+    for (size_t j = 0; j < kParams; ++j)
+      this->jtr[j] += _other.jtr[j];
+    this->sse += _other.sse;
+    for (size_t c = 0; c < 2; ++c)
+    {
+      this->sum[c] += _other.sum[c];
+      this->squares[c] += _other.squares[c];
+    }
+    this->count += _other.count;
+  }
+};
+
+/////////////////////////////////////////////////
+struct LiftDragCalibration::Scratch
+{
+  /// \brief Angle of attack, dynamic pressure times panel area, and the
+  /// lift direction signed by the angle of attack and drag direction
+  /// (body x and y), of each sample and panel, sample major.
+  std::vector<double> alpha;
+  std::vector<double> weight;
+  std::vector<double> liftX;
+  std::vector<double> liftY;
+  std::vector<double> dragX;
+  std::vector<double> dragY;
+
+  /// \brief Make space for a number of samples and panels.
+  void Resize(size_t _size)
+  {
+    for (auto *v : {&this->alpha, &this->weight, &this->liftX,
+        &this->liftY, &this->dragX, &this->dragY})
+    {
+      v->resize(_size);
+    }
+  }
+};
+
+/////////////////////////////////////////////////
+double LiftDragCalibration::Param(const LiftDragParams &_params,
+    size_t _index)
+{
+  switch (_index)
+  {
+    case 0: return _params.alpha0;
+    case 1: return _params.cla;
+    case 2: return _params.alphaStall;
+    case 3: return _params.claStall;
+    default: return _params.cda;
+  }
+}
+
+/////////////////////////////////////////////////
+void LiftDragCalibration::SetParam(LiftDragParams &_params, size_t _index,
+    double _value)
+{
+  switch (_index)
+  {
+    case 0: _params.alpha0 = _value; break;
+    case 1: _params.cla = _value; break;
+    case 2: _params.alphaStall = _value; break;
+    case 3: _params.claStall = _value; break;
+    default: _params.cda = _value; break;
+  }
+}
+
+/////////////////////////////////////////////////
+LiftDragCalibration::LiftDragCalibration(const BoatSurface &_sail,
+    double _mass, const LiftDragCalibrationOptions &_options)
+  : sail(_sail), mass(_mass), options(_options)
+{
+  const auto axis = this->sail.trimAxis.Normalized();
+  auto split = [&](const Vector3d &_v, std::vector<Vector3d> &_parallel,
+      std::vector<Vector3d> &_perpendicular, std::vector<Vector3d> &_cross)
+  {
+    auto parallel = axis.Dot(_v) * axis;
+    _parallel.push_back(parallel);
+    _perpendicular.push_back(_v - parallel);
+    _cross.push_back(axis.Cross(_v));
+  };
+
+  for (const auto &panel : this->sail.panels)
+  {
+    auto rot = this->sail.rotation * panel.twist;
+    auto cp = this->sail.position + this->sail.rotation.RotateVector(
+        panel.cp) - this->sail.trimOrigin;
+    split(cp, this->cpParallel, this->cpPerpendicular, this->cpCross);
+    split(rot.RotateVector(this->sail.params.forward),
+        this->forwardParallel, this->forwardPerpendicular,
+        this->forwardCross);
+    split(rot.RotateVector(this->sail.params.upward),
+        this->upwardParallel, this->upwardPerpendicular,
+        this->upwardCross);
+  }
+}
+
+/////////////////////////////////////////////////
+const BoatSurface &LiftDragCalibration::Sail() const
+{
+  return this->sail;
+}
+
+/////////////////////////////////////////////////
+const LiftDragCalibrationOptions &LiftDragCalibration::Options() const
+{
+  return this->options;
+}
+
+/////////////////////////////////////////////////
+void LiftDragCalibration::Geometry(const CalibrationSample *_samples,
+    size_t _count, Scratch &_scratch) const
+{
+  const size_t panels = this->sail.panels.size();
+  const double density = this->sail.params.fluidDensity;
+  for (size_t i = 0; i < _count; ++i)
+  {
+    const auto &sample = _samples[i];
+    const double trim = this->sail.trimmable ? sample.trim : 0.0;
+    const double c = std::cos(trim);
+    const double s = std::sin(trim);
+    const double ch = std::cos(sample.heel);
+    const double sh = std::sin(sample.heel);
+
+    // The wind is horizontal, so in the heeled body frame it is rotated
+    // about the x axis by minus the heel.
+    const double windY = -sample.aws * std::sin(sample.awa);
+    const Vector3d wind(-sample.aws * std::cos(sample.awa), ch * windY,
+        -sh * windY);
+
+    for (size_t k = 0; k < panels; ++k)
+    {
+      const size_t m = i * panels + k;
+      _scratch.weight[m] = 0.0;
+      _scratch.alpha[m] = 0.0;
+      _scratch.liftX[m] = 0.0;
+      _scratch.liftY[m] = 0.0;
+      _scratch.dragX[m] = 0.0;
+      _scratch.dragY[m] = 0.0;
+
+      // The geometry of ComputeLiftDrag, with the height of the centre
+      // of pressure above the waterline for the wind shear.
+      auto cp = this->sail.trimOrigin + this->cpParallel[k] +
+          c * this->cpPerpendicular[k] + s * this->cpCross[k];
+      auto forwardI = this->forwardParallel[k] +
+          c * this->forwardPerpendicular[k] + s * this->forwardCross[k];
+      auto upwardI = this->upwardParallel[k] +
+          c * this->upwardPerpendicular[k] + s * this->upwardCross[k];
+      auto velU = this->sail.WindShearFactor(sh * cp.y + ch * cp.z) * wind;
+      if (velU.Length() <= 0.01)
+        continue;
+
+      auto spanI = forwardI.Cross(upwardI).Normalize();
+      auto velLD = velU - velU.Dot(spanI) * spanI;
+      auto dragUnit = velLD.Normalized();
+      auto liftUnit = dragUnit.Cross(spanI).Normalize();
+      double sgnAlpha = forwardI.Dot(liftUnit) < 0 ? -1.0 : 1.0;
+      double a = std::acos(-forwardI.Dot(dragUnit));
+      double u = velLD.Length();
+      double w = 0.5 * density * u * u * this->sail.panels[k].area;
+      if (!std::isfinite(a) || !std::isfinite(w) ||
+          !liftUnit.IsFinite() || !dragUnit.IsFinite())
+      {
+        continue;
+      }
+
+      _scratch.alpha[m] = a;
+      _scratch.weight[m] = w;
+      _scratch.liftX[m] = sgnAlpha * liftUnit.x;
+      _scratch.liftY[m] = sgnAlpha * liftUnit.y;
+      _scratch.dragX[m] = dragUnit.x;
+      _scratch.dragY[m] = dragUnit.y;
+    }
+  }
+}
+
+/////////////////////////////////////////////////
+void LiftDragCalibration::Force(const LiftDragParams &_params,
+    const Scratch &_scratch, size_t _sample, double _force[2],
+    double _jacobian[2][5]) const
+{
+  const size_t panels = this->sail.panels.size();
+  const double a0 = _params.alpha0;
+  const double cla = _params.cla;
+  const double alphaStall = _params.alphaStall;
+  const double claStall = _params.claStall;
+  const double cda = _params.cda;
+
+  _force[0] = 0.0;
+  _force[1] = 0.0;
+  for (size_t j = 0; j < kParams; ++j)
+  {
+    _jacobian[0][j] = 0.0;
+    _jacobian[1][j] = 0.0;
+  }
+
+  const size_t begin = _sample * panels;
+  for (size_t m = begin; m < begin + panels; ++m)
+  {
+    const double w = _scratch.weight[m];
+    if (w == 0.0)
+      continue;
+
+    // LiftCoefficient and DragCoefficient, and their derivatives with
+    // respect to a0, cla, alpha_stall, cla_stall and cda. Both are
+    // symmetric about alpha = pi/2, and lift changes sign.
+    const double alpha = _scratch.alpha[m];
+    const bool back = alpha >= M_PI / 2.0;
+    const double x = back ? M_PI - alpha : alpha;
+    const double sign = back ? -1.0 : 1.0;
+    double cl;
+    double dcl[4];
+    if (x < alphaStall)
+    {
+      cl = sign * cla * (x - a0);
+      dcl[0] = -sign * cla;
+      dcl[1] = sign * (x - a0);
+      dcl[2] = 0.0;
+      dcl[3] = 0.0;
+    }
+    else
+    {
+      cl = sign * (claStall * (x - alphaStall) + cla * (alphaStall - a0));
+      dcl[0] = -sign * cla;
+      dcl[1] = sign * (alphaStall - a0);
+      dcl[2] = sign * (cla - claStall);
+      dcl[3] = sign * (x - alphaStall);
+    }
+    const double cd = cda * x;
+
+    const double lx = w * _scratch.liftX[m];
+    const double ly = w * _scratch.liftY[m];
+    const double dx = w * _scratch.dragX[m];
+    const double dy = w * _scratch.dragY[m];
+    _force[0] += cl * lx + cd * dx;
+    _force[1] += cl * ly + cd * dy;
+    for (size_t j = 0; j < 4; ++j)
+    {
+      _jacobian[0][j] += dcl[j] * lx;
+      _jacobian[1][j] += dcl[j] * ly;
+    }
+    _jacobian[0][4] += x * dx;
+    _jacobian[1][4] += x * dy;
+  }
+}
+
+/////////////////////////////////////////////////
+void LiftDragCalibration::Evaluate(const LiftDragParams &_params,
+    const CalibrationSample *_samples, size_t _count, double *_force,
+    double *_jacobian) const
+{
+  Scratch scratch;
+  scratch.Resize(kBlock * this->sail.panels.size());
+  for (size_t begin = 0; begin < _count; begin += kBlock)
+  {
+    const size_t n = std::min(kBlock, _count - begin);
+    this->Geometry(_samples + begin, n, scratch);
+    for (size_t i = 0; i < n; ++i)
+    {
+      double force[2];
+      double jacobian[2][5];
+      this->Force(_params, scratch, i, force, jacobian);
+      const size_t s = begin + i;
+      _force[2 * s] = force[0];
+      _force[2 * s + 1] = force[1];
+      if (_jacobian)
+      {
+        std::copy(&jacobian[0][0], &jacobian[0][0] + 2 * kParams,
+            _jacobian + 2 * kParams * s);
+      }
+    }
+  }
+}
+
+/////////////////////////////////////////////////
+void LiftDragCalibration::Accumulate(const LiftDragParams &_params,
+    const CalibrationSample *_samples, size_t _count, Scratch &_scratch,
+    Normal &_normal) const
+{
+  const auto &fit = this->options.fit;
+  this->Geometry(_samples, _count, _scratch);
+  for (size_t i = 0; i < _count; ++i)
+  {
+    double force[2];
+    double jacobian[2][5];
+    this->Force(_params, _scratch, i, force, jacobian);
+    const double measured[2] = {
+        this->mass * _samples[i].ax, this->mass * _samples[i].ay};
+    for (size_t c = 0; c < 2; ++c)
+    {
+      const double r = force[c] - measured[c];
+      for (size_t a = 0; a < kParams; ++a)
+      {
+        if (!fit[a])
+          continue;
+        _normal.jtr[a] += jacobian[c][a] * r;
+        for (size_t b = a; b < kParams; ++b)
+          _normal.jtj[a * kParams + b] += jacobian[c][a] * jacobian[c][b];
+      }
+      _normal.sse += r * r;
+      _normal.sum[c] += measured[c];
+      _normal.squares[c] += measured[c] * measured[c];
+    }
+  }
+  _normal.count += _count;
+}
+
+/////////////////////////////////////////////////
+bool LiftDragCalibration::Pass(CalibrationSource &_source,
+    const LiftDragParams &_params, Normal &_normal) const
+{
+  _normal = Normal();
+  if (!_source.Rewind())
+    return false;
+
+  size_t threads = this->options.threads;
+  if (threads == 0)
+    threads = std::max(std::thread::hardware_concurrency(), 1u);
+  const size_t chunk = std::max<size_t>(this->options.chunkSize, 1);
+  threads = std::max<size_t>(
+      std::min(threads, (chunk + kBlock - 1) / kBlock), 1);
+
+  std::vector<CalibrationSample> buffers[2];
+  buffers[0].resize(chunk);
+  buffers[1].resize(chunk);
+  std::vector<Scratch> scratch(threads);
+  for (auto &s : scratch)
+    s.Resize(kBlock * this->sail.panels.size());
+  std::vector<Normal> blocks;
+
+  size_t current = 0;
+  size_t count = _source.Read(buffers[current].data(), chunk);
+  while (count > 0)
+  {
+    // Each thread takes blocks of the chunk, with their own normal
+    // equations that are summed in order at the end.
+    const CalibrationSample *samples = buffers[current].data();
+    const size_t blockCount = (count + kBlock - 1) / kBlock;
+    blocks.assign(blockCount, Normal());
+    std::atomic<size_t> next{0};
+    auto work = [&](size_t _thread)
+    {
+      for (size_t b = next++; b < blockCount; b = next++)
+      {
+        const size_t begin = b * kBlock;
+        this->Accumulate(_params, samples + begin,
+            std::min(kBlock, count - begin), scratch[_thread], blocks[b]);
+      }
+    };
+
+    std::vector<std::thread> pool;
+    for (size_t t = 1; t < threads; ++t)
+      pool.emplace_back(work, t);
+
+    // Read the next chunk while the pool works on this one.
+    const size_t nextCount = _source.Read(buffers[1 - current].data(),
+        chunk);
+    work(0);
+    for (auto &thread : pool)
+      thread.join();
+
+    for (const auto &block : blocks)
+      _normal.Add(block);
+    current = 1 - current;
+    count = nextCount;
+  }
+  return true;
+}
+
+/////////////////////////////////////////////////
+LiftDragCalibrationResult LiftDragCalibration::Calibrate(
+    CalibrationSource &_source, const LiftDragParams &_initial) const
+{
+  LiftDragCalibrationResult result;
+  result.params = _initial;
+
+  std::array<size_t, kParams> free{};
+  size_t n = 0;
+  for (size_t j = 0; j < kParams; ++j)
+  {
+    if (this->options.fit[j])
+      free[n++] = j;
+  }
+  auto jtj = [&](const Normal &_normal, size_t _r, size_t _c)
+  {
+    size_t a = std::min(free[_r], free[_c]);
+    size_t b = std::max(free[_r], free[_c]);
+    return _normal.jtj[a * kParams + b];
+  };
+
+  Normal current;
+  if (!this->Pass(_source, result.params, current))
+    return result;
+  result.passes = 1;
+  result.samples = current.count;
+  if (current.count == 0)
+    return result;
+
+  const double tol = this->options.tolerance;
+  double lambda = this->options.lambda;
+  result.converged = n == 0 || current.sse == 0.0;
+  while (!result.converged &&
+      result.iterations < this->options.maxIterations)
+  {
+    ++result.iterations;
+
+    // The damped normal equations of the free parameters.
+    std::array<double, kParams * kParams> a{};
+    std::array<double, kParams> step{};
+    for (size_t r = 0; r < n; ++r)
+    {
+      for (size_t c = 0; c < n; ++c)
+        a[r * n + c] = jtj(current, r, c);
+      a[r * n + r] += lambda * std::max(a[r * n + r], 1.0e-12);
+      step[r] = -current.jtr[free[r]];
+    }
+    if (!Cholesky(a, n))
+    {
+      lambda *= 10.0;
+      continue;
+    }
+    CholeskySolve(a, n, step);
+
+    auto trial = result.params;
+    bool small = true;
+    for (size_t r = 0; r < n; ++r)
+    {
+      double value = Param(result.params, free[r]);
+      SetParam(trial, free[r], value + step[r]);
+      small = small && std::abs(step[r]) <= tol * (std::abs(value) + tol);
+    }
+    // Keep the stall within the range of the model.
+    trial.alphaStall = std::clamp(trial.alphaStall, 1.0e-6, M_PI / 2.0);
+
+    Normal next;
+    if (!this->Pass(_source, trial, next))
+      return result;
+    ++result.passes;
+
+    if (next.sse < current.sse)
+    {
+      const bool flat = current.sse - next.sse <= tol * current.sse;
+      result.params = trial;
+      current = next;
+      lambda = std::max(lambda / 10.0, 1.0e-12);
+      result.converged = small || flat || current.sse == 0.0;
+    }
+    else
+    {
+      result.converged = small;
+      lambda *= 10.0;
+    }
+  }
+
+  // The fit, and the covariance of the parameters from the undamped
+  // normal equations.
+  const double count = static_cast<double>(current.count);
+  double sst = 0.0;
+  for (size_t c = 0; c < 2; ++c)
+    sst += current.squares[c] - current.sum[c] * current.sum[c] / count;
+  result.rms = std::sqrt(current.sse / (2.0 * count));
+  result.r2 = sst > 0.0 ? 1.0 - current.sse / sst :
+      (current.sse > 0.0 ? 0.0 : 1.0);
+
+  std::array<double, kParams * kParams> l{};
+  for (size_t r = 0; r < n; ++r)
+  {
+    for (size_t c = 0; c < n; ++c)
+      l[r * n + c] = jtj(current, r, c);
+  }
+  const double dof = 2.0 * count - static_cast<double>(n);
+  if (n > 0 && dof > 0.0 && Cholesky(l, n))
+  {
+    const double variance = current.sse / dof;
+    for (size_t r = 0; r < n; ++r)
+    {
+      std::array<double, kParams> e{};
+      e[r] = 1.0;
+      CholeskySolve(l, n, e);
+      result.stddev[free[r]] = std::sqrt(variance * e[r]);
+    }
+  }
+  return result;
+}
+
+}  // namespace core
+}  // namespace asv
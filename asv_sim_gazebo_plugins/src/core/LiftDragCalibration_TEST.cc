@@ -0,0 +1,332 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "asv/core/LiftDragCalibration.hh"
+
+#include "TestBoat.hh"
+
+/////////////////////////////////////////////////
+/// \brief The parameters the samples are made with.
+asv::core::LiftDragParams MakeTruth()
+{
+    auto params = MakeSail().params;
+    params.alpha0 = 0.05;
+    params.cla = 5.5;
+    params.alphaStall = 0.2;
+    params.claStall = -1.2;
+    params.cda = 0.9;
+    return params;
+}
+
+/////////////////////////////////////////////////
+/// \brief Samples over a range of winds, heels and trims, with the
+/// sail to leeward, without the accelerations.
+std::vector<asv::core::CalibrationSample> MakeSamples(size_t _count)
+{
+    std::vector<asv::core::CalibrationSample> samples(_count);
+    for (size_t i = 0; i < _count; ++i)
+    {
+      auto &sample = samples[i];
+      double side = i % 2 == 0 ? 1.0 : -1.0;
+      sample.aws = 3.0 + 6.0 * (0.5 + 0.5 * std::sin(0.37 * i));
+      sample.awa = side * (0.4 + 2.4 * (0.5 + 0.5 * std::sin(0.91 * i)));
+      sample.heel = side * 0.3 * (0.5 + 0.5 * std::sin(1.3 * i));
+      sample.trim = -side * (0.1 + 1.2 * (0.5 + 0.5 * std::sin(0.53 * i)));
+    }
+    return samples;
+}
+
+/////////////////////////////////////////////////
+/// \brief Set the accelerations to those of the forces of some
+/// parameters.
+void SetAccelerations(const asv::core::LiftDragCalibration &_calibration,
+    const asv::core::LiftDragParams &_params, double _mass,
+    std::vector<asv::core::CalibrationSample> &_samples)
+{
+    std::vector<double> force(2 * _samples.size());
+    _calibration.Evaluate(_params, _samples.data(), _samples.size(),
+        force.data());
+    for (size_t i = 0; i < _samples.size(); ++i)
+    {
+      _samples[i].ax = force[2 * i] / _mass;
+      _samples[i].ay = force[2 * i + 1] / _mass;
+    }
+}
+
+/////////////////////////////////////////////////
+/// \brief Samples held in memory.
+class VectorSource : public asv::core::CalibrationSource
+{
+    public: explicit VectorSource(
+        const std::vector<asv::core::CalibrationSample> &_samples)
+      : samples(_samples)
+    {
+    }
+
+    public: bool Rewind() override
+    {
+      this->next = 0;
+      ++this->rewinds;
+      return true;
+    }
+
+    public: size_t Read(asv::core::CalibrationSample *_samples,
+        size_t _count) override
+    {
+      size_t n = std::min(_count, this->samples.size() - this->next);
+      std::copy(this->samples.begin() + this->next,
+          this->samples.begin() + this->next + n, _samples);
+      this->next += n;
+      return n;
+    }
+
+    public: std::vector<asv::core::CalibrationSample> samples;
+    public: size_t next = 0;
+    public: size_t rewinds = 0;
+};
+
+/////////////////////////////////////////////////
+TEST(LiftDragCalibration, Evaluate)
+{
+    const double mass = 200.0;
+    asv::core::LiftDragCalibration calibration(MakeSail(), mass);
+    auto samples = MakeSamples(300);
+
+    // The forces are those of the simulation in the heeled body frame.
+    auto params = MakeTruth();
+    auto sail = MakeSail();
+    sail.params = params;
+    std::vector<double> force(2 * samples.size());
+    calibration.Evaluate(params, samples.data(), samples.size(),
+        force.data());
+    for (size_t i = 0; i < samples.size(); ++i)
+    {
+      const auto &s = samples[i];
+      asv::core::Vector3d wind(-s.aws * std::cos(s.awa),
+          -s.aws * std::sin(s.awa), 0.0);
+      auto bodyRot = asv::core::Quaterniond::FromEuler(s.heel, 0.0, 0.0);
+      asv::core::Vector3d zero;
+      asv::core::Vector3d f;
+      asv::core::Vector3d torque;
+      sail.AddWrench(s.trim, zero, bodyRot, zero, zero, wind, f, torque);
+      f = bodyRot.RotateVectorReverse(f);
+      EXPECT_NEAR(force[2 * i], f.x, 1.0E-9) << i;
+      EXPECT_NEAR(force[2 * i + 1], f.y, 1.0E-9) << i;
+    }
+}
+
+/////////////////////////////////////////////////
+TEST(LiftDragCalibration, Jacobian)
+{
+    asv::core::LiftDragCalibration calibration(MakeSail(), 200.0);
+    auto samples = MakeSamples(200);
+    auto params = MakeTruth();
+    const size_t n = samples.size();
+    std::vector<double> force(2 * n);
+    std::vector<double> jacobian(10 * n);
+    calibration.Evaluate(params, samples.data(), n, force.data(),
+        jacobian.data());
+
+    // Central differences, away from the stall where the lift is not
+    // differentiable.
+    std::vector<double> plus(2 * n);
+    std::vector<double> minus(2 * n);
+    for (size_t j = 0; j < 5; ++j)
+    {
+      const double h = 1.0E-6;
+      auto p = params;
+      auto m = params;
+      double value = asv::core::LiftDragCalibration::Param(params, j);
+      asv::core::LiftDragCalibration::SetParam(p, j, value + h);
+      asv::core::LiftDragCalibration::SetParam(m, j, value - h);
+      calibration.Evaluate(p, samples.data(), n, plus.data());
+      calibration.Evaluate(m, samples.data(), n, minus.data());
+      for (size_t i = 0; i < 2 * n; ++i)
+      {
+        double numeric = (plus[i] - minus[i]) / (2.0 * h);
+        double analytic = jacobian[(i / 2) * 10 + (i % 2) * 5 + j];
+        EXPECT_NEAR(analytic, numeric, 1.0E-4 * (1.0 + std::abs(numeric)))
+            << asv::core::LiftDragCalibration::kParamNames[j] << " " << i;
+      }
+    }
+}
+
+/////////////////////////////////////////////////
+TEST(LiftDragCalibration, Calibrate)
+{
+    const double mass = 200.0;
+    asv::core::LiftDragCalibrationOptions options;
+    options.chunkSize = 1000;
+    options.threads = 1;
+    asv::core::LiftDragCalibration serial(MakeSail(), mass, options);
+    auto samples = MakeSamples(5000);
+    auto truth = MakeTruth();
+    SetAccelerations(serial, truth, mass, samples);
+
+    auto initial = MakeSail().params;
+    initial.alpha0 = 0.0;
+    initial.cla = 4.0;
+    initial.alphaStall = 0.25;
+    initial.claStall = -0.5;
+    initial.cda = 0.5;
+
+    VectorSource source(samples);
+    auto result = serial.Calibrate(source, initial);
+    EXPECT_TRUE(result.converged);
+    EXPECT_EQ(result.samples, samples.size());
+    EXPECT_EQ(result.passes, source.rewinds);
+    EXPECT_LT(result.iterations, options.maxIterations);
+    for (size_t j = 0; j < 5; ++j)
+    {
+      EXPECT_NEAR(asv::core::LiftDragCalibration::Param(result.params, j),
+          asv::core::LiftDragCalibration::Param(truth, j), 1.0E-6)
+          << asv::core::LiftDragCalibration::kParamNames[j];
+      EXPECT_LT(result.stddev[j], 1.0E-6);
+    }
+    EXPECT_LT(result.rms, 1.0E-6);
+    EXPECT_NEAR(result.r2, 1.0, 1.0E-12);
+
+    // The result does not depend on the number of threads.
+    options.threads = 4;
+    asv::core::LiftDragCalibration parallel(MakeSail(), mass, options);
+    auto other = parallel.Calibrate(source, initial);
+    EXPECT_EQ(other.iterations, result.iterations);
+    for (size_t j = 0; j < 5; ++j)
+    {
+      EXPECT_EQ(asv::core::LiftDragCalibration::Param(other.params, j),
+          asv::core::LiftDragCalibration::Param(result.params, j));
+    }
+    EXPECT_EQ(other.rms, result.rms);
+
+    // Parameters that are not fitted keep their values.
+    options.fit = {false, true, true, true, false};
+    asv::core::LiftDragCalibration partial(MakeSail(), mass, options);
+    initial.alpha0 = truth.alpha0;
+    initial.cda = 0.8;
+    result = partial.Calibrate(source, initial);
+    EXPECT_TRUE(result.converged);
+    EXPECT_DOUBLE_EQ(result.params.alpha0, truth.alpha0);
+    EXPECT_DOUBLE_EQ(result.params.cda, 0.8);
+    EXPECT_EQ(result.stddev[0], 0.0);
+    EXPECT_EQ(result.stddev[4], 0.0);
+    EXPECT_GT(result.rms, 0.0);
+    EXPECT_LT(result.r2, 1.0);
+
+    // With noise the error of the fit is within a few standard errors.
+    for (size_t i = 0; i < samples.size(); ++i)
+    {
+      source.samples[i].ax += 0.05 * std::sin(12.9898 * i);
+      source.samples[i].ay += 0.05 * std::cos(78.233 * i);
+    }
+    result = serial.Calibrate(source, initial);
+    EXPECT_TRUE(result.converged);
+    EXPECT_NEAR(result.rms, 0.05 * mass / std::sqrt(2.0), 1.0);
+    for (size_t j = 0; j < 5; ++j)
+    {
+      EXPECT_GT(result.stddev[j], 0.0);
+      EXPECT_NEAR(asv::core::LiftDragCalibration::Param(result.params, j),
+          asv::core::LiftDragCalibration::Param(truth, j),
+          4.0 * result.stddev[j])
+          << asv::core::LiftDragCalibration::kParamNames[j];
+    }
+}
+
+/////////////////////////////////////////////////
+TEST(LiftDragCalibration, CsvSource)
+{
+    const std::string filename = "LiftDragCalibration_TEST.csv";
+    {
+      std::ofstream out(filename);
+      out << "time, ay,ax,trim,heel,awa,aws\n";
+      out << "0.0,1,2,3,4,5,6\n";
+      out << "# comment\n";
+      out << "\n";
+      out << "0.1,1,2,x,4,5,6\n";
+      out << "0.2,7,8,9,10,11\n";
+      out << "0.3,-1,-2,-3,-4,-5,-6\r\n";
+    }
+
+    asv::core::CsvCalibrationSource source;
+    ASSERT_TRUE(source.Open(filename));
+    asv::core::CalibrationSample samples[4];
+    for (int pass = 0; pass < 2; ++pass)
+    {
+      ASSERT_TRUE(source.Rewind());
+      EXPECT_EQ(source.Read(samples, 1), 1u);
+      EXPECT_EQ(source.Read(samples + 1, 3), 1u);
+      EXPECT_EQ(source.Read(samples + 2, 2), 0u);
+      EXPECT_EQ(source.Skipped(), 2u);
+      EXPECT_DOUBLE_EQ(samples[0].aws, 6.0);
+      EXPECT_DOUBLE_EQ(samples[0].awa, 5.0);
+      EXPECT_DOUBLE_EQ(samples[0].heel, 4.0);
+      EXPECT_DOUBLE_EQ(samples[0].trim, 3.0);
+      EXPECT_DOUBLE_EQ(samples[0].ax, 2.0);
+      EXPECT_DOUBLE_EQ(samples[0].ay, 1.0);
+      EXPECT_DOUBLE_EQ(samples[1].aws, -6.0);
+      EXPECT_DOUBLE_EQ(samples[1].ay, -1.0);
+    }
+
+    // A longer file, parsed on several threads.
+    auto expected = MakeSamples(3000);
+    {
+      std::ofstream out(filename);
+      out << "aws,awa,heel,trim,ax,ay\n";
+      out.precision(17);
+      for (const auto &s : expected)
+      {
+        out << s.aws << "," << s.awa << "," << s.heel << "," << s.trim
+            << "," << s.ax << "," << s.ay << "\n";
+      }
+    }
+    asv::core::CsvCalibrationSource parallel(4);
+    ASSERT_TRUE(parallel.Open(filename));
+    std::vector<asv::core::CalibrationSample> read(expected.size());
+    size_t n = 0;
+    for (size_t count; (count = parallel.Read(read.data() + n, 1000));)
+      n += count;
+    ASSERT_EQ(n, expected.size());
+    EXPECT_EQ(parallel.Skipped(), 0u);
+    for (size_t i = 0; i < n; ++i)
+    {
+      EXPECT_EQ(read[i].aws, expected[i].aws) << i;
+      EXPECT_EQ(read[i].trim, expected[i].trim) << i;
+    }
+
+    // A missing column.
+    {
+      std::ofstream out(filename);
+      out << "aws,awa,heel,trim,ax\n";
+    }
+    asv::core::CsvCalibrationSource missing;
+    EXPECT_FALSE(missing.Open(filename));
+    EXPECT_FALSE(missing.Open("no_such_file.csv"));
+    std::remove(filename.c_str());
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,345 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#include "asv/core/LiftDragSweep.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+namespace asv
+{
+namespace core
+{
+namespace
+{
+/////////////////////////////////////////////////
+/// \brief Order fits by error, then by index so the order does not
+/// depend on the threads.
+bool Better(const LiftDragFit &_a, const LiftDragFit &_b)
+{
+  if (_a.rms != _b.rms)
+    return _a.rms < _b.rms;
+  return _a.index < _b.index;
+}
+
+/////////////////////////////////////////////////
+/// \brief Add a fit to a list of the best fits, sorted best first.
+void Keep(std::vector<LiftDragFit> &_best, size_t _count,
+    const LiftDragFit &_fit)
+{
+  if (_best.size() == _count && !Better(_fit, _best.back()))
+    return;
+  auto it = std::upper_bound(_best.begin(), _best.end(), _fit, Better);
+  _best.insert(it, _fit);
+  if (_best.size() > _count)
+    _best.pop_back();
+}
+}  // namespace
+
+/////////////////////////////////////////////////
+size_t LiftDragRanges::Count() const
+{
+  size_t n = 1;
+  for (const auto &v : this->values)
+    n *= std::max<size_t>(v.size(), 1);
+  return n;
+}
+
+/////////////////////////////////////////////////
+LiftDragParams LiftDragRanges::Combination(const LiftDragParams &_base,
+    size_t _index) const
+{
+  LiftDragParams params = _base;
+  for (size_t j = this->values.size(); j-- > 0;)
+  {
+    const auto &v = this->values[j];
+    if (v.empty())
+      continue;
+    LiftDragSweep::SetParam(params, j, v[_index % v.size()]);
+    _index /= v.size();
+  }
+  return params;
+}
+
+/////////////////////////////////////////////////
+double LiftDragSweep::Param(const LiftDragParams &_params, size_t _index)
+{
+  switch (_index)
+  {
+    case 0: return _params.cla;
+    case 1: return _params.alphaStall;
+    case 2: return _params.claStall;
+    case 3: return _params.cda;
+    default: return _params.area;
+  }
+}
+
+/////////////////////////////////////////////////
+void LiftDragSweep::SetParam(LiftDragParams &_params, size_t _index,
+    double _value)
+{
+  switch (_index)
+  {
+    case 0: _params.cla = _value; break;
+    case 1: _params.alphaStall = _value; break;
+    case 2: _params.claStall = _value; break;
+    case 3: _params.cda = _value; break;
+    default: _params.area = _value; break;
+  }
+}
+
+/////////////////////////////////////////////////
+LiftDragSweep::LiftDragSweep(const BoatSurface &_sail, double _trim,
+    const std::vector<double> &_aws, const std::vector<double> &_awa)
+  : sail(_sail), points(std::min(_aws.size(), _awa.size())),
+    panels(_sail.panels.size())
+{
+  const auto &params = this->sail.params;
+  const double areaInv = params.area != 0.0 ? 1.0 / params.area : 0.0;
+  const size_t n = this->points * this->panels;
+  this->pressure.resize(this->points);
+  this->alpha.assign(n, 0.0);
+  this->weight.assign(n, 0.0);
+  this->liftX.assign(n, 0.0);
+  this->liftY.assign(n, 0.0);
+  this->dragX.assign(n, 0.0);
+  this->dragY.assign(n, 0.0);
+
+  Vector3d linkPos;
+  Quaterniond linkRot;
+  this->sail.Pose(_trim, linkPos, linkRot);
+  for (size_t i = 0; i < this->points; ++i)
+  {
+    this->pressure[i] = 0.5 * params.fluidDensity * _aws[i] * _aws[i];
+    Vector3d wind(-_aws[i] * std::cos(_awa[i]),
+        -_aws[i] * std::sin(_awa[i]), 0.0);
+    for (size_t k = 0; k < this->panels; ++k)
+    {
+      // The geometry of ComputeLiftDrag.
+      const auto &panel = this->sail.panels[k];
+      auto xr = linkPos + linkRot.RotateVector(panel.cp);
+      auto rot = linkRot * panel.twist;
+      auto forwardI = rot.RotateVector(params.forward);
+      auto upwardI = rot.RotateVector(params.upward);
+      auto velU = this->sail.WindShearFactor(xr.z) * wind;
+      if (velU.Length() <= 0.01)
+        continue;
+
+      auto spanI = forwardI.Cross(upwardI).Normalize();
+      auto velLD = velU - velU.Dot(spanI) * spanI;
+      auto dragUnit = velLD.Normalized();
+      auto liftUnit = dragUnit.Cross(spanI).Normalize();
+      double sgnAlpha = forwardI.Dot(liftUnit) < 0 ? -1.0 : 1.0;
+      double a = std::acos(-forwardI.Dot(dragUnit));
+      double u = velLD.Length();
+      double w = 0.5 * params.fluidDensity * u * u * panel.area * areaInv;
+      if (!std::isfinite(a) || !std::isfinite(w))
+        continue;
+
+      const size_t m = i * this->panels + k;
+      this->alpha[m] = a;
+      this->weight[m] = w;
+      this->liftX[m] = sgnAlpha * liftUnit.x;
+      this->liftY[m] = sgnAlpha * liftUnit.y;
+      this->dragX[m] = dragUnit.x;
+      this->dragY[m] = dragUnit.y;
+    }
+  }
+
+  std::vector<double> drive(this->points);
+  std::vector<double> side(this->points);
+  this->Evaluate(params, drive.data(), side.data());
+  this->SetReference(drive, side);
+}
+
+/////////////////////////////////////////////////
+const BoatSurface &LiftDragSweep::Sail() const
+{
+  return this->sail;
+}
+
+/////////////////////////////////////////////////
+size_t LiftDragSweep::Size() const
+{
+  return this->points;
+}
+
+/////////////////////////////////////////////////
+void LiftDragSweep::PointForce(const LiftDragParams &_params,
+    size_t _point, double &_drive, double &_side) const
+{
+  double drive = 0.0;
+  double side = 0.0;
+  const size_t begin = _point * this->panels;
+  for (size_t m = begin; m < begin + this->panels; ++m)
+  {
+    double cl = LiftCoefficient(_params, this->alpha[m]);
+    double cd = DragCoefficient(_params, this->alpha[m]);
+    drive += this->weight[m] * (cl * this->liftX[m] + cd * this->dragX[m]);
+    side += this->weight[m] * (cl * this->liftY[m] + cd * this->dragY[m]);
+  }
+  _drive = _params.area * drive;
+  _side = _params.area * side;
+}
+
+/////////////////////////////////////////////////
+void LiftDragSweep::Evaluate(const LiftDragParams &_params,
+    double *_drive, double *_side) const
+{
+  for (size_t i = 0; i < this->points; ++i)
+    this->PointForce(_params, i, _drive[i], _side[i]);
+}
+
+/////////////////////////////////////////////////
+bool LiftDragSweep::SetReference(const std::vector<double> &_drive,
+    const std::vector<double> &_side)
+{
+  if (_drive.size() != this->points || _side.size() != this->points)
+    return false;
+  this->referenceDrive = _drive;
+  this->referenceSide = _side;
+
+  // Total sum of squares about the means, for the fits.
+  double meanDrive = 0.0;
+  double meanSide = 0.0;
+  for (size_t i = 0; i < this->points; ++i)
+  {
+    meanDrive += _drive[i];
+    meanSide += _side[i];
+  }
+  if (this->points > 0)
+  {
+    meanDrive /= this->points;
+    meanSide /= this->points;
+  }
+  this->referenceSquares = 0.0;
+  for (size_t i = 0; i < this->points; ++i)
+  {
+    this->referenceSquares += (_drive[i] - meanDrive) *
+        (_drive[i] - meanDrive) + (_side[i] - meanSide) *
+        (_side[i] - meanSide);
+  }
+  return true;
+}
+
+/////////////////////////////////////////////////
+LiftDragFit LiftDragSweep::Fit(const LiftDragParams &_params) const
+{
+  LiftDragFit fit;
+  fit.params = _params;
+  if (this->points == 0)
+    return fit;
+
+  double sse = 0.0;
+  for (size_t i = 0; i < this->points; ++i)
+  {
+    double drive;
+    double side;
+    this->PointForce(_params, i, drive, side);
+    double ed = drive - this->referenceDrive[i];
+    double es = side - this->referenceSide[i];
+    sse += ed * ed + es * es;
+  }
+  const double sst = this->referenceSquares;
+  fit.rms = std::sqrt(sse / (2.0 * this->points));
+  fit.r2 = sst > 0.0 ? 1.0 - sse / sst : (sse > 0.0 ? 0.0 : 1.0);
+  return fit;
+}
+
+/////////////////////////////////////////////////
+std::vector<LiftDragFit> LiftDragSweep::Sweep(
+    const LiftDragRanges &_ranges, size_t _best, size_t _threads) const
+{
+  const size_t count = _ranges.Count();
+  if (_best == 0)
+    return {};
+
+  size_t threads = _threads;
+  if (threads == 0)
+    threads = std::max(std::thread::hardware_concurrency(), 1u);
+  threads = std::max<size_t>(std::min(threads, count), 1);
+
+  // Each thread takes blocks of combinations and keeps its own best
+  // fits, which are merged at the end.
+  const size_t block = 64;
+  std::atomic<size_t> next{0};
+  std::vector<std::vector<LiftDragFit>> best(threads);
+  auto work = [&](size_t _thread)
+  {
+    auto &local = best[_thread];
+    for (size_t begin = next.fetch_add(block); begin < count;
+        begin = next.fetch_add(block))
+    {
+      for (size_t c = begin; c < std::min(begin + block, count); ++c)
+      {
+        auto fit = this->Fit(_ranges.Combination(this->sail.params, c));
+        fit.index = c;
+        Keep(local, _best, fit);
+      }
+    }
+  };
+
+  std::vector<std::thread> pool;
+  for (size_t t = 1; t < threads; ++t)
+    pool.emplace_back(work, t);
+  work(0);
+  for (auto &thread : pool)
+    thread.join();
+
+  std::vector<LiftDragFit> merged;
+  for (const auto &local : best)
+  {
+    for (const auto &fit : local)
+      Keep(merged, _best, fit);
+  }
+  return merged;
+}
+
+/////////////////////////////////////////////////
+void LiftDragSweep::Sensitivity(const LiftDragParams &_params,
+    std::vector<std::array<double, 5>> &_drive,
+    std::vector<std::array<double, 5>> &_side) const
+{
+  _drive.assign(this->points, {});
+  _side.assign(this->points, {});
+  for (size_t j = 0; j < kParamNames.size(); ++j)
+  {
+    const double value = Param(_params, j);
+    if (value == 0.0)
+      continue;
+    const double h = 1.0e-4 * std::abs(value);
+    auto plus = _params;
+    auto minus = _params;
+    SetParam(plus, j, value + h);
+    SetParam(minus, j, value - h);
+    for (size_t i = 0; i < this->points; ++i)
+    {
+      double scale = this->pressure[i] * _params.area;
+      if (scale <= 0.0)
+        continue;
+      double drivePlus, sidePlus, driveMinus, sideMinus;
+      this->PointForce(plus, i, drivePlus, sidePlus);
+      this->PointForce(minus, i, driveMinus, sideMinus);
+      _drive[i][j] = (drivePlus - driveMinus) / (2.0 * h) * value / scale;
+      _side[i][j] = (sidePlus - sideMinus) / (2.0 * h) * value / scale;
+    }
+  }
+}
+
+}  // namespace core
+}  // namespace asv
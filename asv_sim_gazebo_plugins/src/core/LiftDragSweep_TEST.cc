@@ -0,0 +1,197 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+#include "asv/core/LiftDragSweep.hh"
+
+#include "TestBoat.hh"
+
+/////////////////////////////////////////////////
+/// \brief A grid of apparent winds.
+void MakeGrid(std::vector<double> &_aws, std::vector<double> &_awa)
+{
+    for (double aws : {3.0, 6.0})
+    {
+      for (double awa = -3.0; awa <= 3.0; awa += 0.1)
+      {
+        _aws.push_back(aws);
+        _awa.push_back(awa);
+      }
+    }
+}
+
+/////////////////////////////////////////////////
+TEST(LiftDragSweep, Evaluate)
+{
+    std::vector<double> aws;
+    std::vector<double> awa;
+    MakeGrid(aws, awa);
+    const double trim = 0.4;
+    asv::core::LiftDragSweep sweep(MakeSail(), trim, aws, awa);
+    ASSERT_EQ(sweep.Size(), aws.size());
+
+    // The forces are those of the simulation, for the parameters of the
+    // sail and for others.
+    auto params = MakeSail().params;
+    auto other = params;
+    other.cla = 5.0;
+    other.alphaStall = 0.25;
+    other.claStall = -1.0;
+    other.cda = 0.8;
+    other.area = 4.0;
+    for (const auto &p : {params, other})
+    {
+      auto sail = MakeSail();
+      sail.params = p;
+      for (auto &panel : sail.panels)
+        panel.area *= p.area / params.area;
+
+      std::vector<double> drive(sweep.Size());
+      std::vector<double> side(sweep.Size());
+      sweep.Evaluate(p, drive.data(), side.data());
+      for (size_t i = 0; i < sweep.Size(); ++i)
+      {
+        asv::core::Vector3d wind(-aws[i] * std::cos(awa[i]),
+            -aws[i] * std::sin(awa[i]), 0.0);
+        asv::core::Vector3d zero;
+        asv::core::Vector3d force;
+        asv::core::Vector3d torque;
+        sail.AddWrench(trim, zero, asv::core::Quaterniond(), zero, zero,
+            wind, force, torque);
+        EXPECT_NEAR(drive[i], force.x, 1.0E-9) << i;
+        EXPECT_NEAR(side[i], force.y, 1.0E-9) << i;
+      }
+    }
+}
+
+/////////////////////////////////////////////////
+TEST(LiftDragSweep, Ranges)
+{
+    asv::core::LiftDragRanges ranges;
+    ranges.values[0] = {5.0, 6.0};
+    ranges.values[3] = {0.5, 0.6, 0.7};
+    EXPECT_EQ(ranges.Count(), 6u);
+
+    asv::core::LiftDragParams base;
+    auto params = ranges.Combination(base, 4);
+    EXPECT_DOUBLE_EQ(params.cla, 6.0);
+    EXPECT_DOUBLE_EQ(params.cda, 0.6);
+    EXPECT_DOUBLE_EQ(params.alphaStall, base.alphaStall);
+    EXPECT_DOUBLE_EQ(params.area, base.area);
+
+    for (size_t j = 0; j < 5; ++j)
+    {
+      asv::core::LiftDragSweep::SetParam(params, j, 10.0 + j);
+      EXPECT_DOUBLE_EQ(asv::core::LiftDragSweep::Param(params, j),
+          10.0 + j);
+    }
+}
+
+/////////////////////////////////////////////////
+TEST(LiftDragSweep, Fit)
+{
+    std::vector<double> aws;
+    std::vector<double> awa;
+    MakeGrid(aws, awa);
+    asv::core::LiftDragSweep sweep(MakeSail(), 0.0, aws, awa);
+
+    // Reference forces from parameters that are on the grid.
+    auto truth = MakeSail().params;
+    truth.cla = 5.5;
+    truth.alphaStall = 0.16;
+    truth.cda = 0.7;
+    truth.area = 5.0;
+    std::vector<double> drive(sweep.Size());
+    std::vector<double> side(sweep.Size());
+    sweep.Evaluate(truth, drive.data(), side.data());
+    EXPECT_FALSE(sweep.SetReference(drive, {}));
+    ASSERT_TRUE(sweep.SetReference(drive, side));
+
+    asv::core::LiftDragRanges ranges;
+    for (double v = 4.5; v <= 7.01; v += 0.5)
+      ranges.values[0].push_back(v);
+    ranges.values[1] = {0.12, 0.16, 0.2};
+    ranges.values[3] = {0.5, 0.6, 0.7, 0.8};
+    ranges.values[4] = {4.0, 5.0, 6.0};
+    auto serial = sweep.Sweep(ranges, 5, 1);
+    ASSERT_EQ(serial.size(), 5u);
+    EXPECT_DOUBLE_EQ(serial[0].params.cla, 5.5);
+    EXPECT_DOUBLE_EQ(serial[0].params.alphaStall, 0.16);
+    EXPECT_DOUBLE_EQ(serial[0].params.cda, 0.7);
+    EXPECT_DOUBLE_EQ(serial[0].params.area, 5.0);
+    EXPECT_NEAR(serial[0].rms, 0.0, 1.0E-9);
+    EXPECT_NEAR(serial[0].r2, 1.0, 1.0E-12);
+    for (size_t i = 1; i < serial.size(); ++i)
+    {
+      EXPECT_GE(serial[i].rms, serial[i - 1].rms);
+      EXPECT_LT(serial[i].r2, 1.0);
+    }
+
+    // The same whatever the number of threads.
+    auto parallel = sweep.Sweep(ranges, 5, 4);
+    ASSERT_EQ(parallel.size(), serial.size());
+    for (size_t i = 0; i < serial.size(); ++i)
+    {
+      EXPECT_EQ(parallel[i].index, serial[i].index);
+      EXPECT_DOUBLE_EQ(parallel[i].rms, serial[i].rms);
+    }
+}
+
+/////////////////////////////////////////////////
+TEST(LiftDragSweep, Sensitivity)
+{
+    std::vector<double> aws;
+    std::vector<double> awa;
+    MakeGrid(aws, awa);
+    asv::core::LiftDragSweep sweep(MakeSail(), 0.0, aws, awa);
+    auto params = MakeSail().params;
+
+    std::vector<std::array<double, 5>> drive;
+    std::vector<std::array<double, 5>> side;
+    sweep.Sensitivity(params, drive, side);
+    ASSERT_EQ(drive.size(), sweep.Size());
+
+    // The forces are proportional to the area, so the sensitivity to it
+    // is the force coefficient.
+    std::vector<double> fx(sweep.Size());
+    std::vector<double> fy(sweep.Size());
+    sweep.Evaluate(params, fx.data(), fy.data());
+    for (size_t i = 0; i < sweep.Size(); ++i)
+    {
+      double scale = 0.5 * params.fluidDensity * aws[i] * aws[i] *
+          params.area;
+      EXPECT_NEAR(drive[i][4], fx[i] / scale, 1.0E-6) << i;
+      EXPECT_NEAR(side[i][4], fy[i] / scale, 1.0E-6) << i;
+    }
+
+    // Near head to wind the sail is below the stall and insensitive to
+    // the slope after the stall.
+    size_t head = 30;
+    ASSERT_NEAR(awa[head], 0.0, 1.0E-9);
+    EXPECT_NEAR(side[head][2], 0.0, 1.0E-9);
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,121 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include "asv/core/LiftDrag.hh"
+#include "asv/core/Quaternion.hh"
+#include "asv/core/Vector3.hh"
+
+/////////////////////////////////////////////////
+TEST(LiftDrag, Coefficients)
+{
+    asv::core::LiftDragParams params;
+    params.cla = 6.2832;
+    params.alphaStall = 0.1592;
+    params.claStall = -0.7083;
+    params.cda = 0.63662;
+
+    // Linear before stall, symmetric about pi/2.
+    EXPECT_NEAR(asv::core::LiftCoefficient(params, 0.1), 0.62832, 1.0E-12);
+    EXPECT_NEAR(asv::core::LiftCoefficient(params, M_PI - 0.1),
+        -0.62832, 1.0E-12);
+    EXPECT_NEAR(asv::core::LiftCoefficient(params, 0.5),
+        -0.7083 * (0.5 - 0.1592) + 6.2832 * 0.1592, 1.0E-12);
+    EXPECT_NEAR(asv::core::DragCoefficient(params, 0.5),
+        0.63662 * 0.5, 1.0E-12);
+    EXPECT_NEAR(asv::core::DragCoefficient(params, M_PI - 0.5),
+        0.63662 * 0.5, 1.0E-12);
+}
+
+/////////////////////////////////////////////////
+TEST(LiftDrag, Compute)
+{
+    asv::core::LiftDragParams params;
+    params.forward = asv::core::Vector3d(1.0, 0.0, 0.0);
+    params.upward = asv::core::Vector3d(0.0, 1.0, 0.0);
+    params.area = 2.0;
+    params.fluidDensity = 1.2;
+
+    // Free stream from ahead and below, a positive angle of attack.
+    const double alpha = 0.1;
+    const double speed = 5.0;
+    asv::core::Vector3d vel(-speed * std::cos(alpha),
+        speed * std::sin(alpha), 0.0);
+    asv::core::LiftDragResult result;
+    ASSERT_TRUE(asv::core::ComputeLiftDrag(params, vel,
+        asv::core::Quaterniond(), result));
+
+    const double q = 0.5 * 1.2 * speed * speed;
+    EXPECT_NEAR(result.alpha, alpha, 1.0E-12);
+    EXPECT_NEAR(result.u, speed, 1.0E-12);
+    EXPECT_NEAR(result.cl, params.cla * alpha, 1.0E-12);
+    EXPECT_NEAR(result.cd, params.cda * alpha, 1.0E-12);
+
+    // Drag along the free stream, lift normal to it towards upward.
+    EXPECT_NEAR(result.drag.Length(), result.cd * q * 2.0, 1.0E-9);
+    EXPECT_NEAR(result.drag.Cross(vel).Length(), 0.0, 1.0E-9);
+    EXPECT_GT(result.drag.Dot(vel), 0.0);
+    EXPECT_NEAR(result.lift.Length(), result.cl * q * 2.0, 1.0E-9);
+    EXPECT_NEAR(result.lift.Dot(vel), 0.0, 1.0E-9);
+    EXPECT_GT(result.lift.y, 0.0);
+
+    // Rotating the foil and the flow together rotates the forces.
+    auto rot = asv::core::Quaterniond::FromEuler(0.3, -0.2, 1.1);
+    asv::core::LiftDragResult rotated;
+    ASSERT_TRUE(asv::core::ComputeLiftDrag(params, rot.RotateVector(vel),
+        rot, rotated));
+    auto lift = rot.RotateVector(result.lift);
+    EXPECT_NEAR(rotated.lift.x, lift.x, 1.0E-9);
+    EXPECT_NEAR(rotated.lift.y, lift.y, 1.0E-9);
+    EXPECT_NEAR(rotated.lift.z, lift.z, 1.0E-9);
+
+    // No force in still air, the outputs are left as they were.
+    rotated.alpha = -1.0;
+    EXPECT_FALSE(asv::core::ComputeLiftDrag(params,
+        asv::core::Vector3d(), rot, rotated));
+    EXPECT_DOUBLE_EQ(rotated.lift.Length(), 0.0);
+    EXPECT_DOUBLE_EQ(rotated.alpha, -1.0);
+}
+
+/////////////////////////////////////////////////
+TEST(LiftDrag, Quaternion)
+{
+    // Yaw of pi/2 takes x to y.
+    auto q = asv::core::Quaterniond::FromEuler(0.0, 0.0, M_PI / 2.0);
+    auto v = q.RotateVector(asv::core::Vector3d(1.0, 0.0, 0.0));
+    EXPECT_NEAR(v.x, 0.0, 1.0E-12);
+    EXPECT_NEAR(v.y, 1.0, 1.0E-12);
+    EXPECT_NEAR(v.z, 0.0, 1.0E-12);
+
+    auto p = asv::core::Quaterniond::FromAxisAngle(
+        asv::core::Vector3d(0.0, 0.0, 2.0), M_PI / 2.0);
+    EXPECT_NEAR(p.w, q.w, 1.0E-12);
+    EXPECT_NEAR(p.z, q.z, 1.0E-12);
+
+    auto u = q.RotateVectorReverse(v);
+    EXPECT_NEAR(u.x, 1.0, 1.0E-12);
+    EXPECT_NEAR(u.y, 0.0, 1.0E-12);
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
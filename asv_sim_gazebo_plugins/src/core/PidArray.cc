@@ -0,0 +1,90 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "asv/core/PidArray.hh"
+
+#include <algorithm>
+#include <cmath>
+
+namespace asv
+{
+namespace core
+{
+/////////////////////////////////////////////////
+size_t PidArray::Add(double _p, double _i, double _d,
+    double _iMax, double _iMin, double _cmdMax, double _cmdMin,
+    double _cmdOffset)
+{
+  this->pGain.push_back(_p);
+  this->iGain.push_back(_i);
+  this->dGain.push_back(_d);
+  this->iMax.push_back(_iMax);
+  this->iMin.push_back(_iMin);
+  this->cmdMax.push_back(_cmdMax);
+  this->cmdMin.push_back(_cmdMin);
+  this->cmdOffset.push_back(_cmdOffset);
+  this->iErr.push_back(0.0);
+  this->pErrLast.push_back(0.0);
+  return this->pGain.size() - 1;
+}
+
+/////////////////////////////////////////////////
+size_t PidArray::Size() const
+{
+  return this->pGain.size();
+}
+
+/////////////////////////////////////////////////
+void PidArray::Reset()
+{
+  std::fill(this->iErr.begin(), this->iErr.end(), 0.0);
+  std::fill(this->pErrLast.begin(), this->pErrLast.end(), 0.0);
+}
+
+/////////////////////////////////////////////////
+double PidArray::Update(size_t _index, double _error, double _dt)
+{
+  const size_t k = _index;
+  if (_dt <= 0.0 || !std::isfinite(_error))
+    return 0.0;
+
+  double pTerm = this->pGain[k] * _error;
+
+  this->iErr[k] += this->iGain[k] * _dt * _error;
+  if (this->iMax[k] >= this->iMin[k])
+    this->iErr[k] = std::clamp(this->iErr[k], this->iMin[k], this->iMax[k]);
+
+  double dErr = (_error - this->pErrLast[k]) / _dt;
+  this->pErrLast[k] = _error;
+  double dTerm = this->dGain[k] * dErr;
+
+  double cmd = this->cmdOffset[k] - pTerm - this->iErr[k] - dTerm;
+  if (this->cmdMax[k] >= this->cmdMin[k])
+    cmd = std::clamp(cmd, this->cmdMin[k], this->cmdMax[k]);
+  return cmd;
+}
+
+/////////////////////////////////////////////////
+void PidArray::Update(const double *_error, double _dt, double *_cmd)
+{
+  const size_t n = this->pGain.size();
+  for (size_t k = 0; k < n; ++k)
+  {
+    _cmd[k] = this->Update(k, _error[k], _dt);
+  }
+}
+
+}  // namespace core
+}  // namespace asv
@@ -0,0 +1,75 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "asv/core/PidArray.hh"
+
+/////////////////////////////////////////////////
+TEST(PidArray, Update)
+{
+    asv::core::PidArray pid;
+    EXPECT_EQ(pid.Add(2.0, 0.5, 0.1, 1.0, -1.0, 10.0, -10.0), 0u);
+    EXPECT_EQ(pid.Add(1.0, 0.0, 0.0, 1.0, -1.0, 3.0, -3.0, 0.5), 1u);
+    EXPECT_EQ(pid.Size(), 2u);
+
+    // p, i and d terms for the first step.
+    const double dt = 0.1;
+    double cmd = pid.Update(0, 1.0, dt);
+    EXPECT_NEAR(cmd, -(2.0 * 1.0 + 0.5 * dt * 1.0 + 0.1 * 1.0 / dt), 1.0E-12);
+
+    // The integral is clamped.
+    for (int i = 0; i < 100; ++i)
+      cmd = pid.Update(0, 1.0, dt);
+    EXPECT_NEAR(cmd, -(2.0 + 1.0), 1.0E-12);
+
+    // The command is clamped and offset.
+    EXPECT_NEAR(pid.Update(1, 100.0, dt), -3.0, 1.0E-12);
+    EXPECT_NEAR(pid.Update(1, 0.25, dt), 0.25, 1.0E-12);
+
+    // Invalid input gives no command.
+    EXPECT_DOUBLE_EQ(pid.Update(1, 1.0, 0.0), 0.0);
+}
+
+/////////////////////////////////////////////////
+TEST(PidArray, Independent)
+{
+    // Each controller keeps its own state.
+    asv::core::PidArray pid;
+    for (int i = 0; i < 3; ++i)
+      pid.Add(1.0, 1.0, 0.0, 100.0, -100.0, 100.0, -100.0);
+
+    std::vector<double> error = {1.0, 0.0, -2.0};
+    std::vector<double> cmd(3);
+    for (int i = 0; i < 10; ++i)
+      pid.Update(error.data(), 0.1, cmd.data());
+
+    EXPECT_NEAR(cmd[0], -(1.0 + 1.0), 1.0E-12);
+    EXPECT_NEAR(cmd[1], 0.0, 1.0E-12);
+    EXPECT_NEAR(cmd[2], 2.0 + 2.0, 1.0E-12);
+
+    pid.Reset();
+    pid.Update(error.data(), 0.1, cmd.data());
+    EXPECT_NEAR(cmd[0], -(1.0 + 0.1), 1.0E-12);
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
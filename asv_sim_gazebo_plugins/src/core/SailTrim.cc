@@ -0,0 +1,196 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#include "asv/core/SailTrim.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "asv/core/LiftDrag.hh"
+
+namespace asv
+{
+namespace core
+{
+/////////////////////////////////////////////////
+SailTrim::SailTrim(const BoatSurface &_sail, const SailTrimOptions &_options)
+  : sail(_sail), options(_options)
+{
+  const auto axis = this->sail.trimAxis.Normalized();
+  auto split = [&](const Vector3d &_v, std::vector<Vector3d> &_parallel,
+      std::vector<Vector3d> &_perpendicular, std::vector<Vector3d> &_cross)
+  {
+    auto parallel = axis.Dot(_v) * axis;
+    _parallel.push_back(parallel);
+    _perpendicular.push_back(_v - parallel);
+    _cross.push_back(axis.Cross(_v));
+  };
+
+  for (const auto &panel : this->sail.panels)
+  {
+    auto rot = this->sail.rotation * panel.twist;
+    auto cp = this->sail.position + this->sail.rotation.RotateVector(
+        panel.cp) - this->sail.trimOrigin;
+    split(cp, this->cpParallel, this->cpPerpendicular, this->cpCross);
+    split(rot.RotateVector(this->sail.params.forward),
+        this->forwardParallel, this->forwardPerpendicular,
+        this->forwardCross);
+    split(rot.RotateVector(this->sail.params.upward),
+        this->upwardParallel, this->upwardPerpendicular,
+        this->upwardCross);
+  }
+}
+
+/////////////////////////////////////////////////
+const BoatSurface &SailTrim::Sail() const
+{
+  return this->sail;
+}
+
+/////////////////////////////////////////////////
+const SailTrimOptions &SailTrim::Options() const
+{
+  return this->options;
+}
+
+/////////////////////////////////////////////////
+SailTrimResult SailTrim::Evaluate(const Vector3d &_wind, double _trim) const
+{
+  SailTrimResult result;
+  result.trim = this->sail.trimmable ? _trim : 0.0;
+  const double c = std::cos(result.trim);
+  const double s = std::sin(result.trim);
+
+  Vector3d force;
+  LiftDragResult liftDrag;
+  for (size_t k = 0; k < this->cpParallel.size(); ++k)
+  {
+    auto cp = this->sail.trimOrigin + this->cpParallel[k] +
+        c * this->cpPerpendicular[k] + s * this->cpCross[k];
+    auto forward = this->forwardParallel[k] +
+        c * this->forwardPerpendicular[k] + s * this->forwardCross[k];
+    auto upward = this->upwardParallel[k] +
+        c * this->upwardPerpendicular[k] + s * this->upwardCross[k];
+    ComputeLiftDrag(this->sail.params,
+        this->sail.WindShearFactor(cp.z) * _wind, forward, upward,
+        this->sail.panels[k].area, liftDrag);
+    auto f = liftDrag.lift + liftDrag.drag;
+    if (!f.IsFinite())
+      continue;
+    force += f;
+    result.heelingMoment += cp.y * f.z - cp.z * f.y;
+  }
+  result.drive = force.Dot(this->options.forward);
+  result.side = force.y;
+  result.feasible = this->options.maxHeelingMoment <= 0.0 ||
+      std::abs(result.heelingMoment) <= this->options.maxHeelingMoment;
+  return result;
+}
+
+/////////////////////////////////////////////////
+void SailTrim::Evaluate(const Vector3d &_wind, const double *_trim,
+    size_t _count, double *_drive, double *_heelingMoment) const
+{
+  for (size_t i = 0; i < _count; ++i)
+  {
+    auto result = this->Evaluate(_wind, _trim[i]);
+    _drive[i] = result.drive;
+    _heelingMoment[i] = result.heelingMoment;
+  }
+}
+
+/////////////////////////////////////////////////
+SailTrimResult SailTrim::Optimize(double _aws, double _awa) const
+{
+  return this->Optimize(
+      Vector3d(-_aws * std::cos(_awa), -_aws * std::sin(_awa), 0.0));
+}
+
+/////////////////////////////////////////////////
+SailTrimResult SailTrim::Optimize(const Vector3d &_wind) const
+{
+  if (!this->sail.trimmable)
+    return this->Evaluate(_wind, 0.0);
+
+  // Sweep, keeping the best feasible trim and the trim with the least
+  // heeling moment in case none is feasible.
+  const double lo = this->sail.trimMin;
+  const double hi = this->sail.trimMax;
+  const size_t n = std::max<size_t>(this->options.samples, 3);
+  const double step = (hi - lo) / (n - 1);
+  const double infeasible = -std::numeric_limits<double>::infinity();
+  auto objective = [&](const SailTrimResult &_result)
+  {
+    return _result.feasible ? _result.drive : infeasible;
+  };
+
+  SailTrimResult best;
+  SailTrimResult least;
+  double bestValue = infeasible;
+  for (size_t i = 0; i < n; ++i)
+  {
+    auto result = this->Evaluate(_wind, lo + i * step);
+    if (objective(result) > bestValue)
+    {
+      best = result;
+      bestValue = objective(result);
+    }
+    if (i == 0 ||
+        std::abs(result.heelingMoment) < std::abs(least.heelingMoment))
+    {
+      least = result;
+    }
+  }
+  if (bestValue == infeasible)
+    return least;
+
+  // Golden section search between the neighbours of the best trim. A
+  // binding heel limit is a step down to -infinity, which the search
+  // brackets in the same way as a maximum.
+  const double ratio = 0.5 * (std::sqrt(5.0) - 1.0);
+  double a = std::max(lo, best.trim - step);
+  double b = std::min(hi, best.trim + step);
+  double x1 = b - ratio * (b - a);
+  double x2 = a + ratio * (b - a);
+  double f1 = objective(this->Evaluate(_wind, x1));
+  double f2 = objective(this->Evaluate(_wind, x2));
+  while (b - a > this->options.tolerance)
+  {
+    if (f1 >= f2)
+    {
+      b = x2;
+      x2 = x1;
+      f2 = f1;
+      x1 = b - ratio * (b - a);
+      f1 = objective(this->Evaluate(_wind, x1));
+    }
+    else
+    {
+      a = x1;
+      x1 = x2;
+      f1 = f2;
+      x2 = a + ratio * (b - a);
+      f2 = objective(this->Evaluate(_wind, x2));
+    }
+  }
+
+  auto refined = this->Evaluate(_wind, f1 >= f2 ? x1 : x2);
+  return objective(refined) >= bestValue ? refined : best;
+}
+
+}  // namespace core
+}  // namespace asv
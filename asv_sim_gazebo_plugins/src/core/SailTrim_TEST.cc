@@ -0,0 +1,158 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "asv/core/SailTrim.hh"
+
+#include "TestBoat.hh"
+
+/////////////////////////////////////////////////
+/// \brief The test sail on a mast with some rake.
+asv::core::BoatSurface RakedSail()
+{
+    auto sail = MakeSail();
+    sail.name = "sail_link";
+    sail.trimAxis = asv::core::Vector3d(0.1, 0.0, 1.0).Normalized();
+    sail.trimMin = -1.5;
+    sail.trimMax = 1.5;
+    return sail;
+}
+
+/////////////////////////////////////////////////
+TEST(SailTrim, Evaluate)
+{
+    auto sail = RakedSail();
+    asv::core::SailTrim trim(sail);
+    const asv::core::Vector3d wind(-3.0, -4.0, 0.0);
+    const asv::core::Vector3d zero;
+
+    // The forces are those of the simulation.
+    std::vector<double> trims{-1.2, -0.3, 0.0, 0.4, 1.1};
+    std::vector<double> drive(trims.size());
+    std::vector<double> heel(trims.size());
+    trim.Evaluate(wind, trims.data(), trims.size(), drive.data(),
+        heel.data());
+    for (size_t i = 0; i < trims.size(); ++i)
+    {
+      asv::core::Vector3d force;
+      asv::core::Vector3d torque;
+      sail.AddWrench(trims[i], zero, asv::core::Quaterniond(), zero, zero,
+          wind, force, torque);
+      EXPECT_NEAR(drive[i], force.x, 1.0E-9) << trims[i];
+      EXPECT_NEAR(heel[i], torque.x, 1.0E-9) << trims[i];
+      auto result = trim.Evaluate(wind, trims[i]);
+      EXPECT_NEAR(result.side, force.y, 1.0E-9) << trims[i];
+      EXPECT_TRUE(result.feasible);
+    }
+}
+
+/////////////////////////////////////////////////
+TEST(SailTrim, Optimize)
+{
+    asv::core::SailTrim trim(RakedSail());
+    for (double awa : {0.6, 1.0, 1.6, 2.4, -1.0})
+    {
+      auto result = trim.Optimize(5.0, awa);
+
+      // No trim on a fine grid has more drive.
+      const asv::core::Vector3d wind(-5.0 * std::cos(awa),
+          -5.0 * std::sin(awa), 0.0);
+      double gridBest = -1.0E9;
+      for (double t = -1.5; t <= 1.5; t += 0.001)
+        gridBest = std::max(gridBest, trim.Evaluate(wind, t).drive);
+      EXPECT_GE(result.drive, gridBest - 1.0E-6) << "awa: " << awa;
+      EXPECT_GT(result.drive, 0.0) << "awa: " << awa;
+
+      // Upwind the sail is out to leeward.
+      if (std::abs(awa) < 2.0)
+      {
+        EXPECT_GT(result.trim * awa, 0.0) << "awa: " << awa;
+      }
+    }
+
+    // Symmetric sails give mirrored trims on port and starboard.
+    auto sail = RakedSail();
+    sail.trimAxis = asv::core::Vector3d(0.0, 0.0, 1.0);
+    sail.windShearExponent = 0.0;
+    for (auto &panel : sail.panels)
+      panel.twist = asv::core::Quaterniond();
+    asv::core::SailTrim symmetric(sail);
+    auto port = symmetric.Optimize(5.0, 1.2);
+    auto starboard = symmetric.Optimize(5.0, -1.2);
+    EXPECT_NEAR(port.trim, -starboard.trim, 1.0E-3);
+    EXPECT_NEAR(port.drive, starboard.drive, 1.0E-6);
+    EXPECT_NEAR(port.heelingMoment, -starboard.heelingMoment, 1.0E-3);
+}
+
+/////////////////////////////////////////////////
+TEST(SailTrim, HeelLimit)
+{
+    const double awa = 1.0;
+    asv::core::SailTrim free(RakedSail());
+    auto unlimited = free.Optimize(6.0, awa);
+
+    asv::core::SailTrimOptions options;
+    options.maxHeelingMoment = 0.5 * std::abs(unlimited.heelingMoment);
+    asv::core::SailTrim limited(RakedSail(), options);
+    auto result = limited.Optimize(6.0, awa);
+    EXPECT_TRUE(result.feasible);
+    EXPECT_LE(std::abs(result.heelingMoment), options.maxHeelingMoment);
+    EXPECT_LT(result.drive, unlimited.drive);
+
+    // The sail is eased until the limit binds.
+    EXPECT_GT(result.trim, unlimited.trim);
+    EXPECT_NEAR(std::abs(result.heelingMoment), options.maxHeelingMoment,
+        1.0E-2 * options.maxHeelingMoment);
+
+    // No trim on a fine grid within the limit has more drive.
+    const asv::core::Vector3d wind(-6.0 * std::cos(awa),
+        -6.0 * std::sin(awa), 0.0);
+    for (double t = -1.5; t <= 1.5; t += 0.001)
+    {
+      auto point = limited.Evaluate(wind, t);
+      if (point.feasible)
+      {
+        EXPECT_LE(point.drive, result.drive + 1.0E-6) << "trim: " << t;
+      }
+    }
+
+    // With an impossible limit the least heeling trim is returned.
+    options.maxHeelingMoment = 1.0E-9;
+    auto none = asv::core::SailTrim(RakedSail(), options).Optimize(6.0, awa);
+    EXPECT_FALSE(none.feasible);
+}
+
+/////////////////////////////////////////////////
+TEST(SailTrim, Fixed)
+{
+    auto sail = RakedSail();
+    sail.trimmable = false;
+    auto result = asv::core::SailTrim(sail).Optimize(5.0, 1.0);
+    EXPECT_DOUBLE_EQ(result.trim, 0.0);
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
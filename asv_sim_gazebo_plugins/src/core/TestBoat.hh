@@ -0,0 +1,77 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ASV_CORE_TESTBOAT_HH_
+#define ASV_CORE_TESTBOAT_HH_
+
+#include "asv/core/Boat.hh"
+
+/////////////////////////////////////////////////
+/// \brief A sail of twisted strips in a wind with shear, shared by the
+/// core unit tests.
+inline asv::core::BoatSurface MakeSail()
+{
+    asv::core::BoatSurface sail;
+    sail.sail = true;
+    sail.params.area = 6.0;
+    sail.params.upward = asv::core::Vector3d(0.0, 1.0, 0.0);
+    sail.position = asv::core::Vector3d(0.5, 0.0, 1.0);
+    sail.trimmable = true;
+    sail.trimOrigin = sail.position;
+    sail.windShearExponent = 0.14;
+    sail.windReferenceHeight = 3.0;
+    for (int i = 0; i < 4; ++i)
+    {
+      sail.panels.push_back({asv::core::Vector3d(-0.4, 0.0, 0.5 + i),
+          1.5, asv::core::Quaterniond::FromAxisAngle(
+              asv::core::Vector3d(0.0, 0.0, 1.0), 0.05 * i)});
+    }
+    return sail;
+}
+
+/////////////////////////////////////////////////
+/// \brief A dinghy like the FleetWorld boat: a trimmable sail and a keel,
+/// shared by the core unit tests.
+inline asv::core::Boat MakeBoat()
+{
+    asv::core::Boat boat;
+
+    asv::core::BoatSurface sail;
+    sail.name = "sail_link";
+    sail.sail = true;
+    sail.params.fluidDensity = 1.2;
+    sail.params.area = 3.0;
+    sail.params.upward = asv::core::Vector3d(0.0, 1.0, 0.0);
+    sail.panels.push_back({asv::core::Vector3d(0.0, 0.0, 0.5), 3.0, {}});
+    sail.position = asv::core::Vector3d(0.5, 0.0, 2.0);
+    sail.trimmable = true;
+    sail.trimOrigin = sail.position;
+    boat.surfaces.push_back(sail);
+
+    asv::core::BoatSurface keel;
+    keel.name = "base_link";
+    keel.params.fluidDensity = 1025.0;
+    keel.params.area = 0.5;
+    keel.params.upward = asv::core::Vector3d(0.0, 1.0, 0.0);
+    keel.panels.push_back({asv::core::Vector3d(0.0, 0.0, -0.5), 0.5, {}});
+    boat.surfaces.push_back(keel);
+
+    boat.hull.mass = 205.0;
+    boat.hull.metacentricHeight = 1.0;
+    boat.hull.quadraticDrag = asv::core::Vector3d(20.0, 200.0, 0.0);
+    return boat;
+}
+
+#endif  // ASV_CORE_TESTBOAT_HH_
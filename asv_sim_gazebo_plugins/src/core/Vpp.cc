@@ -0,0 +1,473 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#include "asv/core/Vpp.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+namespace asv
+{
+namespace core
+{
+namespace
+{
+/// \brief Bounds of the unknowns: speed, leeway and heel.
+const std::array<double, 3> kLower{0.0, -0.7, -1.4};
+const std::array<double, 3> kUpper{
+    std::numeric_limits<double>::infinity(), 0.7, 1.4};
+
+/// \brief Largest Newton step in leeway and heel, radians.
+const double kMaxAngleStep = 0.2;
+
+/////////////////////////////////////////////////
+/// \brief The largest absolute value of a residual.
+double Norm(const std::array<double, 3> &_r)
+{
+  return std::max({std::abs(_r[0]), std::abs(_r[1]), std::abs(_r[2])});
+}
+
+/////////////////////////////////////////////////
+/// \brief Solve a 3x3 linear system by Gaussian elimination with
+/// partial pivoting.
+/// \param[in,out] _a The matrix, overwritten.
+/// \param[in,out] _b The right hand side, on output the solution.
+/// \return False if the matrix is singular.
+bool Solve3(double _a[3][3], std::array<double, 3> &_b)
+{
+  for (int k = 0; k < 3; ++k)
+  {
+    int p = k;
+    for (int i = k + 1; i < 3; ++i)
+    {
+      if (std::abs(_a[i][k]) > std::abs(_a[p][k]))
+        p = i;
+    }
+    if (std::abs(_a[p][k]) < 1.0e-12)
+      return false;
+    if (p != k)
+    {
+      for (int j = 0; j < 3; ++j)
+        std::swap(_a[k][j], _a[p][j]);
+      std::swap(_b[k], _b[p]);
+    }
+    for (int i = k + 1; i < 3; ++i)
+    {
+      double f = _a[i][k] / _a[k][k];
+      for (int j = k; j < 3; ++j)
+        _a[i][j] -= f * _a[k][j];
+      _b[i] -= f * _b[k];
+    }
+  }
+  for (int k = 2; k >= 0; --k)
+  {
+    for (int j = k + 1; j < 3; ++j)
+      _b[k] -= _a[k][j] * _b[j];
+    _b[k] /= _a[k][k];
+  }
+  return true;
+}
+}  // namespace
+
+/////////////////////////////////////////////////
+Vpp::Vpp(const Boat &_boat, const VppOptions &_options)
+  : boat(_boat), options(_options)
+{
+  double sailArea = 0.0;
+  double airDensity = 0.0;
+  double height = 0.0;
+  for (size_t i = 0; i < this->boat.surfaces.size(); ++i)
+  {
+    const auto &surface = this->boat.surfaces[i];
+    if (surface.trimmable && surface.sail)
+      this->trimmed.push_back(i);
+    if (!surface.sail)
+      continue;
+    for (const auto &panel : surface.panels)
+    {
+      sailArea += panel.area;
+      height += panel.area * std::abs(
+          (surface.position + surface.rotation.RotateVector(panel.cp)).z);
+    }
+    airDensity = surface.params.fluidDensity;
+  }
+  if (sailArea > 0.0)
+  {
+    this->sailScale = 0.5 * airDensity * sailArea;
+    this->lengthScale = std::max(height / sailArea, 0.1);
+  }
+}
+
+/////////////////////////////////////////////////
+const Boat &Vpp::BoatModel() const
+{
+  return this->boat;
+}
+
+/////////////////////////////////////////////////
+const VppOptions &Vpp::Options() const
+{
+  return this->options;
+}
+
+/////////////////////////////////////////////////
+void Vpp::Wrench(double _tws, double _twa,
+    const std::vector<double> &_trim,
+    double _speed, double _leeway, double _heel,
+    Vector3d &_force, Vector3d &_torque) const
+{
+  _force = Vector3d();
+  _torque = Vector3d();
+
+  // Heading frame: the boat moves along the course, at the leeway angle
+  // from the heading, and the wind comes from the true wind angle off
+  // the course.
+  Vector3d velBoat(_speed * std::cos(_leeway), _speed * std::sin(_leeway),
+      0.0);
+  double from = _leeway + _twa;
+  Vector3d velWind(-_tws * std::cos(from), -_tws * std::sin(from), 0.0);
+  auto bodyRot = Quaterniond::FromEuler(_heel, 0.0, 0.0);
+
+  const Vector3d zero;
+  size_t t = 0;
+  for (const auto &surface : this->boat.surfaces)
+  {
+    double trim = 0.0;
+    if (surface.trimmable && surface.sail)
+      trim = t < _trim.size() ? _trim[t++] : 0.0;
+    surface.AddWrench(trim, zero, bodyRot, velBoat, zero,
+        surface.sail ? velWind : zero, _force, _torque);
+  }
+
+  // Hull resistance, at the body origin, and the righting moment.
+  const auto &hull = this->boat.hull;
+  _force += bodyRot.RotateVector(
+      hull.Resistance(bodyRot.RotateVectorReverse(velBoat)));
+  _torque.x -= hull.mass * this->options.gravity *
+      hull.metacentricHeight * std::sin(_heel);
+}
+
+/////////////////////////////////////////////////
+bool Vpp::Balance(double _tws, double _twa,
+    const std::vector<double> &_trim, std::array<double, 3> &_x) const
+{
+  double forceScale = std::max(this->sailScale * _tws * _tws, 1.0e-9);
+  double momentScale = forceScale * this->lengthScale;
+  auto residual = [&](const std::array<double, 3> &_y)
+  {
+    Vector3d force;
+    Vector3d torque;
+    this->Wrench(_tws, _twa, _trim, _y[0], _y[1], _y[2], force, torque);
+    return std::array<double, 3>{
+        force.x / forceScale, force.y / forceScale, torque.x / momentScale};
+  };
+  auto clamp = [](std::array<double, 3> &_y)
+  {
+    for (int i = 0; i < 3; ++i)
+      _y[i] = std::clamp(_y[i], kLower[i], kUpper[i]);
+  };
+
+  // The foils have no force when the boat is at rest, so keep clear of
+  // zero speed where the Jacobian is singular.
+  const double minSpeed = 0.02;
+  auto x = _x;
+  x[0] = std::max(x[0], minSpeed);
+  clamp(x);
+  auto r = residual(x);
+  double norm = Norm(r);
+
+  for (size_t iter = 0; iter < this->options.maxIterations; ++iter)
+  {
+    if (!std::isfinite(norm))
+      return false;
+    if (norm < this->options.tolerance)
+    {
+      _x = x;
+      return true;
+    }
+
+    // Forward difference Jacobian.
+    double jac[3][3];
+    const std::array<double, 3> h{
+        1.0e-6 * std::max(x[0], 1.0), 1.0e-6, 1.0e-6};
+    for (int j = 0; j < 3; ++j)
+    {
+      auto y = x;
+      y[j] += h[j];
+      auto ry = residual(y);
+      for (int i = 0; i < 3; ++i)
+        jac[i][j] = (ry[i] - r[i]) / h[j];
+    }
+
+    std::array<double, 3> dx{-r[0], -r[1], -r[2]};
+    if (!Solve3(jac, dx))
+      return false;
+
+    // Limit the step, then backtrack until the residual decreases.
+    double scale = 1.0;
+    double maxSpeedStep = 0.5 * std::max(x[0], 0.2 * _tws);
+    if (std::abs(dx[0]) > maxSpeedStep)
+      scale = maxSpeedStep / std::abs(dx[0]);
+    for (int i = 1; i < 3; ++i)
+    {
+      if (std::abs(dx[i]) * scale > kMaxAngleStep)
+        scale = kMaxAngleStep / std::abs(dx[i]);
+    }
+
+    bool improved = false;
+    for (int k = 0; k < 12 && !improved; ++k, scale *= 0.5)
+    {
+      std::array<double, 3> y{
+          x[0] + scale * dx[0], x[1] + scale * dx[1], x[2] + scale * dx[2]};
+      clamp(y);
+      y[0] = std::max(y[0], minSpeed);
+      auto ry = residual(y);
+      double normY = Norm(ry);
+      if (normY < norm)
+      {
+        x = y;
+        r = ry;
+        norm = normY;
+        improved = true;
+      }
+    }
+    if (!improved)
+      return false;
+  }
+  return false;
+}
+
+/////////////////////////////////////////////////
+bool Vpp::BalanceFrom(double _tws, double _twa,
+    const std::vector<double> &_trim, std::array<double, 3> &_x) const
+{
+  // The given guess, then guesses spread over plausible speeds.
+  auto x = _x;
+  if (this->Balance(_tws, _twa, _trim, x))
+  {
+    _x = x;
+    return true;
+  }
+  for (double f : {0.5, 0.2, 1.0, 1.5})
+  {
+    x = {f * _tws, 0.0, 0.0};
+    if (this->Balance(_tws, _twa, _trim, x))
+    {
+      _x = x;
+      return true;
+    }
+  }
+  return false;
+}
+
+/////////////////////////////////////////////////
+VppPoint Vpp::Point(double _tws, double _twa,
+    const std::vector<double> &_trim, std::array<double, 3> _x) const
+{
+  VppPoint point;
+  point.tws = _tws;
+  point.twa = _twa;
+  point.trim = _trim;
+  if (_trim.size() != this->trimmed.size() ||
+      !this->BalanceFrom(_tws, _twa, _trim, _x))
+  {
+    return point;
+  }
+
+  point.converged = true;
+  point.speed = _x[0];
+  point.leeway = _x[1];
+  point.heel = _x[2];
+  point.vmg = _x[0] * std::cos(_twa);
+
+  // Apparent wind in the heading frame.
+  double from = _x[1] + _twa;
+  Vector3d velApparent(-_tws * std::cos(from) - _x[0] * std::cos(_x[1]),
+      -_tws * std::sin(from) - _x[0] * std::sin(_x[1]), 0.0);
+  point.aws = velApparent.Length();
+  point.awa = std::atan2(-velApparent.y, -velApparent.x);
+
+  Vector3d force;
+  Vector3d torque;
+  this->Wrench(_tws, _twa, _trim, _x[0], _x[1], _x[2], force, torque);
+  point.yawMoment = torque.z;
+  return point;
+}
+
+/////////////////////////////////////////////////
+VppPoint Vpp::Solve(double _tws, double _twa,
+    const std::vector<double> &_trim) const
+{
+  return this->Point(_tws, _twa, _trim, {0.5 * _tws, 0.0, 0.0});
+}
+
+/////////////////////////////////////////////////
+VppPoint Vpp::Solve(double _tws, double _twa) const
+{
+  std::vector<double> trim(this->trimmed.size(), 0.0);
+  if (trim.empty())
+    return this->Solve(_tws, _twa, trim);
+
+  // The speed for a trim, or -1 if the balance fails or the heel is over
+  // the limit. Each solve starts from the best state so far.
+  std::array<double, 3> best{0.5 * _tws, 0.0, 0.0};
+  double bestSpeed = -1.0;
+  auto speedAt = [&](size_t _t, double _trim)
+  {
+    double saved = trim[_t];
+    trim[_t] = _trim;
+    auto x = best;
+    double speed = -1.0;
+    if (this->BalanceFrom(_tws, _twa, trim, x) &&
+        (this->options.maxHeel <= 0.0 ||
+         std::abs(x[2]) <= this->options.maxHeel))
+    {
+      speed = x[0];
+    }
+    if (speed > bestSpeed)
+    {
+      bestSpeed = speed;
+      best = x;
+    }
+    trim[_t] = saved;
+    return speed;
+  };
+
+  size_t passes = trim.size() > 1 ? std::max<size_t>(
+      this->options.trimPasses, 1) : 1;
+  size_t samples = std::max<size_t>(this->options.trimSamples, 3);
+  for (size_t pass = 0; pass < passes; ++pass)
+  {
+    for (size_t t = 0; t < trim.size(); ++t)
+    {
+      const auto &surface = this->boat.surfaces[this->trimmed[t]];
+      double lo = surface.trimMin;
+      double hi = surface.trimMax;
+
+      // Sweep the trim range, after the first pass only near the
+      // current trim.
+      if (pass > 0)
+      {
+        double span = (hi - lo) / static_cast<double>(samples - 1);
+        lo = std::max(lo, trim[t] - span);
+        hi = std::min(hi, trim[t] + span);
+      }
+      double step = (hi - lo) / static_cast<double>(samples - 1);
+      size_t k = 0;
+      double kSpeed = -1.0;
+      for (size_t i = 0; i < samples; ++i)
+      {
+        double speed = speedAt(t, lo + step * static_cast<double>(i));
+        if (speed > kSpeed)
+        {
+          kSpeed = speed;
+          k = i;
+        }
+      }
+      if (kSpeed < 0.0)
+        continue;
+
+      // Golden section search in the bracket around the best sample.
+      const double g = 0.5 * (std::sqrt(5.0) - 1.0);
+      double a = lo + step * static_cast<double>(k > 0 ? k - 1 : 0);
+      double b = lo + step * static_cast<double>(std::min(k + 1,
+          samples - 1));
+      double c = b - g * (b - a);
+      double d = a + g * (b - a);
+      double fc = speedAt(t, c);
+      double fd = speedAt(t, d);
+      while (b - a > this->options.trimTolerance)
+      {
+        if (fc > fd)
+        {
+          b = d;
+          d = c;
+          fd = fc;
+          c = b - g * (b - a);
+          fc = speedAt(t, c);
+        }
+        else
+        {
+          a = c;
+          c = d;
+          fc = fd;
+          d = a + g * (b - a);
+          fd = speedAt(t, d);
+        }
+      }
+
+      // Keep the best trim seen, which may be the sample itself.
+      double tBest = lo + step * static_cast<double>(k);
+      double fBest = kSpeed;
+      if (fc > fBest)
+      {
+        tBest = c;
+        fBest = fc;
+      }
+      if (fd > fBest)
+        tBest = d;
+      trim[t] = tBest;
+    }
+  }
+
+  // No trim balances the forces within the heel limit.
+  if (bestSpeed < 0.0)
+  {
+    VppPoint point;
+    point.tws = _tws;
+    point.twa = _twa;
+    point.trim = trim;
+    return point;
+  }
+  return this->Point(_tws, _twa, trim, best);
+}
+
+/////////////////////////////////////////////////
+std::vector<VppPoint> Vpp::Polar(const std::vector<double> &_tws,
+    const std::vector<double> &_twa) const
+{
+  std::vector<VppPoint> points(_tws.size() * _twa.size());
+  if (points.empty())
+    return points;
+
+  size_t threads = this->options.threads;
+  if (threads == 0)
+    threads = std::max(std::thread::hardware_concurrency(), 1u);
+  threads = std::min(threads, points.size());
+
+  std::atomic<size_t> next{0};
+  auto work = [&]()
+  {
+    for (size_t i = next++; i < points.size(); i = next++)
+    {
+      points[i] = this->Solve(_tws[i / _twa.size()], _twa[i % _twa.size()]);
+    }
+  };
+
+  std::vector<std::thread> pool;
+  for (size_t i = 1; i < threads; ++i)
+    pool.emplace_back(work);
+  work();
+  for (auto &thread : pool)
+    thread.join();
+  return points;
+}
+
+}  // namespace core
+}  // namespace asv
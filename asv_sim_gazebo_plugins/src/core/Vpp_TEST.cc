@@ -0,0 +1,141 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+#include "asv/core/Vpp.hh"
+
+#include "TestBoat.hh"
+
+/////////////////////////////////////////////////
+TEST(Vpp, Balance)
+{
+    asv::core::Vpp vpp(MakeBoat());
+    auto point = vpp.Solve(5.0, 1.5, {0.9});
+    ASSERT_TRUE(point.converged);
+    EXPECT_GT(point.speed, 0.0);
+
+    // The surge and sway forces and the heeling moment balance.
+    asv::core::Vector3d force;
+    asv::core::Vector3d torque;
+    vpp.Wrench(5.0, 1.5, point.trim, point.speed, point.leeway,
+        point.heel, force, torque);
+    EXPECT_NEAR(force.x, 0.0, 1.0E-3);
+    EXPECT_NEAR(force.y, 0.0, 1.0E-3);
+    EXPECT_NEAR(torque.x, 0.0, 1.0E-2);
+
+    // With the wind on the port side the boat heels to starboard and
+    // slips to leeward.
+    EXPECT_GT(point.heel, 0.0);
+    EXPECT_LT(point.leeway, 0.0);
+    EXPECT_NEAR(point.vmg, point.speed * std::cos(1.5), 1.0E-12);
+
+    // The wrong trim count is rejected.
+    EXPECT_FALSE(vpp.Solve(5.0, 1.5, {}).converged);
+}
+
+/////////////////////////////////////////////////
+TEST(Vpp, Trim)
+{
+    asv::core::Vpp vpp(MakeBoat());
+    for (double twa : {0.8, 1.5, 2.5})
+    {
+      auto point = vpp.Solve(5.0, twa);
+      ASSERT_TRUE(point.converged) << "twa: " << twa;
+      ASSERT_EQ(point.trim.size(), 1u);
+
+      // No trim on a coarse grid is faster.
+      for (double trim = -1.5; trim <= 1.5; trim += 0.1)
+      {
+        auto fixed = vpp.Solve(5.0, twa, {trim});
+        if (fixed.converged)
+        {
+          EXPECT_LE(fixed.speed, point.speed + 1.0E-6) << "twa: " << twa;
+        }
+      }
+    }
+}
+
+/////////////////////////////////////////////////
+TEST(Vpp, Symmetry)
+{
+    asv::core::Vpp vpp(MakeBoat());
+    auto port = vpp.Solve(6.0, 1.2);
+    auto starboard = vpp.Solve(6.0, -1.2);
+    ASSERT_TRUE(port.converged);
+    ASSERT_TRUE(starboard.converged);
+    EXPECT_NEAR(port.speed, starboard.speed, 1.0E-3);
+    EXPECT_NEAR(port.heel, -starboard.heel, 1.0E-3);
+    EXPECT_NEAR(port.leeway, -starboard.leeway, 1.0E-3);
+    EXPECT_NEAR(port.trim[0], -starboard.trim[0], 1.0E-2);
+}
+
+/////////////////////////////////////////////////
+TEST(Vpp, HeelLimit)
+{
+    asv::core::Vpp free(MakeBoat());
+    auto point = free.Solve(10.0, 1.5);
+    ASSERT_TRUE(point.converged);
+
+    // Limiting the heel eases the sail and slows the boat.
+    asv::core::VppOptions options;
+    options.maxHeel = 0.5 * std::abs(point.heel);
+    asv::core::Vpp limited(MakeBoat(), options);
+    auto eased = limited.Solve(10.0, 1.5);
+    ASSERT_TRUE(eased.converged);
+    EXPECT_LE(std::abs(eased.heel), options.maxHeel + 1.0E-9);
+    EXPECT_LT(eased.speed, point.speed);
+}
+
+/////////////////////////////////////////////////
+TEST(Vpp, Polar)
+{
+    std::vector<double> tws{4.0, 8.0};
+    std::vector<double> twa{0.8, 1.6, 2.4};
+
+    asv::core::VppOptions options;
+    options.threads = 1;
+    auto serial = asv::core::Vpp(MakeBoat(), options).Polar(tws, twa);
+    options.threads = 4;
+    auto parallel = asv::core::Vpp(MakeBoat(), options).Polar(tws, twa);
+
+    // Ordered by wind speed then angle, and independent of the threads.
+    ASSERT_EQ(serial.size(), 6u);
+    ASSERT_EQ(parallel.size(), 6u);
+    for (size_t i = 0; i < serial.size(); ++i)
+    {
+      EXPECT_DOUBLE_EQ(serial[i].tws, tws[i / twa.size()]);
+      EXPECT_DOUBLE_EQ(serial[i].twa, twa[i % twa.size()]);
+      EXPECT_TRUE(serial[i].converged);
+      EXPECT_EQ(serial[i].speed, parallel[i].speed);
+      EXPECT_EQ(serial[i].trim, parallel[i].trim);
+    }
+
+    // More wind, more speed.
+    for (size_t j = 0; j < twa.size(); ++j)
+      EXPECT_GT(serial[twa.size() + j].speed, serial[j].speed);
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
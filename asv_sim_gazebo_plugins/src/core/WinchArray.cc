@@ -0,0 +1,125 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "asv/core/WinchArray.hh"
+
+#include <algorithm>
+#include <cmath>
+
+namespace asv
+{
+namespace core
+{
+/////////////////////////////////////////////////
+size_t WinchArray::Add(const WinchParams &_params, double _length)
+{
+  this->maxSpeed.push_back(_params.maxSpeed);
+  this->maxForce.push_back(_params.maxForce);
+  this->maxPower.push_back(_params.maxPower);
+  this->stiffness.push_back(_params.stiffness);
+  this->damping.push_back(_params.damping);
+  this->gain.push_back(_params.gain);
+  this->length.push_back(std::max(_length, 0.0));
+  this->tension.push_back(0.0);
+  this->extentLast.push_back(-1.0);
+  return this->length.size() - 1;
+}
+
+/////////////////////////////////////////////////
+size_t WinchArray::Size() const
+{
+  return this->length.size();
+}
+
+/////////////////////////////////////////////////
+void WinchArray::Reset(double _length)
+{
+  std::fill(this->length.begin(), this->length.end(),
+      std::max(_length, 0.0));
+  std::fill(this->tension.begin(), this->tension.end(), 0.0);
+  std::fill(this->extentLast.begin(), this->extentLast.end(), -1.0);
+}
+
+/////////////////////////////////////////////////
+double WinchArray::Length(size_t _index) const
+{
+  return this->length[_index];
+}
+
+/////////////////////////////////////////////////
+double WinchArray::Tension(size_t _index) const
+{
+  return this->tension[_index];
+}
+
+/////////////////////////////////////////////////
+double WinchArray::Update(size_t _index, double _target, double _position,
+    double _dt)
+{
+  const size_t k = _index;
+  if (_dt <= 0.0 || !std::isfinite(_target) || !std::isfinite(_position))
+    return 0.0;
+
+  // Rate the sheet is being pulled out, zero on the first update.
+  const double extent = std::abs(_position);
+  const double rate = this->extentLast[k] < 0.0 ?
+      0.0 : (extent - this->extentLast[k]) / _dt;
+  this->extentLast[k] = extent;
+
+  // Tension-only sheet.
+  const double stretch = extent - this->length[k];
+  double t = 0.0;
+  if (stretch > 0.0)
+  {
+    t = std::max(0.0,
+        this->stiffness[k] * stretch + this->damping[k] * rate);
+  }
+
+  // Winch speed, rate limited, and power limited when hauling in.
+  double v = this->gain[k] * (std::max(_target, 0.0) - this->length[k]);
+  v = std::clamp(v, -this->maxSpeed[k], this->maxSpeed[k]);
+  if (v < 0.0 && this->maxPower[k] > 0.0 && t > 0.0)
+    v = std::max(v, -this->maxPower[k] / t);
+  this->length[k] = std::max(this->length[k] + v * _dt, 0.0);
+
+  // The sheet slips on the drum above the holding force.
+  if (t > this->maxForce[k])
+  {
+    t = this->maxForce[k];
+    if (this->stiffness[k] > 0.0)
+    {
+      this->length[k] = std::max(this->length[k],
+          extent - this->maxForce[k] / this->stiffness[k]);
+    }
+  }
+  this->tension[k] = t;
+
+  // The sheet pulls the joint towards zero.
+  return _position < 0.0 ? t : -t;
+}
+
+/////////////////////////////////////////////////
+void WinchArray::Update(const double *_target, const double *_position,
+    double _dt, double *_force)
+{
+  const size_t n = this->length.size();
+  for (size_t k = 0; k < n; ++k)
+  {
+    _force[k] = this->Update(k, _target[k], _position[k], _dt);
+  }
+}
+
+}  // namespace core
+}  // namespace asv
@@ -0,0 +1,86 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "asv/core/WinchArray.hh"
+
+/////////////////////////////////////////////////
+TEST(WinchArray, Sheet)
+{
+    asv::core::WinchParams params;
+    params.maxSpeed = 0.2;
+    params.maxForce = 500.0;
+    params.stiffness = 1000.0;
+    params.damping = 0.0;
+    params.gain = 100.0;
+
+    asv::core::WinchArray winch;
+    EXPECT_EQ(winch.Add(params, 1.0), 0u);
+    EXPECT_EQ(winch.Size(), 1u);
+
+    // Slack sheet gives no force.
+    EXPECT_DOUBLE_EQ(winch.Update(0, 1.0, 0.5, 0.01), 0.0);
+    EXPECT_DOUBLE_EQ(winch.Update(0, 1.0, -0.5, 0.01), 0.0);
+
+    // A stretched sheet pulls the joint towards zero.
+    EXPECT_NEAR(winch.Update(0, 1.0, 1.1, 0.01), -100.0, 1.0E-9);
+    EXPECT_NEAR(winch.Update(0, 1.0, -1.1, 0.01), 100.0, 1.0E-9);
+
+    // Hauling in is rate limited.
+    for (int i = 0; i < 100; ++i)
+      winch.Update(0, 0.0, 0.0, 0.01);
+    EXPECT_NEAR(winch.Length(0), 0.8, 1.0E-9);
+}
+
+/////////////////////////////////////////////////
+TEST(WinchArray, Limits)
+{
+    asv::core::WinchParams params;
+    params.maxSpeed = 1.0;
+    params.maxForce = 200.0;
+    params.maxPower = 10.0;
+    params.stiffness = 1000.0;
+    params.damping = 0.0;
+    params.gain = 100.0;
+
+    asv::core::WinchArray winch;
+    winch.Add(params, 1.0);
+    winch.Add(params, 1.0);
+
+    // The sheet slips at the holding force.
+    std::vector<double> target = {1.0, 1.0};
+    std::vector<double> pos = {1.5, 1.1};
+    std::vector<double> force(2);
+    winch.Update(target.data(), pos.data(), 0.01, force.data());
+    EXPECT_NEAR(force[0], -200.0, 1.0E-9);
+    EXPECT_NEAR(winch.Length(0), 1.3, 1.0E-9);
+
+    // Hauling in under tension is power limited, 10 W / 100 N.
+    EXPECT_NEAR(force[1], -100.0, 1.0E-9);
+    EXPECT_NEAR(winch.Tension(1), 100.0, 1.0E-9);
+    target[1] = 0.0;
+    winch.Update(target.data(), pos.data(), 0.01, force.data());
+    EXPECT_NEAR(winch.Length(1), 1.0 - 0.1 * 0.01, 1.0E-9);
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -17,11 +17,13 @@
 
 #include <gz/msgs/vector3d.pb.h>
 
+#include <memory>
 #include <mutex>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include <gz/common/Console.hh>
 #include <gz/common/Profiler.hh>
@@ -48,6 +50,10 @@
 
 #include <sdf/Sensor.hh>
 
+#include "asv/sim/components/WindShadow.hh"
+#include "asv/sim/Metrics.hh"
+#include "asv/sim/Trace.hh"
+
 namespace custom
 {
 //////////////////////////////////////////////////
@@ -68,7 +74,14 @@ bool Anemometer::Load(const sdf::Sensor &_sdf)
   gz::sensors::Sensor::Load(_sdf);
 
   // Advertise topic where data will be published
-  this->pub = this->node.Advertise<gz::msgs::Vector3d>(this->Topic());
+  this->pub = asv::TransportRegistry::Advertise<gz::msgs::Vector3d>(
+      this->Topic());
+  if (!this->pub)
+    return false;
+
+  auto frame = this->msg.mutable_header()->add_data();
+  frame->set_key("frame_id");
+  frame->add_value(this->Name());
 
   if (!_sdf.Element()->HasElement("gz:anemometer"))
   {
@@ -100,16 +113,11 @@ bool Anemometer::Load(const sdf::Sensor &_sdf)
 //////////////////////////////////////////////////
 bool Anemometer::Update(const std::chrono::steady_clock::duration &_now)
 {
-  gz::msgs::Vector3d msg;
-  *msg.mutable_header()->mutable_stamp() = gz::msgs::Convert(_now);
-  auto frame = msg.mutable_header()->add_data();
-  frame->set_key("frame_id");
-  frame->add_value(this->Name());
-
-  gz::msgs::Set(&msg, this->prevApparentWindVel);
+  *this->msg.mutable_header()->mutable_stamp() = gz::msgs::Convert(_now);
+  gz::msgs::Set(&this->msg, this->prevApparentWindVel);
 
-  this->AddSequence(msg.mutable_header());
-  this->pub.Publish(msg);
+  this->AddSequence(this->msg.mutable_header());
+  this->pub->Publish(this->msg);
 
   return true;
 }
@@ -148,6 +156,18 @@ class AnemometerPrivate
   /// \brief A map of custom entities to their sensors.
   public: std::unordered_map<gz::sim::Entity,
       std::shared_ptr<custom::Anemometer>> entitySensorMap;
+
+  /// \brief A map of custom entities to their debug traces.
+  public: std::unordered_map<gz::sim::Entity,
+      std::unique_ptr<asv::TraceChannel>> entityTraceMap;
+
+  /// \brief Latency of PreUpdate.
+  public: asv::Metric &preUpdateLatency =
+      asv::Metrics::Instance().Latency("Anemometer", "PreUpdate");
+
+  /// \brief Latency of PostUpdate.
+  public: asv::Metric &postUpdateLatency =
+      asv::Metrics::Instance().Latency("Anemometer", "PostUpdate");
 };
 
 /////////////////////////////////////////////////
@@ -158,6 +178,7 @@ void AnemometerPrivate::RemoveSensorEntities(
     [&](const gz::sim::Entity &_entity,
         const gz::sim::components::CustomSensor *)->bool
       {
+        this->entityTraceMap.erase(_entity);
         if (this->entitySensorMap.erase(_entity) == 0)
         {
           gzerr << "Internal error, missing anemometer for entity ["
@@ -182,6 +203,9 @@ void Anemometer::PreUpdate(
     const UpdateInfo &/*_info*/,
     EntityComponentManager &_ecm)
 {
+  GZ_PROFILE("Anemometer::PreUpdate");
+  asv::MetricTimer timer(this->dataPtr->preUpdateLatency);
+
   _ecm.EachNew<gz::sim::components::CustomSensor,
                gz::sim::components::ParentEntity>(
     [&](const gz::sim::Entity &_entity,
@@ -219,10 +243,22 @@ void Anemometer::PreUpdate(
         _ecm.CreateComponent(_entity,
             gz::sim::components::SensorTopic(sensor->Topic()));
 
+        // Receive the wind shadow of nearby vessels
+        _ecm.CreateComponent(_entity,
+            gz::sim::components::WindShadowFactor(1.0));
+
         // Keep track of this sensor
         this->dataPtr->entitySensorMap.insert(std::make_pair(_entity,
             std::move(sensor)));
 
+        // Debug trace, 1 Hz unless set by the rule enabling it
+        auto trace = std::make_unique<asv::TraceChannel>("Anemometer",
+            std::vector<std::string>{"X_WS.pos:3", "X_WS.rot:3", "v_s_S:3",
+                "v_s_W:3", "v_wt_W:3", "v_wa_W:3", "v_wa_S:3"},
+            _entity);
+        trace->SetDefaultRate(1.0);
+        this->dataPtr->entityTraceMap[_entity] = std::move(trace);
+
         // Enable components (enable velocity checks)
         enableComponent<components::WorldLinearVelocity>(_ecm, _entity, true);
         enableComponent<components::WorldAngularVelocity>(_ecm, _entity, true);
@@ -239,6 +275,9 @@ void Anemometer::PostUpdate(
     const UpdateInfo &_info,
     const EntityComponentManager &_ecm)
 {
+  GZ_PROFILE("Anemometer::PostUpdate");
+  asv::MetricTimer timer(this->dataPtr->postUpdateLatency);
+
   // Only update and publish if not paused.
   if (!_info.paused)
   {
@@ -262,6 +301,11 @@ void Anemometer::PostUpdate(
       {
         v_wt_W = velWindWorldComp->Data();
       }
+      auto shadowComp = _ecm.Component<components::WindShadowFactor>(entity);
+      if (shadowComp)
+      {
+        v_wt_W *= shadowComp->Data();
+      }
 
       // Apparent wind velocity at the sensor origin in the world frame.
       math::Vector3d v_wa_W = v_wt_W - v_s_W;
@@ -271,25 +315,25 @@ void Anemometer::PostUpdate(
       math::Vector3d v_wa_S = X_WS.Rot().Inverse().RotateVector(v_wa_W);
 
       // debug info
-      #if 0
-      auto link = sim::Link(entity);
-      gzmsg << "\n"
-            << "parent_link:  "
-            << link.Name(_ecm).value() << "\n"
-            << "sensor_link:  " << sensor->Name() << "\n"
-            << "X_WS.Pos():   " << X_WS.Pos() << "\n"
-            << "X_WS.Rot():   " << X_WS.Rot().Euler() << "\n"
-            << "v_s_S:        " << v_s_S << "\n"
-            << "v_s_W:        " << v_s_W << "\n"
-            << "v_wt_W:       " << v_wt_W << "\n"
-            << "v_wa_W:       " << v_wa_W << "\n"
-            << "v_wa_S:       " << v_wa_S
-            << "\n";
-      #endif
-
-      // Update the sensor.
+      auto traceIt = this->dataPtr->entityTraceMap.find(entity);
+      if (traceIt != this->dataPtr->entityTraceMap.end() &&
+          traceIt->second->Enabled())
+      {
+        auto rot = X_WS.Rot().Euler();
+        traceIt->second->Write(
+            std::chrono::duration<double>(_info.simTime).count(), {
+            X_WS.Pos().X(), X_WS.Pos().Y(), X_WS.Pos().Z(),
+            rot.X(), rot.Y(), rot.Z(),
+            v_s_S.X(), v_s_S.Y(), v_s_S.Z(),
+            v_s_W.X(), v_s_W.Y(), v_s_W.Z(),
+            v_wt_W.X(), v_wt_W.Y(), v_wt_W.Z(),
+            v_wa_W.X(), v_wa_W.Y(), v_wa_W.Z(),
+            v_wa_S.X(), v_wa_S.Y(), v_wa_S.Z()});
+      }
+
+      // Update the sensor, which publishes at its <update_rate>.
       sensor->SetApparentWindVelocity(v_wa_S);
-      sensor->Update(_info.simTime);
+      sensor->Update(_info.simTime, false);
     }
   }
 
@@ -24,12 +24,13 @@
 #include <string>
 
 #include <gz/math/Vector3.hh>
+#include <gz/msgs/vector3d.pb.h>
 
 #include <gz/sensors/Sensor.hh>
 #include <gz/sensors/SensorTypes.hh>
 #include <gz/sim/System.hh>
 
-#include <gz/transport/Node.hh>
+#include "asv/sim/TransportRegistry.hh"
 
 namespace custom
 {
@@ -46,6 +47,9 @@ class Anemometer : public gz::sensors::Sensor
   public: virtual bool Update(
     const std::chrono::steady_clock::duration &_now) override;
 
+  // Rate limited update, as declared by the base class.
+  public: using gz::sensors::Sensor::Update;
+
   /// \brief Set the apparent wind velocity.
   public: void SetApparentWindVelocity(const gz::math::Vector3d &_vel);
 
@@ -59,11 +63,12 @@ class Anemometer : public gz::sensors::Sensor
   /// \brief Noise that will be applied to the sensor data
   private: gz::sensors::NoisePtr noise{nullptr};
 
-  /// \brief Node for communication
-  private: gz::transport::Node node;
+  /// \brief Publishes sensor data, shared through the registry.
+  private: asv::TransportRegistry::Publisher pub;
 
-  /// \brief Publishes sensor data
-  private: gz::transport::Node::Publisher pub;
+  /// \brief Message reused for every update, so publishing does not
+  /// rebuild the header.
+  private: gz::msgs::Vector3d msg;
 };
 }  // namespace custom
 
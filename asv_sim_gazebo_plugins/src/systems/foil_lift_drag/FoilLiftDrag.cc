@@ -34,6 +34,8 @@
 
 #include "FoilLiftDrag.hh"
 
+#include <algorithm>
+#include <memory>
 #include <mutex>
 #include <string>
 
@@ -45,9 +47,15 @@
 #include <gz/sim/Link.hh>
 #include <gz/sim/Model.hh>
 #include <gz/sim/Util.hh>
-#include <gz/transport/Node.hh>
+#include <gz/transport/TopicUtils.hh>
 
+#include "asv/sim/FlightRecorder.hh"
 #include "asv/sim/LiftDragModel.hh"
+#include "asv/sim/LiftDragTelemetry.hh"
+#include "asv/sim/Log.hh"
+#include "asv/sim/Metrics.hh"
+#include "asv/sim/WakeBuffer.hh"
+#include "asv/sim/components/FoilWake.hh"
 
 namespace gz
 {
@@ -55,21 +63,53 @@ namespace sim
 {
 namespace systems
 {
+/////////////////////////////////////////////////
+/// \brief Downwash coupling to an upstream foil.
+class FoilUpstream
+{
+  /// \brief The upstream foil link.
+  public: Link link{kNullEntity};
+
+  /// \brief Span of the upstream foil.
+  public: double span{1.0};
+
+  /// \brief Scale applied to the downwash, Gamma / span.
+  public: double downwashFactor{1.0};
+
+  /// \brief Distance the wake convects to reach this foil. If not
+  /// positive it is the separation of the link origins along the flow.
+  public: double distance{0.0};
+
+  /// \brief Lagged wake state of the upstream foil.
+  public: asv::WakeBuffer wake;
+};
+
 /////////////////////////////////////////////////
 class FoilLiftDragPrivate
 {
+  /// \brief Load the upstream coupling from SDF.
+  /// \return True if successful.
+  public: bool LoadUpstream(
+      const std::shared_ptr<const sdf::Element> &_sdf,
+      EntityComponentManager &_ecm);
+
+  /// \brief Downwash from the upstream foil at this foil.
+  /// \param[in] _ecm The entity component manager.
+  /// \param[in] _simTime The current simulation time in seconds.
+  /// \param[in] _velWorld Free stream at the centre of pressure.
+  /// \param[in] _cpWorld Centre of pressure (world frame).
+  public: math::Vector3d Downwash(
+      const EntityComponentManager &_ecm,
+      double _simTime,
+      const math::Vector3d &_velWorld,
+      const math::Vector3d &_cpWorld);
+
   /// \brief Model interface
   public: Model model{kNullEntity};
 
   /// \brief Link interface.
   public: Link link{kNullEntity};
 
-  /// \brief Gazebo communication node.
-  public: transport::Node node;
-
-  /// \brief Publish to topic "/model/<model>/link/<link>/foil_lift_drag".
-  public: transport::Node::Publisher liftDragPub;
-
   /// \brief Update period calculated from <update_rate>.
   public: std::chrono::steady_clock::duration updatePeriod{0};
 
@@ -81,8 +121,109 @@ class FoilLiftDragPrivate
 
   /// \brief Lift drag model.
   public: std::unique_ptr<asv::LiftDragModel> liftDrag;
+
+  /// \brief Lift drag telemetry, disabled unless <telemetry> is set.
+  public: asv::LiftDragTelemetry telemetry;
+
+  /// \brief Optional coupling to an upstream foil.
+  public: std::unique_ptr<FoilUpstream> upstream;
+
+  /// \brief Latency of PreUpdate.
+  public: asv::Metric &preUpdateLatency =
+      asv::Metrics::Instance().Latency("FoilLiftDrag", "PreUpdate");
+
+  /// \brief Number of updates of the link, set in Configure.
+  public: asv::Metric *calls{nullptr};
 };
 
+/////////////////////////////////////////////////
+bool FoilLiftDragPrivate::LoadUpstream(
+    const std::shared_ptr<const sdf::Element> &_sdf,
+    EntityComponentManager &_ecm)
+{
+  if (!_sdf->HasElement("link_name"))
+  {
+    gzerr << "You must specify a <link_name> for the <upstream> foil.\n";
+    return false;
+  }
+  auto linkName = _sdf->Get<std::string>("link_name");
+  auto linkEntity = this->model.LinkByName(_ecm, linkName);
+  if (!_ecm.HasEntity(linkEntity))
+  {
+    gzerr << "Upstream link with name [" << linkName << "] not found "
+          << "in model [" << this->model.Name(_ecm) << "].\n";
+    return false;
+  }
+
+  size_t bufferSize = 256;
+  double samplePeriod = 0.01;
+  if (_sdf->HasElement("buffer_size"))
+    bufferSize = _sdf->Get<int>("buffer_size");
+  if (_sdf->HasElement("sample_period"))
+    samplePeriod = _sdf->Get<double>("sample_period");
+  if (bufferSize < 2 || samplePeriod <= 0.0)
+  {
+    gzerr << "<upstream> requires a <buffer_size> of at least 2 "
+          << "and a positive <sample_period>.\n";
+    return false;
+  }
+
+  auto upstream = std::make_unique<FoilUpstream>();
+  upstream->link = Link(linkEntity);
+  upstream->wake = asv::WakeBuffer(bufferSize, samplePeriod);
+  if (_sdf->HasElement("span"))
+    upstream->span = _sdf->Get<double>("span");
+  if (_sdf->HasElement("downwash_factor"))
+    upstream->downwashFactor = _sdf->Get<double>("downwash_factor");
+  if (_sdf->HasElement("distance"))
+    upstream->distance = _sdf->Get<double>("distance");
+  if (upstream->span <= 0.0)
+  {
+    gzerr << "The <upstream> <span> must be positive.\n";
+    return false;
+  }
+
+  this->upstream = std::move(upstream);
+  return true;
+}
+
+/////////////////////////////////////////////////
+math::Vector3d FoilLiftDragPrivate::Downwash(
+    const EntityComponentManager &_ecm,
+    double _simTime,
+    const math::Vector3d &_velWorld,
+    const math::Vector3d &_cpWorld)
+{
+  auto &upstream = *this->upstream;
+
+  // Record the latest upstream wake state. The upstream foil may not
+  // have run yet this step, which adds at most one step of lag.
+  auto wakeComp = _ecm.Component<components::FoilWake>(
+      upstream.link.Entity());
+  if (wakeComp)
+    upstream.wake.Push(_simTime, wakeComp->Data());
+
+  double speed = _velWorld.Length();
+  if (speed < 1.0E-6)
+    return math::Vector3d::Zero;
+
+  // Convection time from the upstream foil.
+  double distance = upstream.distance;
+  if (distance <= 0.0)
+  {
+    auto upPoseOpt = upstream.link.WorldPose(_ecm);
+    if (!upPoseOpt.has_value())
+      return math::Vector3d::Zero;
+    distance = asv::ConvectionDistance(
+        upPoseOpt->Pos(), _cpWorld, _velWorld);
+  }
+  auto wake = upstream.wake.Sample(_simTime - distance / speed);
+
+  // The wake is Gamma * span along the upstream lift, and induces a
+  // downwash opposing it.
+  return -upstream.downwashFactor / (upstream.span * upstream.span) * wake;
+}
+
 /////////////////////////////////////////////////
 FoilLiftDrag::~FoilLiftDrag() = default;
 
@@ -140,13 +281,52 @@ void FoilLiftDrag::Configure(
 
   {
     double rate = 50.0;
+    if (_sdf->HasElement("update_rate"))
+      rate = _sdf->Get<double>("update_rate");
     std::chrono::duration<double> period{rate > 0.0 ? 1.0 / rate : 0.0};
     this->dataPtr->updatePeriod = std::chrono::duration_cast<
         std::chrono::steady_clock::duration>(period);
+
+    if (_sdf->Get<bool>("telemetry", false).first)
+    {
+      std::string topic = "/model/" + this->dataPtr->model.Name(_ecm) +
+          "/link/" + this->dataPtr->link.Name(_ecm).value_or("") +
+          "/foil_lift_drag";
+      if (_sdf->HasElement("telemetry_topic"))
+        topic = _sdf->Get<std::string>("telemetry_topic");
+      topic = transport::TopicUtils::AsValidTopic(topic);
+      if (topic.empty())
+      {
+        gzerr << "Failed to create a valid <telemetry_topic> for the "
+              << "FoilLiftDrag plugin.\n";
+        return;
+      }
+      this->dataPtr->telemetry.Configure(topic, rate);
+    }
   }
 
   // Lift / Drag model
   this->dataPtr->liftDrag.reset(asv::LiftDragModel::Create(_sdf));
+  if (this->dataPtr->liftDrag)
+    this->dataPtr->liftDrag->SetTraceEntity(this->dataPtr->link.Entity());
+  this->dataPtr->calls = &asv::Metrics::Instance().Counter("FoilLiftDrag",
+      "calls", this->dataPtr->link.Entity());
+
+  // Upstream foil
+  if (_sdf->HasElement("upstream"))
+  {
+    if (!this->dataPtr->LoadUpstream(_sdf->FindElement("upstream"), _ecm))
+    {
+      gzerr << "Failed to load <upstream>. "
+            << "The FoilLiftDrag plugin will not generate forces.\n";
+      this->dataPtr->liftDrag.reset();
+      return;
+    }
+  }
+
+  // Wake state read by any downstream foils.
+  _ecm.CreateComponent(this->dataPtr->link.Entity(),
+      components::FoilWake(math::Vector3d::Zero));
 }
 
 /////////////////////////////////////////////////
@@ -154,11 +334,15 @@ void FoilLiftDrag::PreUpdate(
     const UpdateInfo &_info,
     EntityComponentManager &_ecm)
 {
+  GZ_PROFILE("FoilLiftDrag::PreUpdate");
+  asv::MetricTimer timer(this->dataPtr->preUpdateLatency);
+
   if (_info.paused)
     return;
 
   if (!this->dataPtr->link.Valid(_ecm) || !this->dataPtr->liftDrag)
     return;
+  this->dataPtr->calls->Increment();
 
   // ensure components are available
   this->dataPtr->link.EnableVelocityChecks(_ecm, true);
@@ -180,6 +364,17 @@ void FoilLiftDrag::PreUpdate(
   // Free stream velocity at centre of pressure (world frame).
   auto velWorld = - velCpWorld;
 
+  // Rotate the centre of pressure (CP) into the world frame.
+  auto xr = linkPoseWorld.Rot().RotateVector(this->dataPtr->cpLink);
+
+  // Downwash from the upstream foil.
+  if (this->dataPtr->upstream)
+  {
+    double simTime = std::chrono::duration<double>(_info.simTime).count();
+    velWorld += this->dataPtr->Downwash(_ecm, simTime, velWorld,
+        linkPoseWorld.Pos() + xr);
+  }
+
   // Compute lift and drag in world frame
   double alpha = 0;
   double u = 0;
@@ -190,17 +385,38 @@ void FoilLiftDrag::PreUpdate(
   this->dataPtr->liftDrag->Compute(velWorld, linkPoseWorld,
       lift, drag, alpha, u, cl, cd);
 
-  // Rotate the centre of pressure (CP) into the world frame.
-  auto xr = linkPoseWorld.Rot().RotateVector(this->dataPtr->cpLink);
-
-  // Ensure no overflow.
+  // Ensure no overflow, keeping the state that led to it.
+  if (!lift.IsFinite() || !drag.IsFinite())
+  {
+    asv::FlightRecorder::Instance().Freeze(
+        "FoilLiftDrag: non-finite lift or drag",
+        std::chrono::duration<double>(_info.simTime).count());
+  }
   lift.Correct();
   drag.Correct();
 
+  // Wake state for downstream foils.
+  {
+    auto wake = math::Vector3d::Zero;
+    double rhoU = this->dataPtr->liftDrag->FluidDensity() * u;
+    if (rhoU > 1.0E-9)
+      wake = lift / rhoU;
+    _ecm.SetComponentData<components::FoilWake>(
+        this->dataPtr->link.Entity(), wake);
+  }
+
   // Compute torque (about link origin in world frame)
   auto liftTorque = xr.Cross(lift);
   auto dragTorque = xr.Cross(drag);
 
+  if (this->dataPtr->telemetry.Due(_info.simTime))
+  {
+    this->dataPtr->telemetry.Publish(_info.simTime, alpha, u, cl, cd,
+        lift, drag, liftTorque + dragTorque);
+  }
+  asv::LiftDragTelemetry::Record(_info.simTime,
+      this->dataPtr->link.Entity(), alpha, u, cl, cd, lift, drag, velWorld);
+
   // Add force and torque to link (applied at link origin in world frame).
   if (lift.IsFinite() && liftTorque.IsFinite())
   {
@@ -210,12 +426,16 @@ void FoilLiftDrag::PreUpdate(
   }
   else
   {
-    gzwarn << "FoilLiftDrag: overflow in lift calculation\n"
-           << "Link:         " << this->dataPtr->link.Name(_ecm).value() << "\n"
-           << "xr:           " << xr << "\n"
-           << "lift:         " << lift << "\n"
-           << "liftTorque:   " << liftTorque << "\n"
-           << "\n";
+    asvwarn << "FoilLiftDrag: overflow in lift calculation\n"
+            << "Link:         "
+            << this->dataPtr->link.Name(_ecm).value() << "\n"
+            << "xr:           " << xr << "\n"
+            << "lift:         " << lift << "\n"
+            << "liftTorque:   " << liftTorque << "\n"
+            << "\n";
+    asv::FlightRecorder::Instance().Freeze(
+        "FoilLiftDrag: overflow in lift calculation",
+        std::chrono::duration<double>(_info.simTime).count());
   }
   if (drag.IsFinite() && dragTorque.IsFinite())
   {
@@ -225,12 +445,16 @@ void FoilLiftDrag::PreUpdate(
   }
   else
   {
-    gzwarn << "FoilLiftDrag: overflow in drag calculation\n"
-           << "Link:         " << this->dataPtr->link.Name(_ecm).value() << "\n"
-           << "xr:           " << xr << "\n"
-           << "drag:         " << drag << "\n"
-           << "dragTorque:   " << dragTorque << "\n"
-           << "\n";
+    asvwarn << "FoilLiftDrag: overflow in drag calculation\n"
+            << "Link:         "
+            << this->dataPtr->link.Name(_ecm).value() << "\n"
+            << "xr:           " << xr << "\n"
+            << "drag:         " << drag << "\n"
+            << "dragTorque:   " << dragTorque << "\n"
+            << "\n";
+    asv::FlightRecorder::Instance().Freeze(
+        "FoilLiftDrag: overflow in drag calculation",
+        std::chrono::duration<double>(_info.simTime).count());
   }
 }
 
@@ -35,6 +35,46 @@ class FoilLiftDragPrivate;
 
 /// \brief A plugin that simulates lift and drag on a foil moving
 /// in a stationary fluid.
+///
+/// A downstream foil, such as a rudder behind a keel, may be coupled to
+/// the upstream foil's wake. Each foil publishes its circulation times
+/// span on its link, and the downstream foil keeps a fixed-size
+/// asv::WakeBuffer of it, sampled after the convection time to give the
+/// downwash added to the free stream.
+///
+/// # Parameters
+///
+/// 1. <upstream> (element, optional)
+///   <link_name> of the upstream foil, which must also use FoilLiftDrag,
+///   and the following:
+///
+///   <span> (double, default: 1)
+///     Span of the upstream foil.
+///
+///   <downwash_factor> (double, default: 1)
+///     The downwash is this factor times the upstream circulation
+///     divided by its span.
+///
+///   <distance> (double, default: 0)
+///     Convection distance from the upstream foil. If not positive the
+///     separation of the upstream link origin and the centre of pressure
+///     along the flow is used.
+///
+///   <buffer_size> (int, default: 256)
+///   <sample_period> (double, default: 0.01)
+///     Size and sample period of the wake history. Delays longer than
+///     their product are clamped.
+///
+/// 2. <telemetry> (bool, default: false)
+///   Publish the lift and drag state as an asv::LiftDragTelemetry
+///   message.
+///
+/// 3. <telemetry_topic> (string, default:
+///   /model/<model>/link/<link>/foil_lift_drag)
+///
+/// 4. <update_rate> (double, default: 50)
+///   Telemetry rate in Hz of simulation time.
+///
 class FoilLiftDrag
     : public System,
       public ISystemConfigure,
@@ -0,0 +1,161 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "Metrics.hh"
+
+#include <chrono>
+#include <string>
+
+#include <gz/msgs/stringmsg.pb.h>
+
+#include <gz/common/Console.hh>
+#include <gz/plugin/Register.hh>
+#include <gz/sim/EntityComponentManager.hh>
+#include <gz/sim/World.hh>
+#include <gz/transport/TopicUtils.hh>
+
+#include "asv/sim/Metrics.hh"
+#include "asv/sim/TransportRegistry.hh"
+
+namespace gz
+{
+namespace sim
+{
+namespace systems
+{
+/////////////////////////////////////////////////
+class MetricsPrivate
+{
+  /// \brief Publish the metrics and write the file.
+  public: void Publish();
+
+  /// \brief Metrics publisher.
+  public: asv::TransportRegistry::Publisher pub;
+
+  /// \brief The CSV file, or empty.
+  public: std::string csvPath;
+
+  /// \brief Publication period calculated from <update_rate>.
+  public: std::chrono::steady_clock::duration updatePeriod{0};
+
+  /// \brief Previous publication time.
+  public: std::chrono::steady_clock::duration lastUpdateTime{0};
+
+  /// \brief True once configured.
+  public: bool valid{false};
+};
+
+/////////////////////////////////////////////////
+void MetricsPrivate::Publish()
+{
+  std::string csv = asv::Metrics::Instance().Csv();
+  if (this->pub)
+  {
+    msgs::StringMsg msg;
+    msg.set_data(csv);
+    this->pub->Publish(msg);
+  }
+  if (!this->csvPath.empty())
+    asv::Metrics::Instance().WriteCsv(this->csvPath);
+}
+
+/////////////////////////////////////////////////
+Metrics::~Metrics()
+{
+  if (this->dataPtr->valid && !this->dataPtr->csvPath.empty())
+    asv::Metrics::Instance().WriteCsv(this->dataPtr->csvPath);
+}
+
+/////////////////////////////////////////////////
+Metrics::Metrics()
+  : System(), dataPtr(std::make_unique<MetricsPrivate>())
+{
+}
+
+/////////////////////////////////////////////////
+void Metrics::Configure(
+    const Entity &_entity,
+    const std::shared_ptr<const sdf::Element> &_sdf,
+    EntityComponentManager &_ecm,
+    EventManager &/*_eventMgr*/)
+{
+  if (!World(_entity).Valid(_ecm))
+  {
+    gzerr << "Metrics plugin should be attached to a world "
+          << "entity. Failed to initialize.\n";
+    return;
+  }
+
+  std::string topic = "/asv_sim/metrics";
+  if (_sdf->HasElement("topic"))
+    topic = _sdf->Get<std::string>("topic");
+  topic = transport::TopicUtils::AsValidTopic(topic);
+  if (topic.empty())
+  {
+    gzerr << "Failed to create a valid <topic> for the Metrics plugin.\n";
+    return;
+  }
+
+  double rate = 1.0;
+  if (_sdf->HasElement("update_rate"))
+    rate = _sdf->Get<double>("update_rate");
+  std::chrono::duration<double> period{rate > 0.0 ? 1.0 / rate : 0.0};
+  this->dataPtr->updatePeriod = std::chrono::duration_cast<
+      std::chrono::steady_clock::duration>(period);
+
+  if (_sdf->HasElement("csv"))
+    this->dataPtr->csvPath = _sdf->Get<std::string>("csv");
+
+  this->dataPtr->pub =
+      asv::TransportRegistry::Advertise<msgs::StringMsg>(topic);
+  if (!this->dataPtr->pub)
+  {
+    gzerr << "Failed to advertise [" << topic << "] for the Metrics "
+          << "plugin.\n";
+    return;
+  }
+
+  this->dataPtr->valid = true;
+  gzmsg << "[Metrics] publishing on [" << topic << "].\n";
+}
+
+/////////////////////////////////////////////////
+void Metrics::PostUpdate(
+    const UpdateInfo &_info,
+    const EntityComponentManager &/*_ecm*/)
+{
+  if (!this->dataPtr->valid || _info.paused)
+    return;
+
+  auto elapsed = _info.simTime - this->dataPtr->lastUpdateTime;
+  if (elapsed < this->dataPtr->updatePeriod && elapsed.count() >= 0)
+    return;
+  this->dataPtr->lastUpdateTime = _info.simTime;
+  this->dataPtr->Publish();
+}
+
+}  // namespace systems
+}  // namespace sim
+}  // namespace gz
+
+GZ_ADD_PLUGIN(
+    gz::sim::systems::Metrics,
+    gz::sim::System,
+    gz::sim::systems::Metrics::ISystemConfigure,
+    gz::sim::systems::Metrics::ISystemPostUpdate)
+
+GZ_ADD_PLUGIN_ALIAS(
+    gz::sim::systems::Metrics,
+    "gz::sim::systems::Metrics")
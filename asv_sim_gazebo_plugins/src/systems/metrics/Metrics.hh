@@ -0,0 +1,106 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ASV_SIM_METRICSSYSTEM_HH_
+#define ASV_SIM_METRICSSYSTEM_HH_
+
+#include <memory>
+#include <string>
+
+#include <gz/sim/System.hh>
+
+namespace gz
+{
+namespace sim
+{
+// Inline bracket to help doxygen filtering.
+inline namespace GZ_SIM_VERSION_NAMESPACE {
+namespace systems
+{
+
+// Forward declarations.
+class MetricsPrivate;
+
+/// \brief A plugin that publishes the metrics of the asv_sim systems.
+///
+/// The asv_sim systems always collect metrics in asv::Metrics: latency
+/// histograms of each update phase, call counts per entity and solver
+/// iterations. This plugin publishes them as CSV (gz::msgs::StringMsg)
+/// and optionally writes them to a file, so the cost of the aerodynamic
+/// and mooring systems can be watched without a profiler:
+///
+/// \code
+/// gz topic -e -t /asv_sim/metrics
+/// \endcode
+///
+/// The columns are kind, system, name, entity, count, sum, min, max,
+/// p50, p90, p99 and allocations. Latencies are in nanoseconds and
+/// quantiles are upper bounds accurate to a factor of 2.
+///
+/// # Usage
+///
+/// \code
+/// <plugin filename="asv_sim2-metrics-system"
+///     name="gz::sim::systems::Metrics">
+///   <update_rate>0.2</update_rate>
+///   <csv>/tmp/asv_sim_metrics.csv</csv>
+/// </plugin>
+/// \endcode
+///
+/// # Parameters
+///
+/// 1. <topic> (string, default: /asv_sim/metrics)
+///   The topic the metrics are published on.
+///
+/// 2. <update_rate> (double, default: 1)
+///   Publication rate in Hz of simulation time.
+///
+/// 3. <csv> (string, optional)
+///   A file rewritten with the metrics at each publication and when the
+///   plugin is unloaded.
+///
+class Metrics
+    : public System,
+      public ISystemConfigure,
+      public ISystemPostUpdate
+{
+  /// \brief Destructor.
+  public: virtual ~Metrics();
+
+  /// \brief Constructor.
+  public: Metrics();
+
+  // Documentation inherited
+  public: void Configure(
+      const Entity &_entity,
+      const std::shared_ptr<const sdf::Element> &_sdf,
+      EntityComponentManager &_ecm,
+      EventManager &_eventMgr) final;
+
+  /// Documentation inherited
+  public: void PostUpdate(
+      const UpdateInfo &_info,
+      const EntityComponentManager &_ecm) override;
+
+  /// \brief Private data pointer.
+  private: std::unique_ptr<MetricsPrivate> dataPtr;
+};
+
+}  // namespace systems
+}
+}  // namespace sim
+}  // namespace gz
+
+#endif  // ASV_SIM_METRICSSYSTEM_HH_
@@ -40,6 +40,7 @@
 #include <cmath>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <gz/common/Profiler.hh>
 #include <gz/plugin/Register.hh>
@@ -48,6 +49,13 @@
 #include <gz/sim/World.hh>
 #include <gz/sim/Util.hh>
 
+#include "asv/core/Catenary.hh"
+#include "asv/sim/FlightRecorder.hh"
+#include "asv/sim/Log.hh"
+#include "asv/sim/Metrics.hh"
+#include "asv/sim/Recorder.hh"
+#include "asv/sim/Trace.hh"
+
 namespace gz
 {
 namespace sim
@@ -97,21 +105,15 @@ class MooringPrivate
   /// \brief radians, atan2 angle of buoy from anchor
   public: double theta{std::nanf("")};
 
-  /// \brief Catenary equation to pass to solver
-  public: std::unique_ptr<CatenaryHSoln> catenarySoln;
+  /// \brief Solver for the catenary equation, reused every step.
+  public: asv::core::CatenaryHSolver catenarySolver;
 
   /// \brief Solution to catenary equation. Meters, length of chain laying on
   /// the bottom, start of catenary.
-  public: Eigen::VectorXd B{};
-
-  /// \brief Debug print period calculated from <debug_print_rate>
-  public: std::chrono::steady_clock::duration debugPrintPeriod{0};
+  public: double B{std::nanf("")};
 
-  /// \brief Last debug print simulation time
-  public: std::chrono::steady_clock::duration lastDebugPrintTime{0};
-
-  /// \brief Constructor
-  public: MooringPrivate();
+  /// \brief Debug trace of the solver, throttled by <debug_print_rate>
+  public: std::unique_ptr<asv::TraceChannel> trace;
 
   /// \brief Look for buoy link to find input to catenary equation, and heave
   /// cone link to apply output force to
@@ -119,12 +121,51 @@ class MooringPrivate
 
   /// \brief Update V and H for solver input
   public: void UpdateVH(sim::EntityComponentManager &_ecm);
+
+  /// \brief Record the force on the link to the flight recorder and,
+  /// if it is open, the trace recorder.
+  public: void Record(const UpdateInfo &_info, const math::Vector3d &_force);
+
+  /// \brief Record type of the mooring trace.
+  public: uint32_t recordType{asv::Recorder::kInvalidType};
+
+  /// \brief Latency of PreUpdate.
+  public: asv::Metric &preUpdateLatency =
+      asv::Metrics::Instance().Latency("Mooring", "PreUpdate");
+
+  /// \brief Iterations of the catenary solver.
+  public: asv::Metric &solverIterations =
+      asv::Metrics::Instance().Value("Mooring", "solver_iterations");
+
+  /// \brief Function evaluations of the catenary solver.
+  public: asv::Metric &solverEvaluations =
+      asv::Metrics::Instance().Value("Mooring", "solver_evaluations");
+
+  /// \brief Number of times the catenary solver failed to converge.
+  public: asv::Metric &solverFailures =
+      asv::Metrics::Instance().Counter("Mooring", "solver_failures");
 };
 
 //////////////////////////////////////////////////
-MooringPrivate::MooringPrivate()
-    : catenarySoln(std::make_unique<CatenaryHSoln>(V, H, L))
+void MooringPrivate::Record(const UpdateInfo &_info,
+    const math::Vector3d &_force)
 {
+  const double time = std::chrono::duration<double>(_info.simTime).count();
+  const double values[] = {
+      _force.X(), _force.Y(), _force.Z(), this->V, this->H};
+  asv::FlightRecorder::Instance().Write(asv::FlightRecorder::kMooring,
+      time, this->link.Entity(), values, 5);
+
+  auto &recorder = asv::Recorder::Instance();
+  if (!recorder.IsOpen())
+    return;
+
+  if (this->recordType == asv::Recorder::kInvalidType)
+  {
+    this->recordType = recorder.RegisterType("mooring",
+        {"force_x", "force_y", "force_z", "v", "h"});
+  }
+  recorder.Record(this->recordType, time, this->link.Entity(), values);
 }
 
 //////////////////////////////////////////////////
@@ -171,8 +212,6 @@ void MooringPrivate::UpdateVH(sim::EntityComponentManager &_ecm)
   // Update angle between buoy and anchor
   this->theta = std::atan2(this->linkWorldPos[1U] - this->anchorWorldPos[1U],
       this->linkWorldPos[0U] - this->anchorWorldPos[0U]);
-
-  this->catenarySoln.reset(new CatenaryHSoln(this->V, this->H, this->L));
 }
 
 /////////////////////////////////////////////////
@@ -268,9 +307,12 @@ void Mooring::Configure(
       rate = _sdf->Get<double>("debug_print_rate", rate).first;
       gzdbg << "Debug print rate set to " << rate << std::endl;
     }
-    std::chrono::duration<double> period{rate > 0.0 ? 1.0 / rate : 0.0};
-    this->dataPtr->debugPrintPeriod = std::chrono::duration_cast<
-        std::chrono::steady_clock::duration>(period);
+    this->dataPtr->trace = std::make_unique<asv::TraceChannel>("Mooring",
+        std::vector<std::string>{"solverInfo", "anchor:3", "link:3", "L",
+            "V+H", "V", "H", "b", "B", "c", "theta", "Tx", "Ty", "Tr", "Tz",
+            "nfev", "iter", "fnorm"},
+        _entity);
+    this->dataPtr->trace->SetDefaultRate(rate);
   }
 
   // Find necessary model links
@@ -279,7 +321,10 @@ void Mooring::Configure(
     this->dataPtr->UpdateVH(_ecm);
   }
 
-  this->dataPtr->B.resize(1U);
+  // Tolerance for error between two consecutive iterations
+  this->dataPtr->catenarySolver.xtol = 0.001;
+  // Max number of calls to the function
+  this->dataPtr->catenarySolver.maxfev = 20;
 }
 
 /////////////////////////////////////////////////
@@ -288,6 +333,7 @@ void Mooring::PreUpdate(
     EntityComponentManager &_ecm)
 {
   GZ_PROFILE("Mooring::PreUpdate");
+  asv::MetricTimer timer(this->dataPtr->preUpdateLatency);
 
   // Skip if buoy link is not valid.
   if (!this->dataPtr->link.Valid(_ecm))
@@ -312,13 +358,20 @@ void Mooring::PreUpdate(
   // Update V and H based on latest buoy position
   this->dataPtr->UpdateVH(_ecm);
 
-  // Skip solver if the chain can drop vertically (within tolerance).
-  double toleranceL = 0.1;
-  if (this->dataPtr->V + this->dataPtr->H <= this->dataPtr->L + toleranceL)
+  // Horizontal (Tr) and vertical (Tz) components of chain tension at
+  // the attachment point, in Newtons.
+  auto &catenarySolver = this->dataPtr->catenarySolver;
+  double Tr = 0.0;
+  double Tz = 0.0;
+  int solverInfo = asv::core::CatenaryTension(
+      this->dataPtr->V, this->dataPtr->H, this->dataPtr->L,
+      this->dataPtr->w, catenarySolver, Tr, Tz, &this->dataPtr->B);
+
+  // The chain can drop vertically (within tolerance), so the solver did
+  // not run and all force is vertical.
+  if (asv::core::CatenarySlack(
+      this->dataPtr->V, this->dataPtr->H, this->dataPtr->L))
   {
-    // Assume all force is vertical.
-    double Tz = - this->dataPtr->w * this->dataPtr->V;
-
     math::Vector3d force(0.0, 0.0, Tz);
     math::Vector3d torque = math::Vector3d::Zero;
     if (force.IsFinite() && torque.IsFinite())
@@ -328,80 +381,62 @@ void Mooring::PreUpdate(
     }
     else
     {
-      gzerr << "[Mooring] force is not finite.\n";
+      asverr << "[Mooring] force is not finite.\n";
+    }
+    this->dataPtr->Record(_info, force);
+    if (!force.IsFinite())
+    {
+      asv::FlightRecorder::Instance().Freeze(
+          "[Mooring] force is not finite",
+          std::chrono::duration<double>(_info.simTime).count());
     }
     return;
   }
 
-  Eigen::HybridNonLinearSolver<CatenaryHSoln> catenarySolver(
-    *this->dataPtr->catenarySoln);
-  // Tolerance for error between two consecutive iterations
-  catenarySolver.parameters.xtol = 0.001;
-  // Max number of calls to the function
-  catenarySolver.parameters.maxfev = 20;
-  catenarySolver.diag.setConstant(1, 1.0);
-  // Improves solution stability dramatically.
-  catenarySolver.useExternalScaling = true;
-
-  // Initial estimate for B (upper bound).
-  auto BMax = [](double V, double H, double L) -> double
-  {
-    return (L * L - (V * V + H * H)) / (2 * (L - H));
-  };
-
-  double bMax = BMax(this->dataPtr->V, this->dataPtr->H, this->dataPtr->L);
-
-  this->dataPtr->B[0] = bMax;
-  int solverInfo = catenarySolver.solveNumericalDiff(this->dataPtr->B);
-
-  double c = CatenaryFunction::CatenaryScalingFactor(
-    this->dataPtr->V, this->dataPtr->B[0U], this->dataPtr->L);
+  this->dataPtr->solverIterations.Add(
+      static_cast<uint64_t>(catenarySolver.iter));
+  this->dataPtr->solverEvaluations.Add(
+      static_cast<uint64_t>(catenarySolver.nfev));
 
-  // Horizontal component of chain tension, in Newtons
   // Force at buoy heave cone is Fx = -Tx
-  double Tr = - c * this->dataPtr->w;
   double Tx = Tr * std::cos(this->dataPtr->theta);
   double Ty = Tr * std::sin(this->dataPtr->theta);
-  // Vertical component of chain tension at attachment point, in Newtons.
-  double Tz = - this->dataPtr->w * (this->dataPtr->L - this->dataPtr->B[0U]);
-
-  #if 0
-  // Throttle update rate
-  auto elapsed = _info.simTime - this->dataPtr->lastDebugPrintTime;
-  if (elapsed > std::chrono::steady_clock::duration::zero() &&
-      elapsed >= this->dataPtr->debugPrintPeriod)
+
+  if (this->dataPtr->trace && this->dataPtr->trace->Enabled())
   {
-    this->dataPtr->lastDebugPrintTime = _info.simTime;
-    gzdbg << "HSolver solverInfo: " << solverInfo << "\n"
-          << " t: " << std::chrono::duration_cast<
-              std::chrono::milliseconds>(_info.simTime).count()/1000.0 << "\n"
-          << " Anchor: " << this->dataPtr->anchorWorldPos << "\n"
-          << " Link:   " << this->dataPtr->linkWorldPos << "\n"
-          << " R: " << this->dataPtr->effectiveRadius << "\n"
-          << " L: " << this->dataPtr->L << "\n"
-          << " V + H : " << this->dataPtr->V + this->dataPtr->H << "\n"
-          << " V: " << this->dataPtr->V << "\n"
-          << " H: " << this->dataPtr->H << "\n"
-          << " b: " << bMax << "\n"
-          << " B: " << this->dataPtr->B[0U] << "\n"
-          << " c: " << c << "\n"
-          << " theta: " << this->dataPtr->theta << "\n"
-          << " Tx: " << Tx << "\n"
-          << " Ty: " << Ty << "\n"
-          << " Tr: " << Tr << "\n"
-          << " Tz: " << Tz << "\n"
-          << " nfev: " << catenarySolver.nfev << "\n"
-          << " iter: " << catenarySolver.iter << "\n"
-          << " fnorm: " << catenarySolver.fnorm << "\n"
-          << "\n";
+    const auto &anchor = this->dataPtr->anchorWorldPos;
+    const auto &link = this->dataPtr->linkWorldPos;
+    this->dataPtr->trace->Write(
+        std::chrono::duration<double>(_info.simTime).count(), {
+        static_cast<double>(solverInfo),
+        anchor.X(), anchor.Y(), anchor.Z(),
+        link.X(), link.Y(), link.Z(),
+        this->dataPtr->L,
+        this->dataPtr->V + this->dataPtr->H,
+        this->dataPtr->V,
+        this->dataPtr->H,
+        asv::core::CatenaryBMax(
+            this->dataPtr->V, this->dataPtr->H, this->dataPtr->L),
+        this->dataPtr->B,
+        asv::core::CatenaryFunction::CatenaryScalingFactor(
+            this->dataPtr->V, this->dataPtr->B, this->dataPtr->L),
+        this->dataPtr->theta,
+        Tx, Ty, Tr, Tz,
+        static_cast<double>(catenarySolver.nfev),
+        static_cast<double>(catenarySolver.iter),
+        catenarySolver.fnorm});
   }
-  #endif
 
   // Did not find solution.
-  if (solverInfo != 1)
+  if (solverInfo != asv::core::CatenaryHSolver::kConverged)
   {
-    gzerr << "[Mooring] solver failed to converge, solverInfo: "
-          << solverInfo << "\n";
+    this->dataPtr->solverFailures.Increment();
+    asverr << "[Mooring] solver failed to converge, solverInfo: "
+           << solverInfo << "\n";
+    this->dataPtr->Record(_info, math::Vector3d(Tx, Ty, Tz));
+    asv::FlightRecorder::Instance().Freeze(
+        "[Mooring] solver failed to converge",
+        std::chrono::duration<double>(_info.simTime).count());
     return;
   }
 
@@ -414,7 +449,14 @@ void Mooring::PreUpdate(
   }
   else
   {
-    gzerr << "[Mooring] force is not finite.\n";
+    asverr << "[Mooring] force is not finite.\n";
+  }
+  this->dataPtr->Record(_info, force);
+  if (!force.IsFinite())
+  {
+    asv::FlightRecorder::Instance().Freeze(
+        "[Mooring] force is not finite",
+        std::chrono::duration<double>(_info.simTime).count());
   }
 }
 
@@ -45,8 +45,6 @@
 
 #include <gz/sim/System.hh>
 
-#include "CatenarySoln.hh"
-
 namespace gz
 {
 namespace sim
@@ -0,0 +1,204 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "SailFleetCommand.hh"
+
+#include <gz/msgs/model_v.pb.h>
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <gz/common/Profiler.hh>
+#include <gz/plugin/Register.hh>
+#include <gz/sim/components/Joint.hh>
+#include <gz/sim/EntityComponentManager.hh>
+#include <gz/sim/Util.hh>
+#include <gz/sim/World.hh>
+#include <gz/transport/Node.hh>
+
+#include "asv/sim/components/SailCommand.hh"
+#include "asv/sim/Metrics.hh"
+#include "asv/sim/SailCommandBuffer.hh"
+#include "asv/sim/TransportRegistry.hh"
+
+namespace gz
+{
+namespace sim
+{
+namespace systems
+{
+/////////////////////////////////////////////////
+class SailFleetCommandPrivate
+{
+  /// \brief Callback for the fleet command subscription.
+  /// \param[in] _msg The commands.
+  public: void OnCmd(const msgs::Model_V &_msg);
+
+  /// \brief The joint a command is addressed to, cached.
+  public: Entity FindJoint(const EntityComponentManager &_ecm,
+      const asv::SailCommand &_command);
+
+  /// \brief Fleet command subscription.
+  public: asv::TransportRegistry::Subscription cmdSub;
+
+  /// \brief World
+  public: World world{kNullEntity};
+
+  /// \brief Commands received and not yet applied.
+  public: asv::SailCommandBuffer commands;
+
+  /// \brief Cache of the joint entity of each scoped joint name.
+  public: std::unordered_map<std::string, Entity> jointCache;
+
+  /// \brief Names that have been reported as not found.
+  public: std::unordered_set<std::string> reported;
+
+  /// \brief Latency of PreUpdate.
+  public: asv::Metric &preUpdateLatency =
+      asv::Metrics::Instance().Latency("SailFleetCommand", "PreUpdate");
+};
+
+/////////////////////////////////////////////////
+void SailFleetCommandPrivate::OnCmd(const msgs::Model_V &_msg)
+{
+  auto &batch = this->commands.BeginWrite();
+  for (const auto &model : _msg.models())
+  {
+    for (const auto &joint : model.joint())
+    {
+      batch.push_back({model.name(), joint.name(), joint.axis1().position()});
+    }
+  }
+  this->commands.Publish();
+}
+
+/////////////////////////////////////////////////
+Entity SailFleetCommandPrivate::FindJoint(
+    const EntityComponentManager &_ecm,
+    const asv::SailCommand &_command)
+{
+  std::string name = _command.model + "::" + _command.joint;
+  auto it = this->jointCache.find(name);
+  if (it != this->jointCache.end() && _ecm.HasEntity(it->second))
+    return it->second;
+
+  Entity joint = kNullEntity;
+  for (auto entity : entitiesFromScopedName(name, _ecm, this->world.Entity()))
+  {
+    if (_ecm.EntityHasComponentType(entity, components::Joint::typeId))
+    {
+      joint = entity;
+      break;
+    }
+  }
+
+  if (joint == kNullEntity)
+  {
+    if (this->reported.insert(name).second)
+    {
+      gzwarn << "[SailFleetCommand] joint [" << name << "] not found. "
+             << "Commands for it are ignored.\n";
+    }
+    this->jointCache.erase(name);
+    return kNullEntity;
+  }
+
+  this->reported.erase(name);
+  this->jointCache[name] = joint;
+  return joint;
+}
+
+/////////////////////////////////////////////////
+SailFleetCommand::~SailFleetCommand() = default;
+
+/////////////////////////////////////////////////
+SailFleetCommand::SailFleetCommand()
+  : System(), dataPtr(std::make_unique<SailFleetCommandPrivate>())
+{
+}
+
+/////////////////////////////////////////////////
+void SailFleetCommand::Configure(
+    const Entity &_entity,
+    const std::shared_ptr<const sdf::Element> &_sdf,
+    EntityComponentManager &_ecm,
+    EventManager &/*_eventMgr*/)
+{
+  this->dataPtr->world = World(_entity);
+
+  if (!this->dataPtr->world.Valid(_ecm))
+  {
+    gzerr << "SailFleetCommand plugin should be attached to a world "
+          << "entity. Failed to initialize.\n";
+    return;
+  }
+
+  std::string topic = "/world/" +
+      this->dataPtr->world.Name(_ecm).value_or("") + "/sail_cmd";
+  if (_sdf->HasElement("topic"))
+    topic = _sdf->Get<std::string>("topic");
+  topic = transport::TopicUtils::AsValidTopic(topic);
+  if (topic.empty())
+  {
+    gzerr << "SailFleetCommand failed to create a valid topic. "
+          << "Failed to initialize.\n";
+    return;
+  }
+
+  this->dataPtr->cmdSub = asv::TransportRegistry::Subscribe(
+      topic, &SailFleetCommandPrivate::OnCmd, this->dataPtr.get());
+
+  gzdbg << "[SailFleetCommand] system parameters:\n"
+        << "topic: [" << topic << "]\n";
+}
+
+/////////////////////////////////////////////////
+void SailFleetCommand::PreUpdate(
+    const UpdateInfo &/*_info*/,
+    EntityComponentManager &_ecm)
+{
+  GZ_PROFILE("SailFleetCommand::PreUpdate");
+  asv::MetricTimer timer(this->dataPtr->preUpdateLatency);
+
+  auto commands = this->dataPtr->commands.Read();
+  if (!commands)
+    return;
+
+  // Applied in order so the latest command for a joint wins.
+  for (const auto &command : *commands)
+  {
+    Entity joint = this->dataPtr->FindJoint(_ecm, command);
+    if (joint != kNullEntity)
+    {
+      _ecm.SetComponentData<components::SailPositionCmd>(
+          joint, command.position);
+    }
+  }
+}
+
+}  // namespace systems
+}  // namespace sim
+}  // namespace gz
+
+GZ_ADD_PLUGIN(
+    gz::sim::systems::SailFleetCommand,
+    gz::sim::System,
+    gz::sim::systems::SailFleetCommand::ISystemConfigure,
+    gz::sim::systems::SailFleetCommand::ISystemPreUpdate)
+
+GZ_ADD_PLUGIN_ALIAS(
+    gz::sim::systems::SailFleetCommand,
+    "gz::sim::systems::SailFleetCommand")
@@ -0,0 +1,85 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ASV_SIM_SAILFLEETCOMMAND_HH_
+#define ASV_SIM_SAILFLEETCOMMAND_HH_
+
+#include <memory>
+#include <string>
+
+#include <gz/sim/System.hh>
+
+namespace gz
+{
+namespace sim
+{
+// Inline bracket to help doxygen filtering.
+inline namespace GZ_SIM_VERSION_NAMESPACE {
+namespace systems
+{
+
+// Forward declarations.
+class SailFleetCommandPrivate;
+
+/// \brief A plugin that receives the sail commands for a whole fleet
+/// on a single topic.
+///
+/// The message is a gz::msgs::Model_V. Each model is addressed by its
+/// scoped name and each of its joints by name, with the commanded
+/// position in axis1.position, the same layout the joint state
+/// publisher uses. Commands are handed from the transport thread to the
+/// simulation through an asv::SailCommandBuffer without locking, and
+/// applied in PreUpdate by setting the SailPositionCmd component of the
+/// joint. A SailPositionController with <fleet_command> enabled uses
+/// that component instead of subscribing to its own topic.
+///
+/// # Parameters
+///
+/// 1. <topic> (string, default: /world/<world>/sail_cmd)
+///   Topic the fleet commands are received on.
+///
+class SailFleetCommand
+    : public System,
+      public ISystemConfigure,
+      public ISystemPreUpdate
+{
+  /// \brief Destructor.
+  public: virtual ~SailFleetCommand();
+
+  /// \brief Constructor.
+  public: SailFleetCommand();
+
+  // Documentation inherited
+  public: void Configure(
+      const Entity &_entity,
+      const std::shared_ptr<const sdf::Element> &_sdf,
+      EntityComponentManager &_ecm,
+      EventManager &_eventMgr) final;
+
+  /// Documentation inherited
+  public: void PreUpdate(
+      const UpdateInfo &_info,
+      EntityComponentManager &_ecm) override;
+
+  /// \brief Private data pointer.
+  private: std::unique_ptr<SailFleetCommandPrivate> dataPtr;
+};
+
+}  // namespace systems
+}
+}  // namespace sim
+}  // namespace gz
+
+#endif  // ASV_SIM_SAILFLEETCOMMAND_HH_
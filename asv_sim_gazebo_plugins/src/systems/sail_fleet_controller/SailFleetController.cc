@@ -0,0 +1,537 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "SailFleetController.hh"
+
+#include <gz/msgs/double.pb.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gz/common/Profiler.hh>
+#include <gz/plugin/Register.hh>
+
+#include <gz/sim/components/Joint.hh>
+#include <gz/sim/components/JointForceCmd.hh>
+#include <gz/sim/components/JointPosition.hh>
+#include <gz/sim/components/Name.hh>
+#include <gz/sim/Util.hh>
+
+#include <gz/transport/Node.hh>
+
+#include "asv/core/PidArray.hh"
+#include "asv/core/WinchArray.hh"
+#include "asv/sim/FlightRecorder.hh"
+#include "asv/sim/Metrics.hh"
+#include "asv/sim/Recorder.hh"
+#include "asv/sim/TransportRegistry.hh"
+#include "asv/sim/components/SailCommand.hh"
+
+namespace gz
+{
+namespace sim
+{
+namespace systems
+{
+/////////////////////////////////////////////////
+class SailFleetControllerPrivate
+{
+  /// \brief Resolve any joints not yet found.
+  public: void ResolveJoints(const EntityComponentManager &_ecm);
+
+  /// \brief Cache the joint components, creating them if needed.
+  public: void CacheComponents(EntityComponentManager &_ecm);
+
+  /// \brief True if the cached components are still those of the joints.
+  public: bool CacheCurrent(const EntityComponentManager &_ecm) const;
+
+  /// \brief Record the command, position and force of every joint to
+  /// the flight recorder and, if it is open, the trace recorder.
+  public: void Record(const UpdateInfo &_info);
+
+  /// \brief Copy the fleet commands set on the joints.
+  public: void ReadFleetCommands();
+
+  /// \brief Command subscriptions.
+  public: std::vector<asv::TransportRegistry::Subscription> cmdSubs;
+
+  /// \brief Entity the plugin is attached to, the scope for joint names.
+  public: Entity scope{kNullEntity};
+
+  /// \brief Joint scoped names.
+  public: std::vector<std::string> jointNames;
+
+  /// \brief Joint entities, kNullEntity until resolved.
+  public: std::vector<Entity> jointEntities;
+
+  /// \brief Joint axis index.
+  public: std::vector<unsigned int> jointIndex;
+
+  /// \brief Cached joint position components.
+  public: std::vector<components::JointPosition *> posComp;
+
+  /// \brief Cached joint force command components.
+  public: std::vector<components::JointForceCmd *> forceComp;
+
+  /// \brief Cached fleet command components, null until one is set.
+  public: std::vector<const components::SailPositionCmd *> cmdComp;
+
+  /// \brief Commanded joint positions, written by the subscribers.
+  public: std::unique_ptr<std::atomic<double>[]> jointPosCmd;
+
+  /// \brief True if commands come from the fleet command topic.
+  public: bool fleetCommand{false};
+
+  /// \brief PID state for each joint.
+  public: asv::core::PidArray pid;
+
+  /// \brief Sheet winches, used instead of the PID controllers if set.
+  public: asv::core::WinchArray winch;
+
+  /// \brief Winch target, joint position and force for each sail.
+  public: std::vector<double> winchTarget;
+  public: std::vector<double> winchPos;
+  public: std::vector<double> winchForce;
+
+  /// \brief Number of joints resolved.
+  public: size_t numResolved{0};
+
+  /// \brief True if the component cache must be rebuilt.
+  public: bool cacheDirty{true};
+
+  /// \brief Record type of the controller trace.
+  public: uint32_t recordType{asv::Recorder::kInvalidType};
+
+  /// \brief Latency of PreUpdate.
+  public: asv::Metric &preUpdateLatency =
+      asv::Metrics::Instance().Latency("SailFleetController", "PreUpdate");
+};
+
+/////////////////////////////////////////////////
+void SailFleetControllerPrivate::ResolveJoints(
+    const EntityComponentManager &_ecm)
+{
+  for (size_t k = 0; k < this->jointNames.size(); ++k)
+  {
+    if (this->jointEntities[k] != kNullEntity)
+      continue;
+
+    auto entities = entitiesFromScopedName(
+        this->jointNames[k], _ecm, this->scope);
+    for (auto entity : entities)
+    {
+      if (_ecm.EntityHasComponentType(entity, components::Joint::typeId))
+      {
+        gzdbg << "Identified joint [" << this->jointNames[k]
+              << "] as Entity [" << entity << "]\n";
+        this->jointEntities[k] = entity;
+        ++this->numResolved;
+        this->cacheDirty = true;
+        break;
+      }
+    }
+  }
+}
+
+/////////////////////////////////////////////////
+void SailFleetControllerPrivate::CacheComponents(
+    EntityComponentManager &_ecm)
+{
+  for (size_t k = 0; k < this->jointEntities.size(); ++k)
+  {
+    Entity joint = this->jointEntities[k];
+    this->posComp[k] = nullptr;
+    this->forceComp[k] = nullptr;
+    this->cmdComp[k] = nullptr;
+    if (joint == kNullEntity || !_ecm.HasEntity(joint))
+      continue;
+
+    auto posComp = _ecm.Component<components::JointPosition>(joint);
+    if (!posComp)
+    {
+      posComp = _ecm.CreateComponent(joint, components::JointPosition());
+    }
+    auto forceComp = _ecm.Component<components::JointForceCmd>(joint);
+    if (!forceComp)
+    {
+      forceComp = _ecm.CreateComponent(joint,
+          components::JointForceCmd(
+              std::vector<double>(this->jointIndex[k] + 1, 0.0)));
+    }
+    else if (forceComp->Data().size() <= this->jointIndex[k])
+    {
+      forceComp->Data().resize(this->jointIndex[k] + 1, 0.0);
+    }
+    this->posComp[k] = posComp;
+    this->forceComp[k] = forceComp;
+    if (this->fleetCommand)
+      this->cmdComp[k] = _ecm.Component<components::SailPositionCmd>(joint);
+  }
+  this->cacheDirty = false;
+}
+
+/////////////////////////////////////////////////
+bool SailFleetControllerPrivate::CacheCurrent(
+    const EntityComponentManager &_ecm) const
+{
+  for (size_t k = 0; k < this->jointEntities.size(); ++k)
+  {
+    Entity joint = this->jointEntities[k];
+    if (joint == kNullEntity)
+      continue;
+    if (_ecm.Component<components::JointPosition>(joint) !=
+            this->posComp[k] ||
+        _ecm.Component<components::JointForceCmd>(joint) !=
+            this->forceComp[k])
+    {
+      return false;
+    }
+    if (this->fleetCommand &&
+        _ecm.Component<components::SailPositionCmd>(joint) !=
+            this->cmdComp[k])
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+/////////////////////////////////////////////////
+void SailFleetControllerPrivate::ReadFleetCommands()
+{
+  for (size_t k = 0; k < this->jointEntities.size(); ++k)
+  {
+    if (this->cmdComp[k])
+      this->jointPosCmd[k] = this->cmdComp[k]->Data();
+  }
+}
+
+/////////////////////////////////////////////////
+void SailFleetControllerPrivate::Record(const UpdateInfo &_info)
+{
+  auto &flight = asv::FlightRecorder::Instance();
+  auto &recorder = asv::Recorder::Instance();
+  const bool trace = recorder.IsOpen();
+  if (trace && this->recordType == asv::Recorder::kInvalidType)
+  {
+    this->recordType = recorder.RegisterType("sail_controller",
+        {"command", "position", "force"});
+  }
+
+  const double time = std::chrono::duration<double>(_info.simTime).count();
+  for (size_t k = 0; k < this->jointEntities.size(); ++k)
+  {
+    auto *posComp = this->posComp[k];
+    const unsigned int index = this->jointIndex[k];
+    if (!posComp || index >= posComp->Data().size())
+      continue;
+
+    const double values[] = {this->jointPosCmd[k],
+        posComp->Data()[index], this->forceComp[k]->Data()[index]};
+    flight.Write(asv::FlightRecorder::kSailController, time,
+        this->jointEntities[k], values, 3);
+    if (trace)
+      recorder.Record(this->recordType, time, this->jointEntities[k], values);
+  }
+}
+
+/////////////////////////////////////////////////
+SailFleetController::~SailFleetController() = default;
+
+/////////////////////////////////////////////////
+SailFleetController::SailFleetController()
+  : System(), dataPtr(std::make_unique<SailFleetControllerPrivate>())
+{
+}
+
+/////////////////////////////////////////////////
+void SailFleetController::Configure(
+    const Entity &_entity,
+    const std::shared_ptr<const sdf::Element> &_sdf,
+    EntityComponentManager &_ecm,
+    EventManager &/*_eventMgr*/)
+{
+  this->dataPtr->scope = _entity;
+
+  // Default PID parameters
+  double p         =  1;
+  double i         =  0.1;
+  double d         =  0.01;
+  double iMax      =  1;
+  double iMin      = -1;
+  double cmdMax    =  1000;
+  double cmdMin    = -1000;
+  double cmdOffset =  0;
+
+  auto loadPid = [](const std::shared_ptr<const sdf::Element> &_elem,
+      double &_p, double &_i, double &_d, double &_iMax, double &_iMin,
+      double &_cmdMax, double &_cmdMin, double &_cmdOffset)
+  {
+    _p = _elem->Get<double>("p_gain", _p).first;
+    _i = _elem->Get<double>("i_gain", _i).first;
+    _d = _elem->Get<double>("d_gain", _d).first;
+    _iMax = _elem->Get<double>("i_max", _iMax).first;
+    _iMin = _elem->Get<double>("i_min", _iMin).first;
+    _cmdMax = _elem->Get<double>("cmd_max", _cmdMax).first;
+    _cmdMin = _elem->Get<double>("cmd_min", _cmdMin).first;
+    _cmdOffset = _elem->Get<double>("cmd_offset", _cmdOffset).first;
+  };
+  loadPid(_sdf, p, i, d, iMax, iMin, cmdMax, cmdMin, cmdOffset);
+
+  // Default winch parameters
+  auto loadWinch = [](const std::shared_ptr<const sdf::Element> &_elem,
+      asv::core::WinchParams &_params)
+  {
+    _params.maxSpeed = _elem->Get<double>("max_speed", _params.maxSpeed).first;
+    _params.maxForce = _elem->Get<double>("max_force", _params.maxForce).first;
+    _params.maxPower = _elem->Get<double>("max_power", _params.maxPower).first;
+    _params.stiffness =
+        _elem->Get<double>("stiffness", _params.stiffness).first;
+    _params.damping = _elem->Get<double>("damping", _params.damping).first;
+    _params.gain = _elem->Get<double>("gain", _params.gain).first;
+    return _params.maxSpeed > 0.0 && _params.maxForce > 0.0 &&
+        _params.stiffness > 0.0 && _params.gain > 0.0;
+  };
+  const bool useWinch = _sdf->HasElement("winch");
+  asv::core::WinchParams winch;
+  if (useWinch && !loadWinch(_sdf->FindElement("winch"), winch))
+  {
+    gzerr << "<winch> requires a positive <max_speed>, <max_force>, "
+          << "<stiffness> and <gain>. "
+          << "SailFleetController failed to initialize.\n";
+    return;
+  }
+
+  // Sails
+  std::vector<double> initialPosition;
+  std::vector<std::string> topics;
+  auto sailElem = _sdf->FindElement("sail");
+  while (sailElem)
+  {
+    auto jointName = sailElem->Get<std::string>("joint_name", "").first;
+    if (jointName.empty())
+    {
+      gzerr << "<sail> requires a <joint_name>. "
+            << "SailFleetController failed to initialize.\n";
+      return;
+    }
+
+    double sp = p, si = i, sd = d, siMax = iMax, siMin = iMin;
+    double sCmdMax = cmdMax, sCmdMin = cmdMin, sCmdOffset = cmdOffset;
+    loadPid(sailElem, sp, si, sd, siMax, siMin, sCmdMax, sCmdMin,
+        sCmdOffset);
+    this->dataPtr->pid.Add(sp, si, sd, siMax, siMin, sCmdMax, sCmdMin,
+        sCmdOffset);
+
+    this->dataPtr->jointNames.push_back(jointName);
+    this->dataPtr->jointIndex.push_back(
+        sailElem->Get<unsigned int>("joint_index", 0u).first);
+    initialPosition.push_back(
+        sailElem->Get<double>("initial_position", 0.0).first);
+
+    if (useWinch)
+    {
+      asv::core::WinchParams sailWinch = winch;
+      if (sailElem->HasElement("winch") &&
+          !loadWinch(sailElem->FindElement("winch"), sailWinch))
+      {
+        gzerr << "<winch> for joint [" << jointName << "] requires a "
+              << "positive <max_speed>, <max_force>, <stiffness> and "
+              << "<gain>. SailFleetController failed to initialize.\n";
+        return;
+      }
+      this->dataPtr->winch.Add(sailWinch, initialPosition.back());
+    }
+
+    // Default topic from the scoped joint name.
+    std::string topic = sailElem->Get<std::string>("topic", "").first;
+    if (topic.empty())
+    {
+      std::string modelName;
+      std::string name = jointName;
+      auto pos = jointName.rfind("::");
+      if (pos != std::string::npos)
+      {
+        modelName = jointName.substr(0, pos);
+        name = jointName.substr(pos + 2);
+        for (auto sep = modelName.find("::"); sep != std::string::npos;
+            sep = modelName.find("::", sep))
+        {
+          modelName.replace(sep, 2, "/");
+        }
+      }
+      else
+      {
+        auto nameComp = _ecm.Component<components::Name>(_entity);
+        if (nameComp)
+          modelName = nameComp->Data();
+      }
+      topic = "/model/" + modelName + "/joint/" + name + "/cmd_pos";
+    }
+    topic = transport::TopicUtils::AsValidTopic(topic);
+    if (topic.empty())
+    {
+      gzerr << "Failed to create topic for joint [" << jointName << "]. "
+            << "SailFleetController failed to initialize.\n";
+      return;
+    }
+    topics.push_back(topic);
+
+    sailElem = sailElem->GetNextElement("sail");
+  }
+
+  size_t n = this->dataPtr->jointNames.size();
+  if (n == 0)
+  {
+    gzerr << "SailFleetController requires at least one <sail>.\n";
+    return;
+  }
+  this->dataPtr->jointEntities.assign(n, kNullEntity);
+  if (useWinch)
+  {
+    this->dataPtr->winchTarget.assign(n, 0.0);
+    this->dataPtr->winchPos.assign(n, 0.0);
+    this->dataPtr->winchForce.assign(n, 0.0);
+  }
+  this->dataPtr->posComp.assign(n, nullptr);
+  this->dataPtr->forceComp.assign(n, nullptr);
+  this->dataPtr->cmdComp.assign(n, nullptr);
+  this->dataPtr->jointPosCmd = std::make_unique<std::atomic<double>[]>(n);
+
+  this->dataPtr->fleetCommand =
+      _sdf->Get<bool>("fleet_command", false).first;
+
+  // Subscribe to commands. With fleet commands the SailFleetCommand
+  // system sets the command on each joint, so no subscription is needed.
+  for (size_t k = 0; k < n; ++k)
+  {
+    this->dataPtr->jointPosCmd[k] = initialPosition[k];
+    if (this->dataPtr->fleetCommand)
+      continue;
+    auto *cmd = &this->dataPtr->jointPosCmd[k];
+    std::function<void(const msgs::Double &)> callback =
+        [cmd](const msgs::Double &_msg)
+        {
+          *cmd = _msg.data();
+        };
+    this->dataPtr->cmdSubs.push_back(
+        asv::TransportRegistry::Subscribe(topics[k], callback));
+  }
+
+  this->dataPtr->ResolveJoints(_ecm);
+
+  gzdbg << "[SailFleetController] system parameters:\n"
+        << "sails: [" << n << "]\n"
+        << "fleet_command: [" << this->dataPtr->fleetCommand << "]\n"
+        << "resolved: [" << this->dataPtr->numResolved << "]\n";
+}
+
+/////////////////////////////////////////////////
+void SailFleetController::PreUpdate(
+    const UpdateInfo &_info,
+    EntityComponentManager &_ecm)
+{
+  GZ_PROFILE("SailFleetController::PreUpdate");
+  asv::MetricTimer timer(this->dataPtr->preUpdateLatency);
+
+  auto &data = *this->dataPtr;
+  if (data.jointEntities.empty())
+    return;
+
+  // Joints can only appear when entities are created.
+  if (data.numResolved < data.jointNames.size() && _ecm.HasNewEntities())
+    data.ResolveJoints(_ecm);
+
+  // Nothing left to do if paused.
+  if (_info.paused)
+    return;
+
+  // A component can be removed from a live joint, or a fleet command set
+  // on one, without any entity event, so the cache is checked against
+  // the ECM on every step. Only a change rebuilds it.
+  if (data.cacheDirty || !data.CacheCurrent(_ecm))
+    data.CacheComponents(_ecm);
+
+  if (data.fleetCommand)
+    data.ReadFleetCommands();
+
+  const double dt = std::chrono::duration<double>(_info.dt).count();
+  const size_t n = data.jointEntities.size();
+
+  // The winches set the sheet lengths to the targets, and the sheet
+  // tensions are the joint forces. All winches update in one pass.
+  if (data.winch.Size() > 0)
+  {
+    for (size_t k = 0; k < n; ++k)
+    {
+      auto *posComp = data.posComp[k];
+      const unsigned int index = data.jointIndex[k];
+      data.winchTarget[k] = data.jointPosCmd[k];
+      data.winchPos[k] = posComp && index < posComp->Data().size() ?
+          posComp->Data()[index] : 0.0;
+    }
+    data.winch.Update(data.winchTarget.data(), data.winchPos.data(), dt,
+        data.winchForce.data());
+    for (size_t k = 0; k < n; ++k)
+    {
+      auto *posComp = data.posComp[k];
+      const unsigned int index = data.jointIndex[k];
+      if (posComp && index < posComp->Data().size())
+        data.forceComp[k]->Data()[index] = data.winchForce[k];
+    }
+    data.Record(_info);
+    return;
+  }
+
+  for (size_t k = 0; k < n; ++k)
+  {
+    auto *posComp = data.posComp[k];
+    auto *forceComp = data.forceComp[k];
+    const unsigned int index = data.jointIndex[k];
+
+    // The physics system sizes the position after the first step.
+    if (!posComp || index >= posComp->Data().size())
+      continue;
+
+    // Target position in [0, pos_max] with the sign of the position.
+    const double pos = posComp->Data()[index];
+    const double pos_sgn = pos < 0.0 ? -1.0 : 1.0;
+    const double error = pos - pos_sgn * data.jointPosCmd[k];
+
+    // Only apply tension forces (when |pos_target| < |pos|)
+    double force = data.pid.Update(k, error, dt);
+    if (force * pos_sgn > 0)
+      force = 0.0;
+
+    forceComp->Data()[index] = force;
+  }
+  data.Record(_info);
+}
+
+}  // namespace systems
+}  // namespace sim
+}  // namespace gz
+
+GZ_ADD_PLUGIN(
+    gz::sim::systems::SailFleetController,
+    gz::sim::System,
+    gz::sim::systems::SailFleetController::ISystemConfigure,
+    gz::sim::systems::SailFleetController::ISystemPreUpdate)
+
+GZ_ADD_PLUGIN_ALIAS(
+    gz::sim::systems::SailFleetController,
+    "gz::sim::systems::SailFleetController")
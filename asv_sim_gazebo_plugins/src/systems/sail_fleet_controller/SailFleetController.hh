@@ -0,0 +1,121 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ASV_SIM_SAILFLEETCONTROLLER_HH_
+#define ASV_SIM_SAILFLEETCONTROLLER_HH_
+
+#include <memory>
+#include <string>
+
+#include <gz/sim/System.hh>
+
+namespace gz
+{
+namespace sim
+{
+// Inline bracket to help doxygen filtering.
+inline namespace GZ_SIM_VERSION_NAMESPACE {
+namespace systems
+{
+
+// Forward declarations.
+class SailFleetControllerPrivate;
+
+/// \brief A plugin that controls the sheet tension of many sails,
+/// for instance every sail in a fleet, from one system.
+///
+/// Each sail joint behaves as in SailPositionController: the target
+/// position has the sign of the current position and only tension is
+/// applied. Unlike SailPositionController each joint has its own PID
+/// state and reads its own position. The PID state is held in
+/// contiguous arrays (asv::core::PidArray) and the joint components are
+/// cached, so the update is one loop over the sails that writes the
+/// force commands in place.
+///
+/// # Usage
+///
+/// \code
+/// <plugin filename="asv_sim2-sail-fleet-controller-system"
+///     name="gz::sim::systems::SailFleetController">
+///   <p_gain>1000</p_gain>
+///   <sail>
+///     <joint_name>boat1::main_sail_joint</joint_name>
+///   </sail>
+///   <sail>
+///     <joint_name>boat2::main_sail_joint</joint_name>
+///     <topic>/boat2/main_sail/cmd_pos</topic>
+///     <p_gain>500</p_gain>
+///   </sail>
+/// </plugin>
+/// \endcode
+///
+/// # Parameters
+///
+/// 1. <p_gain>, <i_gain>, <d_gain>, <i_max>, <i_min>, <cmd_max>,
+///   <cmd_min>, <cmd_offset> (double)
+///   Default PID parameters, as for SailPositionController.
+///
+/// 2. <fleet_command> (bool, default: false)
+///   If true no topic is subscribed to, and each joint takes its
+///   command from the SailPositionCmd component set on it by the
+///   SailFleetCommand system.
+///
+/// 3. <sail> (element, at least one)
+///   <joint_name> (string, required) scoped name relative to the
+///   entity the plugin is attached to, <joint_index> (default: 0),
+///   <initial_position> (default: 0), <topic> (default:
+///   /model/<scoped model>/joint/<joint>/cmd_pos), any PID
+///   parameter to override the defaults and a <winch> element to
+///   override the default winch.
+///
+/// 4. <winch> (element, optional)
+///   If present every sail is driven by a sheet winch (asv::core::WinchArray)
+///   instead of a PID controller, and the command is the sheet length.
+///   <max_speed>, <max_force>, <max_power>, <stiffness>, <damping> and
+///   <gain>, as for SailPositionController.
+///
+class SailFleetController
+    : public System,
+      public ISystemConfigure,
+      public ISystemPreUpdate
+{
+  /// \brief Destructor.
+  public: virtual ~SailFleetController();
+
+  /// \brief Constructor.
+  public: SailFleetController();
+
+  // Documentation inherited
+  public: void Configure(
+      const Entity &_entity,
+      const std::shared_ptr<const sdf::Element> &_sdf,
+      EntityComponentManager &_ecm,
+      EventManager &_eventMgr) final;
+
+  /// Documentation inherited
+  public: void PreUpdate(
+      const UpdateInfo &_info,
+      EntityComponentManager &_ecm) override;
+
+  /// \brief Private data pointer.
+  private: std::unique_ptr<SailFleetControllerPrivate> dataPtr;
+};
+
+}  // namespace systems
+}
+}  // namespace sim
+}  // namespace gz
+
+#endif  // ASV_SIM_SAILFLEETCONTROLLER_HH_
@@ -34,8 +34,12 @@
 
 #include "SailLiftDrag.hh"
 
+#include <algorithm>
+#include <cmath>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <vector>
 
 #include <gz/common/Profiler.hh>
 #include <gz/math/Pose3.hh>
@@ -45,9 +49,16 @@
 #include <gz/sim/Link.hh>
 #include <gz/sim/Model.hh>
 #include <gz/sim/Util.hh>
-#include <gz/transport/Node.hh>
+#include <gz/transport/TopicUtils.hh>
 
+#include "asv/sim/components/WindShadow.hh"
+#include "asv/sim/FlightRecorder.hh"
 #include "asv/sim/LiftDragModel.hh"
+#include "asv/sim/LiftDragTelemetry.hh"
+#include "asv/sim/Log.hh"
+#include "asv/sim/Metrics.hh"
+#include "asv/sim/SailPlanform.hh"
+#include "asv/sim/Trace.hh"
 
 namespace gz
 {
@@ -64,25 +75,171 @@ class SailLiftDragPrivate
   /// \brief Link interface.
   public: Link link{kNullEntity};
 
-  /// \brief Gazebo communication node.
-  public: transport::Node node;
-
-  /// \brief Publish to topic "/model/<model>/link/<link>/sail_lift_drag".
-  public: transport::Node::Publisher liftDragPub;
-
-  /// \brief Update period calculated from <update_rate>.
-  public: std::chrono::steady_clock::duration updatePeriod{0};
-
-  /// \brief Previous update time for publisher throttle.
-  public: std::chrono::steady_clock::duration lastUpdateTime{0};
+  /// \brief Debug trace, created in Configure.
+  public: std::unique_ptr<asv::TraceChannel> trace;
 
   /// \brief Center of pressure in link local coordinates.
   public: gz::math::Vector3d cpLink = gz::math::Vector3d::Zero;
 
   /// \brief Lift drag model.
   public: std::unique_ptr<asv::LiftDragModel> liftDrag;
+
+  /// \brief Lift drag telemetry, disabled unless <telemetry> is set.
+  public: asv::LiftDragTelemetry telemetry;
+
+  /// \brief Spanwise strips. Empty unless <strips> is specified,
+  /// in which case they replace the single centre of pressure.
+  public: std::vector<asv::SailStrip> strips;
+
+  /// \brief Strip twist rotations in the link frame.
+  public: std::vector<gz::math::Quaterniond> stripTwist;
+
+  /// \brief Strip areas.
+  public: std::vector<double> stripArea;
+
+  /// \brief Work buffers for the batch lift drag calculation.
+  public: std::vector<gz::math::Vector3d> stripVel;
+  public: std::vector<gz::math::Quaterniond> stripRot;
+  public: std::vector<gz::math::Vector3d> stripLift;
+  public: std::vector<gz::math::Vector3d> stripDrag;
+  public: std::vector<double> stripAlpha;
+  public: std::vector<double> stripU;
+  public: std::vector<double> stripCl;
+  public: std::vector<double> stripCd;
+
+  /// \brief Power law exponent for the wind shear profile.
+  /// Zero for uniform wind.
+  public: double windShearExponent = 0.0;
+
+  /// \brief Height at which the wind shear profile matches the wind
+  /// velocity reported by the wind system.
+  public: double windReferenceHeight = 10.0;
+
+  /// \brief Ratio of the wind speed at height _z to the reference wind.
+  /// \param[in] _z Height above the world origin.
+  public: double WindShearFactor(double _z) const;
+
+  /// \brief Compute the resultant strip force and torque.
+  public: void UpdateStrips(
+      EntityComponentManager &_ecm,
+      const std::chrono::steady_clock::duration &_simTime,
+      const gz::math::Pose3d &_linkPoseWorld,
+      const gz::math::Vector3d &_velWindWorld);
+
+  /// \brief Latency of PreUpdate.
+  public: asv::Metric &preUpdateLatency =
+      asv::Metrics::Instance().Latency("SailLiftDrag", "PreUpdate");
+
+  /// \brief Number of updates of the link, set in Configure.
+  public: asv::Metric *calls{nullptr};
 };
 
+/////////////////////////////////////////////////
+double SailLiftDragPrivate::WindShearFactor(double _z) const
+{
+  if (this->windShearExponent == 0.0)
+    return 1.0;
+
+  // Clamp to avoid a singular profile at or below the surface.
+  double z = std::max(_z, 0.01 * this->windReferenceHeight);
+  return std::pow(z / this->windReferenceHeight, this->windShearExponent);
+}
+
+/////////////////////////////////////////////////
+void SailLiftDragPrivate::UpdateStrips(
+    EntityComponentManager &_ecm,
+    const std::chrono::steady_clock::duration &_simTime,
+    const gz::math::Pose3d &_linkPoseWorld,
+    const gz::math::Vector3d &_velWindWorld)
+{
+  // Link origin velocities (world frame).
+  auto linVelOpt = this->link.WorldLinearVelocity(_ecm);
+  auto angVelOpt = this->link.WorldAngularVelocity(_ecm);
+  if (!linVelOpt.has_value() || !angVelOpt.has_value())
+    return;
+  auto linVel = linVelOpt.value();
+  auto angVel = angVelOpt.value();
+
+  // Apparent wind and orientation for each strip.
+  const auto &linkRot = _linkPoseWorld.Rot();
+  for (size_t i = 0; i < this->strips.size(); ++i)
+  {
+    auto xr = linkRot.RotateVector(this->strips[i].cp);
+    auto velCp = linVel + angVel.Cross(xr);
+    double z = _linkPoseWorld.Pos().Z() + xr.Z();
+    this->stripVel[i] = this->WindShearFactor(z) * _velWindWorld - velCp;
+    this->stripRot[i] = linkRot * this->stripTwist[i];
+  }
+
+  // Evaluate all strips together.
+  this->liftDrag->Compute(this->stripVel, this->stripRot, this->stripArea,
+      this->stripLift, this->stripDrag, &this->stripAlpha, &this->stripU,
+      &this->stripCl, &this->stripCd);
+
+  // Resultant force and torque (about link origin in world frame).
+  gz::math::Vector3d force = gz::math::Vector3d::Zero;
+  gz::math::Vector3d torque = gz::math::Vector3d::Zero;
+  for (size_t i = 0; i < this->strips.size(); ++i)
+  {
+    auto xr = linkRot.RotateVector(this->strips[i].cp);
+    auto f = this->stripLift[i] + this->stripDrag[i];
+    force += f;
+    torque += xr.Cross(f);
+  }
+
+  // Telemetry and traces: strip resultants, with the area weighted
+  // means of the strip apparent wind, angle of attack, speed and
+  // coefficients from the same batch.
+  gz::math::Vector3d lift = gz::math::Vector3d::Zero;
+  gz::math::Vector3d drag = gz::math::Vector3d::Zero;
+  gz::math::Vector3d velMean = gz::math::Vector3d::Zero;
+  double alpha = 0, u = 0, cl = 0, cd = 0;
+  double area = 0.0;
+  for (size_t i = 0; i < this->strips.size(); ++i)
+  {
+    const double a = this->stripArea[i];
+    lift += this->stripLift[i];
+    drag += this->stripDrag[i];
+    velMean += a * this->stripVel[i];
+    alpha += a * this->stripAlpha[i];
+    u += a * this->stripU[i];
+    cl += a * this->stripCl[i];
+    cd += a * this->stripCd[i];
+    area += a;
+  }
+  if (area > 0.0)
+  {
+    velMean /= area;
+    alpha /= area;
+    u /= area;
+    cl /= area;
+    cd /= area;
+  }
+
+  if (this->telemetry.Due(_simTime))
+  {
+    this->telemetry.Publish(_simTime, alpha, u, cl, cd, lift, drag, torque);
+  }
+  asv::LiftDragTelemetry::Record(_simTime, this->link.Entity(),
+      alpha, u, cl, cd, lift, drag, velMean);
+
+  if (force.IsFinite() && torque.IsFinite())
+  {
+    this->link.AddWorldWrench(_ecm, force, torque);
+  }
+  else
+  {
+    asvwarn << "SailLiftDrag: overflow in strip calculation.\n"
+            << "Link:         " << this->link.Name(_ecm).value() << "\n"
+            << "force:        " << force << "\n"
+            << "torque:       " << torque << "\n"
+            << "\n";
+    asv::FlightRecorder::Instance().Freeze(
+        "SailLiftDrag: overflow in strip calculation",
+        std::chrono::duration<double>(_simTime).count());
+  }
+}
+
 /////////////////////////////////////////////////
 SailLiftDrag::~SailLiftDrag() = default;
 
@@ -128,25 +285,127 @@ void SailLiftDrag::Configure(
     this->dataPtr->link = Link(linkEntity);
   }
 
+  if (!_sdf->HasElement("strips"))
   {
     if (!_sdf->HasElement("cp"))
     {
-      gzerr << "You must specify a <cp> for the SailLiftDrag"
+      gzerr << "You must specify a <cp> or <strips> for the SailLiftDrag"
             << " plugin forces to act at.\n";
       return;
     }
     this->dataPtr->cpLink = _sdf->Get<gz::math::Vector3d>("cp");
   }
 
+  if (_sdf->HasElement("wind_shear_exponent"))
+  {
+    this->dataPtr->windShearExponent =
+        _sdf->Get<double>("wind_shear_exponent");
+  }
+  if (_sdf->HasElement("wind_reference_height"))
+  {
+    this->dataPtr->windReferenceHeight =
+        _sdf->Get<double>("wind_reference_height");
+    if (this->dataPtr->windReferenceHeight <= 0.0)
+    {
+      gzerr << "<wind_reference_height> must be positive\n";
+      return;
+    }
+  }
+
   {
     double rate = 1.0;
-    std::chrono::duration<double> period{rate > 0.0 ? 1.0 / rate : 0.0};
-    this->dataPtr->updatePeriod = std::chrono::duration_cast<
-        std::chrono::steady_clock::duration>(period);
+    if (_sdf->HasElement("update_rate"))
+      rate = _sdf->Get<double>("update_rate");
+    this->dataPtr->trace = std::make_unique<asv::TraceChannel>(
+        "SailLiftDrag", std::vector<std::string>{"u", "alpha", "cl", "cd",
+            "link.pos:3", "link.rot:3", "velWind:3", "velCp:3", "vel:3",
+            "lift:3", "drag:3", "torque:3", "xr:3"},
+        this->dataPtr->link.Entity());
+    this->dataPtr->trace->SetDefaultRate(rate);
+
+    if (_sdf->Get<bool>("telemetry", false).first)
+    {
+      std::string topic = "/model/" + this->dataPtr->model.Name(_ecm) +
+          "/link/" + this->dataPtr->link.Name(_ecm).value_or("") +
+          "/sail_lift_drag";
+      if (_sdf->HasElement("telemetry_topic"))
+        topic = _sdf->Get<std::string>("telemetry_topic");
+      topic = transport::TopicUtils::AsValidTopic(topic);
+      if (topic.empty())
+      {
+        gzerr << "Failed to create a valid <telemetry_topic> for the "
+              << "SailLiftDrag plugin.\n";
+        return;
+      }
+      this->dataPtr->telemetry.Configure(topic, rate);
+    }
   }
 
   // Lift / Drag model
   this->dataPtr->liftDrag.reset(asv::LiftDragModel::Create(_sdf));
+  if (!this->dataPtr->liftDrag)
+    return;
+  this->dataPtr->liftDrag->SetTraceEntity(this->dataPtr->link.Entity());
+  this->dataPtr->calls = &asv::Metrics::Instance().Counter("SailLiftDrag",
+      "calls", this->dataPtr->link.Entity());
+
+  // Spanwise strips
+  if (_sdf->HasElement("strips"))
+  {
+    asv::SailPlanform planform;
+    if (!asv::SailPlanform::Load(_sdf->FindElement("strips"), planform))
+    {
+      gzerr << "Invalid <strips> for the SailLiftDrag plugin.\n";
+      this->dataPtr->liftDrag.reset();
+      return;
+    }
+    planform.Discretise(this->dataPtr->liftDrag->Forward(),
+        this->dataPtr->strips);
+
+    // Twist is about the span axis, normal to the lift-drag plane.
+    auto spanAxis = this->dataPtr->liftDrag->Forward().Cross(
+        this->dataPtr->liftDrag->Upward()).Normalize();
+
+    size_t n = this->dataPtr->strips.size();
+    this->dataPtr->stripTwist.resize(n);
+    this->dataPtr->stripArea.resize(n);
+    this->dataPtr->stripVel.resize(n);
+    this->dataPtr->stripRot.resize(n);
+    this->dataPtr->stripLift.resize(n);
+    this->dataPtr->stripDrag.resize(n);
+    this->dataPtr->stripAlpha.resize(n);
+    this->dataPtr->stripU.resize(n);
+    this->dataPtr->stripCl.resize(n);
+    this->dataPtr->stripCd.resize(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+      const auto &strip = this->dataPtr->strips[i];
+      this->dataPtr->stripTwist[i] =
+          gz::math::Quaterniond(spanAxis, strip.twist);
+      this->dataPtr->stripArea[i] = strip.area;
+    }
+  }
+
+  // Wind shadow cast on, and by, this sail.
+  {
+    auto ceLink = this->dataPtr->cpLink;
+    if (!this->dataPtr->strips.empty())
+    {
+      double area = 0.0;
+      ceLink = gz::math::Vector3d::Zero;
+      for (const auto &strip : this->dataPtr->strips)
+      {
+        ceLink += strip.area * strip.cp;
+        area += strip.area;
+      }
+      if (area > 0.0)
+        ceLink /= area;
+    }
+    _ecm.CreateComponent(this->dataPtr->link.Entity(),
+        components::WindShadowSource(ceLink));
+    _ecm.CreateComponent(this->dataPtr->link.Entity(),
+        components::WindShadowFactor(1.0));
+  }
 }
 
 /////////////////////////////////////////////////
@@ -154,11 +413,15 @@ void SailLiftDrag::PreUpdate(
     const UpdateInfo &_info,
     EntityComponentManager &_ecm)
 {
+  GZ_PROFILE("SailLiftDrag::PreUpdate");
+  asv::MetricTimer timer(this->dataPtr->preUpdateLatency);
+
   if (_info.paused)
     return;
 
   if (!this->dataPtr->link.Valid(_ecm) || !this->dataPtr->liftDrag)
     return;
+  this->dataPtr->calls->Increment();
 
   // ensure components are available
   this->dataPtr->link.EnableVelocityChecks(_ecm, true);
@@ -175,12 +438,28 @@ void SailLiftDrag::PreUpdate(
     velWindWorld = velWindWorldComp->Data();
   }
 
+  // Wind shadow from other vessels, if the WindShadow system is loaded.
+  auto shadowComp = _ecm.Component<components::WindShadowFactor>(
+      this->dataPtr->link.Entity());
+  if (shadowComp)
+  {
+    velWindWorld *= shadowComp->Data();
+  }
+
   // Pose of link origin and link CoM (world frame).
   auto linkPoseWorldOpt = this->dataPtr->link.WorldPose(_ecm);
   if (!linkPoseWorldOpt.has_value())
     return;
   auto linkPoseWorld = linkPoseWorldOpt.value();
 
+  // Strip theory: sum the contribution of each strip into one wrench.
+  if (!this->dataPtr->strips.empty())
+  {
+    this->dataPtr->UpdateStrips(_ecm, _info.simTime, linkPoseWorld,
+        velWindWorld);
+    return;
+  }
+
   // Linear velocity at the centre of pressure (world frame).
   auto velCpWorldComp = this->dataPtr->link.WorldLinearVelocity(
       _ecm, this->dataPtr->cpLink);
@@ -204,7 +483,13 @@ void SailLiftDrag::PreUpdate(
   // Rotate the centre of pressure (CP) into the world frame.
   auto xr = linkPoseWorld.Rot().RotateVector(this->dataPtr->cpLink);
 
-  // Ensure no overflow.
+  // Ensure no overflow, keeping the state that led to it.
+  if (!lift.IsFinite() || !drag.IsFinite())
+  {
+    asv::FlightRecorder::Instance().Freeze(
+        "SailLiftDrag: non-finite lift or drag",
+        std::chrono::duration<double>(_info.simTime).count());
+  }
   lift.Correct();
   drag.Correct();
 
@@ -212,49 +497,32 @@ void SailLiftDrag::PreUpdate(
   auto liftTorque = xr.Cross(lift);
   auto dragTorque = xr.Cross(drag);
 
-#if 0
-  auto elapsed = _info.simTime - this->dataPtr->lastUpdateTime;
-  if (elapsed >= this->dataPtr->updatePeriod)
+  if (this->dataPtr->telemetry.Due(_info.simTime))
   {
-    this->dataPtr->lastUpdateTime = _info.simTime;
+    this->dataPtr->telemetry.Publish(_info.simTime, alpha, u, cl, cd,
+        lift, drag, liftTorque + dragTorque);
+  }
+  asv::LiftDragTelemetry::Record(_info.simTime,
+      this->dataPtr->link.Entity(), alpha, u, cl, cd, lift, drag, velWorld);
 
-    // Resultant force arising from lift and drag (world frame).
-    auto force = lift + drag;
+  if (this->dataPtr->trace && this->dataPtr->trace->Enabled())
+  {
     auto torque = liftTorque + dragTorque;
-    force.Correct();
-    torque.Correct();
-
-    gzmsg << "Link:         " << this->dataPtr->link.Name(_ecm).value() << "\n"
-          // Scalars
-          << "u:            " << u << "\n"
-          << "alpha:        " << alpha << "\n"
-          << "cl:           " << cl << "\n"
-          << "cd:           " << cd << "\n"
-          << "||velWind||:  " << velWindWorld.Length() << "\n"
-          << "||velCp||:    " << velCpWorld.Length() << "\n"
-          << "||vel||:      " << velWorld.Length() << "\n"
-          << "||lift||:     " << lift.Length() << "\n"
-          << "||drag||:     " << drag.Length() << "\n"
-          << "||xr||:       " << xr.Length() << "\n"
-          << "||force||:    " << force.Length() << "\n"
-          // Vectors
-          << "link.pos:     " << linkPoseWorld.Pos() << "\n"
-          << "link.rot:     " << linkPoseWorld.Rot().Euler() << "\n"
-          << "velWind:      " << velWindWorld << "\n"
-          << "velCp:        " << velCpWorld << "\n"
-          << "vel:          " << velWorld << "\n"
-          << "lift:         " << lift << "\n"
-          << "drag:         " << drag << "\n"
-          << "liftTorque:   " << liftTorque << "\n"
-          << "dragTorque:   " << dragTorque << "\n"
-          << "xr:           " << xr << "\n"
-          << "force:        " << force << "\n"
-          << "torque:       " << torque << "\n"
-          << "link          " << linkPoseWorld.Pos() << "\n"
-          << "cp:           " << this->dataPtr->cpLink << "\n"
-          << "\n";
+    auto rot = linkPoseWorld.Rot().Euler();
+    this->dataPtr->trace->Write(
+        std::chrono::duration<double>(_info.simTime).count(), {
+        u, alpha, cl, cd,
+        linkPoseWorld.Pos().X(), linkPoseWorld.Pos().Y(),
+        linkPoseWorld.Pos().Z(),
+        rot.X(), rot.Y(), rot.Z(),
+        velWindWorld.X(), velWindWorld.Y(), velWindWorld.Z(),
+        velCpWorld.X(), velCpWorld.Y(), velCpWorld.Z(),
+        velWorld.X(), velWorld.Y(), velWorld.Z(),
+        lift.X(), lift.Y(), lift.Z(),
+        drag.X(), drag.Y(), drag.Z(),
+        torque.X(), torque.Y(), torque.Z(),
+        xr.X(), xr.Y(), xr.Z()});
   }
-#endif
 
   // Add force and torque to link (applied at link origin in world frame).
   if (lift.IsFinite() && liftTorque.IsFinite())
@@ -265,12 +533,16 @@ void SailLiftDrag::PreUpdate(
   }
   else
   {
-    gzwarn << "SailLiftDrag: overflow in lift calculation.\n"
-           << "Link:         " << this->dataPtr->link.Name(_ecm).value() << "\n"
-           << "xr:           " << xr << "\n"
-           << "lift:         " << lift << "\n"
-           << "liftTorque:   " << liftTorque << "\n"
-           << "\n";
+    asvwarn << "SailLiftDrag: overflow in lift calculation.\n"
+            << "Link:         "
+            << this->dataPtr->link.Name(_ecm).value() << "\n"
+            << "xr:           " << xr << "\n"
+            << "lift:         " << lift << "\n"
+            << "liftTorque:   " << liftTorque << "\n"
+            << "\n";
+    asv::FlightRecorder::Instance().Freeze(
+        "SailLiftDrag: overflow in lift calculation",
+        std::chrono::duration<double>(_info.simTime).count());
  }
   if (drag.IsFinite() && dragTorque.IsFinite())
   {
@@ -280,12 +552,16 @@ void SailLiftDrag::PreUpdate(
   }
   else
   {
-    gzwarn << "SailLiftDrag: overflow in drag calculation.\n"
-           << "Link:         " << this->dataPtr->link.Name(_ecm).value() << "\n"
-           << "xr:           " << xr << "\n"
-           << "drag:         " << drag << "\n"
-           << "dragTorque:   " << dragTorque << "\n"
-           << "\n";
+    asvwarn << "SailLiftDrag: overflow in drag calculation.\n"
+            << "Link:         "
+            << this->dataPtr->link.Name(_ecm).value() << "\n"
+            << "xr:           " << xr << "\n"
+            << "drag:         " << drag << "\n"
+            << "dragTorque:   " << dragTorque << "\n"
+            << "\n";
+    asv::FlightRecorder::Instance().Freeze(
+        "SailLiftDrag: overflow in drag calculation",
+        std::chrono::duration<double>(_info.simTime).count());
   }
 }
 
@@ -35,6 +35,39 @@ class SailLiftDragPrivate;
 
 /// \brief A plugin that simulates lift and drag on a sail
 /// in the presence of wind.
+///
+/// By default the force acts at a single centre of pressure <cp>.
+/// If a <strips> element is provided the sail is split into spanwise
+/// strips (see asv::SailPlanform), each with its own chord, twist and
+/// centre of pressure, and the strip forces are summed into one wrench.
+///
+/// # Parameters
+///
+/// 1. <wind_shear_exponent> (double, default: 0)
+///   Power law exponent for the wind speed as a function of height.
+///   Only used in strip mode, where the apparent wind is sampled at
+///   the centre of pressure of each strip.
+///
+/// 2. <wind_reference_height> (double, default: 10)
+///   Height at which the wind equals the wind system velocity.
+///
+/// 3. <telemetry> (bool, default: false)
+///   Publish the lift and drag state as an asv::LiftDragTelemetry
+///   message. In strip mode the forces are the strip resultants and
+///   the angle of attack, speed and coefficients are area weighted
+///   means of the strip values.
+///
+/// 4. <telemetry_topic> (string, default:
+///   /model/<model>/link/<link>/sail_lift_drag)
+///
+/// 5. <update_rate> (double, default: 1)
+///   Telemetry rate in Hz of simulation time. Also the default rate in
+///   Hz of wall clock time of the "SailLiftDrag" debug trace, see
+///   asv::Tracer.
+///
+/// The sail casts a wind shadow on other vessels, and is slowed by
+/// theirs, when the WindShadow system is loaded in the world.
+///
 class SailLiftDrag
     : public System,
       public ISystemConfigure,
@@ -38,7 +38,9 @@
 #include <gz/msgs/double.pb.h>
 
 #include <atomic>
+#include <sstream>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -50,11 +52,19 @@
 #include <gz/sim/components/JointForceCmd.hh>
 #include <gz/sim/components/JointVelocityCmd.hh>
 #include <gz/sim/components/JointPosition.hh>
+#include <gz/sim/components/Name.hh>
 #include <gz/sim/Model.hh>
 #include <gz/sim/Util.hh>
 
 #include <gz/transport/Node.hh>
 
+#include "asv/core/WinchArray.hh"
+#include "asv/sim/components/SailCommand.hh"
+#include "asv/sim/FlightRecorder.hh"
+#include "asv/sim/Metrics.hh"
+#include "asv/sim/Recorder.hh"
+#include "asv/sim/TransportRegistry.hh"
+
 namespace gz
 {
 namespace sim
@@ -68,15 +78,42 @@ class SailPositionControllerPrivate
   /// \param[in] _msg Position message
   public: void OnCmdPos(const msgs::Double &_msg);
 
-  /// \brief Gazebo communication node.
-  public: transport::Node node;
+  /// \brief Resolve a configured joint by its scoped name.
+  /// \param[in] _index Index of the joint name.
+  /// \param[in] _ecm The entity component manager.
+  /// \return True if the joint was found.
+  public: bool ResolveJoint(size_t _index,
+      const EntityComponentManager &_ecm);
+
+  /// \brief Resolve joints created since the last step.
+  /// \param[in] _ecm The entity component manager.
+  public: void ResolveNewJoints(const EntityComponentManager &_ecm);
+
+  /// \brief Report the joints that have not been found.
+  public: void ReportUnresolved() const;
 
-  /// \brief Joint Entity
+  /// \brief Command subscription.
+  public: asv::TransportRegistry::Subscription cmdSub;
+
+  /// \brief Joint entity for each joint name, kNullEntity until
+  /// resolved. The position of the first drives the controller.
   public: std::vector<Entity> jointEntities;
 
   /// \brief Joint name
   public: std::vector<std::string> jointNames;
 
+  /// \brief True for each joint name that has been resolved.
+  public: std::vector<bool> jointResolved;
+
+  /// \brief Index of the joint names by unscoped name, built once.
+  public: std::unordered_map<std::string, std::vector<size_t>> nameIndex;
+
+  /// \brief Number of joint names not yet resolved.
+  public: size_t numUnresolved{0};
+
+  /// \brief True once the existing entities have been searched.
+  public: bool initialSearch{false};
+
   /// \brief Commanded joint position
   public: std::atomic<double> jointPosCmd{0.0};
 
@@ -88,6 +125,19 @@ class SailPositionControllerPrivate
 
   /// \brief Joint index to be used.
   public: unsigned int jointIndex{0};
+
+  /// \brief True if commands come from the fleet command topic.
+  public: bool fleetCommand{false};
+
+  /// \brief Sheet winch, used instead of the PID controller if set.
+  public: asv::core::WinchArray winch;
+
+  /// \brief Record type of the controller trace.
+  public: uint32_t recordType{asv::Recorder::kInvalidType};
+
+  /// \brief Latency of PreUpdate.
+  public: asv::Metric &preUpdateLatency =
+      asv::Metrics::Instance().Latency("SailPositionController", "PreUpdate");
 };
 
 /////////////////////////////////////////////////
@@ -96,6 +146,79 @@ void SailPositionControllerPrivate::OnCmdPos(const msgs::Double &_msg)
   this->jointPosCmd = _msg.data();
 }
 
+/////////////////////////////////////////////////
+bool SailPositionControllerPrivate::ResolveJoint(size_t _index,
+    const EntityComponentManager &_ecm)
+{
+  const std::string &name = this->jointNames[_index];
+  auto entities = entitiesFromScopedName(name, _ecm, this->model.Entity());
+  if (entities.empty())
+    return false;
+
+  if (entities.size() > 1)
+  {
+    gzwarn << "Multiple joint entities with name ["
+           << name << "] found. "
+           << "Using the first one.\n";
+  }
+  Entity joint = *entities.begin();
+
+  // Validate
+  if (!_ecm.EntityHasComponentType(joint, components::Joint::typeId))
+  {
+    gzerr << "Entity with name[" << name
+          << "] is not a joint\n";
+    return false;
+  }
+
+  gzdbg << "Identified joint [" << name
+        << "] as Entity [" << joint << "]\n";
+  this->jointEntities[_index] = joint;
+  this->jointResolved[_index] = true;
+  --this->numUnresolved;
+  return true;
+}
+
+/////////////////////////////////////////////////
+void SailPositionControllerPrivate::ResolveNewJoints(
+    const EntityComponentManager &_ecm)
+{
+  bool resolved{false};
+  _ecm.EachNew<components::Joint, components::Name>(
+      [&](const Entity &,
+          const components::Joint *,
+          const components::Name *_name) -> bool
+      {
+        auto it = this->nameIndex.find(_name->Data());
+        if (it == this->nameIndex.end())
+          return true;
+
+        for (size_t index : it->second)
+        {
+          if (!this->jointResolved[index])
+            resolved |= this->ResolveJoint(index, _ecm);
+        }
+        return this->numUnresolved > 0;
+      });
+
+  if (resolved && this->numUnresolved > 0)
+    this->ReportUnresolved();
+}
+
+/////////////////////////////////////////////////
+void SailPositionControllerPrivate::ReportUnresolved() const
+{
+  std::ostringstream names;
+  for (size_t k = 0; k < this->jointNames.size(); ++k)
+  {
+    if (!this->jointResolved[k])
+      names << " [" << this->jointNames[k] << "]";
+  }
+  gzwarn << "[SailPositionController] " << this->numUnresolved << " of "
+         << this->jointNames.size() << " joints not found:" << names.str()
+         << ". Waiting for them to be created.\n";
+}
+
 /////////////////////////////////////////////////
 /////////////////////////////////////////////////
 SailPositionController::~SailPositionController() = default;
@@ -142,6 +265,19 @@ void SailPositionController::Configure(
     return;
   }
 
+  // Index the names by the unscoped name carried by the joint entity.
+  for (size_t k = 0; k < this->dataPtr->jointNames.size(); ++k)
+  {
+    const std::string &name = this->dataPtr->jointNames[k];
+    auto pos = name.rfind("::");
+    std::string leaf = pos == std::string::npos ? name : name.substr(pos + 2);
+    this->dataPtr->nameIndex[leaf].push_back(k);
+  }
+  this->dataPtr->jointEntities.assign(this->dataPtr->jointNames.size(),
+      kNullEntity);
+  this->dataPtr->jointResolved.assign(this->dataPtr->jointNames.size(), false);
+  this->dataPtr->numUnresolved = this->dataPtr->jointNames.size();
+
   if (_sdf->HasElement("joint_index"))
   {
     this->dataPtr->jointIndex = _sdf->Get<unsigned int>("joint_index");
@@ -198,6 +334,39 @@ void SailPositionController::Configure(
     this->dataPtr->jointPosCmd = _sdf->Get<double>("initial_position");
   }
 
+  // Winch
+  if (_sdf->HasElement("winch"))
+  {
+    auto winchElem = _sdf->FindElement("winch");
+    asv::core::WinchParams params;
+    params.maxSpeed =
+        winchElem->Get<double>("max_speed", params.maxSpeed).first;
+    params.maxForce =
+        winchElem->Get<double>("max_force", params.maxForce).first;
+    params.maxPower =
+        winchElem->Get<double>("max_power", params.maxPower).first;
+    params.stiffness =
+        winchElem->Get<double>("stiffness", params.stiffness).first;
+    params.damping = winchElem->Get<double>("damping", params.damping).first;
+    params.gain = winchElem->Get<double>("gain", params.gain).first;
+    if (params.maxSpeed <= 0.0 || params.maxForce <= 0.0 ||
+        params.stiffness <= 0.0 || params.gain <= 0.0)
+    {
+      gzerr << "<winch> requires a positive <max_speed>, <max_force>, "
+            << "<stiffness> and <gain>. Failed to initialize.\n";
+      return;
+    }
+    this->dataPtr->winch.Add(params, this->dataPtr->jointPosCmd);
+
+    gzdbg << "[SailPositionController] winch parameters:\n"
+          << "max_speed: [" << params.maxSpeed << "]\n"
+          << "max_force: [" << params.maxForce << "]\n"
+          << "max_power: [" << params.maxPower << "]\n"
+          << "stiffness: [" << params.stiffness << "]\n"
+          << "damping: ["   << params.damping << "]\n"
+          << "gain: ["      << params.gain << "]\n";
+  }
+
   // Subscribe to commands
   std::string topic;
   if ((!_sdf->HasElement("sub_topic")) && (!_sdf->HasElement("topic")))
@@ -243,8 +412,18 @@ void SailPositionController::Configure(
       return;
     }
   }
-  this->dataPtr->node.Subscribe(
-      topic, &SailPositionControllerPrivate::OnCmdPos, this->dataPtr.get());
+  if (_sdf->HasElement("fleet_command"))
+  {
+    this->dataPtr->fleetCommand = _sdf->Get<bool>("fleet_command");
+  }
+
+  // With fleet commands the SailFleetCommand system sets the command
+  // on the joint, so no subscription is needed.
+  if (!this->dataPtr->fleetCommand)
+  {
+    this->dataPtr->cmdSub = asv::TransportRegistry::Subscribe(
+        topic, &SailPositionControllerPrivate::OnCmdPos, this->dataPtr.get());
+  }
 
   gzdbg << "[SailPositionController] system parameters:" << "\n"
         << "p_gain: ["     << p         << "]"            << "\n"
@@ -256,6 +435,7 @@ void SailPositionController::Configure(
         << "cmd_min: ["    << cmdMin    << "]"            << "\n"
         << "cmd_offset: [" << cmdOffset << "]"            << "\n"
         << "topic: ["      << topic     << "]"            << "\n"
+        << "fleet_command: [" << this->dataPtr->fleetCommand << "]" << "\n"
         << "initial_position: [" << this->dataPtr->jointPosCmd << "]"
         << "\n";
 }
@@ -266,6 +446,7 @@ void SailPositionController::PreUpdate(
     EntityComponentManager &_ecm)
 {
   GZ_PROFILE("SailPositionController::PreUpdate");
+  asv::MetricTimer timer(this->dataPtr->preUpdateLatency);
 
   /// \todo(anyone) Support rewind
   if (_info.dt < std::chrono::steady_clock::duration::zero())
@@ -275,54 +456,27 @@ void SailPositionController::PreUpdate(
            << "s]. System may not work properly." << "\n";
   }
 
-  // If the joints haven't been identified yet, look for them
-  if (this->dataPtr->jointEntities.empty())
+  // Search the existing entities once, then only joints as they are
+  // created, so an unresolved controller costs nothing per step.
+  if (!this->dataPtr->initialSearch)
   {
-    bool warned{false};
-    for (const std::string &name : this->dataPtr->jointNames)
-    {
-      // First try to resolve by scoped name.
-      Entity joint = kNullEntity;
-      auto entities = entitiesFromScopedName(
-          name, _ecm, this->dataPtr->model.Entity());
-
-      if (!entities.empty())
-      {
-        if (entities.size() > 1)
-        {
-          gzwarn << "Multiple joint entities with name ["
-                 << name << "] found. "
-                 << "Using the first one.\n";
-        }
-        joint = *entities.begin();
-
-        // Validate
-        if (!_ecm.EntityHasComponentType(joint, components::Joint::typeId))
-        {
-          gzerr << "Entity with name[" << name
-                << "] is not a joint\n";
-          joint = kNullEntity;
-        }
-        else
-        {
-          gzdbg << "Identified joint [" << name
-                << "] as Entity [" << joint << "]\n";
-        }
-      }
-
-      if (joint != kNullEntity)
-      {
-        this->dataPtr->jointEntities.push_back(joint);
-      }
-      else if (!warned)
-      {
-        gzwarn << "Failed to find joint [" << name << "]\n";
-        warned = true;
-      }
-    }
+    this->dataPtr->initialSearch = true;
+    for (size_t k = 0; k < this->dataPtr->jointNames.size(); ++k)
+      this->dataPtr->ResolveJoint(k, _ecm);
+    if (this->dataPtr->numUnresolved > 0)
+      this->dataPtr->ReportUnresolved();
+  }
+  else if (this->dataPtr->numUnresolved > 0 && _ecm.HasNewEntities())
+  {
+    this->dataPtr->ResolveNewJoints(_ecm);
   }
-  if (this->dataPtr->jointEntities.empty())
+  // The position of the first <joint_name> drives the controller, in
+  // whatever order the joints are found.
+  if (this->dataPtr->jointEntities.empty() ||
+      this->dataPtr->jointEntities[0] == kNullEntity)
+  {
     return;
+  }
 
   // Nothing left to do if paused.
   if (_info.paused)
@@ -363,6 +517,16 @@ void SailPositionController::PreUpdate(
   const double pos = jointPosComp->Data().at(this->dataPtr->jointIndex);
   const double pos_sgn = pos < 0.0 ? -1.0 : 1.0;
 
+  // Fleet command, addressed to the first joint as there is one
+  // command for all joints.
+  if (this->dataPtr->fleetCommand)
+  {
+    auto cmdComp = _ecm.Component<components::SailPositionCmd>(
+        this->dataPtr->jointEntities[0]);
+    if (cmdComp)
+      this->dataPtr->jointPosCmd = cmdComp->Data();
+  }
+
   // Target position will be in [0, pos_max] (positive),
   // we set it to have the same sign as the current position
   const double pos_target = pos_sgn * this->dataPtr->jointPosCmd;
@@ -370,15 +534,41 @@ void SailPositionController::PreUpdate(
   // Calculate the error
   const double error = pos - pos_target;
 
+  // The winch sets the sheet length to the target and the sheet
+  // tension is the force on every joint.
+  double winchForce = 0.0;
+  if (this->dataPtr->winch.Size() > 0)
+  {
+    const double dt = std::chrono::duration<double>(_info.dt).count();
+    winchForce = this->dataPtr->winch.Update(
+        0, this->dataPtr->jointPosCmd, pos, dt);
+  }
+
+  const double time = std::chrono::duration<double>(_info.simTime).count();
+  auto &recorder = asv::Recorder::Instance();
+  if (recorder.IsOpen() &&
+      this->dataPtr->recordType == asv::Recorder::kInvalidType)
+  {
+    this->dataPtr->recordType = recorder.RegisterType("sail_controller",
+        {"command", "position", "force"});
+  }
+
   for (Entity joint : this->dataPtr->jointEntities)
   {
-    // Update force command.
-    double force = this->dataPtr->posPid.Update(error, _info.dt);
+    if (joint == kNullEntity)
+      continue;
 
-    // Only apply tension forces (when |pos_target| < |pos|)
-    if (force * pos_sgn > 0)
+    double force = winchForce;
+    if (this->dataPtr->winch.Size() == 0)
     {
-      force = 0.0;
+      // Update force command.
+      force = this->dataPtr->posPid.Update(error, _info.dt);
+
+      // Only apply tension forces (when |pos_target| < |pos|)
+      if (force * pos_sgn > 0)
+      {
+        force = 0.0;
+      }
     }
 
     auto forceComp = _ecm.Component<components::JointForceCmd>(joint);
@@ -388,8 +578,19 @@ void SailPositionController::PreUpdate(
     }
     else
     {
-      *forceComp = components::JointForceCmd({force});
+      // Write in place, the physics system zeroes the command each
+      // step but keeps its size.
+      auto &forceCmd = forceComp->Data();
+      if (forceCmd.size() != 1)
+        forceCmd.resize(1);
+      forceCmd[0] = force;
     }
+
+    const double values[] = {this->dataPtr->jointPosCmd, pos, force};
+    asv::FlightRecorder::Instance().Write(
+        asv::FlightRecorder::kSailController, time, joint, values, 3);
+    if (recorder.IsOpen())
+      recorder.Record(this->dataPtr->recordType, time, joint, values);
   }
 }
 
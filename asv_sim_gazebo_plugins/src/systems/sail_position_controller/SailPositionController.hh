@@ -35,6 +35,18 @@ class SailPositionControllerPrivate;
 
 /// \brief A plugin that simulates lift and drag on a sail
 /// in the presence of wind.
+///
+/// When <fleet_command> is true the controller does not subscribe to
+/// its own topic and takes its command from the SailPositionCmd
+/// component set on the joint by the SailFleetCommand system. The
+/// controller has one command for all of its joints, so only the first
+/// joint is addressed by the fleet command.
+///
+/// If a <winch> element is given the joint is driven by a sheet winch
+/// (asv::core::WinchArray) instead of the PID controller. The command is the
+/// sheet length in joint units. Elements, all optional:
+/// <max_speed>, <max_force>, <max_power>, <stiffness>, <damping>
+/// and <gain>.
 class SailPositionController
     : public System,
       public ISystemConfigure,
@@ -0,0 +1,524 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "SailVortexLattice.hh"
+
+#include <string>
+#include <vector>
+
+#include <gz/common/Profiler.hh>
+#include <gz/common/Util.hh>
+#include <gz/math/Pose3.hh>
+#include <gz/plugin/Register.hh>
+#include <gz/sim/components/LinearVelocity.hh>
+#include <gz/sim/components/Wind.hh>
+#include <gz/sim/Link.hh>
+#include <gz/sim/Model.hh>
+#include <gz/sim/Util.hh>
+
+#include "asv/sim/LiftDragModel.hh"
+#include "asv/sim/Log.hh"
+#include "asv/sim/Metrics.hh"
+#include "asv/sim/SailInteractionTable.hh"
+#include "asv/sim/SailPlanform.hh"
+#include "asv/sim/VortexLattice.hh"
+
+namespace gz
+{
+namespace sim
+{
+namespace systems
+{
+/////////////////////////////////////////////////
+/// \brief A sail in the vortex lattice.
+class VortexLatticeSail
+{
+  /// \brief Link interface.
+  public: Link link{kNullEntity};
+
+  /// \brief Lift drag model, used for profile drag, or for lift and
+  /// drag when using an interaction table.
+  public: std::unique_ptr<asv::LiftDragModel> liftDrag;
+
+  /// \brief Spanwise strips.
+  public: std::vector<asv::SailStrip> strips;
+
+  /// \brief Strip twist rotations in the link frame.
+  public: std::vector<math::Quaterniond> stripTwist;
+
+  /// \brief Strip areas.
+  public: std::vector<double> stripArea;
+
+  /// \brief Work buffers for the batch lift drag calculation.
+  public: std::vector<math::Vector3d> stripVel;
+  public: std::vector<math::Quaterniond> stripRot;
+  public: std::vector<math::Vector3d> stripLift;
+  public: std::vector<math::Vector3d> stripDrag;
+
+  /// \brief Index of the surface in the vortex lattice.
+  public: size_t surface{0};
+};
+
+/////////////////////////////////////////////////
+class SailVortexLatticePrivate
+{
+  /// \brief Load a sail from SDF.
+  /// \return True if successful.
+  public: bool LoadSail(
+      const std::shared_ptr<const sdf::Element> &_sdf,
+      EntityComponentManager &_ecm);
+
+  /// \brief Compute the sail forces using the interaction table.
+  /// \param[in] _velMean Sum of the panel free-stream velocities
+  /// (base link frame), giving the apparent wind angle.
+  public: void UpdateTable(
+      EntityComponentManager &_ecm,
+      const math::Vector3d &_velMean);
+
+  /// \brief Apply the resultant wrench to a sail.
+  public: void ApplyWrench(
+      EntityComponentManager &_ecm,
+      VortexLatticeSail &_sail,
+      const math::Vector3d &_force,
+      const math::Vector3d &_torque);
+
+  /// \brief Model interface
+  public: Model model{kNullEntity};
+
+  /// \brief Base link, the reference frame for the vortex lattice.
+  public: Link baseLink{kNullEntity};
+
+  /// \brief The sails.
+  public: std::vector<VortexLatticeSail> sails;
+
+  /// \brief The vortex lattice solver.
+  public: asv::VortexLattice vlm;
+
+  /// \brief Fluid density.
+  public: double fluidDensity{1.2};
+
+  /// \brief Precomputed interaction table, used instead of the
+  /// vortex lattice if set.
+  public: std::unique_ptr<asv::SailInteractionTable> table;
+
+  /// \brief Trim of each sail (base link frame).
+  public: std::vector<double> trim;
+
+  /// \brief Upwash on each sail from the interaction table.
+  public: std::vector<double> upwash;
+
+  /// \brief Free-stream velocity at each panel (base link frame).
+  public: std::vector<math::Vector3d> panelVel;
+
+  /// \brief Force on each panel (base link frame).
+  public: std::vector<math::Vector3d> panelForce;
+
+  /// \brief True if the configuration is valid.
+  public: bool valid{false};
+
+  /// \brief Latency of PreUpdate.
+  public: asv::Metric &preUpdateLatency =
+      asv::Metrics::Instance().Latency("SailVortexLattice", "PreUpdate");
+
+  /// \brief Latency of the lattice solve.
+  public: asv::Metric &solveLatency =
+      asv::Metrics::Instance().Latency("SailVortexLattice", "Solve");
+
+  /// \brief Number of factorisations of the influence matrix.
+  public: asv::Metric &factorisations =
+      asv::Metrics::Instance().Counter("SailVortexLattice",
+          "factorisations");
+};
+
+/////////////////////////////////////////////////
+bool SailVortexLatticePrivate::LoadSail(
+    const std::shared_ptr<const sdf::Element> &_sdf,
+    EntityComponentManager &_ecm)
+{
+  VortexLatticeSail sail;
+
+  if (!_sdf->HasElement("link_name"))
+  {
+    gzerr << "You must specify a <link_name> for each <sail> of the"
+          << " SailVortexLattice plugin.\n";
+    return false;
+  }
+  auto linkName = _sdf->Get<std::string>("link_name");
+  auto linkEntity = this->model.LinkByName(_ecm, linkName);
+  if (!_ecm.HasEntity(linkEntity))
+  {
+    gzerr << "Link with name [" << linkName << "] not found "
+          << "in model [" << this->model.Name(_ecm) << "]. "
+          << "The SailVortexLattice plugin will not generate forces.\n";
+    return false;
+  }
+  sail.link = Link(linkEntity);
+
+  sail.liftDrag.reset(asv::LiftDragModel::Create(_sdf));
+  if (!sail.liftDrag)
+    return false;
+
+  asv::SailPlanform planform;
+  if (!_sdf->HasElement("strips") ||
+      !asv::SailPlanform::Load(_sdf->FindElement("strips"), planform))
+  {
+    gzerr << "You must specify valid <strips> for sail [" << linkName
+          << "] of the SailVortexLattice plugin.\n";
+    return false;
+  }
+  planform.Discretise(sail.liftDrag->Forward(), sail.strips);
+
+  // Twist is about the span axis, normal to the lift-drag plane.
+  auto spanAxis = sail.liftDrag->Forward().Cross(
+      sail.liftDrag->Upward()).Normalize();
+
+  size_t n = sail.strips.size();
+  sail.stripTwist.resize(n);
+  sail.stripArea.resize(n);
+  sail.stripVel.resize(n);
+  sail.stripRot.resize(n);
+  sail.stripLift.resize(n);
+  sail.stripDrag.resize(n);
+  for (size_t i = 0; i < n; ++i)
+  {
+    sail.stripTwist[i] = math::Quaterniond(spanAxis, sail.strips[i].twist);
+    sail.stripArea[i] = sail.strips[i].area;
+  }
+
+  sail.surface = this->vlm.AddSurface(sail.strips,
+      sail.liftDrag->Forward(), sail.liftDrag->Upward());
+  this->sails.push_back(std::move(sail));
+
+  return true;
+}
+
+/////////////////////////////////////////////////
+void SailVortexLatticePrivate::UpdateTable(
+    EntityComponentManager &_ecm,
+    const math::Vector3d &_velMean)
+{
+  // Interaction corrections for all sails from one set of lookups.
+  double awa = asv::SailInteractionTable::ApparentWindAngle(_velMean);
+  this->table->Upwash(this->trim, awa, this->upwash);
+
+  for (size_t s = 0; s < this->sails.size(); ++s)
+  {
+    auto &sail = this->sails[s];
+    for (size_t i = 0; i < sail.strips.size(); ++i)
+    {
+      auto normal = sail.stripRot[i].RotateVector(sail.liftDrag->Upward());
+      sail.stripVel[i] += this->upwash[s] * sail.stripVel[i].Length()
+          * normal;
+    }
+
+    sail.liftDrag->Compute(sail.stripVel, sail.stripRot, sail.stripArea,
+        sail.stripLift, sail.stripDrag);
+
+    auto linkRotWorld = sail.link.WorldPose(_ecm)->Rot();
+    math::Vector3d force = math::Vector3d::Zero;
+    math::Vector3d torque = math::Vector3d::Zero;
+    for (size_t i = 0; i < sail.strips.size(); ++i)
+    {
+      auto f = sail.stripLift[i] + sail.stripDrag[i];
+      auto xr = linkRotWorld.RotateVector(sail.strips[i].cp);
+      force += f;
+      torque += xr.Cross(f);
+    }
+    this->ApplyWrench(_ecm, sail, force, torque);
+  }
+}
+
+/////////////////////////////////////////////////
+void SailVortexLatticePrivate::ApplyWrench(
+    EntityComponentManager &_ecm,
+    VortexLatticeSail &_sail,
+    const math::Vector3d &_force,
+    const math::Vector3d &_torque)
+{
+  if (_force.IsFinite() && _torque.IsFinite())
+  {
+    _sail.link.AddWorldWrench(_ecm, _force, _torque);
+  }
+  else
+  {
+    asvwarn << "SailVortexLattice: overflow in force calculation.\n"
+            << "Link:         " << _sail.link.Name(_ecm).value() << "\n"
+            << "force:        " << _force << "\n"
+            << "torque:       " << _torque << "\n"
+            << "\n";
+  }
+}
+
+/////////////////////////////////////////////////
+SailVortexLattice::~SailVortexLattice() = default;
+
+/////////////////////////////////////////////////
+SailVortexLattice::SailVortexLattice()
+  : System(), dataPtr(std::make_unique<SailVortexLatticePrivate>())
+{
+}
+
+/////////////////////////////////////////////////
+void SailVortexLattice::Configure(
+    const Entity &_entity,
+    const std::shared_ptr<const sdf::Element> &_sdf,
+    EntityComponentManager &_ecm,
+    EventManager &/*_eventMgr*/)
+{
+  this->dataPtr->model = Model(_entity);
+
+  if (!this->dataPtr->model.Valid(_ecm))
+  {
+    gzerr << "SailVortexLattice plugin should be attached to a model "
+           << "entity. Failed to initialize.\n";
+    return;
+  }
+
+  // Base link
+  {
+    Entity linkEntity = kNullEntity;
+    if (_sdf->HasElement("base_link_name"))
+    {
+      auto linkName = _sdf->Get<std::string>("base_link_name");
+      linkEntity = this->dataPtr->model.LinkByName(_ecm, linkName);
+    }
+    else
+    {
+      linkEntity = this->dataPtr->model.CanonicalLink(_ecm);
+    }
+    if (!_ecm.HasEntity(linkEntity))
+    {
+      gzerr << "Base link not found in model ["
+            << this->dataPtr->model.Name(_ecm) << "]. "
+            << "The SailVortexLattice plugin will not generate forces.\n";
+      return;
+    }
+    this->dataPtr->baseLink = Link(linkEntity);
+  }
+
+  if (_sdf->HasElement("refactor_threshold"))
+  {
+    this->dataPtr->vlm.SetRefactorThreshold(
+        _sdf->Get<double>("refactor_threshold"));
+  }
+  else
+  {
+    this->dataPtr->vlm.SetRefactorThreshold(0.02);
+  }
+
+  if (_sdf->HasElement("fluid_density"))
+  {
+    this->dataPtr->fluidDensity = _sdf->Get<double>("fluid_density");
+  }
+
+  // Sails
+  auto sailElem = _sdf->FindElement("sail");
+  while (sailElem)
+  {
+    if (!this->dataPtr->LoadSail(sailElem, _ecm))
+    {
+      gzerr << "Failed to load <sail>. "
+            << "The SailVortexLattice plugin will not generate forces.\n";
+      return;
+    }
+    sailElem = sailElem->GetNextElement("sail");
+  }
+  if (this->dataPtr->sails.empty())
+  {
+    gzerr << "You must specify at least one <sail> for the "
+          << "SailVortexLattice plugin.\n";
+    return;
+  }
+
+  // Interaction table
+  if (_sdf->HasElement("interaction_table"))
+  {
+    auto uri = _sdf->Get<std::string>("interaction_table");
+    auto filename = common::findFile(asFullPath(uri, _sdf->FilePath()));
+    this->dataPtr->table = std::make_unique<asv::SailInteractionTable>();
+    if (!this->dataPtr->table->Load(filename))
+    {
+      gzerr << "Failed to load <interaction_table> [" << uri << "]. "
+            << "The SailVortexLattice plugin will not generate forces.\n";
+      return;
+    }
+    if (this->dataPtr->table->SailCount() != this->dataPtr->sails.size())
+    {
+      gzerr << "The <interaction_table> [" << uri << "] is for ["
+            << this->dataPtr->table->SailCount() << "] sails but ["
+            << this->dataPtr->sails.size() << "] are listed. "
+            << "The SailVortexLattice plugin will not generate forces.\n";
+      return;
+    }
+    this->dataPtr->trim.resize(this->dataPtr->sails.size());
+    this->dataPtr->upwash.resize(this->dataPtr->sails.size());
+  }
+
+  size_t n = this->dataPtr->vlm.PanelCount();
+  this->dataPtr->panelVel.resize(n);
+  this->dataPtr->panelForce.resize(n);
+  this->dataPtr->valid = true;
+
+  gzdbg << "[SailVortexLattice] system parameters:\n"
+        << "sails: [" << this->dataPtr->sails.size() << "]\n"
+        << "panels: [" << n << "]\n"
+        << "solver: ["
+        << (this->dataPtr->table ? "interaction_table" : "vortex_lattice")
+        << "]\n";
+}
+
+/////////////////////////////////////////////////
+void SailVortexLattice::PreUpdate(
+    const UpdateInfo &_info,
+    EntityComponentManager &_ecm)
+{
+  GZ_PROFILE("SailVortexLattice::PreUpdate");
+  asv::MetricTimer timer(this->dataPtr->preUpdateLatency);
+
+  if (_info.paused)
+    return;
+
+  if (!this->dataPtr->valid || !this->dataPtr->baseLink.Valid(_ecm))
+    return;
+
+  // ensure components are available
+  this->dataPtr->baseLink.EnableVelocityChecks(_ecm, true);
+  for (auto &sail : this->dataPtr->sails)
+  {
+    sail.link.EnableVelocityChecks(_ecm, true);
+  }
+
+  // wind velocity
+  auto velWindWorld = math::Vector3d::Zero;
+  Entity windEntity = _ecm.EntityByComponents(components::Wind());
+  auto velWindWorldComp =
+      _ecm.Component<components::WorldLinearVelocity>(windEntity);
+  if (velWindWorldComp)
+  {
+    velWindWorld = velWindWorldComp->Data();
+  }
+
+  // Pose of the base link (world frame).
+  auto basePoseWorldOpt = this->dataPtr->baseLink.WorldPose(_ecm);
+  if (!basePoseWorldOpt.has_value())
+    return;
+  auto basePoseWorld = basePoseWorldOpt.value();
+  auto baseRotInv = basePoseWorld.Rot().Inverse();
+
+  // Sail poses and the free stream at each panel.
+  math::Vector3d velMean = math::Vector3d::Zero;
+  for (size_t s = 0; s < this->dataPtr->sails.size(); ++s)
+  {
+    auto &sail = this->dataPtr->sails[s];
+    auto linkPoseWorldOpt = sail.link.WorldPose(_ecm);
+    auto linVelOpt = sail.link.WorldLinearVelocity(_ecm);
+    auto angVelOpt = sail.link.WorldAngularVelocity(_ecm);
+    if (!linkPoseWorldOpt.has_value() || !linVelOpt.has_value() ||
+        !angVelOpt.has_value())
+    {
+      return;
+    }
+    auto linkPoseWorld = linkPoseWorldOpt.value();
+    auto linVel = linVelOpt.value();
+    auto angVel = angVelOpt.value();
+
+    // Sail pose in the base link frame.
+    math::Pose3d linkPoseBase(
+        baseRotInv.RotateVector(linkPoseWorld.Pos() - basePoseWorld.Pos()),
+        baseRotInv * linkPoseWorld.Rot());
+    this->dataPtr->vlm.SetSurfacePose(sail.surface, linkPoseBase);
+    if (this->dataPtr->table)
+    {
+      this->dataPtr->trim[s] = asv::SailInteractionTable::TrimAngle(
+          linkPoseBase.Rot(), sail.liftDrag->Forward());
+    }
+
+    size_t offset = this->dataPtr->vlm.PanelOffset(sail.surface);
+    for (size_t i = 0; i < sail.strips.size(); ++i)
+    {
+      auto xr = linkPoseWorld.Rot().RotateVector(sail.strips[i].cp);
+      auto velCp = linVel + angVel.Cross(xr);
+      sail.stripVel[i] = velWindWorld - velCp;
+      sail.stripRot[i] = linkPoseWorld.Rot() * sail.stripTwist[i];
+      this->dataPtr->panelVel[offset + i] =
+          baseRotInv.RotateVector(sail.stripVel[i]);
+      velMean += this->dataPtr->panelVel[offset + i];
+    }
+  }
+
+  if (this->dataPtr->table)
+  {
+    this->dataPtr->UpdateTable(_ecm, velMean);
+    return;
+  }
+
+  // Coupled lift for all sails.
+  bool solved = false;
+  {
+    asv::MetricTimer solveTimer(this->dataPtr->solveLatency);
+    size_t factorisations = this->dataPtr->vlm.FactorisationCount();
+    solved = this->dataPtr->vlm.Solve(this->dataPtr->panelVel,
+        this->dataPtr->fluidDensity, this->dataPtr->panelForce);
+    this->dataPtr->factorisations.Increment(
+        this->dataPtr->vlm.FactorisationCount() - factorisations);
+  }
+  if (!solved)
+  {
+    asvwarn << "SailVortexLattice: solver failed.\n";
+    return;
+  }
+
+  // Resultant wrench for each sail.
+  for (auto &sail : this->dataPtr->sails)
+  {
+    // Profile drag for each strip.
+    sail.liftDrag->Compute(sail.stripVel, sail.stripRot, sail.stripArea,
+        sail.stripLift, sail.stripDrag);
+
+    auto linkPosWorld = sail.link.WorldPose(_ecm)->Pos();
+    math::Vector3d force = math::Vector3d::Zero;
+    math::Vector3d torque = math::Vector3d::Zero;
+    size_t offset = this->dataPtr->vlm.PanelOffset(sail.surface);
+    for (size_t i = 0; i < sail.strips.size(); ++i)
+    {
+      size_t k = offset + i;
+      auto lift = basePoseWorld.Rot().RotateVector(
+          this->dataPtr->panelForce[k]);
+      auto f = lift + sail.stripDrag[i];
+
+      // Force acts at the bound vortex (about link origin in world frame).
+      auto xr = basePoseWorld.Pos() + basePoseWorld.Rot().RotateVector(
+          this->dataPtr->vlm.BoundMidpoint(k)) - linkPosWorld;
+      force += f;
+      torque += xr.Cross(f);
+    }
+
+    this->dataPtr->ApplyWrench(_ecm, sail, force, torque);
+  }
+}
+
+}  // namespace systems
+}  // namespace sim
+}  // namespace gz
+
+GZ_ADD_PLUGIN(
+    gz::sim::systems::SailVortexLattice,
+    gz::sim::System,
+    gz::sim::systems::SailVortexLattice::ISystemConfigure,
+    gz::sim::systems::SailVortexLattice::ISystemPreUpdate)
+
+GZ_ADD_PLUGIN_ALIAS(
+    gz::sim::systems::SailVortexLattice,
+    "gz::sim::systems::SailVortexLattice")
@@ -0,0 +1,124 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ASV_SIM_SAILVORTEXLATTICE_HH_
+#define ASV_SIM_SAILVORTEXLATTICE_HH_
+
+#include <memory>
+#include <string>
+
+#include <gz/sim/System.hh>
+
+namespace gz
+{
+namespace sim
+{
+// Inline bracket to help doxygen filtering.
+inline namespace GZ_SIM_VERSION_NAMESPACE {
+namespace systems
+{
+
+// Forward declarations.
+class SailVortexLatticePrivate;
+
+/// \brief A plugin that simulates the lift and drag on a set of
+/// interacting sails using a vortex lattice method.
+///
+/// The plugin is attached to a model and replaces the SailLiftDrag
+/// plugins for the sails it lists. Lift is computed by an
+/// asv::VortexLattice solver that couples all the sails, and profile
+/// drag for each strip is computed by its asv::LiftDragModel.
+///
+/// Alternatively an <interaction_table> generated offline by
+/// asv_sim_sail_interaction_table may be given. The lattice is then not
+/// solved: the upwash each sail induces on the others is looked up for
+/// the current trims and apparent wind angle, added to the free stream
+/// at each strip, and the lift and drag are computed by the
+/// asv::LiftDragModel of each sail. This costs little more than
+/// independent SailLiftDrag plugins.
+///
+/// # Usage
+///
+/// \code
+/// <plugin filename="asv_sim2-sail-vortex-lattice-system"
+///     name="gz::sim::systems::SailVortexLattice">
+///   <base_link_name>base_link</base_link_name>
+///   <refactor_threshold>0.02</refactor_threshold>
+///   <sail>
+///     <link_name>main_sail_link</link_name>
+///     <cla>6.2832</cla>
+///     ...
+///     <strips>...</strips>
+///   </sail>
+///   <sail>
+///     <link_name>jib_sail_link</link_name>
+///     ...
+///   </sail>
+/// </plugin>
+/// \endcode
+///
+/// # Parameters
+///
+/// 1. <base_link_name> (string, default: canonical link)
+///   The link whose frame the influence matrix is built in.
+///
+/// 2. <refactor_threshold> (double, default: 0.02)
+///   Trim angle change in radians before the influence matrix
+///   is refactorised.
+///
+/// 3. <fluid_density> (double, default: 1.2)
+///   The fluid density.
+///
+/// 4. <sail> (element, at least one)
+///   A <link_name>, <strips> (see asv::SailPlanform) and the
+///   asv::LiftDragModel parameters for each sail.
+///
+/// 5. <interaction_table> (string, optional)
+///   URI of a binary asv::SailInteractionTable with an entry for each
+///   <sail> in the order listed.
+///
+class SailVortexLattice
+    : public System,
+      public ISystemConfigure,
+      public ISystemPreUpdate
+{
+  /// \brief Destructor.
+  public: virtual ~SailVortexLattice();
+
+  /// \brief Constructor.
+  public: SailVortexLattice();
+
+  // Documentation inherited
+  public: void Configure(
+      const Entity &_entity,
+      const std::shared_ptr<const sdf::Element> &_sdf,
+      EntityComponentManager &_ecm,
+      EventManager &_eventMgr) final;
+
+  /// Documentation inherited
+  public: void PreUpdate(
+      const UpdateInfo &_info,
+      EntityComponentManager &_ecm) override;
+
+  /// \brief Private data pointer.
+  private: std::unique_ptr<SailVortexLatticePrivate> dataPtr;
+};
+
+}  // namespace systems
+}
+}  // namespace sim
+}  // namespace gz
+
+#endif  // ASV_SIM_SAILVORTEXLATTICE_HH_
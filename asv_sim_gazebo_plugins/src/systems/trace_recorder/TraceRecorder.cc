@@ -0,0 +1,99 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "TraceRecorder.hh"
+
+#include <string>
+
+#include <gz/plugin/Register.hh>
+#include <gz/sim/EntityComponentManager.hh>
+#include <gz/sim/World.hh>
+
+#include "asv/sim/Recorder.hh"
+
+namespace gz
+{
+namespace sim
+{
+namespace systems
+{
+/////////////////////////////////////////////////
+class TraceRecorderPrivate
+{
+  /// \brief True if this plugin opened the recorder.
+  public: bool opened{false};
+};
+
+/////////////////////////////////////////////////
+TraceRecorder::~TraceRecorder()
+{
+  if (this->dataPtr->opened)
+  {
+    auto &recorder = asv::Recorder::Instance();
+    recorder.Close();
+    gzmsg << "[TraceRecorder] wrote [" << recorder.WrittenCount()
+          << "] samples, dropped [" << recorder.DroppedCount() << "].\n";
+  }
+}
+
+/////////////////////////////////////////////////
+TraceRecorder::TraceRecorder()
+  : System(), dataPtr(std::make_unique<TraceRecorderPrivate>())
+{
+}
+
+/////////////////////////////////////////////////
+void TraceRecorder::Configure(
+    const Entity &_entity,
+    const std::shared_ptr<const sdf::Element> &_sdf,
+    EntityComponentManager &_ecm,
+    EventManager &/*_eventMgr*/)
+{
+  if (!World(_entity).Valid(_ecm))
+  {
+    gzerr << "TraceRecorder plugin should be attached to a world "
+          << "entity. Failed to initialize.\n";
+    return;
+  }
+
+  auto &recorder = asv::Recorder::Instance();
+  if (recorder.IsOpen())
+  {
+    gzerr << "TraceRecorder: the recorder is already open. "
+          << "Failed to initialize.\n";
+    return;
+  }
+
+  std::string path = "asv_sim_trace.asvr";
+  if (_sdf->HasElement("path"))
+    path = _sdf->Get<std::string>("path");
+
+  this->dataPtr->opened = recorder.Open(path);
+  if (this->dataPtr->opened)
+    gzmsg << "[TraceRecorder] recording to [" << path << "].\n";
+}
+
+}  // namespace systems
+}  // namespace sim
+}  // namespace gz
+
+GZ_ADD_PLUGIN(
+    gz::sim::systems::TraceRecorder,
+    gz::sim::System,
+    gz::sim::systems::TraceRecorder::ISystemConfigure)
+
+GZ_ADD_PLUGIN_ALIAS(
+    gz::sim::systems::TraceRecorder,
+    "gz::sim::systems::TraceRecorder")
@@ -0,0 +1,94 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ASV_SIM_TRACERECORDER_HH_
+#define ASV_SIM_TRACERECORDER_HH_
+
+#include <memory>
+#include <string>
+
+#include <gz/sim/System.hh>
+
+namespace gz
+{
+namespace sim
+{
+// Inline bracket to help doxygen filtering.
+inline namespace GZ_SIM_VERSION_NAMESPACE {
+namespace systems
+{
+
+// Forward declarations.
+class TraceRecorderPrivate;
+
+/// \brief A plugin that records per-step traces of the asv_sim systems
+/// to a file for offline analysis.
+///
+/// The plugin opens the process-wide asv::Recorder for the lifetime of
+/// the world. While it is open SailLiftDrag, FoilLiftDrag, Mooring,
+/// SailPositionController and SailFleetController record a sample for
+/// each of their entities every step. The file is read with
+/// asv::RecordReader. Record types:
+///
+/// - lift_drag: alpha, speed, cl, cd, lift_{x,y,z}, drag_{x,y,z} and
+///   wind_{x,y,z}, the apparent wind in the world frame. The entity is
+///   the link.
+/// - mooring: force_{x,y,z}, the chain force on the link, and v, h,
+///   the vertical and horizontal distance to the anchor. The entity is
+///   the link.
+/// - sail_controller: command, position and force. The entity is the
+///   joint.
+///
+/// # Usage
+///
+/// \code
+/// <plugin filename="asv_sim2-trace-recorder-system"
+///     name="gz::sim::systems::TraceRecorder">
+///   <path>/tmp/race.asvr</path>
+/// </plugin>
+/// \endcode
+///
+/// # Parameters
+///
+/// 1. <path> (string, default: asv_sim_trace.asvr)
+///   The file to write. An existing file is overwritten.
+///
+class TraceRecorder
+    : public System,
+      public ISystemConfigure
+{
+  /// \brief Destructor.
+  public: virtual ~TraceRecorder();
+
+  /// \brief Constructor.
+  public: TraceRecorder();
+
+  // Documentation inherited
+  public: void Configure(
+      const Entity &_entity,
+      const std::shared_ptr<const sdf::Element> &_sdf,
+      EntityComponentManager &_ecm,
+      EventManager &_eventMgr) final;
+
+  /// \brief Private data pointer.
+  private: std::unique_ptr<TraceRecorderPrivate> dataPtr;
+};
+
+}  // namespace systems
+}
+}  // namespace sim
+}  // namespace gz
+
+#endif  // ASV_SIM_TRACERECORDER_HH_
@@ -34,6 +34,9 @@
 
 #include <gz/transport/Node.hh>
 
+#include "asv/sim/Metrics.hh"
+#include "asv/sim/TransportRegistry.hh"
+
 namespace gz
 {
 namespace sim
@@ -47,8 +50,8 @@ class WindPrivate
   /// \param[in] _msg Position message
   public: void OnWindVelocity(const msgs::Vector3d &_msg);
 
-  /// \brief Gazebo communication node.
-  public: transport::Node node;
+  /// \brief Wind velocity subscription.
+  public: asv::TransportRegistry::Subscription windSub;
 
   /// \brief World
   public: World world;
@@ -60,6 +63,10 @@ class WindPrivate
 
   /// \brief World wind velocity
   public: math::Vector3d windVelWorld;
+
+  /// \brief Latency of PreUpdate.
+  public: asv::Metric &preUpdateLatency =
+      asv::Metrics::Instance().Latency("Wind", "PreUpdate");
 };
 
 /////////////////////////////////////////////////
@@ -120,7 +127,7 @@ void Wind::Configure(
       return;
     }
   }
-  this->dataPtr->node.Subscribe(
+  this->dataPtr->windSub = asv::TransportRegistry::Subscribe(
       topic, &WindPrivate::OnWindVelocity, this->dataPtr.get());
 
   gzdbg << "[Wind] system parameters:" << "\n"
@@ -134,6 +141,7 @@ void Wind::PreUpdate(
     EntityComponentManager &_ecm)
 {
   GZ_PROFILE("Wind::PreUpdate");
+  asv::MetricTimer timer(this->dataPtr->preUpdateLatency);
 
   /// \todo(anyone) Support rewind
   if (_info.dt < std::chrono::steady_clock::duration::zero())
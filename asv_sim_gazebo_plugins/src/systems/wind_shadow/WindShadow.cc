@@ -0,0 +1,219 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "WindShadow.hh"
+
+#include <string>
+#include <unordered_map>
+
+#include <gz/common/Profiler.hh>
+#include <gz/math/Helpers.hh>
+#include <gz/math/Pose3.hh>
+#include <gz/plugin/Register.hh>
+#include <gz/sim/components/LinearVelocity.hh>
+#include <gz/sim/components/Wind.hh>
+#include <gz/sim/EntityComponentManager.hh>
+#include <gz/sim/Util.hh>
+#include <gz/sim/World.hh>
+
+#include "asv/sim/components/WindShadow.hh"
+#include "asv/sim/Metrics.hh"
+#include "asv/sim/WindShadowGrid.hh"
+
+namespace gz
+{
+namespace sim
+{
+namespace systems
+{
+/////////////////////////////////////////////////
+class WindShadowPrivate
+{
+  /// \brief The top level model of an entity, cached.
+  public: Entity TopLevelModel(
+      const EntityComponentManager &_ecm, Entity _entity);
+
+  /// \brief World
+  public: World world{kNullEntity};
+
+  /// \brief Template for the wake cones.
+  public: asv::WindShadowCone cone;
+
+  /// \brief Spatial hash grid of the wake cones.
+  public: std::unique_ptr<asv::WindShadowGrid> grid;
+
+  /// \brief Cache of the top level model of each entity.
+  public: std::unordered_map<Entity, Entity> modelCache;
+
+  /// \brief Latency of PreUpdate.
+  public: asv::Metric &preUpdateLatency =
+      asv::Metrics::Instance().Latency("WindShadow", "PreUpdate");
+};
+
+/////////////////////////////////////////////////
+Entity WindShadowPrivate::TopLevelModel(
+    const EntityComponentManager &_ecm, Entity _entity)
+{
+  auto it = this->modelCache.find(_entity);
+  if (it != this->modelCache.end())
+    return it->second;
+
+  auto model = topLevelModel(_entity, _ecm);
+  this->modelCache.emplace(_entity, model);
+  return model;
+}
+
+/////////////////////////////////////////////////
+WindShadow::~WindShadow() = default;
+
+/////////////////////////////////////////////////
+WindShadow::WindShadow()
+  : System(), dataPtr(std::make_unique<WindShadowPrivate>())
+{
+}
+
+/////////////////////////////////////////////////
+void WindShadow::Configure(
+    const Entity &_entity,
+    const std::shared_ptr<const sdf::Element> &_sdf,
+    EntityComponentManager &_ecm,
+    EventManager &/*_eventMgr*/)
+{
+  this->dataPtr->world = World(_entity);
+
+  if (!this->dataPtr->world.Valid(_ecm))
+  {
+    gzerr << "WindShadow plugin should be attached to a world "
+          << "entity. Failed to initialize.\n";
+    return;
+  }
+
+  auto &cone = this->dataPtr->cone;
+  if (_sdf->HasElement("cone_length"))
+    cone.length = _sdf->Get<double>("cone_length");
+  if (_sdf->HasElement("cone_radius"))
+    cone.radius = _sdf->Get<double>("cone_radius");
+  if (_sdf->HasElement("cone_half_angle"))
+    cone.halfAngle = _sdf->Get<double>("cone_half_angle");
+  if (_sdf->HasElement("max_deficit"))
+    cone.deficit = _sdf->Get<double>("max_deficit");
+
+  double cellSize = 25.0;
+  if (_sdf->HasElement("cell_size"))
+    cellSize = _sdf->Get<double>("cell_size");
+
+  if (cone.length <= 0.0 || cone.radius < 0.0 || cellSize <= 0.0 ||
+      cone.halfAngle < 0.0 || cone.halfAngle >= GZ_PI / 2.0 ||
+      cone.deficit < 0.0 || cone.deficit >= 1.0)
+  {
+    gzerr << "WindShadow requires a positive <cone_length> and "
+          << "<cell_size>, a non-negative <cone_radius>, a "
+          << "<cone_half_angle> in [0, pi/2), and a <max_deficit> in "
+          << "[0, 1). Failed to initialize.\n";
+    return;
+  }
+
+  this->dataPtr->grid = std::make_unique<asv::WindShadowGrid>(cellSize);
+
+  gzdbg << "[WindShadow] system parameters:\n"
+        << "cone_length:     [" << cone.length << "]\n"
+        << "cone_radius:     [" << cone.radius << "]\n"
+        << "cone_half_angle: [" << cone.halfAngle << "]\n"
+        << "max_deficit:     [" << cone.deficit << "]\n"
+        << "cell_size:       [" << cellSize << "]\n";
+}
+
+/////////////////////////////////////////////////
+void WindShadow::PreUpdate(
+    const UpdateInfo &_info,
+    EntityComponentManager &_ecm)
+{
+  GZ_PROFILE("WindShadow::PreUpdate");
+  asv::MetricTimer timer(this->dataPtr->preUpdateLatency);
+
+  if (_info.paused || !this->dataPtr->grid)
+    return;
+
+  _ecm.EachRemoved<components::WindShadowFactor>(
+    [&](const Entity &_entity, const components::WindShadowFactor *)->bool
+    {
+      this->dataPtr->modelCache.erase(_entity);
+      return true;
+    });
+
+  // wind velocity
+  auto velWindWorld = math::Vector3d::Zero;
+  Entity windEntity = _ecm.EntityByComponents(components::Wind());
+  auto velWindWorldComp =
+      _ecm.Component<components::WorldLinearVelocity>(windEntity);
+  if (velWindWorldComp)
+  {
+    velWindWorld = velWindWorldComp->Data();
+  }
+  velWindWorld.Z(0.0);
+
+  // Insert the wake cone of every sail.
+  auto &grid = *this->dataPtr->grid;
+  grid.Clear();
+  if (velWindWorld.Length() > 1.0E-3)
+  {
+    auto &cone = this->dataPtr->cone;
+    cone.direction = velWindWorld.Normalized();
+    _ecm.Each<components::WindShadowSource>(
+      [&](const Entity &_entity,
+          const components::WindShadowSource *_source)->bool
+      {
+        auto pose = worldPose(_entity, _ecm);
+        cone.apex = pose.Pos() + pose.Rot().RotateVector(_source->Data());
+        cone.source = this->dataPtr->TopLevelModel(_ecm, _entity);
+        grid.Insert(cone);
+        return true;
+      });
+  }
+
+  // Look up the shadow at every receiver.
+  _ecm.Each<components::WindShadowFactor>(
+    [&](const Entity &_entity,
+        components::WindShadowFactor *_factor)->bool
+    {
+      if (grid.ConeCount() == 0)
+      {
+        _factor->Data() = 1.0;
+        return true;
+      }
+      auto pose = worldPose(_entity, _ecm);
+      auto point = pose.Pos();
+      auto source = _ecm.Component<components::WindShadowSource>(_entity);
+      if (source)
+        point += pose.Rot().RotateVector(source->Data());
+      _factor->Data() = grid.Factor(point,
+          this->dataPtr->TopLevelModel(_ecm, _entity));
+      return true;
+    });
+}
+
+}  // namespace systems
+}  // namespace sim
+}  // namespace gz
+
+GZ_ADD_PLUGIN(
+    gz::sim::systems::WindShadow,
+    gz::sim::System,
+    gz::sim::systems::WindShadow::ISystemConfigure,
+    gz::sim::systems::WindShadow::ISystemPreUpdate)
+
+GZ_ADD_PLUGIN_ALIAS(
+    gz::sim::systems::WindShadow,
+    "gz::sim::systems::WindShadow")
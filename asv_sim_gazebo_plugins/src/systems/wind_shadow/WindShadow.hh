@@ -0,0 +1,96 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ASV_SIM_WINDSHADOW_HH_
+#define ASV_SIM_WINDSHADOW_HH_
+
+#include <memory>
+#include <string>
+
+#include <gz/sim/System.hh>
+
+namespace gz
+{
+namespace sim
+{
+// Inline bracket to help doxygen filtering.
+inline namespace GZ_SIM_VERSION_NAMESPACE {
+namespace systems
+{
+
+// Forward declarations.
+class WindShadowPrivate;
+
+/// \brief A plugin that models the wind shadow vessels cast on
+/// each other.
+///
+/// Every step each sail (a link with a WindShadowSource component,
+/// created by SailLiftDrag) inserts a wake cone, aligned with the wind
+/// at its centre of effort, into an asv::WindShadowGrid. Each entity
+/// with a WindShadowFactor component (sails and anemometers) then looks
+/// up the factor the wind is reduced by at its position, ignoring the
+/// cones of its own model. Systems that read the factor may run before
+/// this one in a step, so it may lag by one step.
+///
+/// # Parameters
+///
+/// 1. <cone_length> (double, default: 60)
+///   Length of the wake cone behind a sail.
+///
+/// 2. <cone_radius> (double, default: 1)
+///   Radius of the wake cone at the sail.
+///
+/// 3. <cone_half_angle> (double, default: 0.2)
+///   Half angle of the wake cone in radians, in [0, pi/2).
+///
+/// 4. <max_deficit> (double, default: 0.3)
+///   Fractional wind speed deficit on the cone axis at the sail.
+///
+/// 5. <cell_size> (double, default: 25)
+///   Size of the spatial hash grid cells.
+///
+class WindShadow
+    : public System,
+      public ISystemConfigure,
+      public ISystemPreUpdate
+{
+  /// \brief Destructor.
+  public: virtual ~WindShadow();
+
+  /// \brief Constructor.
+  public: WindShadow();
+
+  // Documentation inherited
+  public: void Configure(
+      const Entity &_entity,
+      const std::shared_ptr<const sdf::Element> &_sdf,
+      EntityComponentManager &_ecm,
+      EventManager &_eventMgr) final;
+
+  /// Documentation inherited
+  public: void PreUpdate(
+      const UpdateInfo &_info,
+      EntityComponentManager &_ecm) override;
+
+  /// \brief Private data pointer.
+  private: std::unique_ptr<WindShadowPrivate> dataPtr;
+};
+
+}  // namespace systems
+}
+}  // namespace sim
+}  // namespace gz
+
+#endif  // ASV_SIM_WINDSHADOW_HH_
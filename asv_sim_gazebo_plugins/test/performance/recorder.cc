@@ -0,0 +1,71 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "asv/sim/Recorder.hh"
+
+/////////////////////////////////////////////////
+/// \brief The cost on the simulation thread of recording lift drag
+/// samples, the largest record type the systems write.
+TEST(Recorder, SampleCost)
+{
+    asv::Recorder recorder(1 << 16);
+    uint32_t type = recorder.RegisterType("lift_drag",
+        {"alpha", "speed", "cl", "cd", "lift_x", "lift_y", "lift_z",
+         "drag_x", "drag_y", "drag_z", "wind_x", "wind_y", "wind_z"});
+    ASSERT_TRUE(recorder.Open(testing::TempDir() + "recorder_perf.asvr"));
+
+    // Batches of one ring at most, paced as a fleet stepping at 1 kHz
+    // would be, so the writer keeps up and nothing is dropped.
+    const size_t numBatches = 100;
+    const size_t batchSize = 10000;
+    double values[13] = {};
+    double elapsed = 0.0;
+    for (size_t b = 0; b < numBatches; ++b)
+    {
+      auto start = std::chrono::steady_clock::now();
+      for (size_t i = 0; i < batchSize; ++i)
+      {
+        values[0] = 0.001 * i;
+        recorder.Record(type, 0.001 * b, i % 500, values);
+      }
+      auto stop = std::chrono::steady_clock::now();
+      elapsed += std::chrono::duration<double>(stop - start).count();
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    recorder.Close();
+
+    double perSample = 1.0E9 * elapsed / (numBatches * batchSize);
+    std::cout << "samples:  " << numBatches * batchSize << "\n"
+              << "dropped:  " << recorder.DroppedCount() << "\n"
+              << "per sample [ns]: " << std::fixed << std::setprecision(1)
+              << perSample << "\n";
+    EXPECT_EQ(recorder.DroppedCount(), 0u);
+    EXPECT_LT(perSample, 1000.0);
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,81 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "asv/core/SailTrim.hh"
+
+/////////////////////////////////////////////////
+/// \brief A sail on a vertical mast with a number of strips.
+asv::core::BoatSurface MakeSail(size_t _strips)
+{
+  asv::core::BoatSurface sail;
+  sail.sail = true;
+  sail.params.area = 6.0;
+  sail.params.upward = asv::core::Vector3d(0.0, 1.0, 0.0);
+  sail.trimmable = true;
+  sail.trimMin = -1.5;
+  sail.trimMax = 1.5;
+  sail.windShearExponent = _strips > 1 ? 0.14 : 0.0;
+  for (size_t i = 0; i < _strips; ++i)
+  {
+    sail.panels.push_back({asv::core::Vector3d(-0.4, 0.0, 0.5 + i),
+        6.0 / _strips, asv::core::Quaterniond()});
+  }
+  return sail;
+}
+
+/////////////////////////////////////////////////
+TEST(SailTrim, Optimize)
+{
+  std::cout << std::setw(8) << "strips"
+            << std::setw(16) << "optimize [us]" << "\n";
+  for (size_t strips : {1, 4, 10})
+  {
+    asv::core::SailTrim trim(MakeSail(strips));
+    const size_t count = 2000;
+    double sum = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i)
+    {
+      double awa = 0.5 + 2.5 * i / count;
+      sum += trim.Optimize(5.0, awa).trim;
+    }
+    auto stop = std::chrono::steady_clock::now();
+    double t = std::chrono::duration<double>(stop - start).count() / count;
+    std::cout << std::setw(8) << strips
+              << std::setw(16) << std::fixed << std::setprecision(2)
+              << 1.0E6 * t << "\n";
+
+    // Keep the results from being optimised away, and fast enough for
+    // every control tick.
+    EXPECT_TRUE(std::isfinite(sum));
+    EXPECT_LT(t, 1.0E-3);
+  }
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,151 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+
+#include <gz/msgs/double.pb.h>
+#include <gz/msgs/vector3d.pb.h>
+
+#include <unistd.h>
+
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gz/transport/Node.hh>
+
+#include "asv/sim/TransportRegistry.hh"
+
+/////////////////////////////////////////////////
+/// \brief Resident memory of the process in MB.
+double resident_mb()
+{
+  std::ifstream statm("/proc/self/statm");
+  size_t size = 0, resident = 0;
+  statm >> size >> resident;
+  return resident * static_cast<double>(sysconf(_SC_PAGESIZE)) / 1.0E6;
+}
+
+/////////////////////////////////////////////////
+std::string boat_topic(size_t _boat, const std::string &_name)
+{
+  return "/model/boat" + std::to_string(_boat) + "/" + _name;
+}
+
+/////////////////////////////////////////////////
+/// \brief Each boat has a sail controller subscribing to its command,
+/// a lift drag system and an anemometer publishing, and all of them
+/// subscribe to the world wind, as the systems did with a node each.
+struct NodePerSystem
+{
+  explicit NodePerSystem(size_t _numBoats)
+  {
+    std::function<void(const gz::msgs::Double &)> onCmd =
+        [](const gz::msgs::Double &) {};
+    std::function<void(const gz::msgs::Vector3d &)> onWind =
+        [](const gz::msgs::Vector3d &) {};
+    for (size_t b = 0; b < _numBoats; ++b)
+    {
+      nodes.push_back(std::make_unique<gz::transport::Node>());
+      nodes.back()->Subscribe(boat_topic(b, "cmd_pos"), onCmd);
+      nodes.push_back(std::make_unique<gz::transport::Node>());
+      nodes.push_back(std::make_unique<gz::transport::Node>());
+      pubs.push_back(nodes.back()->Advertise<gz::msgs::Vector3d>(
+          boat_topic(b, "anemometer")));
+    }
+    nodes.push_back(std::make_unique<gz::transport::Node>());
+    nodes.back()->Subscribe("/world/fleet/wind", onWind);
+  }
+
+  std::vector<std::unique_ptr<gz::transport::Node>> nodes;
+  std::vector<gz::transport::Node::Publisher> pubs;
+};
+
+/////////////////////////////////////////////////
+/// \brief The same fleet through the shared registry.
+struct SharedRegistry
+{
+  explicit SharedRegistry(size_t _numBoats)
+  {
+    std::function<void(const gz::msgs::Double &)> onCmd =
+        [](const gz::msgs::Double &) {};
+    std::function<void(const gz::msgs::Vector3d &)> onWind =
+        [](const gz::msgs::Vector3d &) {};
+    for (size_t b = 0; b < _numBoats; ++b)
+    {
+      subs.push_back(asv::TransportRegistry::Subscribe(
+          boat_topic(b, "cmd_pos"), onCmd));
+      pubs.push_back(asv::TransportRegistry::Advertise<gz::msgs::Vector3d>(
+          boat_topic(b, "anemometer")));
+    }
+    subs.push_back(asv::TransportRegistry::Subscribe(
+        "/world/fleet/wind", onWind));
+  }
+
+  std::vector<asv::TransportRegistry::Subscription> subs;
+  std::vector<asv::TransportRegistry::Publisher> pubs;
+};
+
+/////////////////////////////////////////////////
+template <typename T>
+void measure(const std::string &_name, const std::string &_prefix,
+    size_t _numBoats)
+{
+  double mem0 = resident_mb();
+  auto start = std::chrono::steady_clock::now();
+  auto fleet = std::make_unique<T>(_numBoats);
+  auto stop = std::chrono::steady_clock::now();
+  double mem1 = resident_mb();
+  double startupMs =
+      1.0E3 * std::chrono::duration<double>(stop - start).count();
+
+  std::cout << std::setw(18) << _name
+            << std::setw(14) << std::fixed << std::setprecision(1)
+            << startupMs
+            << std::setw(14) << mem1 - mem0 << "\n";
+
+  // Also in the test XML, so the figures can be collected from ctest.
+  ::testing::Test::RecordProperty(_prefix + "_startup_ms",
+      std::to_string(startupMs));
+  ::testing::Test::RecordProperty(_prefix + "_rss_mb",
+      std::to_string(mem1 - mem0));
+}
+
+/////////////////////////////////////////////////
+TEST(TransportRegistry, FleetStartup)
+{
+    const size_t numBoats = 500;
+    std::cout << std::setw(18) << "transport"
+              << std::setw(14) << "startup [ms]"
+              << std::setw(14) << "rss [MB]" << "\n";
+
+    // The registry runs first so the node per system case does not
+    // benefit from memory released by it.
+    measure<SharedRegistry>("shared registry", "registry", numBoats);
+    EXPECT_FALSE(asv::TransportRegistry::HasNode());
+    measure<NodePerSystem>("node per system", "node_per_system", numBoats);
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
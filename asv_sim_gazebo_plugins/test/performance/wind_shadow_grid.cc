@@ -0,0 +1,108 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "asv/sim/WindShadowGrid.hh"
+
+/////////////////////////////////////////////////
+/// \brief Mean time in seconds to rebuild and query the wind shadow grid
+/// for a fleet of boats, each with a main and a jib, spread over a
+/// race area whose size grows with the fleet.
+double time_step(size_t _numBoats, size_t _numSteps)
+{
+  const size_t sailsPerBoat = 2;
+  const double spacing = 40.0;
+  const double side = spacing * std::sqrt(static_cast<double>(_numBoats));
+
+  std::mt19937 gen(1);
+  std::uniform_real_distribution<double> pos(0.0, side);
+  std::uniform_real_distribution<double> heading(-0.3, 0.3);
+
+  std::vector<gz::math::Vector3d> sailPos(_numBoats * sailsPerBoat);
+  for (size_t b = 0; b < _numBoats; ++b)
+  {
+    gz::math::Vector3d boat(pos(gen), pos(gen), 0.0);
+    sailPos[b * sailsPerBoat] = boat + gz::math::Vector3d(0.0, 0.0, 5.0);
+    sailPos[b * sailsPerBoat + 1] = boat + gz::math::Vector3d(3.0, 0.0, 4.0);
+  }
+
+  asv::WindShadowGrid grid(25.0, 4 * _numBoats * sailsPerBoat);
+  asv::WindShadowCone cone;
+  cone.length = 60.0;
+
+  double sum = 0.0;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t step = 0; step < _numSteps; ++step)
+  {
+    double windDir = heading(gen);
+    cone.direction = gz::math::Vector3d(
+        std::cos(windDir), std::sin(windDir), 0.0);
+
+    grid.Clear();
+    for (size_t s = 0; s < sailPos.size(); ++s)
+    {
+      cone.apex = sailPos[s];
+      cone.source = s / sailsPerBoat;
+      grid.Insert(cone);
+    }
+    for (size_t s = 0; s < sailPos.size(); ++s)
+    {
+      sum += grid.Factor(sailPos[s], s / sailsPerBoat);
+    }
+  }
+  auto stop = std::chrono::steady_clock::now();
+
+  // Keep the queries from being optimised away.
+  EXPECT_GT(sum, 0.0);
+  return std::chrono::duration<double>(stop - start).count() / _numSteps;
+}
+
+/////////////////////////////////////////////////
+TEST(WindShadowGrid, FleetScaling)
+{
+    const std::vector<size_t> fleets = {10, 30, 100, 300, 1000};
+    std::vector<double> perBoat;
+
+    std::cout << std::setw(8) << "boats"
+              << std::setw(16) << "step [us]"
+              << std::setw(16) << "per boat [us]" << "\n";
+    for (auto n : fleets)
+    {
+      double t = time_step(n, 20000 / n + 20);
+      perBoat.push_back(t / n);
+      std::cout << std::setw(8) << n
+                << std::setw(16) << std::fixed << std::setprecision(2)
+                << 1.0E6 * t
+                << std::setw(16) << 1.0E6 * t / n << "\n";
+    }
+
+    // Near linear: the cost per boat grows much less than the fleet.
+    EXPECT_LT(perBoat.back(), 10.0 * perBoat[2]);
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,108 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ASV_SIM_TOOLS_COMMANDLINE_HH_
+#define ASV_SIM_TOOLS_COMMANDLINE_HH_
+
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "asv/core/Vector3.hh"
+
+namespace asv
+{
+namespace tools
+{
+/////////////////////////////////////////////////
+/// \brief Parse a comma separated list of numbers.
+inline bool ParseList(const std::string &_text,
+    std::vector<double> &_values)
+{
+  _values.clear();
+  std::istringstream in(_text);
+  std::string item;
+  while (std::getline(in, item, ','))
+  {
+    char *end = nullptr;
+    double value = std::strtod(item.c_str(), &end);
+    if (item.empty() || *end != '\0')
+      return false;
+    _values.push_back(value);
+  }
+  return !_values.empty();
+}
+
+/////////////////////////////////////////////////
+/// \brief Parse a comma separated list of positive counts.
+inline bool ParseCounts(const std::string &_text,
+    std::vector<size_t> &_counts)
+{
+  _counts.clear();
+  std::istringstream in(_text);
+  std::string item;
+  while (std::getline(in, item, ','))
+  {
+    char *end = nullptr;
+    unsigned long n = std::strtoul(item.c_str(), &end, 10);
+    if (item.empty() || *end != '\0' || n == 0)
+      return false;
+    _counts.push_back(n);
+  }
+  return !_counts.empty();
+}
+
+/////////////////////////////////////////////////
+/// \brief Parse a list of numbers or a range first:last:step.
+inline bool ParseRange(const std::string &_text,
+    std::vector<double> &_values)
+{
+  if (_text.find(':') == std::string::npos)
+    return ParseList(_text, _values);
+
+  std::vector<double> range;
+  std::string text = _text;
+  for (auto &c : text)
+    c = c == ':' ? ',' : c;
+  if (!ParseList(text, range) || range.size() != 3 || range[2] <= 0.0 ||
+      range[1] < range[0])
+  {
+    return false;
+  }
+  _values.clear();
+  for (double v = range[0]; v <= range[1] + 1.0e-9 * range[2];
+      v += range[2])
+  {
+    _values.push_back(v);
+  }
+  return true;
+}
+
+/////////////////////////////////////////////////
+/// \brief Parse a vector x,y,z.
+inline bool ParseVector(const std::string &_text, core::Vector3d &_v)
+{
+  std::vector<double> values;
+  if (!ParseList(_text, values) || values.size() != 3)
+    return false;
+  _v = core::Vector3d(values[0], values[1], values[2]);
+  return true;
+}
+
+}  // namespace tools
+}  // namespace asv
+
+#endif  // ASV_SIM_TOOLS_COMMANDLINE_HH_
@@ -0,0 +1,228 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+/// \file fast_sim.cc
+/// \brief Run a Monte Carlo study of a boat in gusty wind with the
+/// fast-time simulator asv::core::FastSim.
+///
+/// Usage:
+///
+///   asv_sim_fast_sim <model.sdf> [--model name] [--boats 100]
+///       [--duration 60] [--step-size 0.005] [--seed n] [--threads n]
+///       [--wind x,y,z] [--gust m/s] [--shift deg] [--gust-time s]
+///       [--metacentric-height m] [--waterplane-area a]
+///       [--hull-drag x,y,z] [--hull-linear-drag x,y,z]
+///       [--angular-drag x,y,z] [--output file]
+///
+/// The boat is loaded with asv::LoadBoat from the first model in the
+/// file, or the model given by --model, so the sails, foils, moorings
+/// and sail controllers have the parameters of their plugins. The hull
+/// resistance, angular damping, waterplane area and metacentric height
+/// are not part of the model and are given on the command line; without
+/// damping the hull oscillates in heave, roll and pitch.
+///
+/// Each boat starts at rest at the model pose and sees the mean wind
+/// (m/s, the direction it blows towards) with gusts and wind shifts of
+/// the given standard deviations and time constant. The boats are
+/// stepped on a thread pool, one per core unless --threads is given,
+/// and the results depend only on the seed.
+///
+/// The output is comma separated, one line per boat: the final
+/// position, heading (degrees) and speed, and the mean speed and
+/// largest heel (degrees) over the run.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sdf/sdf.hh>
+
+#include "asv/core/FastSim.hh"
+#include "asv/sim/BoatModel.hh"
+
+#include "CommandLine.hh"
+
+namespace
+{
+/////////////////////////////////////////////////
+double Degrees(double _radians)
+{
+  return _radians * 180.0 / M_PI;
+}
+}  // namespace
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  std::string input;
+  std::string modelName;
+  std::string outputPath;
+  size_t boats = 100;
+  double duration = 60.0;
+  asv::core::FastSimOptions options;
+  options.wind = asv::core::Vector3d(0.0, -5.0, 0.0);
+  asv::core::Vector3d hullDrag;
+  asv::core::Vector3d hullLinearDrag;
+  asv::core::Vector3d angularDrag;
+  double metacentricHeight = -1.0;
+  double waterplaneArea = -1.0;
+
+  bool usage = argc < 2;
+  for (int i = 1; i < argc && !usage; ++i)
+  {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--model" && hasValue)
+      modelName = argv[++i];
+    else if (arg == "--boats" && hasValue)
+      boats = std::strtoul(argv[++i], nullptr, 10);
+    else if (arg == "--duration" && hasValue)
+      duration = std::strtod(argv[++i], nullptr);
+    else if (arg == "--step-size" && hasValue)
+      options.stepSize = std::strtod(argv[++i], nullptr);
+    else if (arg == "--seed" && hasValue)
+      options.seed = std::strtoull(argv[++i], nullptr, 10);
+    else if (arg == "--threads" && hasValue)
+      options.threads = std::strtoul(argv[++i], nullptr, 10);
+    else if (arg == "--wind" && hasValue)
+      usage = !asv::tools::ParseVector(argv[++i], options.wind);
+    else if (arg == "--gust" && hasValue)
+      options.gustIntensity = std::strtod(argv[++i], nullptr);
+    else if (arg == "--shift" && hasValue)
+    {
+      options.directionDeviation =
+          std::strtod(argv[++i], nullptr) * M_PI / 180.0;
+    }
+    else if (arg == "--gust-time" && hasValue)
+      options.gustTimeConstant = std::strtod(argv[++i], nullptr);
+    else if (arg == "--metacentric-height" && hasValue)
+      metacentricHeight = std::strtod(argv[++i], nullptr);
+    else if (arg == "--waterplane-area" && hasValue)
+      waterplaneArea = std::strtod(argv[++i], nullptr);
+    else if (arg == "--hull-drag" && hasValue)
+      usage = !asv::tools::ParseVector(argv[++i], hullDrag);
+    else if (arg == "--hull-linear-drag" && hasValue)
+      usage = !asv::tools::ParseVector(argv[++i], hullLinearDrag);
+    else if (arg == "--angular-drag" && hasValue)
+      usage = !asv::tools::ParseVector(argv[++i], angularDrag);
+    else if (arg == "--output" && hasValue)
+      outputPath = argv[++i];
+    else if (input.empty() && arg.compare(0, 2, "--") != 0)
+      input = arg;
+    else
+      usage = true;
+  }
+  if (usage || input.empty() || boats == 0 || options.stepSize <= 0.0)
+  {
+    std::cerr << "Usage: " << argv[0]
+              << " <model.sdf> [--model name] [--boats 100]"
+              << " [--duration 60] [--step-size 0.005] [--seed n]"
+              << " [--threads n] [--wind x,y,z] [--gust m/s]"
+              << " [--shift deg] [--gust-time s]"
+              << " [--metacentric-height m] [--waterplane-area a]"
+              << " [--hull-drag x,y,z] [--hull-linear-drag x,y,z]"
+              << " [--angular-drag x,y,z] [--output file]\n";
+    return EXIT_FAILURE;
+  }
+
+  sdf::SDFPtr sdfParsed(new sdf::SDF());
+  sdf::init(sdfParsed);
+  if (!sdf::readFile(input, sdfParsed))
+  {
+    std::cerr << "Failed to read [" << input << "]\n";
+    return EXIT_FAILURE;
+  }
+  auto model = asv::FindModel(sdfParsed->Root(), modelName);
+  if (!model)
+  {
+    std::cerr << "No <model> " << (modelName.empty() ? "" :
+        "[" + modelName + "] ") << "in [" << input << "]\n";
+    return EXIT_FAILURE;
+  }
+
+  asv::core::Boat boat;
+  if (!asv::LoadBoat(model, boat))
+    return EXIT_FAILURE;
+  boat.hull.quadraticDrag = hullDrag;
+  boat.hull.linearDrag = hullLinearDrag;
+  boat.hull.angularLinearDrag = angularDrag;
+  if (metacentricHeight >= 0.0)
+    boat.hull.metacentricHeight = metacentricHeight;
+  if (waterplaneArea > 0.0)
+    boat.hull.waterplaneArea = waterplaneArea;
+
+  // Statistics of each boat, each written only by the thread that
+  // steps the boat.
+  std::vector<double> speedSum(boats, 0.0);
+  std::vector<double> maxHeel(boats, 0.0);
+  auto record = [&](asv::core::FastSim &_sim, size_t _boat, double)
+  {
+    auto velocity = _sim.LinearVelocity(_boat);
+    speedSum[_boat] += std::sqrt(velocity.x * velocity.x +
+        velocity.y * velocity.y);
+    auto up = _sim.Rotation(_boat).RotateVector(
+        asv::core::Vector3d(0.0, 0.0, 1.0));
+    maxHeel[_boat] = std::max(maxHeel[_boat],
+        std::acos(std::clamp(up.z, -1.0, 1.0)));
+  };
+
+  size_t steps = static_cast<size_t>(std::ceil(duration / options.stepSize));
+  auto t0 = std::chrono::steady_clock::now();
+  asv::core::FastSim sim(boat, boats, options);
+  sim.Step(steps, record);
+  auto t1 = std::chrono::steady_clock::now();
+  double elapsed = std::chrono::duration<double>(t1 - t0).count();
+  std::cerr << "Simulated [" << boats << "] boats for [" << sim.Time()
+            << "] s in " << elapsed << " s, "
+            << boats * sim.Time() / std::max(elapsed, 1.0e-9)
+            << " x real time\n";
+
+  std::ofstream file;
+  if (!outputPath.empty())
+  {
+    file.open(outputPath);
+    if (!file)
+    {
+      std::cerr << "Failed to open [" << outputPath << "]\n";
+      return EXIT_FAILURE;
+    }
+  }
+  std::ostream &out = file.is_open() ? file : std::cout;
+  out << std::fixed << std::setprecision(4);
+
+  out << "boat,x,y,z,heading,speed,mean_speed,max_heel\n";
+  for (size_t b = 0; b < boats; ++b)
+  {
+    auto position = sim.Position(b);
+    auto forward = sim.Rotation(b).RotateVector(
+        asv::core::Vector3d(1.0, 0.0, 0.0));
+    auto velocity = sim.LinearVelocity(b);
+    out << b << "," << position.x << "," << position.y << ","
+        << position.z << "," << Degrees(std::atan2(forward.y, forward.x))
+        << "," << std::sqrt(velocity.x * velocity.x +
+            velocity.y * velocity.y)
+        << "," << speedSum[b] / std::max<size_t>(steps, 1) << ","
+        << Degrees(maxHeel[b]) << "\n";
+  }
+  return EXIT_SUCCESS;
+}
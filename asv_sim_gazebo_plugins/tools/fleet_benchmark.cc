@@ -0,0 +1,407 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+/// \file fleet_benchmark.cc
+/// \brief Measure how the asv_sim systems scale with the number of
+/// vessels.
+///
+/// Usage:
+///
+///   asv_sim_fleet_benchmark [--boats 1,10,100] [--steps 1000]
+///       [--warmup 100] [--csv file] [--world-dir dir]
+///       [--no-sails] [--no-controllers] [--no-foils]
+///       [--no-anemometers] [--no-moorings] [--max-allocations n]
+///
+/// For each boat count a world is generated with asv::GenerateFleetWorld
+/// and run headless in an embedded gz::sim::Server: first the warm-up
+/// steps, then the timed steps. Reported for each run:
+///
+/// - setup_s: wall clock time to load the world and warm up.
+/// - wall_s and rtf: wall clock time and real time factor of the timed
+///   steps.
+/// - rss_mb and peak_rss_mb: resident and peak resident memory after the
+///   run. Each boat count runs in a child process of its own, so these
+///   are the memory of that world alone.
+/// - <system>.<phase>_us: mean time per step spent in each asv_sim
+///   system phase, summed over its instances, from asv::Metrics.
+/// - <system>.<phase>_allocs: mean heap allocations per step in each
+///   phase. The benchmark replaces the global operator new to count
+///   them, which includes the systems loaded as plugins.
+///
+/// With --max-allocations the benchmark fails if any phase allocates
+/// more than n times per step once warmed up. The systems do not
+/// allocate in the steady state, except when publishing through
+/// gz-transport, as the anemometer does at its update rate. So
+/// --max-allocations 0 --no-anemometers is a strict check. It runs
+/// for two boats as the INTEGRATION_fleet_benchmark_allocations test.
+///
+/// The systems are loaded from GZ_SIM_SYSTEM_PLUGIN_PATH, which is
+/// extended with the build tree when run from there.
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gz/sim/Server.hh>
+#include <gz/sim/ServerConfig.hh>
+
+#include "asv/sim/FleetWorld.hh"
+#include "asv/sim/Metrics.hh"
+
+#include "CommandLine.hh"
+
+/////////////////////////////////////////////////
+void *operator new(std::size_t _size)
+{
+  asv::Metrics::CountAllocation();
+  if (void *ptr = std::malloc(_size > 0 ? _size : 1))
+    return ptr;
+  throw std::bad_alloc();
+}
+
+/////////////////////////////////////////////////
+void *operator new[](std::size_t _size)
+{
+  return ::operator new(_size);
+}
+
+/////////////////////////////////////////////////
+void *operator new(std::size_t _size, const std::nothrow_t &) noexcept
+{
+  asv::Metrics::CountAllocation();
+  return std::malloc(_size > 0 ? _size : 1);
+}
+
+/////////////////////////////////////////////////
+void *operator new[](std::size_t _size, const std::nothrow_t &_tag) noexcept
+{
+  return ::operator new(_size, _tag);
+}
+
+/////////////////////////////////////////////////
+void operator delete(void *_ptr) noexcept
+{
+  std::free(_ptr);
+}
+
+/////////////////////////////////////////////////
+void operator delete[](void *_ptr) noexcept
+{
+  std::free(_ptr);
+}
+
+/////////////////////////////////////////////////
+void operator delete(void *_ptr, std::size_t) noexcept
+{
+  std::free(_ptr);
+}
+
+/////////////////////////////////////////////////
+void operator delete[](void *_ptr, std::size_t) noexcept
+{
+  std::free(_ptr);
+}
+
+namespace
+{
+/////////////////////////////////////////////////
+/// \brief A value in MB from /proc/self/status, or 0.
+double StatusMb(const std::string &_key)
+{
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line))
+  {
+    if (line.compare(0, _key.size(), _key) == 0)
+    {
+      std::istringstream in(line.substr(_key.size() + 1));
+      double kb = 0.0;
+      in >> kb;
+      return kb / 1024.0;
+    }
+  }
+  return 0.0;
+}
+
+/////////////////////////////////////////////////
+/// \brief The results of one run.
+struct Result
+{
+  size_t boats = 0;
+  double setup = 0.0;
+  double wall = 0.0;
+  double rtf = 0.0;
+  double rss = 0.0;
+  double peakRss = 0.0;
+
+  /// \brief Mean microseconds per step for each system phase.
+  std::map<std::string, double> phases;
+
+  /// \brief Mean allocations per step for each system phase.
+  std::map<std::string, double> allocations;
+};
+
+/////////////////////////////////////////////////
+/// \brief Run one fleet world and report it.
+/// \param[in] _options The fleet.
+/// \param[in] _sdf The world.
+/// \param[in] _steps The number of timed steps.
+/// \param[in] _warmup The number of warm-up steps.
+/// \param[in] _maxAllocations The allocation limit per step, or negative.
+/// \param[in] _header True if the CSV header has been written.
+/// \param[in] _csv The CSV file, if open.
+/// \return EXIT_SUCCESS, or EXIT_FAILURE if the run failed or allocated
+/// more than the limit.
+int RunFleet(const asv::FleetWorldOptions &_options, const std::string &_sdf,
+    uint64_t _steps, uint64_t _warmup, double _maxAllocations, bool _header,
+    std::ofstream &_csv)
+{
+  Result result;
+  result.boats = _options.boats;
+
+  auto t0 = std::chrono::steady_clock::now();
+  gz::sim::ServerConfig config;
+  config.SetSdfString(_sdf);
+  gz::sim::Server server(config);
+  if (_warmup > 0 && !server.Run(true, _warmup, false))
+  {
+    std::cerr << "Failed to run the world with [" << _options.boats
+              << "] boats\n";
+    return EXIT_FAILURE;
+  }
+
+  asv::Metrics::Instance().Reset();
+  auto t1 = std::chrono::steady_clock::now();
+  if (!server.Run(true, _steps, false))
+  {
+    std::cerr << "Failed to run the world with [" << _options.boats
+              << "] boats\n";
+    return EXIT_FAILURE;
+  }
+  auto t2 = std::chrono::steady_clock::now();
+
+  result.setup = std::chrono::duration<double>(t1 - t0).count();
+  result.wall = std::chrono::duration<double>(t2 - t1).count();
+  result.rtf = static_cast<double>(_steps) * _options.stepSize /
+      result.wall;
+  result.rss = StatusMb("VmRSS");
+  result.peakRss = StatusMb("VmHWM");
+  asv::Metrics::Instance().ForEach(
+      [&](const std::string &_system, const std::string &_name,
+          uint64_t _entity, const asv::Metric &_metric)
+      {
+        if (_metric.MetricKind() != asv::Metric::Kind::kLatency ||
+            _entity != asv::Metrics::kNoEntity)
+        {
+          return;
+        }
+        result.phases[_system + "." + _name + "_us"] =
+            1.0e-3 * static_cast<double>(_metric.Sum()) /
+            static_cast<double>(_steps);
+        result.allocations[_system + "." + _name + "_allocs"] =
+            static_cast<double>(_metric.Allocations()) /
+            static_cast<double>(_steps);
+      });
+
+  std::cout << std::setw(5) << result.boats
+            << std::setw(11) << result.setup
+            << std::setw(10) << result.wall
+            << std::setw(12) << result.rtf
+            << std::setw(10) << result.rss
+            << std::setw(13) << result.peakRss << "\n";
+  for (const auto &[phase, us] : result.phases)
+    std::cout << "      " << phase << ": " << us << "\n";
+  for (const auto &[phase, allocs] : result.allocations)
+    std::cout << "      " << phase << ": " << allocs << "\n";
+
+  if (_csv.is_open())
+  {
+    if (!_header)
+    {
+      _csv << "boats,steps,setup_s,wall_s,rtf,rss_mb,peak_rss_mb";
+      for (const auto &phase : result.phases)
+        _csv << "," << phase.first;
+      for (const auto &phase : result.allocations)
+        _csv << "," << phase.first;
+      _csv << "\n";
+    }
+    _csv << result.boats << "," << _steps << "," << result.setup << ","
+        << result.wall << "," << result.rtf << "," << result.rss << ","
+        << result.peakRss;
+    for (const auto &phase : result.phases)
+      _csv << "," << phase.second;
+    for (const auto &phase : result.allocations)
+      _csv << "," << phase.second;
+    _csv << "\n" << std::flush;
+  }
+
+  if (_maxAllocations >= 0.0)
+  {
+    bool failed = false;
+    for (const auto &[phase, allocs] : result.allocations)
+    {
+      if (allocs > _maxAllocations)
+      {
+        std::cerr << "[" << phase << "] allocates " << allocs
+                  << " times per step with [" << _options.boats
+                  << "] boats, more than the limit of " << _maxAllocations
+                  << "\n";
+        failed = true;
+      }
+    }
+    if (failed)
+      return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+}  // namespace
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  std::vector<size_t> boats{1, 2, 5, 10, 20, 50, 100, 200, 500, 1000};
+  uint64_t steps = 1000;
+  uint64_t warmup = 100;
+  std::string csvPath;
+  std::string worldDir;
+  double maxAllocations = -1.0;
+  asv::FleetWorldOptions options;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--boats" && hasValue &&
+        asv::tools::ParseCounts(argv[i + 1], boats))
+    {
+      ++i;
+    }
+    else if (arg == "--steps" && hasValue)
+      steps = std::strtoull(argv[++i], nullptr, 10);
+    else if (arg == "--warmup" && hasValue)
+      warmup = std::strtoull(argv[++i], nullptr, 10);
+    else if (arg == "--csv" && hasValue)
+      csvPath = argv[++i];
+    else if (arg == "--world-dir" && hasValue)
+      worldDir = argv[++i];
+    else if (arg == "--no-sails")
+      options.sails = false;
+    else if (arg == "--no-controllers")
+      options.controllers = false;
+    else if (arg == "--no-foils")
+      options.foils = false;
+    else if (arg == "--no-anemometers")
+      options.anemometers = false;
+    else if (arg == "--no-moorings")
+      options.moorings = false;
+    else if (arg == "--max-allocations" && hasValue)
+      maxAllocations = std::strtod(argv[++i], nullptr);
+    else
+    {
+      std::cerr << "Usage: " << argv[0]
+                << " [--boats 1,10,100] [--steps 1000] [--warmup 100]"
+                << " [--csv file] [--world-dir dir] [--no-sails]"
+                << " [--no-controllers] [--no-foils] [--no-anemometers]"
+                << " [--no-moorings] [--max-allocations n]\n";
+      return EXIT_FAILURE;
+    }
+  }
+  if (steps == 0)
+  {
+    std::cerr << "--steps must be positive\n";
+    return EXIT_FAILURE;
+  }
+
+#ifdef ASV_SIM_PLUGIN_DIR
+  {
+    const char *env = std::getenv("GZ_SIM_SYSTEM_PLUGIN_PATH");
+    std::string path = ASV_SIM_PLUGIN_DIR;
+    if (env && *env)
+      path += std::string(":") + env;
+    setenv("GZ_SIM_SYSTEM_PLUGIN_PATH", path.c_str(), 1);
+  }
+#endif
+
+  std::ofstream csv;
+  if (!csvPath.empty())
+  {
+    csv.open(csvPath);
+    if (!csv)
+    {
+      std::cerr << "Failed to open [" << csvPath << "]\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::cout << std::fixed << std::setprecision(3);
+  std::cout << "boats    setup_s    wall_s         rtf    rss_mb"
+            << "  peak_rss_mb\n";
+
+  bool header = false;
+  for (size_t n : boats)
+  {
+    options.boats = n;
+    options.name = "fleet" + std::to_string(n);
+    std::string sdf = asv::GenerateFleetWorld(options);
+    if (!worldDir.empty())
+    {
+      std::ofstream(worldDir + "/" + options.name + ".sdf") << sdf;
+    }
+
+    // Each boat count runs in its own process, so that its memory use
+    // is not mixed with what is left of the earlier worlds.
+    std::cout << std::flush;
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+      std::cerr << "Failed to fork: " << std::strerror(errno) << "\n";
+      return EXIT_FAILURE;
+    }
+    if (pid == 0)
+    {
+      int code = RunFleet(options, sdf, steps, warmup, maxAllocations,
+          header, csv);
+      std::cout << std::flush;
+      std::cerr << std::flush;
+      if (csv.is_open())
+        csv.flush();
+      _exit(code);
+    }
+
+    int status = 0;
+    if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status))
+    {
+      std::cerr << "The run with [" << n << "] boats did not finish\n";
+      return EXIT_FAILURE;
+    }
+    if (WEXITSTATUS(status) != EXIT_SUCCESS)
+      return EXIT_FAILURE;
+    header = true;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,113 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/// \file flight_decode.cc
+/// \brief Decode an asv::FlightRecorder file.
+///
+/// Usage:
+///
+///   asv_sim_flight_decode <file.ring> [seconds] [--csv]
+///
+/// Prints the records in the order they were written, optionally only
+/// those in the last <seconds> of simulation time before the freeze (or
+/// the last record if the recorder was not frozen). With --csv each
+/// record is one comma separated line: time, type, entity and values.
+
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "asv/sim/FlightRecorder.hh"
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  std::vector<std::string> args;
+  bool csv = false;
+  for (int i = 1; i < argc; ++i)
+  {
+    if (std::strcmp(argv[i], "--csv") == 0)
+      csv = true;
+    else
+      args.push_back(argv[i]);
+  }
+  // Window of simulation time to print.
+  double window = -1.0;
+  if (args.size() == 2)
+  {
+    char *end = nullptr;
+    window = std::strtod(args[1].c_str(), &end);
+    if (args[1].empty() || *end != '\0' || !(window >= 0.0))
+      args.clear();
+  }
+  if (args.empty() || args.size() > 2)
+  {
+    std::cerr << "Usage: " << argv[0]
+              << " <file.ring> [seconds] [--csv]\n";
+    return EXIT_FAILURE;
+  }
+
+  asv::FlightLog log;
+  if (!asv::FlightRecorder::Read(args[0], log))
+    return EXIT_FAILURE;
+
+  double end = log.frozen ? log.frozenTime :
+      (log.records.empty() ? 0.0 : log.records.back().time);
+  double start = window >= 0.0 ? end - window : -1.0E300;
+
+  std::cout << std::setprecision(9);
+  if (!csv)
+  {
+    std::cout << "# slots: " << log.numSlots
+              << ", records: " << log.records.size() << "\n";
+    if (log.frozen)
+    {
+      std::cout << "# frozen at t=" << log.frozenTime << ": "
+                << log.reason << "\n";
+    }
+  }
+
+  for (const auto &record : log.records)
+  {
+    if (record.time < start)
+      continue;
+
+    auto fields = asv::FlightRecorder::FieldNames(record.type);
+    if (csv)
+    {
+      std::cout << record.time << ","
+                << asv::FlightRecorder::TypeName(record.type) << ","
+                << record.entity;
+      for (size_t i = 0; i < record.count; ++i)
+        std::cout << "," << record.values[i];
+      std::cout << "\n";
+      continue;
+    }
+
+    std::cout << "t=" << record.time << " "
+              << asv::FlightRecorder::TypeName(record.type)
+              << " entity=" << record.entity;
+    for (size_t i = 0; i < record.count; ++i)
+    {
+      std::cout << " " << (i < fields.size() ? fields[i] :
+          "v" + std::to_string(i)) << "=" << record.values[i];
+    }
+    std::cout << "\n";
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,232 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+/// \file lift_drag_calibration.cc
+/// \brief Fit the lift and drag parameters of a sail to logged data with
+/// asv::core::LiftDragCalibration.
+///
+/// Usage:
+///
+///   asv_sim_lift_drag_calibration <model.sdf> <log.csv> [--model name]
+///       [--sail link] [--mass kg] [--fix names] [--iterations 50]
+///       [--tolerance 1e-8] [--chunk 65536] [--threads n]
+///       [--output file]
+///
+/// The sail is loaded with asv::LoadBoat from the first model in the
+/// file, or the model given by --model, and is the first sail or the
+/// one on the link given by --sail. Its SailLiftDrag parameters are the
+/// initial values of the fit, and the mass is that of the model unless
+/// it is given by --mass.
+///
+/// The log is a comma separated file with a header that names the
+/// columns aws, awa, heel, trim, ax and ay, as described by
+/// asv::core::CalibrationSample, in any order and with any other
+/// columns. Angles are in radians. The log is streamed once per
+/// iteration, so it may be larger than the memory.
+///
+/// The parameters a0, cla, alpha_stall, cla_stall and cda are fitted,
+/// except those in the comma separated list given by --fix. The output
+/// is comma separated, one line per parameter: its name, the initial
+/// and fitted values and the standard error. A summary of the fit is
+/// written to the standard error.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include <sdf/sdf.hh>
+
+#include "asv/core/LiftDragCalibration.hh"
+#include "asv/sim/BoatModel.hh"
+
+namespace
+{
+/////////////////////////////////////////////////
+/// \brief Parse a comma separated list of parameter names to fix.
+bool ParseFixed(const std::string &_text, std::array<bool, 5> &_fit)
+{
+  using asv::core::LiftDragCalibration;
+  std::istringstream in(_text);
+  std::string item;
+  while (std::getline(in, item, ','))
+  {
+    bool found = false;
+    for (size_t j = 0; j < LiftDragCalibration::kParamNames.size(); ++j)
+    {
+      if (item == LiftDragCalibration::kParamNames[j])
+      {
+        _fit[j] = false;
+        found = true;
+      }
+    }
+    if (!found)
+      return false;
+  }
+  return true;
+}
+}  // namespace
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  using asv::core::LiftDragCalibration;
+
+  std::string input;
+  std::string logPath;
+  std::string modelName;
+  std::string sailName;
+  std::string outputPath;
+  double mass = 0.0;
+  asv::core::LiftDragCalibrationOptions options;
+
+  bool usage = argc < 3;
+  for (int i = 1; i < argc && !usage; ++i)
+  {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--model" && hasValue)
+      modelName = argv[++i];
+    else if (arg == "--sail" && hasValue)
+      sailName = argv[++i];
+    else if (arg == "--mass" && hasValue)
+      mass = std::strtod(argv[++i], nullptr);
+    else if (arg == "--fix" && hasValue)
+      usage = !ParseFixed(argv[++i], options.fit);
+    else if (arg == "--iterations" && hasValue)
+      options.maxIterations = std::strtoul(argv[++i], nullptr, 10);
+    else if (arg == "--tolerance" && hasValue)
+      options.tolerance = std::strtod(argv[++i], nullptr);
+    else if (arg == "--chunk" && hasValue)
+      options.chunkSize = std::strtoul(argv[++i], nullptr, 10);
+    else if (arg == "--threads" && hasValue)
+      options.threads = std::strtoul(argv[++i], nullptr, 10);
+    else if (arg == "--output" && hasValue)
+      outputPath = argv[++i];
+    else if (input.empty() && arg.compare(0, 2, "--") != 0)
+      input = arg;
+    else if (logPath.empty() && arg.compare(0, 2, "--") != 0)
+      logPath = arg;
+    else
+      usage = true;
+  }
+  if (usage || input.empty() || logPath.empty())
+  {
+    std::cerr << "Usage: " << argv[0]
+              << " <model.sdf> <log.csv> [--model name] [--sail link]"
+              << " [--mass kg] [--fix names] [--iterations 50]"
+              << " [--tolerance 1e-8] [--chunk 65536] [--threads n]"
+              << " [--output file]\n";
+    return EXIT_FAILURE;
+  }
+
+  sdf::SDFPtr sdfParsed(new sdf::SDF());
+  sdf::init(sdfParsed);
+  if (!sdf::readFile(input, sdfParsed))
+  {
+    std::cerr << "Failed to read [" << input << "]\n";
+    return EXIT_FAILURE;
+  }
+  auto model = asv::FindModel(sdfParsed->Root(), modelName);
+  if (!model)
+  {
+    std::cerr << "No <model> " << (modelName.empty() ? "" :
+        "[" + modelName + "] ") << "in [" << input << "]\n";
+    return EXIT_FAILURE;
+  }
+
+  asv::core::Boat boat;
+  if (!asv::LoadBoat(model, boat))
+    return EXIT_FAILURE;
+  const asv::core::BoatSurface *sail = nullptr;
+  for (const auto &surface : boat.surfaces)
+  {
+    if (surface.sail && !sail &&
+        (sailName.empty() || surface.name == sailName))
+    {
+      sail = &surface;
+    }
+  }
+  if (!sail)
+  {
+    std::cerr << "No sail " << (sailName.empty() ? "" :
+        "[" + sailName + "] ") << "in [" << input << "]\n";
+    return EXIT_FAILURE;
+  }
+  if (mass <= 0.0)
+    mass = boat.hull.mass;
+  if (mass <= 0.0)
+  {
+    std::cerr << "The mass of [" << input << "] is not positive, set it"
+              << " with --mass\n";
+    return EXIT_FAILURE;
+  }
+
+  asv::core::CsvCalibrationSource source(options.threads);
+  if (!source.Open(logPath))
+  {
+    std::cerr << "Failed to read [" << logPath << "], which needs the"
+              << " columns aws, awa, heel, trim, ax and ay\n";
+    return EXIT_FAILURE;
+  }
+
+  LiftDragCalibration calibration(*sail, mass, options);
+  auto t0 = std::chrono::steady_clock::now();
+  auto result = calibration.Calibrate(source, sail->params);
+  auto t1 = std::chrono::steady_clock::now();
+  double elapsed = std::chrono::duration<double>(t1 - t0).count();
+  if (result.samples == 0)
+  {
+    std::cerr << "No samples in [" << logPath << "]\n";
+    return EXIT_FAILURE;
+  }
+  double evaluations = static_cast<double>(result.samples) *
+      result.passes;
+  std::cerr << "Fitted [" << sail->name << "] to [" << result.samples
+            << "] samples (" << source.Skipped() << " skipped) in ["
+            << result.iterations << "] iterations, [" << result.passes
+            << "] passes, " << elapsed << " s, "
+            << evaluations / std::max(elapsed, 1.0e-9) << " samples/s\n"
+            << "rms " << result.rms << " N, r2 " << result.r2
+            << (result.converged ? "" : ", not converged") << "\n";
+
+  std::ofstream file;
+  if (!outputPath.empty())
+  {
+    file.open(outputPath);
+    if (!file)
+    {
+      std::cerr << "Failed to open [" << outputPath << "]\n";
+      return EXIT_FAILURE;
+    }
+  }
+  std::ostream &out = file.is_open() ? file : std::cout;
+  out << std::setprecision(8);
+  out << "name,initial,value,stddev\n";
+  for (size_t j = 0; j < LiftDragCalibration::kParamNames.size(); ++j)
+  {
+    out << LiftDragCalibration::kParamNames[j] << ","
+        << LiftDragCalibration::Param(sail->params, j) << ","
+        << LiftDragCalibration::Param(result.params, j) << ","
+        << result.stddev[j] << "\n";
+  }
+  return result.converged ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,294 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+/// \file lift_drag_sweep.cc
+/// \brief Sweep the lift and drag parameters of a sail and report the
+/// sensitivity of its forces and the fit of each combination, with
+/// asv::core::LiftDragSweep.
+///
+/// Usage:
+///
+///   asv_sim_lift_drag_sweep <model.sdf> [--model name] [--sail link]
+///       [--trim deg] [--aws 2,4,6,8,10] [--awa -180:180:5]
+///       [--reference file] [--cla values] [--alpha-stall values]
+///       [--cla-stall values] [--cda values] [--area values]
+///       [--best 10] [--threads n] [--output file]
+///
+/// The sail is loaded with asv::LoadBoat from the first model in the
+/// file, or the model given by --model, and is the first sail or the
+/// one on the link given by --sail. Its SailLiftDrag parameters are the
+/// base of the sweep and it is held at the --trim angle.
+///
+/// The forces are evaluated at every combination of apparent wind speed
+/// (m/s) and angle (degrees), or at the points of the --reference file,
+/// a comma separated file of aws, awa (degrees), drive and side force
+/// per line. Without a reference file the fits are to the forces with
+/// the base parameters. Parameter values are a list or a range
+/// first:last:step, in the units of the SDF; a parameter with no values
+/// keeps its base value.
+///
+/// The output is comma separated, in two sections. The first is the
+/// sensitivity at each point: the change in the drive and side force
+/// coefficients for a relative change in each parameter, about the base
+/// parameters. The second is the best fits, least error first: the root
+/// mean square force error, the coefficient of determination and the
+/// parameters. The number of evaluations per second is written to the
+/// standard error.
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sdf/sdf.hh>
+
+#include "asv/core/LiftDragSweep.hh"
+#include "asv/sim/BoatModel.hh"
+
+#include "CommandLine.hh"
+
+namespace
+{
+/////////////////////////////////////////////////
+/// \brief Read the reference forces.
+bool ReadReference(const std::string &_path, std::vector<double> &_aws,
+    std::vector<double> &_awa, std::vector<double> &_drive,
+    std::vector<double> &_side)
+{
+  std::ifstream in(_path);
+  if (!in)
+  {
+    std::cerr << "Failed to open [" << _path << "]\n";
+    return false;
+  }
+  std::string line;
+  size_t number = 0;
+  while (std::getline(in, line))
+  {
+    ++number;
+    std::vector<double> values;
+    if (line.empty() || line[0] == '#')
+      continue;
+    if (!asv::tools::ParseList(line, values) || values.size() != 4)
+    {
+      // Allow a header line.
+      if (number == 1)
+        continue;
+      std::cerr << "Invalid line [" << number << "] in [" << _path
+                << "]\n";
+      return false;
+    }
+    _aws.push_back(values[0]);
+    _awa.push_back(values[1] * M_PI / 180.0);
+    _drive.push_back(values[2]);
+    _side.push_back(values[3]);
+  }
+  return !_aws.empty();
+}
+}  // namespace
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  std::string input;
+  std::string modelName;
+  std::string sailName;
+  std::string referencePath;
+  std::string outputPath;
+  double trimDeg = 0.0;
+  std::vector<double> tws{2.0, 4.0, 6.0, 8.0, 10.0};
+  std::vector<double> twaDeg;
+  asv::tools::ParseRange("-180:180:5", twaDeg);
+  asv::core::LiftDragRanges ranges;
+  size_t best = 10;
+  size_t threads = 0;
+  const char *flags[] = {"--cla", "--alpha-stall", "--cla-stall", "--cda",
+      "--area"};
+
+  bool usage = argc < 2;
+  for (int i = 1; i < argc && !usage; ++i)
+  {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    bool param = false;
+    for (size_t j = 0; j < ranges.values.size(); ++j)
+    {
+      if (arg == flags[j] && hasValue)
+      {
+        usage = !asv::tools::ParseRange(argv[++i], ranges.values[j]);
+        param = true;
+      }
+    }
+    if (param)
+      continue;
+    if (arg == "--model" && hasValue)
+      modelName = argv[++i];
+    else if (arg == "--sail" && hasValue)
+      sailName = argv[++i];
+    else if (arg == "--trim" && hasValue)
+      trimDeg = std::strtod(argv[++i], nullptr);
+    else if (arg == "--aws" && hasValue)
+      usage = !asv::tools::ParseList(argv[++i], tws);
+    else if (arg == "--awa" && hasValue)
+      usage = !asv::tools::ParseRange(argv[++i], twaDeg);
+    else if (arg == "--reference" && hasValue)
+      referencePath = argv[++i];
+    else if (arg == "--best" && hasValue)
+      best = std::strtoul(argv[++i], nullptr, 10);
+    else if (arg == "--threads" && hasValue)
+      threads = std::strtoul(argv[++i], nullptr, 10);
+    else if (arg == "--output" && hasValue)
+      outputPath = argv[++i];
+    else if (input.empty() && arg.compare(0, 2, "--") != 0)
+      input = arg;
+    else
+      usage = true;
+  }
+  if (usage || input.empty())
+  {
+    std::cerr << "Usage: " << argv[0]
+              << " <model.sdf> [--model name] [--sail link] [--trim deg]"
+              << " [--aws 2,4,6,8,10] [--awa -180:180:5]"
+              << " [--reference file] [--cla values]"
+              << " [--alpha-stall values] [--cla-stall values]"
+              << " [--cda values] [--area values] [--best 10]"
+              << " [--threads n] [--output file]\n";
+    return EXIT_FAILURE;
+  }
+
+  sdf::SDFPtr sdfParsed(new sdf::SDF());
+  sdf::init(sdfParsed);
+  if (!sdf::readFile(input, sdfParsed))
+  {
+    std::cerr << "Failed to read [" << input << "]\n";
+    return EXIT_FAILURE;
+  }
+  auto model = asv::FindModel(sdfParsed->Root(), modelName);
+  if (!model)
+  {
+    std::cerr << "No <model> " << (modelName.empty() ? "" :
+        "[" + modelName + "] ") << "in [" << input << "]\n";
+    return EXIT_FAILURE;
+  }
+
+  asv::core::Boat boat;
+  if (!asv::LoadBoat(model, boat))
+    return EXIT_FAILURE;
+  const asv::core::BoatSurface *sail = nullptr;
+  for (const auto &surface : boat.surfaces)
+  {
+    if (surface.sail && !sail &&
+        (sailName.empty() || surface.name == sailName))
+    {
+      sail = &surface;
+    }
+  }
+  if (!sail)
+  {
+    std::cerr << "No sail " << (sailName.empty() ? "" :
+        "[" + sailName + "] ") << "in [" << input << "]\n";
+    return EXIT_FAILURE;
+  }
+
+  // The points: the reference file, or the grid of winds.
+  std::vector<double> aws;
+  std::vector<double> awa;
+  std::vector<double> drive;
+  std::vector<double> side;
+  if (!referencePath.empty())
+  {
+    if (!ReadReference(referencePath, aws, awa, drive, side))
+      return EXIT_FAILURE;
+  }
+  else
+  {
+    for (double speed : tws)
+    {
+      for (double angle : twaDeg)
+      {
+        aws.push_back(speed);
+        awa.push_back(angle * M_PI / 180.0);
+      }
+    }
+  }
+
+  asv::core::LiftDragSweep sweep(*sail, trimDeg * M_PI / 180.0, aws, awa);
+  if (!referencePath.empty())
+    sweep.SetReference(drive, side);
+
+  std::vector<std::array<double, 5>> driveSensitivity;
+  std::vector<std::array<double, 5>> sideSensitivity;
+  sweep.Sensitivity(sail->params, driveSensitivity, sideSensitivity);
+
+  auto t0 = std::chrono::steady_clock::now();
+  auto fits = sweep.Sweep(ranges, best, threads);
+  auto t1 = std::chrono::steady_clock::now();
+  double elapsed = std::chrono::duration<double>(t1 - t0).count();
+  double evaluations = static_cast<double>(ranges.Count()) *
+      sweep.Size() * sail->panels.size();
+  std::cerr << "Fitted [" << ranges.Count() << "] combinations at ["
+            << sweep.Size() << "] points of [" << sail->name << "] in "
+            << elapsed << " s, " << evaluations / std::max(elapsed, 1.0e-9)
+            << " evaluations/s\n";
+
+  std::ofstream file;
+  if (!outputPath.empty())
+  {
+    file.open(outputPath);
+    if (!file)
+    {
+      std::cerr << "Failed to open [" << outputPath << "]\n";
+      return EXIT_FAILURE;
+    }
+  }
+  std::ostream &out = file.is_open() ? file : std::cout;
+  out << std::setprecision(6);
+
+  out << "aws,awa";
+  for (const char *axis : {"drive", "side"})
+  {
+    for (auto name : asv::core::LiftDragSweep::kParamNames)
+      out << "," << axis << "_" << name;
+  }
+  out << "\n";
+  for (size_t i = 0; i < sweep.Size(); ++i)
+  {
+    out << aws[i] << "," << awa[i] * 180.0 / M_PI;
+    for (double value : driveSensitivity[i])
+      out << "," << value;
+    for (double value : sideSensitivity[i])
+      out << "," << value;
+    out << "\n";
+  }
+
+  out << "\nrms,r2";
+  for (auto name : asv::core::LiftDragSweep::kParamNames)
+    out << "," << name;
+  out << "\n";
+  for (const auto &fit : fits)
+  {
+    out << fit.rms << "," << fit.r2;
+    for (size_t j = 0; j < asv::core::LiftDragSweep::kParamNames.size(); ++j)
+      out << "," << asv::core::LiftDragSweep::Param(fit.params, j);
+    out << "\n";
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,168 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/// \file sail_interaction_table.cc
+/// \brief Generate an asv::SailInteractionTable for the sails of a
+/// SailVortexLattice plugin.
+///
+/// Usage:
+///
+///   asv_sim_sail_interaction_table <model.sdf> <table.bin>
+///       [num_trim] [num_awa]
+///
+/// The model file must contain a SailVortexLattice plugin. The pose of
+/// each sail relative to the base link is taken from the link <pose>
+/// elements, which are assumed to be relative to the model frame. The
+/// trim grid spans +/- 90 degrees and the apparent wind angle grid
+/// spans +/- 180 degrees.
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gz/math/Helpers.hh>
+#include <gz/math/Pose3.hh>
+#include <sdf/sdf.hh>
+
+#include "asv/sim/LiftDragModel.hh"
+#include "asv/sim/SailInteractionTable.hh"
+#include "asv/sim/SailPlanform.hh"
+
+namespace
+{
+/////////////////////////////////////////////////
+/// \brief Find a child element by name attribute.
+sdf::ElementPtr FindNamed(const sdf::ElementPtr &_parent,
+    const std::string &_type, const std::string &_name)
+{
+  auto elem = _parent->FindElement(_type);
+  while (elem)
+  {
+    if (elem->Get<std::string>("name") == _name)
+      return elem;
+    elem = elem->GetNextElement(_type);
+  }
+  return nullptr;
+}
+
+/////////////////////////////////////////////////
+/// \brief The pose of a link in the model frame.
+bool LinkPose(const sdf::ElementPtr &_model, const std::string &_name,
+    gz::math::Pose3d &_pose)
+{
+  auto link = FindNamed(_model, "link", _name);
+  if (!link)
+  {
+    std::cerr << "Link [" << _name << "] not found\n";
+    return false;
+  }
+  _pose = link->Get<gz::math::Pose3d>("pose", gz::math::Pose3d::Zero).first;
+  return true;
+}
+}  // namespace
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  if (argc < 3)
+  {
+    std::cerr << "Usage: " << argv[0]
+              << " <model.sdf> <table.bin> [num_trim] [num_awa]\n";
+    return EXIT_FAILURE;
+  }
+  std::string input = argv[1];
+  std::string output = argv[2];
+  size_t numTrim = argc > 3 ? std::stoul(argv[3]) : 19;
+  size_t numAwa = argc > 4 ? std::stoul(argv[4]) : 37;
+
+  sdf::SDFPtr sdfParsed(new sdf::SDF());
+  sdf::init(sdfParsed);
+  if (!sdf::readFile(input, sdfParsed))
+  {
+    std::cerr << "Failed to read [" << input << "]\n";
+    return EXIT_FAILURE;
+  }
+  auto model = sdfParsed->Root()->FindElement("model");
+  if (!model)
+  {
+    std::cerr << "No <model> in [" << input << "]\n";
+    return EXIT_FAILURE;
+  }
+  auto plugin = FindNamed(model, "plugin",
+      "gz::sim::systems::SailVortexLattice");
+  if (!plugin)
+  {
+    std::cerr << "No SailVortexLattice plugin in [" << input << "]\n";
+    return EXIT_FAILURE;
+  }
+
+  // Base link frame. As in the plugin, default to the first link.
+  std::string baseName;
+  if (plugin->HasElement("base_link_name"))
+    baseName = plugin->Get<std::string>("base_link_name");
+  else if (model->HasElement("link"))
+    baseName = model->FindElement("link")->Get<std::string>("name");
+  gz::math::Pose3d basePose;
+  if (!LinkPose(model, baseName, basePose))
+    return EXIT_FAILURE;
+
+  // Sail geometry in the base link frame.
+  std::vector<asv::InteractionSail> sails;
+  auto sailElem = plugin->FindElement("sail");
+  while (sailElem)
+  {
+    std::unique_ptr<asv::LiftDragModel> liftDrag(
+        asv::LiftDragModel::Create(sailElem));
+    asv::SailPlanform planform;
+    gz::math::Pose3d linkPose;
+    if (!liftDrag || !sailElem->HasElement("strips") ||
+        !asv::SailPlanform::Load(sailElem->FindElement("strips"), planform) ||
+        !LinkPose(model, sailElem->Get<std::string>("link_name"), linkPose))
+    {
+      std::cerr << "Invalid <sail> in [" << input << "]\n";
+      return EXIT_FAILURE;
+    }
+
+    asv::InteractionSail sail;
+    sail.forward = liftDrag->Forward();
+    sail.upward = liftDrag->Upward();
+    auto baseRotInv = basePose.Rot().Inverse();
+    sail.pose = gz::math::Pose3d(
+        baseRotInv.RotateVector(linkPose.Pos() - basePose.Pos()),
+        baseRotInv * linkPose.Rot());
+    planform.Discretise(sail.forward, sail.strips);
+    sails.push_back(std::move(sail));
+
+    sailElem = sailElem->GetNextElement("sail");
+  }
+  if (sails.size() < 2)
+  {
+    std::cerr << "At least two sails are required\n";
+    return EXIT_FAILURE;
+  }
+
+  asv::SailInteractionTable table;
+  table.Resize(sails.size(), numTrim, -0.5 * GZ_PI, 0.5 * GZ_PI,
+      numAwa, -GZ_PI, GZ_PI);
+  std::cout << "Generating table for [" << sails.size() << "] sails, ["
+            << numTrim << "] trims, [" << numAwa << "] wind angles\n";
+  if (!table.Generate(sails) || !table.Save(output))
+    return EXIT_FAILURE;
+
+  std::cout << "Saved [" << output << "]\n";
+  return EXIT_SUCCESS;
+}
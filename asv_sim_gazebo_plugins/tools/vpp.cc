@@ -0,0 +1,211 @@
+// Copyright (C) 2019-2023 Rhys Mainwaring
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+/// \file vpp.cc
+/// \brief Generate the polar diagram of a boat with the velocity
+/// prediction program asv::core::Vpp.
+///
+/// Usage:
+///
+///   asv_sim_vpp <model.sdf> [--model name] [--tws 2,4,6,8,10]
+///       [--twa 30:180:10] [--threads n] [--metacentric-height m]
+///       [--hull-drag x,y,z] [--hull-linear-drag x,y,z] [--max-heel deg]
+///       [--pol] [--output file]
+///
+/// The boat is loaded with asv::LoadBoat from the first model in the
+/// file, or the model given by --model, so the sails and foils have the
+/// parameters of their SailLiftDrag and FoilLiftDrag plugins. The hull
+/// resistance (quadratic and linear coefficients along the body x, y
+/// and z axes) and the metacentric height are not part of the model and
+/// are given on the command line.
+///
+/// Wind speeds are in m/s and angles in degrees. --twa takes a list or
+/// a range first:last:step. The points are solved on a thread pool, one
+/// per core unless --threads is given.
+///
+/// The output is comma separated, one line per point: the true wind,
+/// boat speed, velocity made good, leeway, heel, apparent wind, the
+/// unbalanced yaw moment, whether the balance converged and the trim of
+/// each sail. With --pol it is a polar table instead: a header line of
+/// wind speeds and a line per wind angle of boat speeds, tab separated,
+/// with 0 where the balance did not converge.
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sdf/sdf.hh>
+
+#include "asv/core/Vpp.hh"
+#include "asv/sim/BoatModel.hh"
+
+#include "CommandLine.hh"
+
+namespace
+{
+/////////////////////////////////////////////////
+double Degrees(double _radians)
+{
+  return _radians * 180.0 / M_PI;
+}
+}  // namespace
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  std::string input;
+  std::string modelName;
+  std::string outputPath;
+  std::vector<double> tws{2.0, 4.0, 6.0, 8.0, 10.0};
+  std::vector<double> twaDeg;
+  asv::tools::ParseRange("30:180:10", twaDeg);
+  bool pol = false;
+  asv::core::VppOptions options;
+  asv::core::Vector3d hullDrag;
+  asv::core::Vector3d hullLinearDrag;
+  double metacentricHeight = -1.0;
+
+  bool usage = argc < 2;
+  for (int i = 1; i < argc && !usage; ++i)
+  {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--model" && hasValue)
+      modelName = argv[++i];
+    else if (arg == "--tws" && hasValue)
+      usage = !asv::tools::ParseList(argv[++i], tws);
+    else if (arg == "--twa" && hasValue)
+      usage = !asv::tools::ParseRange(argv[++i], twaDeg);
+    else if (arg == "--threads" && hasValue)
+      options.threads = std::strtoul(argv[++i], nullptr, 10);
+    else if (arg == "--metacentric-height" && hasValue)
+      metacentricHeight = std::strtod(argv[++i], nullptr);
+    else if (arg == "--hull-drag" && hasValue)
+      usage = !asv::tools::ParseVector(argv[++i], hullDrag);
+    else if (arg == "--hull-linear-drag" && hasValue)
+      usage = !asv::tools::ParseVector(argv[++i], hullLinearDrag);
+    else if (arg == "--max-heel" && hasValue)
+      options.maxHeel = std::strtod(argv[++i], nullptr) * M_PI / 180.0;
+    else if (arg == "--pol")
+      pol = true;
+    else if (arg == "--output" && hasValue)
+      outputPath = argv[++i];
+    else if (input.empty() && arg.compare(0, 2, "--") != 0)
+      input = arg;
+    else
+      usage = true;
+  }
+  if (usage || input.empty())
+  {
+    std::cerr << "Usage: " << argv[0]
+              << " <model.sdf> [--model name] [--tws 2,4,6,8,10]"
+              << " [--twa 30:180:10] [--threads n]"
+              << " [--metacentric-height m] [--hull-drag x,y,z]"
+              << " [--hull-linear-drag x,y,z] [--max-heel deg] [--pol]"
+              << " [--output file]\n";
+    return EXIT_FAILURE;
+  }
+
+  sdf::SDFPtr sdfParsed(new sdf::SDF());
+  sdf::init(sdfParsed);
+  if (!sdf::readFile(input, sdfParsed))
+  {
+    std::cerr << "Failed to read [" << input << "]\n";
+    return EXIT_FAILURE;
+  }
+  auto model = asv::FindModel(sdfParsed->Root(), modelName);
+  if (!model)
+  {
+    std::cerr << "No <model> " << (modelName.empty() ? "" :
+        "[" + modelName + "] ") << "in [" << input << "]\n";
+    return EXIT_FAILURE;
+  }
+
+  asv::core::Boat boat;
+  if (!asv::LoadBoat(model, boat))
+    return EXIT_FAILURE;
+  boat.hull.quadraticDrag = hullDrag;
+  boat.hull.linearDrag = hullLinearDrag;
+  if (metacentricHeight >= 0.0)
+    boat.hull.metacentricHeight = metacentricHeight;
+
+  std::vector<double> twa;
+  for (double angle : twaDeg)
+    twa.push_back(angle * M_PI / 180.0);
+
+  auto t0 = std::chrono::steady_clock::now();
+  asv::core::Vpp vpp(boat, options);
+  auto points = vpp.Polar(tws, twa);
+  auto t1 = std::chrono::steady_clock::now();
+  std::cerr << "Solved [" << points.size() << "] points for ["
+            << model->Get<std::string>("name") << "] in "
+            << std::chrono::duration<double>(t1 - t0).count() << " s\n";
+
+  std::ofstream file;
+  if (!outputPath.empty())
+  {
+    file.open(outputPath);
+    if (!file)
+    {
+      std::cerr << "Failed to open [" << outputPath << "]\n";
+      return EXIT_FAILURE;
+    }
+  }
+  std::ostream &out = file.is_open() ? file : std::cout;
+  out << std::fixed << std::setprecision(4);
+
+  if (pol)
+  {
+    out << "twa/tws";
+    for (double speed : tws)
+      out << "\t" << speed;
+    out << "\n";
+    for (size_t j = 0; j < twa.size(); ++j)
+    {
+      out << twaDeg[j];
+      for (size_t i = 0; i < tws.size(); ++i)
+        out << "\t" << points[i * twa.size() + j].speed;
+      out << "\n";
+    }
+    return EXIT_SUCCESS;
+  }
+
+  out << "tws,twa,speed,vmg,leeway,heel,aws,awa,yaw_moment,converged";
+  for (const auto &surface : boat.surfaces)
+  {
+    if (surface.trimmable && surface.sail)
+      out << ",trim_" << surface.name;
+  }
+  out << "\n";
+  for (const auto &point : points)
+  {
+    out << point.tws << "," << Degrees(point.twa) << "," << point.speed
+        << "," << point.vmg << "," << Degrees(point.leeway) << ","
+        << Degrees(point.heel) << "," << point.aws << ","
+        << Degrees(point.awa) << "," << point.yawMoment << ","
+        << (point.converged ? 1 : 0);
+    for (double trim : point.trim)
+      out << "," << Degrees(trim);
+    out << "\n";
+  }
+  return EXIT_SUCCESS;
+}